@@ -5,6 +5,9 @@
 #include <sstream>
 #include <chrono>
 #include <thread>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
 
 using json = nlohmann::json;
 
@@ -25,11 +28,50 @@ static std::string url_encode_path(const std::string& value) {
     return result;
 }
 
+// Parse an RFC 3339 timestamp as emitted by mihomo's delay history
+// (e.g. "2024-05-01T10:00:00.123456789+08:00") into unix epoch milliseconds.
+// Returns 0 if the string cannot be parsed.
+static int64_t parse_rfc3339_ms(const std::string& s) {
+    std::tm tm{};
+    int consumed = 0;
+    if (std::sscanf(s.c_str(), "%d-%d-%dT%d:%d:%d%n",
+                    &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &consumed) != 6) {
+        return 0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+
+    size_t pos = static_cast<size_t>(consumed);
+    int64_t millis = 0;
+    if (pos < s.size() && s[pos] == '.') {
+        int digits = 0;
+        for (++pos; pos < s.size() && std::isdigit(static_cast<unsigned char>(s[pos])); ++pos) {
+            if (digits < 3) millis = millis * 10 + (s[pos] - '0');
+            ++digits;
+        }
+        for (; digits < 3; ++digits) millis *= 10;
+    }
+
+    int64_t offset_sec = 0;
+    if (pos < s.size() && (s[pos] == '+' || s[pos] == '-')) {
+        int oh = 0, om = 0;
+        if (std::sscanf(s.c_str() + pos + 1, "%d:%d", &oh, &om) == 2) {
+            offset_sec = (oh * 3600 + om * 60) * (s[pos] == '-' ? -1 : 1);
+        }
+    }
+
+    int64_t epoch = static_cast<int64_t>(timegm(&tm)) - offset_sec;
+    return epoch * 1000 + millis;
+}
+
 struct MihomoClient::Impl {
     std::string host;
     int port;
     std::string secret;
     int timeout_sec = 5;
+    ReadSource read_source;
+    std::atomic<bool> dirty{false};  // a write happened since the last read
 
     std::unique_ptr<httplib::Client> make_client() {
         auto cli = std::make_unique<httplib::Client>(host, port);
@@ -47,6 +89,20 @@ struct MihomoClient::Impl {
         headers.emplace("Content-Type", "application/json");
         return headers;
     }
+
+    bool get_direct(const std::string& path, std::string& body) {
+        auto cli = make_client();
+        auto res = cli->Get(path, auth_headers());
+        if (!res || res->status != 200) return false;
+        body = std::move(res->body);
+        return true;
+    }
+
+    /// GET a read-only endpoint, preferring the read source
+    bool get(const std::string& path, std::string& body) {
+        if (read_source && read_source(path, dirty.exchange(false), body)) return true;
+        return get_direct(path, body);
+    }
 };
 
 MihomoClient::MihomoClient(const std::string& host, int port, const std::string& secret)
@@ -62,9 +118,8 @@ MihomoClient::~MihomoClient() = default;
 
 bool MihomoClient::test_connection() {
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/version", impl_->auth_headers());
-        return res && res->status == 200;
+        std::string body;
+        return impl_->get("/version", body);
     } catch (...) {
         return false;
     }
@@ -75,10 +130,9 @@ bool MihomoClient::test_connection() {
 VersionInfo MihomoClient::get_version() {
     VersionInfo info;
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/version", impl_->auth_headers());
-        if (res && res->status == 200) {
-            auto j = json::parse(res->body);
+        std::string body;
+        if (impl_->get("/version", body)) {
+            auto j = json::parse(body);
             info.version = j.value("version", "");
             info.premium = j.value("premium", false);
         }
@@ -91,10 +145,9 @@ VersionInfo MihomoClient::get_version() {
 ClashConfig MihomoClient::get_config() {
     ClashConfig cfg;
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/configs", impl_->auth_headers());
-        if (res && res->status == 200) {
-            auto j = json::parse(res->body);
+        std::string body;
+        if (impl_->get("/configs", body)) {
+            auto j = json::parse(body);
             cfg.mode = j.value("mode", "rule");
             cfg.mixed_port = j.value("mixed-port", 0);
             cfg.socks_port = j.value("socks-port", 0);
@@ -113,6 +166,21 @@ bool MihomoClient::set_mode(const std::string& mode) {
         body["mode"] = mode;
         auto res = cli->Patch("/configs", impl_->auth_headers(),
                               body.dump(), "application/json");
+        impl_->dirty.store(true);
+        return res && (res->status == 200 || res->status == 204);
+    } catch (...) {
+        return false;
+    }
+}
+
+bool MihomoClient::set_inbound_ports(const std::map<std::string, int>& ports) {
+    try {
+        auto cli = impl_->make_client();
+        json body = json::object();
+        for (const auto& [key, port] : ports) body[key] = port;
+        auto res = cli->Patch("/configs", impl_->auth_headers(),
+                              body.dump(), "application/json");
+        impl_->dirty.store(true);
         return res && (res->status == 200 || res->status == 204);
     } catch (...) {
         return false;
@@ -128,6 +196,7 @@ bool MihomoClient::reload_config(const std::string& config_path) {
         body["path"] = config_path;
         auto res = cli->Put("/configs", impl_->auth_headers(),
                             body.dump(), "application/json");
+        impl_->dirty.store(true);
         return res && (res->status == 200 || res->status == 204);
     } catch (...) {
         return false;
@@ -157,11 +226,10 @@ bool MihomoClient::reload_config_and_wait(const std::string& config_path, int ma
 std::map<std::string, ProxyGroup> MihomoClient::get_proxy_groups() {
     std::map<std::string, ProxyGroup> groups;
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/proxies", impl_->auth_headers());
-        if (!res || res->status != 200) return groups;
+        std::string body;
+        if (!impl_->get("/proxies", body)) return groups;
 
-        auto j = json::parse(res->body);
+        auto j = json::parse(body);
         auto& proxies = j["proxies"];
 
         for (auto& [name, proxy] : proxies.items()) {
@@ -188,11 +256,10 @@ std::map<std::string, ProxyGroup> MihomoClient::get_proxy_groups() {
 std::map<std::string, ProxyNode> MihomoClient::get_proxy_nodes() {
     std::map<std::string, ProxyNode> nodes;
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/proxies", impl_->auth_headers());
-        if (!res || res->status != 200) return nodes;
+        std::string body;
+        if (!impl_->get("/proxies", body)) return nodes;
 
-        auto j = json::parse(res->body);
+        auto j = json::parse(body);
         auto& proxies = j["proxies"];
 
         for (auto& [name, proxy] : proxies.items()) {
@@ -210,12 +277,16 @@ std::map<std::string, ProxyNode> MihomoClient::get_proxy_nodes() {
             node.port = proxy.value("port", 0);
             node.alive = proxy.value("alive", true);
             if (proxy.contains("history") && proxy["history"].is_array()) {
+                std::vector<DelaySample> samples;
                 for (auto& h : proxy["history"]) {
-                    int d = h.value("delay", 0);
-                    node.delay_history.push_back(d);
+                    DelaySample sample;
+                    sample.delay = h.value("delay", 0);
+                    sample.timestamp_ms = parse_rfc3339_ms(h.value("time", ""));
+                    samples.push_back(sample);
                 }
+                node.delay_history.merge(samples);
                 if (!node.delay_history.empty()) {
-                    node.delay = node.delay_history.back();
+                    node.delay = node.delay_history.back().delay;
                 }
             }
 
@@ -233,6 +304,7 @@ bool MihomoClient::select_proxy(const std::string& group, const std::string& pro
         std::string path = "/proxies/" + url_encode_path(group);
         auto res = cli->Put(path, impl_->auth_headers(),
                             body.dump(), "application/json");
+        impl_->dirty.store(true);
         return res && (res->status == 200 || res->status == 204);
     } catch (...) {
         return false;
@@ -253,6 +325,7 @@ DelayResult MihomoClient::test_delay(const std::string& proxy_name,
                            "?url=" + url_encode_path(test_url) +
                            "&timeout=" + std::to_string(timeout_ms);
         auto res = cli->Get(path, impl_->auth_headers());
+        impl_->dirty.store(true);  // the node's history changed
 
         if (res && res->status == 200) {
             auto j = json::parse(res->body);
@@ -268,6 +341,7 @@ DelayResult MihomoClient::test_delay(const std::string& proxy_name,
             }
         } else {
             result.error = "connection failed";
+            result.api_unreachable = true;
         }
     } catch (const std::exception& e) {
         result.error = e.what();
@@ -282,10 +356,9 @@ DelayResult MihomoClient::test_delay(const std::string& proxy_name,
 ConnectionStats MihomoClient::get_connections() {
     ConnectionStats stats;
     try {
-        auto cli = impl_->make_client();
-        auto res = cli->Get("/connections", impl_->auth_headers());
-        if (res && res->status == 200) {
-            auto j = json::parse(res->body);
+        std::string body;
+        if (impl_->get("/connections", body)) {
+            auto j = json::parse(body);
             stats.upload_total = j.value("uploadTotal", (int64_t)0);
             stats.download_total = j.value("downloadTotal", (int64_t)0);
             if (j.contains("connections") && j["connections"].is_array()) {
@@ -300,12 +373,27 @@ bool MihomoClient::close_all_connections() {
     try {
         auto cli = impl_->make_client();
         auto res = cli->Delete("/connections", impl_->auth_headers());
+        impl_->dirty.store(true);
         return res && (res->status == 200 || res->status == 204);
     } catch (...) {
         return false;
     }
 }
 
+// ── Read source ─────────────────────────────────────────────
+
+void MihomoClient::set_read_source(ReadSource source) {
+    impl_->read_source = std::move(source);
+}
+
+bool MihomoClient::get_raw(const std::string& path, std::string& body) {
+    try {
+        return impl_->get_direct(path, body);
+    } catch (...) {
+        return false;
+    }
+}
+
 // ── Log streaming (SSE) ────────────────────────────────────
 
 void MihomoClient::stream_logs(const std::string& level,
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/delay_history.hpp"
+
 #include <string>
 #include <map>
 #include <vector>
@@ -28,7 +30,7 @@ struct ProxyNode {
     int port = 0;
     int delay = -1; // -1 = untested, 0 = timeout/fail
     bool alive = true;
-    std::vector<int> delay_history;
+    DelayHistory delay_history;
 };
 
 struct ProxyGroup {
@@ -51,6 +53,7 @@ struct DelayResult {
     int delay = 0; // 0 = failed
     bool success = false;
     std::string error;
+    bool api_unreachable = false; // mihomo did not answer: the node was not tested
 };
 
 struct LogEntry {
@@ -68,6 +71,11 @@ public:
     ClashConfig get_config();
     bool set_mode(const std::string& mode);
 
+    /// Move top-level inbound listeners ("port", "mixed-port", ...; 0 closes
+    /// one). PATCH /configs: only those listeners rebind, proxies and open
+    /// connections are left alone.
+    bool set_inbound_ports(const std::map<std::string, int>& ports);
+
     /// Reload mihomo config from a specific YAML file path
     /// PUT /configs {"path": "..."}
     bool reload_config(const std::string& config_path);
@@ -90,6 +98,16 @@ public:
                      std::function<void(LogEntry)> callback,
                      std::atomic<bool>& stop_flag);
 
+    /// Alternative source for GETs of the read-only endpoints (/version,
+    /// /configs, /proxies, /connections), e.g. the daemon's shared cache.
+    /// `fresh` is set on the first read after this client changed something.
+    /// Returning false falls back to asking mihomo directly.
+    using ReadSource = std::function<bool(const std::string& path, bool fresh, std::string& body)>;
+    void set_read_source(ReadSource source);
+
+    /// GET `path` from mihomo itself (never the read source); body of a 200 reply
+    bool get_raw(const std::string& path, std::string& body);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
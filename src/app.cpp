@@ -1,6 +1,10 @@
 #include "app.hpp"
 #include "core/config.hpp"
 #include "core/profile_manager.hpp"
+#include "core/latency_store.hpp"
+#include "core/throughput_tester.hpp"
+#include "core/selection_lock.hpp"
+#include "core/cli.hpp"
 #include "daemon/ipc_client.hpp"
 #include "api/mihomo_client.hpp"
 #include "ui/main_screen.hpp"
@@ -19,6 +23,7 @@
 #include <ftxui/dom/elements.hpp>
 #include <thread>
 #include <atomic>
+#include <mutex>
 
 using namespace ftxui;
 
@@ -27,6 +32,9 @@ struct App::Impl {
     std::unique_ptr<MihomoClient> client;
     ProfileManager profile_mgr{config};
     DaemonClient daemon_client;
+    std::unique_ptr<LatencyStore> latency_store;
+    std::unique_ptr<ThroughputTester> throughput_tester;
+    std::mutex throughput_mutex;
 
     MainScreen main_screen;
     StatusBar status_bar;
@@ -53,6 +61,7 @@ struct App::Impl {
 
     // Cached daemon availability
     std::atomic<bool> daemon_available{false};
+    std::atomic<bool> mihomo_over_limit{false};  // resource warning since mihomo started
     std::atomic<bool> was_connected{false};  // track connection state transitions
 
     void init_client() {
@@ -61,6 +70,11 @@ struct App::Impl {
             config.data().api_port,
             config.data().api_secret
         );
+        // Read through the daemon's shared poller while it is up, so any
+        // number of attached TUIs cost mihomo one set of requests
+        client->set_read_source([this](const std::string& path, bool fresh, std::string& body) {
+            return daemon_available.load() && daemon_client.controller_get(path, fresh, body);
+        });
     }
 
     void setup_callbacks() {
@@ -109,6 +123,55 @@ struct App::Impl {
         main_screen.set_callbacks(std::move(cb));
     }
 
+    // Created on first use so the mixed port is read from the running mihomo
+    ThroughputTester& get_throughput_tester() {
+        std::lock_guard<std::mutex> lock(throughput_mutex);
+        if (!throughput_tester) {
+            const auto& d = config.data();
+            ThroughputTester::Options opts;
+            opts.url = d.throughput_url;
+            opts.max_bytes = d.throughput_max_bytes;
+            opts.max_seconds = d.throughput_max_seconds;
+            opts.concurrency = d.throughput_concurrency;
+            opts.proxy_host = d.api_host;
+            opts.proxy_port = client->get_config().mixed_port;
+            if (opts.proxy_port <= 0) opts.proxy_port = CLI::resolve_ports_fast().http;
+            opts.lock_dir = SelectionLock::default_dir();
+
+            throughput_tester = std::make_unique<ThroughputTester>(
+                opts,
+                [this](const std::string& g, const std::string& p) {
+                    return client->select_proxy(g, p);
+                },
+                [this](const std::string& g) {
+                    auto groups = client->get_proxy_groups();
+                    auto it = groups.find(g);
+                    return it == groups.end() ? std::string() : it->second.now;
+                });
+            throughput_tester->recover();
+        }
+        return *throughput_tester;
+    }
+
+    // Incremental fetch of daemon probe results: only nodes probed since
+    // the previous poll are transferred. Status thread only.
+    int64_t latency_since_ms = 0;
+
+    void poll_daemon_latencies() {
+        int64_t server_now = 0;
+        // First poll fills whole windows, later ones only need the newest samples
+        size_t history = latency_since_ms == 0 ? 20 : 5;
+        auto latencies = daemon_client.get_latencies(latency_since_ms, history, &server_now);
+        if (server_now == 0) return;
+        latency_since_ms = server_now;
+
+        std::map<std::string, std::vector<DelaySample>> samples;
+        for (auto& [name, nl] : latencies) {
+            if (!nl.history.empty()) samples[name] = std::move(nl.history);
+        }
+        if (!samples.empty()) proxy_panel.apply_delay_samples(samples);
+    }
+
     void start_status_thread() {
         status_thread = std::thread([this]() {
             while (!stop_flag.load()) {
@@ -145,8 +208,12 @@ struct App::Impl {
                     }
                 }
 
-                // Check daemon availability periodically
-                daemon_available.store(daemon_client.is_daemon_running());
+                // Pull results of the daemon's background prober
+                if (daemon_available.load()) {
+                    poll_daemon_latencies();
+                } else {
+                    latency_since_ms = 0;
+                }
 
                 // Post a custom event to trigger UI refresh
                 screen.Post(Event::Custom);
@@ -159,8 +226,49 @@ struct App::Impl {
         });
     }
 
+    // Crash counters from the daemon's status, fetched when mihomo
+    // starts or exits rather than polled; usage then follows the
+    // daemon's mihomo_resources events
+    void refresh_mihomo_health() {
+        auto st = daemon_client.get_status();
+        status_bar.set_mihomo_health(st.mihomo_crashes, st.mihomo_crash_loop);
+        status_bar.set_mihomo_resources(st.mihomo_cpu_pct, st.mihomo_running ? st.mihomo_rss_kb : 0,
+                                        mihomo_over_limit.load());
+    }
+
+    // Daemon availability and profile/mihomo changes arrive as pushed
+    // events instead of being polled
+    void start_event_subscription() {
+        daemon_client.subscribe([this](const DaemonEvent& ev) {
+            if (ev.type == "daemon_connected") {
+                daemon_available.store(true);
+                subscription_panel.refresh_profiles();
+                refresh_mihomo_health();
+            } else if (ev.type == "daemon_disconnected") {
+                daemon_available.store(false);
+                subscription_panel.refresh_profiles();
+                status_bar.set_mihomo_health(0, false);
+                status_bar.set_mihomo_resources(-1, 0, false);
+            } else if (ev.type == "mihomo_resources") {
+                status_bar.set_mihomo_resources(ev.cpu_pct, ev.rss_kb, mihomo_over_limit.load());
+            } else if (ev.type == "mihomo_resource_alert") {
+                mihomo_over_limit.store(true);
+            } else if (ev.type == "mihomo_exited" || ev.type == "mihomo_crash_loop" ||
+                       ev.type == "mihomo_started") {
+                if (ev.type == "mihomo_started") mihomo_over_limit.store(false);
+                refresh_mihomo_health();
+            } else if (ev.type == "config_reloaded") {
+                proxy_panel.refresh_data();
+            } else if (ev.type.rfind("profile_", 0) == 0) {
+                subscription_panel.refresh_profiles();
+            }
+            screen.Post(Event::Custom);
+        });
+    }
+
     void stop_threads() {
         stop_flag.store(true);
+        daemon_client.unsubscribe();
         if (status_thread.joinable()) {
             status_thread.join();
         }
@@ -186,6 +294,10 @@ App::App() : impl_(std::make_unique<Impl>()) {
     // Init API client
     impl_->init_client();
 
+    // Local latency database (used when no daemon is running)
+    impl_->latency_store = std::make_unique<LatencyStore>(
+        LatencyStore::default_path(), impl_->config.data().latency_db_max_records);
+
     // Setup UI
     impl_->setup_callbacks();
 
@@ -198,7 +310,33 @@ App::App() : impl_(std::make_unique<Impl>()) {
             return impl_->client->select_proxy(g, p);
         };
         pcb.test_delay = [this](const std::string& name) {
-            return impl_->client->test_delay(name);
+            auto result = impl_->client->test_delay(name);
+            int delay = result.success ? result.delay : 0;
+            if (impl_->daemon_available.load()) {
+                impl_->daemon_client.record_latency(name, delay);
+            } else {
+                impl_->latency_store->append(name, delay, 0, 0,
+                                             impl_->profile_mgr.active_profile_name());
+            }
+            return result;
+        };
+        pcb.get_latency_stats = [this](const std::vector<std::string>& names) {
+            if (impl_->daemon_available.load()) {
+                return impl_->daemon_client.latency_stats(names);
+            }
+            return impl_->latency_store->stats(names, 0, 0,
+                                               impl_->profile_mgr.active_profile_name());
+        };
+        pcb.test_throughput = [this](const std::string& group, const std::string& node) {
+            auto groups = impl_->client->get_proxy_groups();
+            auto it = groups.find(group);
+            ThroughputResult refused;
+            refused.name = node;
+            refused.error = ThroughputTester::check_route(
+                group, it == groups.end() ? std::string() : it->second.type,
+                impl_->client->get_config().mode);
+            if (!refused.error.empty()) return refused;
+            return impl_->get_throughput_tester().test(group, node);
         };
         impl_->proxy_panel.set_callbacks(std::move(pcb));
     }
@@ -250,7 +388,7 @@ App::App() : impl_(std::make_unique<Impl>()) {
             }
             auto result = impl_->profile_mgr.update_profile(name);
             err = result.error;
-            if (result.success && result.was_active && impl_->client) {
+            if (result.success && result.was_active && !result.unchanged && impl_->client) {
                 std::string deployed = impl_->profile_mgr.deploy_active_to_mihomo();
                 if (deployed.empty()) {
                     err = "Failed to deploy profile to mihomo";
@@ -306,6 +444,11 @@ App::App() : impl_(std::make_unique<Impl>()) {
         };
 
         scb.set_update_interval = [this](const std::string& name, int hours) -> bool {
+            // The daemon owns the auto-update schedule; let it reload
+            if (impl_->daemon_available.load()) {
+                std::string err;
+                return impl_->daemon_client.set_update_interval(name, hours, err);
+            }
             return impl_->profile_mgr.set_update_interval(name, hours);
         };
 
@@ -375,6 +518,7 @@ App::~App() {
 void App::run() {
     // Start background threads
     impl_->start_status_thread();
+    impl_->start_event_subscription();
 
     // Check for updates in background
     impl_->update_check_thread = std::thread([this] {
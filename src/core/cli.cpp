@@ -3,22 +3,57 @@
 #include "core/updater.hpp"
 #include "core/installer.hpp"
 #include "core/profile_manager.hpp"
+#include "core/latency_store.hpp"
+#include "core/throughput_tester.hpp"
+#include "core/selection_lock.hpp"
+#include "core/l4_prober.hpp"
 #include "api/mihomo_client.hpp"
 #include "daemon/ipc_client.hpp"
 #include "daemon/daemon.hpp"
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 #include <fstream>
+#include <thread>
 #include <vector>
 #include <signal.h>
+#include <unistd.h>
 
 #ifndef APP_VERSION
 #define APP_VERSION "unknown"
 #endif
 
+namespace {
+
+// One-line progress for daemon jobs, redrawn in place on a terminal
+void print_job_progress(const JobInfo& info) {
+    if (!isatty(STDERR_FILENO)) return;
+    std::string line = "  [job " + std::to_string(info.id) + "] " + info.phase;
+    if (info.phase == "download" && info.bytes > 0) {
+        char buf[64];
+        if (info.total_bytes > 0) {
+            snprintf(buf, sizeof(buf), " %.1f/%.1f KiB", info.bytes / 1024.0, info.total_bytes / 1024.0);
+        } else {
+            snprintf(buf, sizeof(buf), " %.1f KiB", info.bytes / 1024.0);
+        }
+        line += buf;
+    }
+    std::cerr << "\r\033[K" << line << (info.finished() ? "\n" : "") << std::flush;
+}
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
 // ── Subcommand dispatch ─────────────────────────────────────
 
 int CLI::run(int argc, char* argv[]) {
@@ -50,6 +85,21 @@ int CLI::run(int argc, char* argv[]) {
     if (std::strcmp(cmd, "profile") == 0) {
         return cmd_profile(argc, argv);
     }
+    if (std::strcmp(cmd, "latency") == 0) {
+        return cmd_latency(argc, argv);
+    }
+    if (std::strcmp(cmd, "throughput") == 0) {
+        return cmd_throughput(argc, argv);
+    }
+    if (std::strcmp(cmd, "probe") == 0) {
+        return cmd_probe(argc, argv);
+    }
+    if (std::strcmp(cmd, "job") == 0) {
+        return cmd_job(argc, argv);
+    }
+    if (std::strcmp(cmd, "logs") == 0) {
+        return cmd_logs(argc, argv);
+    }
 
     std::cerr << "Unknown command: " << cmd << "\n";
     std::cerr << "Run 'clashtui-cpp help' for usage.\n";
@@ -76,6 +126,16 @@ int CLI::cmd_help() {
         "  clashtui-cpp profile rm <name>         Remove a profile\n"
         "  clashtui-cpp profile update [name]     Update profile(s)\n"
         "  clashtui-cpp profile switch <name>     Switch active profile\n"
+        "  clashtui-cpp latency [--days N] [--l4] [--profile NAME] [node...]\n"
+        "                              Long-term latency percentiles (default: active profile)\n"
+        "  clashtui-cpp throughput [--group G] [--url U] [--bytes N] [--seconds N] [node...]\n"
+        "                              Download speed per node; switches the group's live\n"
+        "                              selection meanwhile (default GLOBAL: global mode only)\n"
+        "  clashtui-cpp probe [--profile NAME] [--concurrency N] [--timeout MS] [--tls]\n"
+        "                              Raw TCP/TLS handshake times of a profile's servers\n"
+        "  clashtui-cpp job [list]     Show daemon jobs (downloads, restarts)\n"
+        "  clashtui-cpp job cancel <id>  Cancel a daemon job\n"
+        "  clashtui-cpp logs [-n N] [-f]  mihomo stdout/stderr captured by the daemon\n"
         "  clashtui-cpp init <shell>   Print shell init function (bash/zsh)\n"
         "  clashtui-cpp version        Show version\n"
         "  clashtui-cpp help           Show this help\n"
@@ -171,11 +231,68 @@ int CLI::cmd_status() {
         if (!st.active_profile.empty()) {
             std::cout << "Profile: " << st.active_profile << "\n";
         }
+        if (st.reloads_skipped > 0) {
+            std::cout << "Reloads: " << st.reloads_skipped << " skipped (profile unchanged)\n";
+        }
+        if (st.mihomo_crash_loop) {
+            std::cout << "Health:  crash loop, restarts suspended until the profile changes\n";
+        }
+        if (st.mihomo_crashes > 0) {
+            std::cout << "Crashes: " << st.mihomo_crashes << " (" << st.mihomo_restarts
+                      << " auto-restarts); last ";
+            if (st.last_exit_signal > 0) std::cout << "killed by signal " << st.last_exit_signal;
+            else std::cout << "exit code " << st.last_exit_code;
+            std::cout << " after " << (st.last_uptime_ms / 1000) << "s, "
+                      << (now_ms() - st.last_exit_ms) / 1000 << "s ago\n";
+        }
+        if (st.startup_ready_ms >= 0) {
+            std::cout << "Startup: mihomo ready in " << st.startup_ready_ms << " ms\n";
+        }
+        if (st.restart_downtime_ms >= 0) {
+            std::cout << "Restart: " << st.restart_downtime_ms << " ms downtime (last)\n";
+        }
+        if (st.mihomo_running && st.mihomo_fds >= 0) {
+            char line[128];
+            snprintf(line, sizeof(line), "RSS %.1f MiB, %d fds, %d threads",
+                          static_cast<double>(st.mihomo_rss_kb) / 1024.0, st.mihomo_fds, st.mihomo_threads);
+            std::cout << "Usage:   " << line;
+            if (st.mihomo_cpu_pct >= 0) {
+                snprintf(line, sizeof(line), ", CPU %.1f%%", st.mihomo_cpu_pct);
+                std::cout << line;
+            }
+            std::cout << "\n";
+        }
+        if (st.mihomo_running && st.launch_pid == st.mihomo_pid) {
+            static const char* const io_classes[] = {"none", "realtime", "best-effort", "idle"};
+            std::cout << "Launch:  cpus " << (st.launch_cpus.empty() ? "?" : st.launch_cpus)
+                      << ", nice " << st.launch_nice;
+            if (st.launch_ionice_class > 0 && st.launch_ionice_class <= 3) {
+                std::cout << ", io " << io_classes[st.launch_ionice_class] << "/" << st.launch_ionice_level;
+            }
+            std::cout << ", nofile " << st.launch_nofile << ", memory ";
+            if (st.launch_memory_bytes == 0) std::cout << "unlimited";
+            else std::cout << (st.launch_memory_bytes >> 20) << " MiB";
+            for (const auto& e : st.launch_env) std::cout << ", " << e;
+            std::cout << "\n";
+            if (!st.launch_failed.empty()) {
+                std::cout << "         not applied:";
+                for (const auto& f : st.launch_failed) std::cout << " " << f;
+                std::cout << "\n";
+            }
+        }
+        if (st.resource_restarts > 0) {
+            std::cout << "Limits:  " << st.resource_restarts << " planned restart(s) after a resource limit\n";
+        }
     }
 
     // Mihomo API status
     auto& d = config.data();
     MihomoClient client(d.api_host, d.api_port, d.api_secret);
+    if (daemon_running) {
+        client.set_read_source([&dc](const std::string& path, bool fresh, std::string& body) {
+            return dc.controller_get(path, fresh, body);
+        });
+    }
     if (client.test_connection()) {
         auto ver = client.get_version();
         std::cout << "API:     connected (mihomo " << ver.version << ")\n";
@@ -567,7 +684,7 @@ int CLI::cmd_profile(int argc, char* argv[]) {
         bool ok = false;
 
         if (dc.is_daemon_running()) {
-            ok = dc.add_profile(name, url, err);
+            ok = dc.add_profile(name, url, err, print_job_progress);
         } else {
             Config config;
             config.load();
@@ -626,7 +743,7 @@ int CLI::cmd_profile(int argc, char* argv[]) {
             std::string err;
             bool ok = false;
             if (dc.is_daemon_running()) {
-                ok = dc.update_profile(name, err);
+                ok = dc.update_profile(name, err, print_job_progress);
             } else {
                 auto result = pm.update_profile(name);
                 ok = result.success;
@@ -646,7 +763,7 @@ int CLI::cmd_profile(int argc, char* argv[]) {
                 std::string err;
                 bool ok = false;
                 if (dc.is_daemon_running()) {
-                    ok = dc.update_profile(p.name, err);
+                    ok = dc.update_profile(p.name, err, print_job_progress);
                 } else {
                     auto result = pm.update_profile(p.name);
                     ok = result.success;
@@ -709,3 +826,351 @@ int CLI::cmd_profile(int argc, char* argv[]) {
         return 1;
     }
 }
+
+// ── latency ────────────────────────────────────────────────
+
+int CLI::cmd_latency(int argc, char* argv[]) {
+    int days = 30;
+    uint16_t flags = 0;
+    std::string profile;
+    std::vector<std::string> names;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--l4") == 0) {
+            flags = kLatencyFlagL4;
+        } else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc) {
+            profile = argv[++i];
+        } else if (std::strcmp(argv[i], "--days") == 0 && i + 1 < argc) {
+            try {
+                days = std::stoi(argv[++i]);
+            } catch (...) {
+                std::cerr << "Invalid --days value: " << argv[i] << "\n";
+                return 1;
+            }
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    int64_t since = days > 0 ? (int64_t)std::time(nullptr) - (int64_t)days * 86400 : 0;
+
+    // Prefer the daemon's database (it records background probes)
+    std::map<std::string, LatencyStats> stats;
+    DaemonClient dc;
+    if (dc.is_daemon_running()) {
+        stats = dc.latency_stats(names, since, flags, profile);
+    } else {
+        Config config;
+        config.load();
+        if (profile.empty()) profile = ProfileManager(config).active_profile_name();
+        LatencyStore store(LatencyStore::default_path(), config.data().latency_db_max_records);
+        stats = names.empty() ? store.stats_all(since, flags, profile)
+                              : store.stats(names, since, flags, profile);
+    }
+
+    if (stats.empty()) {
+        std::cout << "No latency samples recorded.\n";
+        return 0;
+    }
+
+    printf("  %-30s %8s %6s %7s %7s %7s\n", "NODE", "SAMPLES", "FAIL%", "P50", "P95", "P99");
+    auto ms = [](int v) { return v < 0 ? std::string("-") : std::to_string(v) + "ms"; };
+    for (const auto& [name, st] : stats) {
+        double fail_pct = st.samples ? 100.0 * st.failures / st.samples : 0.0;
+        std::string label = name.size() > 30 ? name.substr(0, 27) + "..." : name;
+        printf("  %-30s %8zu %5.1f%% %7s %7s %7s\n",
+               label.c_str(), st.samples, fail_pct,
+               ms(st.p50).c_str(), ms(st.p95).c_str(), ms(st.p99).c_str());
+    }
+    return 0;
+}
+
+// ── throughput ──────────────────────────────────────────────
+
+int CLI::cmd_throughput(int argc, char* argv[]) {
+    Config config;
+    config.load();
+    auto& d = config.data();
+
+    ThroughputTester::Options opts;
+    opts.url = d.throughput_url;
+    opts.max_bytes = d.throughput_max_bytes;
+    opts.max_seconds = d.throughput_max_seconds;
+    opts.concurrency = d.throughput_concurrency;
+    std::string group = "GLOBAL";
+    std::vector<std::string> names;
+
+    for (int i = 2; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        try {
+            if (std::strcmp(argv[i], "--group") == 0 && has_value) {
+                group = argv[++i];
+            } else if (std::strcmp(argv[i], "--url") == 0 && has_value) {
+                opts.url = argv[++i];
+            } else if (std::strcmp(argv[i], "--bytes") == 0 && has_value) {
+                opts.max_bytes = std::stoll(argv[++i]);
+            } else if (std::strcmp(argv[i], "--seconds") == 0 && has_value) {
+                opts.max_seconds = std::stoi(argv[++i]);
+            } else {
+                names.push_back(argv[i]);
+            }
+        } catch (...) {
+            std::cerr << "Invalid value for " << argv[i - 1] << ": " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    MihomoClient client(d.api_host, d.api_port, d.api_secret);
+    if (!client.test_connection()) {
+        std::cerr << "Cannot connect to mihomo API at " << d.api_host << ":" << d.api_port << "\n";
+        return 1;
+    }
+
+    auto groups = client.get_proxy_groups();
+    auto git = groups.find(group);
+    if (git == groups.end()) {
+        std::cerr << "Unknown proxy group: " << group << "\n";
+        return 1;
+    }
+    auto clash = client.get_config();
+    std::string route_error = ThroughputTester::check_route(group, git->second.type, clash.mode);
+    if (!route_error.empty()) {
+        std::cerr << route_error << "\n";
+        return 1;
+    }
+    if (names.empty()) {
+        // Every member of the group that is a real node
+        auto nodes = client.get_proxy_nodes();
+        for (const auto& member : git->second.all) {
+            if (nodes.count(member)) names.push_back(member);
+        }
+    }
+
+    opts.proxy_host = d.api_host;
+    opts.proxy_port = clash.mixed_port;
+    if (opts.proxy_port <= 0) opts.proxy_port = resolve_ports_fast().http;
+    opts.lock_dir = SelectionLock::default_dir();
+
+    ThroughputTester tester(opts,
+        [&client](const std::string& g, const std::string& p) { return client.select_proxy(g, p); },
+        [&client](const std::string& g) {
+            auto all = client.get_proxy_groups();
+            auto it = all.find(g);
+            return it == all.end() ? std::string() : it->second.now;
+        });
+    tester.recover();
+
+    std::cout << "Testing " << names.size() << " node(s) via group " << group
+              << " (" << opts.url << ")\n"
+              << "Traffic through " << group << " follows the tested node until the test ends\n";
+    // All nodes route through the same group, so they run one at a time
+    printf("  %-30s %10s %8s %10s\n", "NODE", "MB/s", "TTFB", "BYTES");
+    for (const auto& name : names) {
+        auto r = tester.test(group, name);
+        std::string label = name.size() > 30 ? name.substr(0, 27) + "..." : name;
+        if (r.success) {
+            printf("  %-30s %10.2f %6dms %10lld\n", label.c_str(), r.mb_per_sec, r.ttfb_ms,
+                   (long long)r.bytes);
+        } else {
+            printf("  %-30s %10s %8s %10s  %s\n", label.c_str(), "-", "-", "-", r.error.c_str());
+        }
+        fflush(stdout);
+    }
+    return 0;
+}
+
+// ── probe ───────────────────────────────────────────────────
+
+int CLI::cmd_probe(int argc, char* argv[]) {
+    Config config;
+    config.load();
+
+    L4Prober::Options opts;
+    std::string profile;
+    for (int i = 2; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        try {
+            if (std::strcmp(argv[i], "--profile") == 0 && has_value) {
+                profile = argv[++i];
+            } else if (std::strcmp(argv[i], "--concurrency") == 0 && has_value) {
+                opts.concurrency = std::stoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--timeout") == 0 && has_value) {
+                opts.timeout_ms = std::stoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--tls") == 0) {
+                opts.tls = true;
+            } else {
+                std::cerr << "Unknown option: " << argv[i] << "\n";
+                std::cerr << "Usage: clashtui-cpp probe [--profile NAME] [--concurrency N] "
+                             "[--timeout MS] [--tls]\n";
+                return 1;
+            }
+        } catch (...) {
+            std::cerr << "Invalid value for " << argv[i - 1] << ": " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    ProfileManager mgr(config);
+    if (profile.empty()) profile = mgr.active_profile_name();
+    std::string path;
+    for (const auto& p : mgr.list_profiles()) {
+        if (p.name == profile) path = mgr.profiles_dir() + "/" + p.filename;
+    }
+    if (path.empty()) {
+        std::cerr << (profile.empty() ? std::string("No active profile") :
+                      "Profile not found: " + profile) << "\n";
+        return 1;
+    }
+
+    auto targets = L4Prober::targets_from_profile(path);
+    if (targets.empty()) {
+        std::cerr << "No TCP proxies in profile: " << profile << "\n";
+        return 1;
+    }
+
+    std::cout << "Probing " << targets.size() << " server(s) of " << profile
+              << (opts.tls ? " (TCP+TLS)" : " (TCP)") << ", concurrency "
+              << opts.concurrency << "...\n";
+
+    auto start = std::chrono::steady_clock::now();
+    L4Prober prober(opts);
+    auto results = prober.run(targets);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // Record as L4 samples so they never mix with full delay tests
+    LatencyStore store(LatencyStore::default_path(), config.data().latency_db_max_records);
+    for (const auto& r : results) {
+        store.append(r.name, r.delay(), 0, kLatencyFlagL4, profile);
+    }
+
+    std::stable_sort(results.begin(), results.end(), [](const L4Result& a, const L4Result& b) {
+        if (a.success != b.success) return a.success;
+        return a.delay() < b.delay();
+    });
+
+    size_t ok = 0;
+    printf("  %-30s %8s %8s  %s\n", "NODE", "TCP", "TLS", "L4");
+    for (const auto& r : results) {
+        std::string label = r.name.size() > 30 ? r.name.substr(0, 27) + "..." : r.name;
+        if (r.success) {
+            ++ok;
+            std::string tls = r.tls_ms >= 0 ? std::to_string(r.tls_ms) + "ms" : "-";
+            printf("  %-30s %6dms %8s  %dms\n", label.c_str(), r.connect_ms, tls.c_str(), r.delay());
+        } else {
+            printf("  %-30s %8s %8s  %s\n", label.c_str(), "-", "-", r.error.c_str());
+        }
+    }
+    std::cout << ok << "/" << results.size() << " reachable in " << elapsed << "ms\n";
+    return 0;
+}
+
+// ── job ─────────────────────────────────────────────────────
+
+int CLI::cmd_job(int argc, char* argv[]) {
+    DaemonClient dc;
+    if (!dc.is_daemon_running()) {
+        std::cerr << "Daemon is not running.\n";
+        return 1;
+    }
+
+    const char* sub = argc >= 3 ? argv[2] : "list";
+
+    if (std::strcmp(sub, "cancel") == 0) {
+        if (argc < 4) {
+            std::cerr << "Usage: clashtui-cpp job cancel <id>\n";
+            return 1;
+        }
+        uint64_t id = 0;
+        try {
+            id = std::stoull(argv[3]);
+        } catch (...) {
+            std::cerr << "Invalid job id: " << argv[3] << "\n";
+            return 1;
+        }
+        std::string err;
+        if (!dc.cancel_job(id, err)) {
+            std::cerr << "Failed to cancel job " << id << ": " << err << "\n";
+            return 1;
+        }
+        std::cout << "Cancellation requested for job " << id << ".\n";
+        return 0;
+    }
+
+    if (std::strcmp(sub, "list") != 0) {
+        std::cerr << "Usage: clashtui-cpp job [list|cancel <id>]\n";
+        return 1;
+    }
+
+    auto jobs = dc.list_jobs();
+    if (jobs.empty()) {
+        std::cout << "No jobs.\n";
+        return 0;
+    }
+    printf("  %-6s %-16s %-18s %-10s %-10s %s\n", "ID", "KIND", "TARGET", "STATE", "PHASE", "DETAIL");
+    for (const auto& j : jobs) {
+        std::string detail = j.error;
+        if (detail.empty() && j.bytes > 0) detail = std::to_string(j.bytes / 1024) + " KiB";
+        printf("  %-6llu %-16s %-18s %-10s %-10s %s\n",
+               (unsigned long long)j.id, j.kind.c_str(), j.target.c_str(),
+               j.state.c_str(), j.phase.c_str(), detail.c_str());
+    }
+    return 0;
+}
+
+// ── logs ────────────────────────────────────────────────────
+
+int CLI::cmd_logs(int argc, char* argv[]) {
+    size_t count = 50;
+    bool follow = false;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-f") == 0 || std::strcmp(argv[i], "--follow") == 0) {
+            follow = true;
+        } else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            try {
+                count = std::stoul(argv[++i]);
+            } catch (...) {
+                std::cerr << "Invalid -n value: " << argv[i] << "\n";
+                return 1;
+            }
+        } else {
+            std::cerr << "Usage: clashtui-cpp logs [-n N] [-f]\n";
+            return 1;
+        }
+    }
+
+    DaemonClient dc;
+    if (!dc.is_daemon_running()) {
+        std::cerr << "Daemon is not running.\n";
+        return 1;
+    }
+
+    auto print = [](const std::vector<MihomoLogLine>& lines) {
+        for (const auto& l : lines) {
+            std::time_t secs = static_cast<std::time_t>(l.time_ms / 1000);
+            std::tm tm{};
+            localtime_r(&secs, &tm);
+            char ts[16];
+            std::strftime(ts, sizeof(ts), "%H:%M:%S", &tm);
+            std::cout << ts << (l.stream == "stderr" ? " ! " : "   ") << l.text << "\n";
+        }
+        std::cout << std::flush;
+    };
+
+    std::vector<MihomoLogLine> lines;
+    uint64_t next = 0;
+    if (!dc.mihomo_logs(0, std::max<size_t>(count, 1), lines, next)) {
+        std::cerr << "Failed to read mihomo logs.\n";
+        return 1;
+    }
+    if (count > 0) print(lines);
+
+    // Follow: fetch only what arrived after the last line shown
+    while (follow) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        if (!dc.mihomo_logs(next, 0, lines, next)) {
+            std::cerr << "Lost connection to daemon.\n";
+            return 1;
+        }
+        print(lines);
+    }
+    return 0;
+}
@@ -27,6 +27,11 @@ private:
     static int cmd_proxy(int argc, char* argv[]);
     static int cmd_update(int argc, char* argv[]);
     static int cmd_profile(int argc, char* argv[]);
+    static int cmd_latency(int argc, char* argv[]);
+    static int cmd_throughput(int argc, char* argv[]);
+    static int cmd_probe(int argc, char* argv[]);
+    static int cmd_job(int argc, char* argv[]);
+    static int cmd_logs(int argc, char* argv[]);
 
     static int proxy_on();
     static int proxy_off();
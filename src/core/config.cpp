@@ -134,6 +134,100 @@ bool Config::load() {
         // Profiles section
         if (auto profiles = root["profiles"]) {
             config_.active_profile = profiles["active"].as<std::string>(config_.active_profile);
+            config_.profile_max_download_mb =
+                profiles["max_download_mb"].as<int>(config_.profile_max_download_mb);
+        }
+
+        // Auto-update section
+        if (auto au = root["auto_update"]) {
+            config_.auto_update_concurrency = au["concurrency"].as<int>(config_.auto_update_concurrency);
+            config_.auto_update_jitter_sec = au["jitter_sec"].as<int>(config_.auto_update_jitter_sec);
+        }
+
+        // Latency section
+        if (auto latency = root["latency"]) {
+            config_.latency_db_max_records = latency["db_max_records"].as<int>(config_.latency_db_max_records);
+        }
+
+        // Prober section
+        if (auto prober = root["prober"]) {
+            config_.prober_enabled = prober["enabled"].as<bool>(config_.prober_enabled);
+            config_.prober_rate_per_sec = prober["rate_per_sec"].as<double>(config_.prober_rate_per_sec);
+            config_.prober_concurrency = prober["concurrency"].as<int>(config_.prober_concurrency);
+            config_.prober_selected_interval_sec = prober["selected_interval_sec"].as<int>(config_.prober_selected_interval_sec);
+            config_.prober_flaky_interval_sec = prober["flaky_interval_sec"].as<int>(config_.prober_flaky_interval_sec);
+            config_.prober_stable_interval_sec = prober["stable_interval_sec"].as<int>(config_.prober_stable_interval_sec);
+            config_.prober_dead_interval_sec = prober["dead_interval_sec"].as<int>(config_.prober_dead_interval_sec);
+        }
+
+        // Auto-select section
+        if (auto sel = root["auto_select"]) {
+            if (auto groups = sel["groups"]) {
+                config_.auto_select_groups.clear();
+                for (const auto& g : groups) {
+                    config_.auto_select_groups.push_back(g.as<std::string>());
+                }
+            }
+            config_.auto_select_interval_sec = sel["interval_sec"].as<int>(config_.auto_select_interval_sec);
+            config_.auto_select_hysteresis_pct = sel["hysteresis_pct"].as<int>(config_.auto_select_hysteresis_pct);
+            config_.auto_select_min_dwell_sec = sel["min_dwell_sec"].as<int>(config_.auto_select_min_dwell_sec);
+            config_.auto_select_max_failure_pct = sel["max_failure_pct"].as<int>(config_.auto_select_max_failure_pct);
+        }
+
+        // Controller cache section
+        if (auto cache = root["controller_cache"]) {
+            config_.controller_cache_enabled = cache["enabled"].as<bool>(config_.controller_cache_enabled);
+            config_.controller_cache_interval_ms = cache["interval_ms"].as<int>(config_.controller_cache_interval_ms);
+        }
+
+        // Blue/green switch section
+        if (auto bg = root["blue_green"]) {
+            config_.blue_green_enabled = bg["enabled"].as<bool>(config_.blue_green_enabled);
+            config_.blue_green_port_offset = bg["port_offset"].as<int>(config_.blue_green_port_offset);
+            config_.blue_green_ready_timeout_sec =
+                bg["ready_timeout_sec"].as<int>(config_.blue_green_ready_timeout_sec);
+        }
+
+        // mihomo output capture section
+        if (auto ml = root["mihomo_log"]) {
+            config_.mihomo_log_lines = ml["lines"].as<int>(config_.mihomo_log_lines);
+            config_.mihomo_log_file_enabled = ml["file"].as<bool>(config_.mihomo_log_file_enabled);
+            config_.mihomo_log_file_max_kb = ml["file_max_kb"].as<int>(config_.mihomo_log_file_max_kb);
+            config_.mihomo_log_file_keep = ml["file_keep"].as<int>(config_.mihomo_log_file_keep);
+        }
+
+        // mihomo resource monitor section
+        if (auto mm = root["mihomo_monitor"]) {
+            config_.mihomo_monitor_enabled = mm["enabled"].as<bool>(config_.mihomo_monitor_enabled);
+            config_.mihomo_monitor_interval_sec = mm["interval_sec"].as<int>(config_.mihomo_monitor_interval_sec);
+            config_.mihomo_monitor_history = mm["history"].as<int>(config_.mihomo_monitor_history);
+            config_.mihomo_monitor_sustain = mm["sustain"].as<int>(config_.mihomo_monitor_sustain);
+            config_.mihomo_monitor_rss_warn_mb = mm["rss_warn_mb"].as<int>(config_.mihomo_monitor_rss_warn_mb);
+            config_.mihomo_monitor_rss_restart_mb =
+                mm["rss_restart_mb"].as<int>(config_.mihomo_monitor_rss_restart_mb);
+            config_.mihomo_monitor_fds_warn = mm["fds_warn"].as<int>(config_.mihomo_monitor_fds_warn);
+            config_.mihomo_monitor_fds_restart = mm["fds_restart"].as<int>(config_.mihomo_monitor_fds_restart);
+            config_.mihomo_monitor_cpu_warn_pct = mm["cpu_warn_pct"].as<int>(config_.mihomo_monitor_cpu_warn_pct);
+        }
+
+        // mihomo launch options section
+        if (auto ml = root["mihomo_launch"]) {
+            config_.mihomo_cpus = ml["cpus"].as<std::string>(config_.mihomo_cpus);
+            config_.mihomo_nice = ml["nice"].as<int>(config_.mihomo_nice);
+            config_.mihomo_ionice_class = ml["ionice_class"].as<int>(config_.mihomo_ionice_class);
+            config_.mihomo_ionice_level = ml["ionice_level"].as<int>(config_.mihomo_ionice_level);
+            config_.mihomo_nofile = ml["nofile"].as<int>(config_.mihomo_nofile);
+            config_.mihomo_memory_limit_mb = ml["memory_limit_mb"].as<int>(config_.mihomo_memory_limit_mb);
+            config_.mihomo_gomaxprocs = ml["gomaxprocs"].as<int>(config_.mihomo_gomaxprocs);
+            config_.mihomo_gomemlimit_mb = ml["gomemlimit_mb"].as<int>(config_.mihomo_gomemlimit_mb);
+        }
+
+        // Throughput section
+        if (auto tp = root["throughput"]) {
+            config_.throughput_url = tp["url"].as<std::string>(config_.throughput_url);
+            config_.throughput_max_bytes = tp["max_bytes"].as<int64_t>(config_.throughput_max_bytes);
+            config_.throughput_max_seconds = tp["max_seconds"].as<int>(config_.throughput_max_seconds);
+            config_.throughput_concurrency = tp["concurrency"].as<int>(config_.throughput_concurrency);
         }
 
         return true;
@@ -196,6 +290,96 @@ bool Config::save() {
         // Profiles section
         out << YAML::Key << "profiles" << YAML::Value << YAML::BeginMap;
         out << YAML::Key << "active" << YAML::Value << config_.active_profile;
+        out << YAML::Key << "max_download_mb" << YAML::Value << config_.profile_max_download_mb;
+        out << YAML::EndMap;
+
+        // Auto-update section
+        out << YAML::Key << "auto_update" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "concurrency" << YAML::Value << config_.auto_update_concurrency;
+        out << YAML::Key << "jitter_sec" << YAML::Value << config_.auto_update_jitter_sec;
+        out << YAML::EndMap;
+
+        // Latency section
+        out << YAML::Key << "latency" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "db_max_records" << YAML::Value << config_.latency_db_max_records;
+        out << YAML::EndMap;
+
+        // Prober section
+        out << YAML::Key << "prober" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "enabled" << YAML::Value << config_.prober_enabled;
+        out << YAML::Key << "rate_per_sec" << YAML::Value << config_.prober_rate_per_sec;
+        out << YAML::Key << "concurrency" << YAML::Value << config_.prober_concurrency;
+        out << YAML::Key << "selected_interval_sec" << YAML::Value << config_.prober_selected_interval_sec;
+        out << YAML::Key << "flaky_interval_sec" << YAML::Value << config_.prober_flaky_interval_sec;
+        out << YAML::Key << "stable_interval_sec" << YAML::Value << config_.prober_stable_interval_sec;
+        out << YAML::Key << "dead_interval_sec" << YAML::Value << config_.prober_dead_interval_sec;
+        out << YAML::EndMap;
+
+        // Auto-select section
+        out << YAML::Key << "auto_select" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "groups" << YAML::Value << YAML::BeginSeq;
+        for (const auto& g : config_.auto_select_groups) {
+            out << g;
+        }
+        out << YAML::EndSeq;
+        out << YAML::Key << "interval_sec" << YAML::Value << config_.auto_select_interval_sec;
+        out << YAML::Key << "hysteresis_pct" << YAML::Value << config_.auto_select_hysteresis_pct;
+        out << YAML::Key << "min_dwell_sec" << YAML::Value << config_.auto_select_min_dwell_sec;
+        out << YAML::Key << "max_failure_pct" << YAML::Value << config_.auto_select_max_failure_pct;
+        out << YAML::EndMap;
+
+        // Controller cache section
+        out << YAML::Key << "controller_cache" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "enabled" << YAML::Value << config_.controller_cache_enabled;
+        out << YAML::Key << "interval_ms" << YAML::Value << config_.controller_cache_interval_ms;
+        out << YAML::EndMap;
+
+        // Blue/green switch section
+        out << YAML::Key << "blue_green" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "enabled" << YAML::Value << config_.blue_green_enabled;
+        out << YAML::Key << "port_offset" << YAML::Value << config_.blue_green_port_offset;
+        out << YAML::Key << "ready_timeout_sec" << YAML::Value << config_.blue_green_ready_timeout_sec;
+        out << YAML::EndMap;
+
+        // mihomo output capture section
+        out << YAML::Key << "mihomo_log" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "lines" << YAML::Value << config_.mihomo_log_lines;
+        out << YAML::Key << "file" << YAML::Value << config_.mihomo_log_file_enabled;
+        out << YAML::Key << "file_max_kb" << YAML::Value << config_.mihomo_log_file_max_kb;
+        out << YAML::Key << "file_keep" << YAML::Value << config_.mihomo_log_file_keep;
+        out << YAML::EndMap;
+
+        // mihomo resource monitor section
+        out << YAML::Key << "mihomo_monitor" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "enabled" << YAML::Value << config_.mihomo_monitor_enabled;
+        out << YAML::Key << "interval_sec" << YAML::Value << config_.mihomo_monitor_interval_sec;
+        out << YAML::Key << "history" << YAML::Value << config_.mihomo_monitor_history;
+        out << YAML::Key << "sustain" << YAML::Value << config_.mihomo_monitor_sustain;
+        out << YAML::Key << "rss_warn_mb" << YAML::Value << config_.mihomo_monitor_rss_warn_mb;
+        out << YAML::Key << "rss_restart_mb" << YAML::Value << config_.mihomo_monitor_rss_restart_mb;
+        out << YAML::Key << "fds_warn" << YAML::Value << config_.mihomo_monitor_fds_warn;
+        out << YAML::Key << "fds_restart" << YAML::Value << config_.mihomo_monitor_fds_restart;
+        out << YAML::Key << "cpu_warn_pct" << YAML::Value << config_.mihomo_monitor_cpu_warn_pct;
+        out << YAML::EndMap;
+
+        // mihomo launch options section
+        out << YAML::Key << "mihomo_launch" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "cpus" << YAML::Value << config_.mihomo_cpus;
+        out << YAML::Key << "nice" << YAML::Value << config_.mihomo_nice;
+        out << YAML::Key << "ionice_class" << YAML::Value << config_.mihomo_ionice_class;
+        out << YAML::Key << "ionice_level" << YAML::Value << config_.mihomo_ionice_level;
+        out << YAML::Key << "nofile" << YAML::Value << config_.mihomo_nofile;
+        out << YAML::Key << "memory_limit_mb" << YAML::Value << config_.mihomo_memory_limit_mb;
+        out << YAML::Key << "gomaxprocs" << YAML::Value << config_.mihomo_gomaxprocs;
+        out << YAML::Key << "gomemlimit_mb" << YAML::Value << config_.mihomo_gomemlimit_mb;
+        out << YAML::EndMap;
+
+        // Throughput section
+        out << YAML::Key << "throughput" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "url" << YAML::Value << config_.throughput_url;
+        out << YAML::Key << "max_bytes" << YAML::Value << config_.throughput_max_bytes;
+        out << YAML::Key << "max_seconds" << YAML::Value << config_.throughput_max_seconds;
+        out << YAML::Key << "concurrency" << YAML::Value << config_.throughput_concurrency;
         out << YAML::EndMap;
 
         out << YAML::EndMap;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,72 @@ struct AppConfig {
 
     // Profiles (daemon mode)
     std::string active_profile;  // name of the currently active profile
+    int profile_max_download_mb = 64;  // larger (decoded) subscription bodies are rejected
+
+    // Subscription auto-update (daemon mode)
+    int auto_update_concurrency = 3;     // downloads running at once
+    int auto_update_jitter_sec = 300;    // random delay spread over due updates
+
+    // Latency database
+    int latency_db_max_records = 4194304;  // 16 bytes each, oldest overwritten
+
+    // Background latency prober (daemon mode)
+    bool prober_enabled = true;
+    double prober_rate_per_sec = 1.0;    // global cap on delay tests
+    int prober_concurrency = 2;
+    int prober_selected_interval_sec = 30;
+    int prober_flaky_interval_sec = 60;
+    int prober_stable_interval_sec = 300;
+    int prober_dead_interval_sec = 600;  // doubled per failure, capped at 1h
+
+    // Auto-select best node for Selector groups (daemon mode, needs prober)
+    std::vector<std::string> auto_select_groups;
+    int auto_select_interval_sec = 30;
+    int auto_select_hysteresis_pct = 20;  // required p95 improvement to switch
+    int auto_select_min_dwell_sec = 300;
+    int auto_select_max_failure_pct = 20;
+
+    // Shared poller of mihomo's controller API (daemon mode)
+    bool controller_cache_enabled = true;
+    int controller_cache_interval_ms = 1000;
+
+    // Profile switches through a standby mihomo (daemon mode)
+    bool blue_green_enabled = false;
+    int blue_green_port_offset = 10000;    // standby listeners/controller during warm-up
+    int blue_green_ready_timeout_sec = 60;  // standby must load and pass its health check
+
+    // Captured mihomo stdout/stderr (daemon mode)
+    int mihomo_log_lines = 2000;           // kept in memory for `mihomo_logs`
+    bool mihomo_log_file_enabled = false;  // also write to <config dir>/logs/mihomo.log
+    int mihomo_log_file_max_kb = 1024;     // rotate past this size
+    int mihomo_log_file_keep = 3;          // rotated files kept (mihomo.log.1 …)
+
+    // mihomo resource sampling from /proc (daemon mode); limits of 0 are off
+    bool mihomo_monitor_enabled = true;
+    int mihomo_monitor_interval_sec = 10;
+    int mihomo_monitor_history = 60;          // samples kept
+    int mihomo_monitor_sustain = 3;           // consecutive samples over a limit before acting
+    int mihomo_monitor_rss_warn_mb = 0;
+    int mihomo_monitor_rss_restart_mb = 0;
+    int mihomo_monitor_fds_warn = 0;
+    int mihomo_monitor_fds_restart = 0;
+    int mihomo_monitor_cpu_warn_pct = 0;      // of one core
+
+    // Applied to mihomo between fork and exec (daemon mode); 0/empty inherit
+    std::string mihomo_cpus;                  // affinity list, e.g. "0-3,6"
+    int mihomo_nice = 0;
+    int mihomo_ionice_class = 0;              // 1 realtime, 2 best-effort, 3 idle
+    int mihomo_ionice_level = 4;              // 0-7
+    int mihomo_nofile = 0;                    // RLIMIT_NOFILE
+    int mihomo_memory_limit_mb = 0;           // RLIMIT_AS
+    int mihomo_gomaxprocs = 0;                // GOMAXPROCS
+    int mihomo_gomemlimit_mb = 0;             // GOMEMLIMIT (Go GC soft limit)
+
+    // Throughput test (through mihomo's mixed port)
+    std::string throughput_url = "https://speed.cloudflare.com/__down?bytes=25000000";
+    int64_t throughput_max_bytes = 10485760;
+    int throughput_max_seconds = 10;
+    int throughput_concurrency = 2;
 };
 
 class Config {
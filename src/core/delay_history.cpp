@@ -0,0 +1,170 @@
+#include "core/delay_history.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+DelayHistory::DelayHistory(size_t capacity)
+    : buf_(capacity > 0 ? capacity : 1) {}
+
+int DelayHistory::bucket_of(int delay) {
+    if (delay < 1000) return delay / 10;
+    if (delay < 10000) return 100 + (delay - 1000) / 100;
+    return kBucketCount - 1;
+}
+
+int DelayHistory::bucket_upper(int bucket) {
+    if (bucket < 100) return (bucket + 1) * 10;
+    if (bucket < kBucketCount - 1) return 1000 + (bucket - 100 + 1) * 100;
+    return 10000;
+}
+
+void DelayHistory::add_stats(uint64_t seq, int delay) {
+    if (delay <= 0) {
+        ++failures_;
+        return;
+    }
+    sum_ += delay;
+    ++ok_count_;
+    ++hist_[bucket_of(delay)];
+
+    while (!min_window_.empty() && min_window_.back().second >= delay) {
+        min_window_.pop_back();
+    }
+    min_window_.emplace_back(seq, delay);
+}
+
+void DelayHistory::remove_stats(uint64_t seq, int delay) {
+    if (delay <= 0) {
+        --failures_;
+        return;
+    }
+    sum_ -= delay;
+    --ok_count_;
+    --hist_[bucket_of(delay)];
+
+    if (!min_window_.empty() && min_window_.front().first == seq) {
+        min_window_.pop_front();
+    }
+}
+
+void DelayHistory::push(int delay, int64_t timestamp_ms) {
+    size_t cap = buf_.size();
+    if (size_ == cap) {
+        // Evict the oldest sample
+        const auto& oldest = buf_[head_];
+        remove_stats(seq_ - size_, oldest.delay);
+        head_ = (head_ + 1) % cap;
+        --size_;
+    }
+
+    buf_[(head_ + size_) % cap] = DelaySample{timestamp_ms, delay};
+    ++size_;
+    add_stats(seq_++, delay);
+}
+
+void DelayHistory::clear() {
+    head_ = 0;
+    size_ = 0;
+    sum_ = 0;
+    ok_count_ = 0;
+    failures_ = 0;
+    hist_.fill(0);
+    min_window_.clear();
+}
+
+void DelayHistory::merge(const std::vector<DelaySample>& incoming) {
+    if (incoming.empty()) return;
+
+    // Each local sample stands in for at most one incoming sample; the
+    // incoming copy wins (mihomo's history carries the test's own time)
+    std::vector<DelaySample> local = samples();
+    std::vector<bool> replaced(local.size(), false);
+    auto same_test = [](const DelaySample& mine, const DelaySample& theirs) {
+        if (mine.delay != theirs.delay) return false;
+        int64_t lag = mine.timestamp_ms - theirs.timestamp_ms;
+        return std::llabs(lag) <= (theirs.delay <= 0 ? kSameFailureToleranceMs
+                                                      : kSameTestToleranceMs);
+    };
+    for (const auto& s : incoming) {
+        for (size_t i = 0; i < local.size(); ++i) {
+            if (!replaced[i] && same_test(local[i], s)) {
+                replaced[i] = true;
+                break;
+            }
+        }
+    }
+
+    std::vector<DelaySample> all(incoming.begin(), incoming.end());
+    for (size_t i = 0; i < local.size(); ++i) {
+        if (!replaced[i]) all.push_back(local[i]);
+    }
+
+    // Stable sort keeps insertion order for equal timestamps
+    std::stable_sort(all.begin(), all.end(),
+        [](const DelaySample& a, const DelaySample& b) {
+            return a.timestamp_ms < b.timestamp_ms;
+        });
+    all.erase(std::unique(all.begin(), all.end(),
+        [](const DelaySample& a, const DelaySample& b) {
+            return a.timestamp_ms == b.timestamp_ms && a.delay == b.delay;
+        }), all.end());
+
+    clear();
+    size_t start = all.size() > buf_.size() ? all.size() - buf_.size() : 0;
+    for (size_t i = start; i < all.size(); ++i) {
+        push(all[i].delay, all[i].timestamp_ms);
+    }
+}
+
+void DelayHistory::merge(const DelayHistory& other) {
+    merge(other.samples());
+}
+
+const DelaySample& DelayHistory::operator[](size_t i) const {
+    return buf_[(head_ + i) % buf_.size()];
+}
+
+const DelaySample& DelayHistory::back() const {
+    return (*this)[size_ - 1];
+}
+
+std::vector<DelaySample> DelayHistory::samples() const {
+    std::vector<DelaySample> out;
+    out.reserve(size_);
+    for (size_t i = 0; i < size_; ++i) {
+        out.push_back((*this)[i]);
+    }
+    return out;
+}
+
+std::vector<int> DelayHistory::recent_delays(size_t count) const {
+    size_t n = std::min(count, size_);
+    std::vector<int> out;
+    out.reserve(n);
+    for (size_t i = size_ - n; i < size_; ++i) {
+        out.push_back((*this)[i].delay);
+    }
+    return out;
+}
+
+int DelayHistory::min() const {
+    if (min_window_.empty()) return -1;
+    return min_window_.front().second;
+}
+
+int DelayHistory::avg() const {
+    if (ok_count_ == 0) return -1;
+    return static_cast<int>(sum_ / ok_count_);
+}
+
+int DelayHistory::p95() const {
+    if (ok_count_ == 0) return -1;
+    // Smallest bucket whose cumulative count covers 95% of the samples
+    int rank = (ok_count_ * 95 + 99) / 100;
+    int seen = 0;
+    for (int b = 0; b < kBucketCount; ++b) {
+        seen += hist_[b];
+        if (seen >= rank) return bucket_upper(b);
+    }
+    return bucket_upper(kBucketCount - 1);
+}
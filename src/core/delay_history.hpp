@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/// A single latency measurement
+struct DelaySample {
+    int64_t timestamp_ms = 0; // unix epoch milliseconds (0 = unknown)
+    int delay = 0;            // 0 = timeout/fail
+};
+
+/// Fixed-capacity ring buffer of delay samples for one proxy node.
+/// Samples are kept oldest-first; pushing into a full buffer overwrites
+/// the oldest entry. Rolling min/avg/p95 over the successful samples in
+/// the window are maintained incrementally and answered in O(1).
+class DelayHistory {
+public:
+    static constexpr size_t kDefaultCapacity = 100;
+
+    /// Samples from different sources with the same delay this close
+    /// together are one test (e.g. a local record and mihomo's own entry)
+    static constexpr int64_t kSameTestToleranceMs = 3000;
+    /// Failures all share delay 0 and may repeat quickly, so they match
+    /// only within this tighter window
+    static constexpr int64_t kSameFailureToleranceMs = 1000;
+
+    explicit DelayHistory(size_t capacity = kDefaultCapacity);
+
+    /// Append a sample, evicting the oldest one when full
+    void push(int delay, int64_t timestamp_ms);
+
+    /// Merge samples (e.g. mihomo's /proxies history) with the local ones.
+    /// Result is ordered by timestamp and only the newest `capacity()`
+    /// samples are kept. An incoming sample replaces a local one with the
+    /// same delay within kSameTestToleranceMs (kSameFailureToleranceMs for
+    /// failures) either way, so a test reported by two sources counts once;
+    /// exact duplicates are dropped.
+    void merge(const std::vector<DelaySample>& samples);
+    void merge(const DelayHistory& other);
+
+    void clear();
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return buf_.size(); }
+
+    /// Sample by age order: 0 = oldest, size()-1 = newest
+    const DelaySample& operator[](size_t i) const;
+    const DelaySample& back() const;
+
+    /// All samples, oldest first
+    std::vector<DelaySample> samples() const;
+
+    /// Delays of the newest `count` samples, oldest first (for sparklines)
+    std::vector<int> recent_delays(size_t count) const;
+
+    // ── Rolling statistics (successful samples only) ─────────
+    /// Minimum delay in the window (-1 if no successful sample)
+    int min() const;
+    /// Mean delay in the window (-1 if no successful sample)
+    int avg() const;
+    /// 95th percentile delay, bucket-resolved (-1 if no successful sample)
+    int p95() const;
+    /// Number of failed samples in the window
+    int failures() const { return failures_; }
+
+private:
+    // Histogram buckets: 10ms up to 1s, 100ms up to 10s, then one overflow bucket
+    static constexpr int kBucketCount = 100 + 90 + 1;
+    static int bucket_of(int delay);
+    static int bucket_upper(int bucket);
+
+    std::vector<DelaySample> buf_;
+    size_t head_ = 0;   // index of the oldest sample
+    size_t size_ = 0;
+    uint64_t seq_ = 0;  // sequence number of the next pushed sample
+
+    // Incremental statistics
+    int64_t sum_ = 0;
+    int ok_count_ = 0;
+    int failures_ = 0;
+    std::array<int, kBucketCount> hist_{};
+    std::deque<std::pair<uint64_t, int>> min_window_; // monotonic (seq, delay)
+
+    void add_stats(uint64_t seq, int delay);
+    void remove_stats(uint64_t seq, int delay);
+};
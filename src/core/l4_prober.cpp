@@ -0,0 +1,352 @@
+#include "core/l4_prober.hpp"
+
+#include <yaml-cpp/yaml.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+int ms_between(Clock::time_point from, Clock::time_point to) {
+    return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count());
+}
+
+struct Address {
+    sockaddr_storage addr{};
+    socklen_t len = 0;
+};
+
+struct Resolved {
+    std::vector<Address> addrs;  // getaddrinfo order, tried in turn
+    std::string error;
+};
+
+// Resolve each host once, in parallel (getaddrinfo blocks)
+std::unordered_map<std::string, Resolved> resolve_all(const std::vector<L4Target>& targets,
+                                                      int thread_count) {
+    std::vector<std::string> hosts;
+    std::unordered_map<std::string, Resolved> out;
+    for (const auto& t : targets) {
+        if (out.emplace(t.host, Resolved{}).second) hosts.push_back(t.host);
+    }
+
+    std::vector<Resolved> resolved(hosts.size());
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < hosts.size(); i = next++) {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* ai = nullptr;
+            int rc = getaddrinfo(hosts[i].c_str(), nullptr, &hints, &ai);
+            if (rc != 0 || !ai) {
+                resolved[i].error = std::string("dns: ") + gai_strerror(rc);
+                continue;
+            }
+            for (addrinfo* p = ai; p; p = p->ai_next) {
+                if (p->ai_family != AF_INET && p->ai_family != AF_INET6) continue;
+                Address a;
+                std::memcpy(&a.addr, p->ai_addr, p->ai_addrlen);
+                a.len = p->ai_addrlen;
+                resolved[i].addrs.push_back(a);
+            }
+            freeaddrinfo(ai);
+            if (resolved[i].addrs.empty()) resolved[i].error = "dns: no usable address";
+        }
+    };
+
+    size_t n = std::min<size_t>(std::max(thread_count, 1), hosts.size());
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < n; ++i) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+
+    for (size_t i = 0; i < hosts.size(); ++i) out[hosts[i]] = std::move(resolved[i]);
+    return out;
+}
+
+// Describe and clear the thread's OpenSSL error queue, which every
+// connection on this thread shares
+std::string take_ssl_error() {
+    unsigned long e = ERR_get_error();
+    std::string msg = "tls handshake failed";
+    if (e != 0) {
+        char buf[256];
+        ERR_error_string_n(e, buf, sizeof(buf));
+        msg += std::string(": ") + buf;
+    }
+    ERR_clear_error();
+    return msg;
+}
+
+bool is_ip_literal(const std::string& host) {
+    in6_addr buf;
+    return inet_pton(AF_INET, host.c_str(), &buf) == 1 ||
+           inet_pton(AF_INET6, host.c_str(), &buf) == 1;
+}
+
+} // namespace
+
+L4Prober::L4Prober(Options opts) : opts_(opts) {
+    if (opts_.concurrency < 1) opts_.concurrency = 1;
+    if (opts_.timeout_ms < 1) opts_.timeout_ms = 1;
+}
+
+std::vector<L4Result> L4Prober::run(const std::vector<L4Target>& targets,
+                                    const std::function<void(const L4Result&)>& on_result) {
+    std::vector<L4Result> results(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) results[i].name = targets[i].name;
+    if (targets.empty()) return results;
+
+    auto resolved = resolve_all(targets, opts_.resolver_threads);
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        for (auto& r : results) r.error = "epoll unavailable";
+        return results;
+    }
+
+    SSL_CTX* ctx = nullptr;
+    if (opts_.tls) {
+        ctx = SSL_CTX_new(TLS_client_method());
+        // Only the handshake time matters; many nodes use self-signed certs
+        if (ctx) SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, nullptr);
+    }
+
+    struct Conn {
+        size_t idx = 0;
+        size_t addr = 0;                 // index into the target's addresses
+        Clock::time_point start;         // first attempt (timeout runs from here)
+        Clock::time_point attempt;       // connect to the current address
+        Clock::time_point connected;
+        SSL* ssl = nullptr;
+        bool handshaking = false;
+    };
+    std::unordered_map<int, Conn> active;
+
+    auto report = [&](size_t idx) {
+        if (on_result) on_result(results[idx]);
+    };
+
+    // Close a connection and record its outcome (caller erases it)
+    auto finish = [&](int fd, Conn& c, bool ok, const std::string& error) {
+        epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+        if (c.ssl) SSL_free(c.ssl);
+        close(fd);
+        results[c.idx].success = ok;
+        results[c.idx].error = error;
+        report(c.idx);
+    };
+
+    // Connect to the target's addresses from `addr_index` on until one is
+    // in progress (added to `active`); false with `error` set if none is
+    auto connect_from = [&](size_t idx, size_t addr_index, Clock::time_point start,
+                            std::string& error) -> bool {
+        const auto& t = targets[idx];
+        const auto& addrs = resolved[t.host].addrs;
+        for (size_t i = addr_index; i < addrs.size(); ++i) {
+            sockaddr_storage addr = addrs[i].addr;
+            if (addr.ss_family == AF_INET) {
+                reinterpret_cast<sockaddr_in*>(&addr)->sin_port = htons(t.port);
+            } else {
+                reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port = htons(t.port);
+            }
+
+            int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                error = std::strerror(errno);
+                continue;
+            }
+
+            Conn c;
+            c.idx = idx;
+            c.addr = i;
+            c.start = start;
+            c.attempt = Clock::now();
+            if (connect(fd, reinterpret_cast<sockaddr*>(&addr), addrs[i].len) < 0 &&
+                errno != EINPROGRESS) {
+                error = std::strerror(errno);
+                close(fd);
+                continue;
+            }
+
+            epoll_event ev{};
+            ev.events = EPOLLOUT;
+            ev.data.fd = fd;
+            if (epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                error = std::strerror(errno);
+                close(fd);
+                continue;
+            }
+            active.emplace(fd, c);
+            return true;
+        }
+        return false;
+    };
+
+    auto start_one = [&](size_t idx) {
+        const auto& t = targets[idx];
+        auto& r = results[idx];
+        if (t.port <= 0 || t.port > 65535) {
+            r.error = "invalid port";
+            report(idx);
+            return;
+        }
+        const auto& rv = resolved[t.host];
+        if (!rv.error.empty()) {
+            r.error = rv.error;
+            report(idx);
+            return;
+        }
+        if (!connect_from(idx, 0, Clock::now(), r.error)) report(idx);
+    };
+
+    // Advance one connection on readiness; true when `fd` is done (closed,
+    // possibly replaced in `active` by a connect to the next address)
+    auto step = [&](int fd, Conn& c) -> bool {
+        const auto& t = targets[c.idx];
+        auto& r = results[c.idx];
+
+        if (!c.handshaking) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                // The old socket stays open until the next one exists, so
+                // the two never share an fd number in `active`
+                std::string error = std::strerror(err);
+                if (connect_from(c.idx, c.addr + 1, c.start, error)) {
+                    epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+                    close(fd);
+                } else {
+                    finish(fd, c, false, error);
+                }
+                return true;
+            }
+            c.connected = Clock::now();
+            r.connect_ms = ms_between(c.attempt, c.connected);
+
+            if (!ctx || !t.tls) {
+                finish(fd, c, true, "");
+                return true;
+            }
+            c.ssl = SSL_new(ctx);
+            if (!c.ssl) {
+                finish(fd, c, false, "tls: out of memory");
+                return true;
+            }
+            SSL_set_fd(c.ssl, fd);
+            std::string sni = t.sni.empty() ? t.host : t.sni;
+            if (!is_ip_literal(sni)) SSL_set_tlsext_host_name(c.ssl, sni.c_str());
+            SSL_set_connect_state(c.ssl);
+            c.handshaking = true;
+        }
+
+        // A stale error left by another connection would turn this one's
+        // WANT_READ/WANT_WRITE into SSL_ERROR_SSL
+        ERR_clear_error();
+        int rc = SSL_do_handshake(c.ssl);
+        if (rc == 1) {
+            r.tls_ms = ms_between(c.connected, Clock::now());
+            finish(fd, c, true, "");
+            return true;
+        }
+
+        epoll_event ev{};
+        ev.data.fd = fd;
+        switch (SSL_get_error(c.ssl, rc)) {
+            case SSL_ERROR_WANT_READ:
+                ev.events = EPOLLIN;
+                break;
+            case SSL_ERROR_WANT_WRITE:
+                ev.events = EPOLLOUT;
+                break;
+            default:
+                finish(fd, c, false, take_ssl_error());
+                return true;
+        }
+        epoll_ctl(ep, EPOLL_CTL_MOD, fd, &ev);
+        return false;
+    };
+
+    std::vector<epoll_event> events(std::min(opts_.concurrency, 1024));
+    size_t next_target = 0;
+
+    while (next_target < targets.size() || !active.empty()) {
+        while ((int)active.size() < opts_.concurrency && next_target < targets.size()) {
+            start_one(next_target++);
+        }
+        if (active.empty()) continue;
+
+        // Sleep until the earliest deadline at most
+        auto now = Clock::now();
+        int wait = opts_.timeout_ms;
+        for (const auto& [fd, c] : active) {
+            wait = std::min(wait, opts_.timeout_ms - ms_between(c.start, now));
+        }
+        int n = epoll_wait(ep, events.data(), (int)events.size(), std::max(wait, 0));
+
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            auto it = active.find(fd);
+            if (it == active.end()) continue;
+            // By key: a replacement connect may have rehashed the map
+            if (step(fd, it->second)) active.erase(fd);
+        }
+
+        now = Clock::now();
+        for (auto it = active.begin(); it != active.end();) {
+            if (ms_between(it->second.start, now) >= opts_.timeout_ms) {
+                finish(it->first, it->second, false,
+                       it->second.handshaking ? "tls timeout" : "timeout");
+                it = active.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (ctx) SSL_CTX_free(ctx);
+    close(ep);
+    return results;
+}
+
+std::vector<L4Target> L4Prober::targets_from_profile(const std::string& yaml_path) {
+    std::vector<L4Target> targets;
+    try {
+        YAML::Node root = YAML::LoadFile(yaml_path);
+        auto proxies = root["proxies"];
+        if (!proxies || !proxies.IsSequence()) return targets;
+
+        for (const auto& p : proxies) {
+            std::string type = p["type"].as<std::string>("");
+            if (type == "hysteria" || type == "hysteria2" || type == "tuic" ||
+                type == "wireguard") {
+                continue;  // UDP transports: no TCP handshake to time
+            }
+
+            L4Target t;
+            t.name = p["name"].as<std::string>("");
+            t.host = p["server"].as<std::string>("");
+            t.port = p["port"].as<int>(0);
+            if (t.name.empty() || t.host.empty()) continue;
+            t.tls = type == "trojan" || type == "anytls" || p["tls"].as<bool>(false);
+            t.sni = p["sni"].as<std::string>(p["servername"].as<std::string>(""));
+            targets.push_back(std::move(t));
+        }
+    } catch (...) {}
+    return targets;
+}
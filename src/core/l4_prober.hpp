@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// One server to probe
+struct L4Target {
+    std::string name;
+    std::string host;
+    int port = 0;
+    bool tls = false;    // node speaks TLS on this port
+    std::string sni;     // empty = host
+};
+
+/// Result of a raw TCP (and optional TLS) handshake
+struct L4Result {
+    std::string name;
+    bool success = false;
+    std::string error;
+    int connect_ms = -1;   // TCP three-way handshake
+    int tls_ms = -1;       // TLS handshake after connect (-1 = not done)
+
+    /// Total handshake time as a delay value (0 = failed)
+    int delay() const {
+        if (!success) return 0;
+        return std::max(1, connect_ms + (tls_ms > 0 ? tls_ms : 0));
+    }
+};
+
+/// Pre-screening prober that talks to node servers directly instead of
+/// going through mihomo's delay API.
+///
+/// Host names are resolved up front by a small thread pool, then a single
+/// epoll loop drives up to `concurrency` non-blocking connects (and, when
+/// enabled, non-blocking OpenSSL handshakes) at once. Only reachability of
+/// the server is measured, not the proxy protocol behind it.
+class L4Prober {
+public:
+    struct Options {
+        int concurrency = 512;
+        int timeout_ms = 3000;     // per target, connect + TLS
+        bool tls = false;          // handshake TLS for targets marked `tls`
+        int resolver_threads = 32;
+    };
+
+    explicit L4Prober(Options opts);
+
+    /// Probe all targets; results are in target order. `on_result` is
+    /// called from the probing thread as each target finishes.
+    std::vector<L4Result> run(const std::vector<L4Target>& targets,
+                              const std::function<void(const L4Result&)>& on_result = nullptr);
+
+    /// Read TCP-based proxies (server/port) from a mihomo profile YAML.
+    /// UDP-only protocols (hysteria, tuic, wireguard) are skipped.
+    static std::vector<L4Target> targets_from_profile(const std::string& yaml_path);
+
+private:
+    Options opts_;
+};
@@ -0,0 +1,403 @@
+#include "core/latency_store.hpp"
+#include "core/config.hpp"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'T', 'L', 'A', 'T', 'D', 'B', '1'};
+constexpr uint32_t kVersion = 1;
+// Bound on a header's capacity, so a corrupt one cannot overflow the file size
+constexpr uint64_t kMaxCapacity = 1ull << 32;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    uint64_t count;        // total records ever appended
+    uint8_t reserved[32];
+};
+static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 bytes");
+
+// RAII flock() guard
+class FileLock {
+public:
+    FileLock(int fd, int op) : fd_(fd) { locked_ = (flock(fd_, op) == 0); }
+    ~FileLock() { if (locked_) flock(fd_, LOCK_UN); }
+    bool locked() const { return locked_; }
+private:
+    int fd_;
+    bool locked_ = false;
+};
+
+int percentile(const std::vector<uint16_t>& sorted, int pct) {
+    if (sorted.empty()) return -1;
+    size_t rank = (sorted.size() * pct + 99) / 100;
+    if (rank == 0) rank = 1;
+    return sorted[rank - 1];
+}
+
+} // namespace
+
+LatencyStore::LatencyStore(const std::string& path, uint64_t capacity)
+    : path_(path), requested_capacity_(capacity > 0 ? capacity : kDefaultCapacity) {}
+
+LatencyStore::~LatencyStore() {
+    if (map_) munmap(map_, map_size_);
+    if (fd_ >= 0) close(fd_);
+}
+
+std::string LatencyStore::default_path() {
+    std::string dir = Config::config_dir();
+    if (dir.empty()) return "";
+    return dir + "/latency.db";
+}
+
+uint64_t LatencyStore::node_id(const std::string& name, const std::string& profile) {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const std::string& s) {
+        for (unsigned char c : s) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+    };
+    if (!profile.empty()) {
+        mix(profile);
+        mix(std::string(1, '\0'));  // separator: cannot occur in either part
+    }
+    mix(name);
+    return hash;
+}
+
+bool LatencyStore::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_locked();
+}
+
+bool LatencyStore::is_open() const {
+    return map_ != nullptr;
+}
+
+bool LatencyStore::open_locked() {
+    if (map_) return true;
+    if (path_.empty()) return false;
+
+    try {
+        fs::create_directories(fs::path(path_).parent_path());
+    } catch (...) {}
+
+    // Header of a new store (or one replacing a short file)
+    auto fresh_header = [this]() {
+        FileHeader h{};
+        std::memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.record_size = sizeof(LatencyRecord);
+        h.capacity = requested_capacity_;
+        h.count = 0;
+        return h;
+    };
+    auto file_size = [](const FileHeader& h) {
+        return static_cast<off_t>(sizeof(FileHeader) + h.capacity * sizeof(LatencyRecord));
+    };
+
+    enum class Prep { Ok, Fail, Reopen };
+    FileHeader header{};
+    bool writable = true;
+    int fd = -1;
+
+    // Validate (or initialize) an opened file under its lock. A file that
+    // another process replaced meanwhile is reopened. Closing is left to
+    // the caller, after the lock on that fd is released.
+    auto prepare = [&](int& cur_fd, int& stale_fd) -> Prep {
+        FileLock flk(cur_fd, writable ? LOCK_EX : LOCK_SH);
+        struct stat st{};
+        if (fstat(cur_fd, &st) != 0) return Prep::Fail;
+        struct stat named{};
+        if (::stat(path_.c_str(), &named) != 0 ||
+            named.st_ino != st.st_ino || named.st_dev != st.st_dev) {
+            return Prep::Reopen;
+        }
+
+        if (st.st_size < (off_t)sizeof(FileHeader)) {
+            if (!writable) return Prep::Fail;
+            // Fresh file: write header and size it (sparse until filled)
+            header = fresh_header();
+            if (pwrite(cur_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+                ftruncate(cur_fd, file_size(header)) != 0) {
+                return Prep::Fail;
+            }
+            return Prep::Ok;
+        }
+        if (pread(cur_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            return Prep::Fail;
+        }
+
+        if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+            header.version != kVersion ||
+            header.record_size != sizeof(LatencyRecord) ||
+            header.capacity == 0 ||
+            header.capacity > kMaxCapacity) {
+            return Prep::Fail;
+        }
+
+        // Mapping past the end of the file would SIGBUS on the first access
+        // (a failed ftruncate, or a file truncated since). Start over in a
+        // new file renamed into place: shrinking this one would SIGBUS the
+        // processes that have it mapped, which keep their old inode instead.
+        if (st.st_size < file_size(header)) {
+            if (!writable) return Prep::Fail;
+            header = fresh_header();
+            std::string tmp = path_ + ".tmp." + std::to_string(getpid());
+            int nfd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (nfd < 0) return Prep::Fail;
+            if (pwrite(nfd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+                ftruncate(nfd, file_size(header)) != 0 ||
+                ::rename(tmp.c_str(), path_.c_str()) != 0) {
+                close(nfd);
+                ::unlink(tmp.c_str());
+                return Prep::Fail;
+            }
+            // Still under the old file's lock, so anyone waiting on it sees
+            // the rename and reopens
+            stale_fd = cur_fd;
+            cur_fd = nfd;
+        }
+        return Prep::Ok;
+    };
+
+    for (int attempt = 0;; ++attempt) {
+        writable = true;
+        fd = ::open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            // e.g. a non-root client reading the daemon's store
+            fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+            writable = false;
+        }
+        if (fd < 0) return false;
+
+        int stale_fd = -1;
+        Prep prep = prepare(fd, stale_fd);
+        if (stale_fd >= 0) close(stale_fd);
+        if (prep == Prep::Ok) break;
+        close(fd);
+        if (prep == Prep::Fail || attempt >= 3) return false;
+    }
+
+    // An existing file keeps its own capacity
+    size_t size = sizeof(FileHeader) + header.capacity * sizeof(LatencyRecord);
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* map = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    map_ = map;
+    map_size_ = size;
+    writable_ = writable;
+    load_names();
+    return true;
+}
+
+void LatencyStore::load_names() {
+    std::ifstream in(path_ + ".names");
+    std::string line;
+    while (std::getline(in, line)) {
+        auto tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        try {
+            uint64_t id = std::stoull(line.substr(0, tab), nullptr, 16);
+            // "<id>\t<name>" (no profile) or "<id>\t<profile>\t<name>"
+            std::string rest = line.substr(tab + 1);
+            auto sep = rest.find('\t');
+            if (sep == std::string::npos) {
+                names_.emplace(id, NodeName{"", rest});
+            } else {
+                names_.emplace(id, NodeName{rest.substr(0, sep), rest.substr(sep + 1)});
+            }
+        } catch (...) {}
+    }
+}
+
+void LatencyStore::remember_name(uint64_t id, const std::string& name,
+                                 const std::string& profile) {
+    if (names_.count(id)) return;
+    names_.emplace(id, NodeName{profile, name});
+
+    // Single O_APPEND write per line keeps concurrent writers from interleaving
+    std::ostringstream oss;
+    oss << std::hex << id << '\t';
+    if (!profile.empty()) oss << profile << '\t';
+    oss << name << '\n';
+    std::string line = oss.str();
+    int fd = ::open((path_ + ".names").c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) return;
+    ssize_t n = write(fd, line.data(), line.size());
+    (void)n;
+    close(fd);
+}
+
+bool LatencyStore::append(const std::string& name, int delay_ms, int64_t timestamp,
+                          uint16_t flags, const std::string& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_locked() || !writable_) return false;
+
+    auto* header = static_cast<FileHeader*>(map_);
+    auto* records = reinterpret_cast<LatencyRecord*>(header + 1);
+
+    LatencyRecord rec;
+    rec.node_id = node_id(name, profile);
+    rec.timestamp = static_cast<uint32_t>(timestamp > 0 ? timestamp : std::time(nullptr));
+    rec.delay_ms = static_cast<uint16_t>(std::clamp(delay_ms, 0, 65535));
+    rec.flags = flags;
+
+    {
+        FileLock flk(fd_, LOCK_EX);
+        if (!flk.locked()) return false;
+        uint64_t count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+        records[count % header->capacity] = rec;
+        __atomic_store_n(&header->count, count + 1, __ATOMIC_RELEASE);
+    }
+
+    remember_name(rec.node_id, name, profile);
+    return true;
+}
+
+uint64_t LatencyStore::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_locked()) return 0;
+    auto* header = static_cast<FileHeader*>(map_);
+    uint64_t count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+    return std::min(count, header->capacity);
+}
+
+uint64_t LatencyStore::capacity() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_locked()) return 0;
+    return static_cast<FileHeader*>(map_)->capacity;
+}
+
+const std::unordered_map<uint64_t, LatencyStats>& LatencyStore::scan(int64_t since, uint16_t flags) {
+    auto* header = static_cast<FileHeader*>(map_);
+    auto* records = reinterpret_cast<const LatencyRecord*>(header + 1);
+
+    uint64_t count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+    if (cache_.valid && cache_.count == count && cache_.since == since && cache_.flags == flags) {
+        return cache_.by_id;
+    }
+
+    struct Acc {
+        std::vector<uint16_t> delays;
+        size_t failures = 0;
+        int64_t first = 0;
+        int64_t last = 0;
+    };
+    std::unordered_map<uint64_t, Acc> acc;
+
+    {
+        FileLock flk(fd_, LOCK_SH);
+        count = __atomic_load_n(&header->count, __ATOMIC_ACQUIRE);
+        uint64_t n = std::min(count, header->capacity);
+        for (uint64_t i = 0; i < n; ++i) {
+            const auto& rec = records[i];
+            if ((int64_t)rec.timestamp < since) continue;
+            if (rec.flags != flags) continue;
+            auto& a = acc[rec.node_id];
+            if (rec.delay_ms == 0) {
+                ++a.failures;
+            } else {
+                a.delays.push_back(rec.delay_ms);
+            }
+            if (a.first == 0 || rec.timestamp < a.first) a.first = rec.timestamp;
+            if (rec.timestamp > a.last) a.last = rec.timestamp;
+        }
+    }
+
+    cache_.by_id.clear();
+    for (auto& [id, a] : acc) {
+        LatencyStats st;
+        st.samples = a.delays.size() + a.failures;
+        st.failures = a.failures;
+        st.first_seen = a.first;
+        st.last_seen = a.last;
+        if (!a.delays.empty()) {
+            std::sort(a.delays.begin(), a.delays.end());
+            int64_t sum = 0;
+            for (auto d : a.delays) sum += d;
+            st.min = a.delays.front();
+            st.avg = static_cast<int>(sum / (int64_t)a.delays.size());
+            st.p50 = percentile(a.delays, 50);
+            st.p95 = percentile(a.delays, 95);
+            st.p99 = percentile(a.delays, 99);
+        }
+        cache_.by_id.emplace(id, std::move(st));
+    }
+    cache_.valid = true;
+    cache_.count = count;
+    cache_.since = since;
+    cache_.flags = flags;
+    return cache_.by_id;
+}
+
+std::map<std::string, LatencyStats> LatencyStore::select(
+        const std::unordered_map<uint64_t, std::string>& wanted, int64_t since, uint16_t flags) {
+    std::map<std::string, LatencyStats> result;
+    if (wanted.empty()) return result;
+    const auto& by_id = scan(since, flags);
+    for (const auto& [id, name] : wanted) {
+        auto it = by_id.find(id);
+        if (it == by_id.end()) continue;
+        LatencyStats st = it->second;
+        st.name = name;
+        result[name] = std::move(st);
+    }
+    return result;
+}
+
+std::map<std::string, LatencyStats> LatencyStore::stats(const std::vector<std::string>& names,
+                                                        int64_t since, uint16_t flags,
+                                                        const std::string& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_locked()) return {};
+    std::unordered_map<uint64_t, std::string> wanted;
+    for (const auto& n : names) wanted.emplace(node_id(n, profile), n);
+    return select(wanted, since, flags);
+}
+
+std::map<std::string, LatencyStats> LatencyStore::stats_all(int64_t since, uint16_t flags,
+                                                            const std::string& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_locked()) return {};
+    load_names();  // pick up names recorded by other processes
+    std::unordered_map<uint64_t, std::string> wanted;
+    for (const auto& [id, n] : names_) {
+        if (n.profile == profile) wanted.emplace(id, n.name);
+    }
+    return select(wanted, since, flags);
+}
+
+std::vector<std::string> LatencyStore::known_nodes(const std::string& profile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> out;
+    if (!open_locked()) return out;
+    load_names();
+    for (const auto& [id, n] : names_) {
+        if (n.profile == profile) out.push_back(n.name);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// One on-disk latency sample (16 bytes, fixed size)
+struct LatencyRecord {
+    uint64_t node_id = 0;    // LatencyStore::node_id(name, profile)
+    uint32_t timestamp = 0;  // unix epoch seconds
+    uint16_t delay_ms = 0;   // 0 = timeout/fail
+    uint16_t flags = 0;      // probe kind: 0 = mihomo delay test, kLatencyFlagL4 = raw handshake
+};
+
+/// LatencyRecord::flags value for raw TCP/TLS handshake samples
+constexpr uint16_t kLatencyFlagL4 = 1;
+static_assert(sizeof(LatencyRecord) == 16, "LatencyRecord must stay 16 bytes");
+
+/// Long-term statistics for one node
+struct LatencyStats {
+    std::string name;
+    size_t samples = 0;
+    size_t failures = 0;
+    int min = -1;
+    int avg = -1;
+    int p50 = -1;
+    int p95 = -1;
+    int p99 = -1;
+    int64_t first_seen = 0;  // unix seconds of the oldest sample
+    int64_t last_seen = 0;   // unix seconds of the newest sample
+};
+
+/// Append-only latency database shared by the TUI, CLI and daemon.
+///
+/// The file is a small header followed by a fixed number of 16-byte record
+/// slots, memory-mapped MAP_SHARED. Appends take an exclusive flock() and
+/// wrap around once the file is full, so the oldest samples are overwritten
+/// and disk usage is bounded by `capacity * 16` bytes (the file is sparse
+/// until filled). Nodes are keyed by profile and name, since subscriptions
+/// often reuse names like "HK 01"; an empty profile is the key samples
+/// recorded before profiles were tracked still use. Names are kept in a
+/// side file (`<path>.names`) so hashed ids can be mapped back for listing.
+class LatencyStore {
+public:
+    /// ~4M samples (64 MiB): e.g. 3000 nodes probed hourly for two months
+    static constexpr uint64_t kDefaultCapacity = 4ull * 1024 * 1024;
+
+    explicit LatencyStore(const std::string& path = default_path(),
+                          uint64_t capacity = kDefaultCapacity);
+    ~LatencyStore();
+
+    LatencyStore(const LatencyStore&) = delete;
+    LatencyStore& operator=(const LatencyStore&) = delete;
+
+    /// Default location: <config_dir>/latency.db
+    static std::string default_path();
+
+    /// Stable 64-bit id for a node of a profile (FNV-1a)
+    static uint64_t node_id(const std::string& name, const std::string& profile = "");
+
+    /// Open (creating if needed) and map the file. Called lazily by the
+    /// other methods; returns false if the store is unusable.
+    bool open();
+    bool is_open() const;
+    const std::string& path() const { return path_; }
+
+    /// Append a sample. timestamp 0 = now. delay <= 0 is recorded as failure.
+    bool append(const std::string& name, int delay_ms, int64_t timestamp = 0,
+                uint16_t flags = 0, const std::string& profile = "");
+
+    /// Number of records currently held (<= capacity)
+    uint64_t size();
+    uint64_t capacity();
+
+    /// Statistics for the given nodes of `profile` over samples newer than
+    /// `since` (unix seconds, 0 = everything) of one probe kind (`flags`).
+    /// One pass over the file, reused until a sample is appended.
+    std::map<std::string, LatencyStats> stats(const std::vector<std::string>& names,
+                                              int64_t since = 0, uint16_t flags = 0,
+                                              const std::string& profile = "");
+
+    /// Statistics for every node of `profile` that has samples since `since`
+    std::map<std::string, LatencyStats> stats_all(int64_t since = 0, uint16_t flags = 0,
+                                                  const std::string& profile = "");
+
+    /// All node names ever recorded for `profile`
+    std::vector<std::string> known_nodes(const std::string& profile = "");
+
+private:
+    std::string path_;
+    uint64_t requested_capacity_;
+    int fd_ = -1;
+    void* map_ = nullptr;
+    size_t map_size_ = 0;
+    bool writable_ = false;
+    std::mutex mutex_;
+
+    // id → profile and name, loaded from / appended to the side file
+    struct NodeName {
+        std::string profile;
+        std::string name;
+    };
+    std::unordered_map<uint64_t, NodeName> names_;
+    void load_names();
+    void remember_name(uint64_t id, const std::string& name, const std::string& profile);
+
+    // Per-node statistics of the last scan, valid while the record count
+    // (the header's append counter) and the query are unchanged
+    struct ScanCache {
+        bool valid = false;
+        uint64_t count = 0;
+        int64_t since = 0;
+        uint16_t flags = 0;
+        std::unordered_map<uint64_t, LatencyStats> by_id;  // names unset
+    };
+    ScanCache cache_;
+
+    bool open_locked();
+    /// Statistics of every node id, from cache_ or a fresh pass
+    const std::unordered_map<uint64_t, LatencyStats>& scan(int64_t since, uint16_t flags);
+    std::map<std::string, LatencyStats> select(
+        const std::unordered_map<uint64_t, std::string>& wanted, int64_t since, uint16_t flags);
+};
@@ -3,6 +3,10 @@
 #include "core/subscription.hpp"
 
 #include <yaml-cpp/yaml.h>
+#include <yaml-cpp/eventhandler.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <chrono>
@@ -72,28 +76,50 @@ std::string ProfileManager::now_timestamp() {
     return oss.str();
 }
 
+bool ProfileManager::stamp_file(const std::string& path, FileStamp& out) {
+    struct stat st{};
+    if (::stat(path.c_str(), &st) != 0) return false;
+    out.dev = static_cast<uint64_t>(st.st_dev);
+    out.ino = static_cast<uint64_t>(st.st_ino);
+    out.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    out.size = static_cast<int64_t>(st.st_size);
+    return true;
+}
+
 std::vector<ProfileInfo> ProfileManager::load_metadata() const {
     std::vector<ProfileInfo> profiles;
     std::string path = metadata_path();
-    if (path.empty() || !fs::exists(path)) return profiles;
-
-    try {
-        YAML::Node root = YAML::LoadFile(path);
-        if (!root.IsSequence()) return profiles;
-
-        for (const auto& node : root) {
-            ProfileInfo info;
-            info.name = node["name"].as<std::string>("");
-            info.filename = node["filename"].as<std::string>("");
-            info.source_url = node["source_url"].as<std::string>("");
-            info.last_updated = node["last_updated"].as<std::string>("");
-            info.auto_update = node["auto_update"].as<bool>(true);
-            info.update_interval_hours = node["update_interval_hours"].as<int>(24);
-            info.is_active = (info.name == config_.data().active_profile);
-            profiles.push_back(std::move(info));
-        }
-    } catch (...) {}
+    FileStamp stamp;
+    if (path.empty() || !stamp_file(path, stamp)) return profiles;
+
+    std::lock_guard<std::mutex> lock(meta_mutex_);
+    if (meta_cache_.valid && meta_cache_.path == path && meta_cache_.stamp == stamp) {
+        profiles = meta_cache_.profiles;
+    } else {
+        try {
+            YAML::Node root = YAML::LoadFile(path);
+            if (root.IsSequence()) {
+                for (const auto& node : root) {
+                    ProfileInfo info;
+                    info.name = node["name"].as<std::string>("");
+                    info.filename = node["filename"].as<std::string>("");
+                    info.source_url = node["source_url"].as<std::string>("");
+                    info.last_updated = node["last_updated"].as<std::string>("");
+                    info.auto_update = node["auto_update"].as<bool>(true);
+                    info.update_interval_hours = node["update_interval_hours"].as<int>(24);
+                    info.etag = node["etag"].as<std::string>("");
+                    info.last_modified = node["last_modified"].as<std::string>("");
+                    info.content_hash = node["content_hash"].as<std::string>("");
+                    profiles.push_back(std::move(info));
+                }
+            }
+        } catch (...) {}
+        // Replaced during the parse: the next stamp won't match, so it reloads
+        meta_cache_ = {true, path, stamp, profiles};
+    }
 
+    // The active profile lives in the config, not in the cached file
+    for (auto& p : profiles) p.is_active = (p.name == config_.data().active_profile);
     return profiles;
 }
 
@@ -115,6 +141,13 @@ bool ProfileManager::save_metadata(const std::vector<ProfileInfo>& profiles) con
             out << YAML::Key << "last_updated" << YAML::Value << p.last_updated;
             out << YAML::Key << "auto_update" << YAML::Value << p.auto_update;
             out << YAML::Key << "update_interval_hours" << YAML::Value << p.update_interval_hours;
+            if (!p.etag.empty()) out << YAML::Key << "etag" << YAML::Value << p.etag;
+            if (!p.last_modified.empty()) {
+                out << YAML::Key << "last_modified" << YAML::Value << p.last_modified;
+            }
+            if (!p.content_hash.empty()) {
+                out << YAML::Key << "content_hash" << YAML::Value << p.content_hash;
+            }
             out << YAML::EndMap;
         }
         out << YAML::EndSeq;
@@ -126,7 +159,15 @@ bool ProfileManager::save_metadata(const std::vector<ProfileInfo>& profiles) con
         fout << out.c_str();
         fout.close();
         if (fout.fail()) return false;
+        // Stamped before the rename (which keeps inode and mtime), so a
+        // concurrent writer's file is never mistaken for ours
+        FileStamp stamp;
+        bool stamped = stamp_file(tmp, stamp);
         fs::rename(tmp, path);
+
+        // What we just wrote is what the next load would parse
+        std::lock_guard<std::mutex> lock(meta_mutex_);
+        meta_cache_ = {stamped, path, stamp, profiles};
         return true;
     } catch (...) {
         return false;
@@ -137,7 +178,123 @@ std::vector<ProfileInfo> ProfileManager::list_profiles() const {
     return load_metadata();
 }
 
-ProfileManager::AddResult ProfileManager::add_profile(const std::string& name, const std::string& url) {
+namespace {
+
+/// Notes whether the first document's root is a mapping. Parsing to events
+/// validates the YAML without building a node tree for the whole profile.
+class RootKindHandler : public YAML::EventHandler {
+public:
+    bool root_is_map = false;
+
+    void OnDocumentStart(const YAML::Mark&) override {}
+    void OnDocumentEnd() override {}
+    void OnNull(const YAML::Mark&, YAML::anchor_t) override { root(false); }
+    void OnAlias(const YAML::Mark&, YAML::anchor_t) override { root(false); }
+    void OnScalar(const YAML::Mark&, const std::string&, YAML::anchor_t,
+                  const std::string&) override { root(false); }
+    void OnSequenceStart(const YAML::Mark&, const std::string&, YAML::anchor_t,
+                         YAML::EmitterStyle::value) override { root(false); ++depth_; }
+    void OnSequenceEnd() override { --depth_; }
+    void OnMapStart(const YAML::Mark&, const std::string&, YAML::anchor_t,
+                    YAML::EmitterStyle::value) override { root(true); ++depth_; }
+    void OnMapEnd() override { --depth_; }
+
+private:
+    int depth_ = 0;
+    bool seen_ = false;
+    void root(bool is_map) {
+        if (depth_ == 0 && !seen_) {
+            seen_ = true;
+            root_is_map = is_map;
+        }
+    }
+};
+
+/// Empty if the file holds a YAML mapping, else why not
+std::string check_profile_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return "Cannot read downloaded profile";
+    try {
+        YAML::Parser parser(in);
+        RootKindHandler handler;
+        parser.HandleNextDocument(handler);
+        if (!handler.root_is_map) return "Invalid profile: not a YAML mapping";
+    } catch (const std::exception& e) {
+        return std::string("Invalid profile: ") + e.what();
+    }
+    return "";
+}
+
+} // namespace
+
+std::string ProfileManager::staging_path(const std::string& name) const {
+    static std::atomic<uint64_t> counter{0};
+    std::string dir = profiles_dir();
+    if (dir.empty()) return "";
+    return dir + "/." + sanitize_filename(name) + "." + std::to_string(getpid()) + "-" +
+           std::to_string(++counter) + ".part";
+}
+
+int64_t ProfileManager::max_download_bytes() const {
+    return static_cast<int64_t>(std::max(0, config_.data().profile_max_download_mb)) * 1024 * 1024;
+}
+
+std::string ProfileManager::fetch_profile(const std::string& url, const std::string& staged,
+                                          const Progress& progress, FetchCache& cache,
+                                          int64_t max_bytes) {
+    cache.unchanged = false;
+    if (staged.empty()) return "Cannot determine profiles directory";
+    try {
+        fs::create_directories(fs::path(staged).parent_path());
+    } catch (...) {
+        return "Cannot create profiles directory";
+    }
+
+    Subscription::Validators since;
+    since.etag = cache.etag;
+    since.last_modified = cache.last_modified;
+    auto dl = Subscription::download(url, staged, [&](int64_t received, int64_t total) {
+        return !progress || progress("download", received, total);
+    }, since, max_bytes);
+    if (!dl.success) return dl.error;
+
+    cache.etag = dl.etag;
+    cache.last_modified = dl.last_modified;
+    if (dl.not_modified) {
+        cache.unchanged = true;
+        return "";
+    }
+
+    // Servers without validators still often send the same bytes
+    auto discard = [&]() {
+        try { fs::remove(staged); } catch (...) {}
+    };
+    cache.unchanged = !dl.content_hash.empty() && dl.content_hash == cache.content_hash;
+    cache.content_hash = dl.content_hash;
+    if (cache.unchanged) {
+        discard();
+        return "";
+    }
+
+    if (progress && !progress("parse", 0, 0)) {
+        discard();
+        return "Cancelled";
+    }
+    std::string error = check_profile_file(staged);
+    if (!error.empty()) {
+        discard();
+        return error;
+    }
+
+    if (progress && !progress("save", 0, 0)) {
+        discard();
+        return "Cancelled";
+    }
+    return "";
+}
+
+ProfileManager::AddResult ProfileManager::add_profile(const std::string& name, const std::string& url,
+                                                      const Progress& progress) {
     AddResult result;
 
     if (name.empty()) {
@@ -162,34 +319,22 @@ ProfileManager::AddResult ProfileManager::add_profile(const std::string& name, c
         }
     }
 
-    // Download subscription content
-    auto dl = Subscription::download(url);
-    if (!dl.success) {
-        result.success = false;
-        result.error = dl.error;
-        return result;
-    }
-
-    // Ensure profiles directory exists
-    std::string dir = profiles_dir();
-    if (dir.empty()) {
+    // Download straight into the profiles directory, then rename into place
+    std::string filename = sanitize_filename(name) + ".yaml";
+    std::string filepath = profiles_dir() + "/" + filename;
+    std::string staged = staging_path(name);
+    FetchCache cache;
+    std::string error = fetch_profile(url, staged, progress, cache, max_download_bytes());
+    if (!error.empty()) {
         result.success = false;
-        result.error = "Cannot determine profiles directory";
+        result.error = error;
         return result;
     }
 
     try {
-        fs::create_directories(dir);
+        fs::rename(staged, filepath);
     } catch (...) {
-        result.success = false;
-        result.error = "Cannot create profiles directory";
-        return result;
-    }
-
-    // Save YAML file
-    std::string filename = sanitize_filename(name) + ".yaml";
-    std::string filepath = dir + "/" + filename;
-    if (!Subscription::save_to_file(dl.content, filepath)) {
+        try { fs::remove(staged); } catch (...) {}
         result.success = false;
         result.error = "Failed to save profile file";
         return result;
@@ -203,6 +348,9 @@ ProfileManager::AddResult ProfileManager::add_profile(const std::string& name, c
     info.last_updated = now_timestamp();
     info.auto_update = true;
     info.update_interval_hours = 24;
+    info.etag = cache.etag;
+    info.last_modified = cache.last_modified;
+    info.content_hash = cache.content_hash;
     existing.push_back(info);
 
     if (!save_metadata(existing)) {
@@ -212,41 +360,89 @@ ProfileManager::AddResult ProfileManager::add_profile(const std::string& name, c
     }
 
     result.success = true;
+    if (on_change) on_change("profile_added", name);
     return result;
 }
 
-ProfileManager::UpdateResult ProfileManager::update_profile(const std::string& name) {
+ProfileManager::UpdateResult ProfileManager::update_profile(const std::string& name,
+                                                            const Progress& progress) {
     UpdateResult result;
     result.was_active = (name == config_.data().active_profile);
 
-    auto profiles = load_metadata();
-    auto it = std::find_if(profiles.begin(), profiles.end(),
-        [&](const ProfileInfo& p) { return p.name == name; });
-
-    if (it == profiles.end()) {
+    FetchCache cache;
+    std::string url = source_url(name, &cache);
+    if (url.empty()) {
         result.success = false;
         result.error = "Profile not found: " + name;
         return result;
     }
 
-    // Re-download
-    auto dl = Subscription::download(it->source_url);
-    if (!dl.success) {
+    // Re-download (conditional when the last download left validators)
+    std::string staged = staging_path(name);
+    std::string error = fetch_profile(url, staged, progress, cache, max_download_bytes());
+    if (!error.empty()) {
         result.success = false;
-        result.error = dl.error;
+        result.error = error;
         return result;
     }
 
-    // Overwrite file
-    std::string filepath = profiles_dir() + "/" + it->filename;
-    if (!Subscription::save_to_file(dl.content, filepath)) {
+    return commit_update(name, staged, cache);
+}
+
+std::string ProfileManager::source_url(const std::string& name, FetchCache* cache) const {
+    for (const auto& p : load_metadata()) {
+        if (p.name != name) continue;
+        // Without the file there is nothing a 304 could refer to
+        if (cache && fs::exists(profiles_dir() + "/" + p.filename)) {
+            cache->etag = p.etag;
+            cache->last_modified = p.last_modified;
+            cache->content_hash = p.content_hash;
+        }
+        return p.source_url;
+    }
+    return "";
+}
+
+ProfileManager::UpdateResult ProfileManager::commit_update(const std::string& name,
+                                                           const std::string& staged,
+                                                           const FetchCache& cache) {
+    UpdateResult result;
+    result.was_active = (name == config_.data().active_profile);
+    result.unchanged = cache.unchanged;
+    auto discard = [&]() {
+        if (result.unchanged) return;
+        try { fs::remove(staged); } catch (...) {}
+    };
+
+    // Looked up again: the profile may have been deleted during the download
+    auto profiles = load_metadata();
+    auto it = std::find_if(profiles.begin(), profiles.end(),
+        [&](const ProfileInfo& p) { return p.name == name; });
+
+    if (it == profiles.end()) {
+        discard();
         result.success = false;
-        result.error = "Failed to save profile file";
+        result.error = "Profile not found: " + name;
         return result;
     }
 
+    // Swap in the new file (atomic rename), unless the content is the same
+    if (!result.unchanged) {
+        try {
+            fs::rename(staged, profiles_dir() + "/" + it->filename);
+        } catch (...) {
+            discard();
+            result.success = false;
+            result.error = "Failed to save profile file";
+            return result;
+        }
+    }
+
     // Update metadata
     it->last_updated = now_timestamp();
+    it->etag = cache.etag;
+    it->last_modified = cache.last_modified;
+    it->content_hash = cache.content_hash;
     if (!save_metadata(profiles)) {
         result.success = false;
         result.error = "Failed to save metadata";
@@ -254,6 +450,7 @@ ProfileManager::UpdateResult ProfileManager::update_profile(const std::string& n
     }
 
     result.success = true;
+    if (on_change) on_change("profile_updated", name);
     return result;
 }
 
@@ -274,10 +471,13 @@ bool ProfileManager::delete_profile(const std::string& name) {
     profiles.erase(it);
     save_metadata(profiles);
 
+    if (on_change) on_change("profile_deleted", name);
+
     // Clear active if deleted
     if (config_.data().active_profile == name) {
         config_.data().active_profile.clear();
         config_.save();
+        if (on_change) on_change("profile_changed", "");
     }
 
     return true;
@@ -292,7 +492,9 @@ bool ProfileManager::set_update_interval(const std::string& name, int hours) {
 
     it->auto_update = (hours > 0);
     it->update_interval_hours = hours > 0 ? hours : 0;
-    return save_metadata(profiles);
+    if (!save_metadata(profiles)) return false;
+    if (on_change) on_change("profile_updated", name);
+    return true;
 }
 
 bool ProfileManager::switch_active(const std::string& name) {
@@ -308,7 +510,9 @@ bool ProfileManager::switch_active(const std::string& name) {
     if (!fs::exists(filepath)) return false;
 
     config_.data().active_profile = name;
-    return config_.save();
+    if (!config_.save()) return false;
+    if (on_change) on_change("profile_changed", name);
+    return true;
 }
 
 std::string ProfileManager::active_profile_path() const {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,9 @@ struct ProfileInfo {
     bool auto_update = true;
     int update_interval_hours = 24;
     bool is_active = false;
+    std::string etag;               // HTTP validators of the last download
+    std::string last_modified;
+    std::string content_hash;       // SHA-256 of the saved YAML
 };
 
 class ProfileManager {
@@ -25,13 +31,59 @@ public:
     /// List all profiles (scanned from profiles dir + config metadata)
     std::vector<ProfileInfo> list_profiles() const;
 
+    /// Progress of add/update: `phase` is "download" (done/total bytes,
+    /// total 0 = unknown), "parse" or "save". Return false to cancel.
+    using Progress = std::function<bool(const std::string& phase, int64_t done, int64_t total)>;
+
     struct AddResult { bool success; std::string error; };
     /// Add a new profile: download subscription and save as YAML
-    AddResult add_profile(const std::string& name, const std::string& url);
-
-    struct UpdateResult { bool success; std::string error; bool was_active; };
+    AddResult add_profile(const std::string& name, const std::string& url,
+                          const Progress& progress = nullptr);
+
+    struct UpdateResult {
+        bool success;
+        std::string error;
+        bool was_active;
+        bool unchanged = false;     // same content as before: file left alone
+    };
     /// Re-download and update an existing profile
-    UpdateResult update_profile(const std::string& name);
+    UpdateResult update_profile(const std::string& name, const Progress& progress = nullptr);
+
+    /// What is known about a profile's current content, so an update can
+    /// ask the server for changes only and recognise an identical body
+    struct FetchCache {
+        std::string etag;
+        std::string last_modified;
+        std::string content_hash;
+        bool unchanged = false;     // set by fetch_profile(): 304 or same hash
+    };
+
+    /// Subscription URL of a profile; empty if the profile is unknown.
+    /// Fills `cache` from the metadata when the profile file exists.
+    std::string source_url(const std::string& name, FetchCache* cache = nullptr) const;
+
+    /// Fresh path next to the profile files for a download in progress,
+    /// so the final rename stays on one filesystem
+    std::string staging_path(const std::string& name) const;
+
+    /// Configured cap on a subscription body (profiles.max_download_mb)
+    int64_t max_download_bytes() const;
+
+    /// Stream the subscription into `staged`, then check it is a YAML
+    /// mapping. Returns an empty error string on success; on failure, or
+    /// when the profile turns out unchanged (cache.unchanged), `staged` is
+    /// removed. Touches no profile files, so callers can run it without
+    /// holding their profile lock. `cache` makes the request conditional
+    /// and receives the new validators and hash.
+    static std::string fetch_profile(const std::string& url, const std::string& staged,
+                                     const Progress& progress, FetchCache& cache,
+                                     int64_t max_bytes = 0);
+
+    /// Second half of update_profile(): rename a staged download over an
+    /// existing profile and record the update time and cache validators.
+    /// An unchanged fetch (nothing staged) only records the time.
+    UpdateResult commit_update(const std::string& name, const std::string& staged,
+                               const FetchCache& cache);
 
     /// Delete a profile (file + config entry)
     bool delete_profile(const std::string& name);
@@ -56,6 +108,11 @@ public:
     /// Get profiles that are due for automatic update
     std::vector<std::string> profiles_due_for_update() const;
 
+    /// Callback invoked after a successful change. `event` is one of
+    /// "profile_added", "profile_updated", "profile_deleted" or
+    /// "profile_changed" (active profile switched; empty name = cleared).
+    std::function<void(const std::string& event, const std::string& name)> on_change;
+
 private:
     Config& config_;
 
@@ -68,12 +125,36 @@ private:
     /// Get the metadata file path (profiles.yaml in profiles dir)
     std::string metadata_path() const;
 
-    /// Load profile metadata from profiles.yaml
+    /// Load profile metadata from profiles.yaml (cached, see below)
     std::vector<ProfileInfo> load_metadata() const;
 
     /// Save profile metadata to profiles.yaml
     bool save_metadata(const std::vector<ProfileInfo>& profiles) const;
 
+    /// Identity of profiles.yaml on disk: any write through save_metadata()
+    /// (rename) or by hand (mtime/size) changes it
+    struct FileStamp {
+        uint64_t dev = 0;
+        uint64_t ino = 0;
+        int64_t mtime_ns = 0;
+        int64_t size = -1;
+        bool operator==(const FileStamp& o) const {
+            return dev == o.dev && ino == o.ino && mtime_ns == o.mtime_ns && size == o.size;
+        }
+    };
+    static bool stamp_file(const std::string& path, FileStamp& out);
+
+    /// Parsed profiles.yaml, reused while its stamp is unchanged so list
+    /// and lookup calls cost a stat() instead of a YAML parse
+    struct MetadataCache {
+        bool valid = false;
+        std::string path;
+        FileStamp stamp;
+        std::vector<ProfileInfo> profiles;
+    };
+    mutable std::mutex meta_mutex_;   // callers may be on any daemon thread
+    mutable MetadataCache meta_cache_;
+
     /// Get current ISO timestamp
     static std::string now_timestamp();
 };
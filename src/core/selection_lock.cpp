@@ -0,0 +1,134 @@
+#include "core/selection_lock.hpp"
+#include "core/config.hpp"
+
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Group names are arbitrary text: name the file by a hash of it
+std::string lock_file(const std::string& dir, const std::string& group) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : group) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "select-%016llx.lock", (unsigned long long)hash);
+    return dir + "/" + name;
+}
+
+// Record: group, previous and node, one per line
+bool parse_record(const std::string& data, std::string& group, std::string& previous,
+                  std::string& node) {
+    std::istringstream in(data);
+    return std::getline(in, group) && std::getline(in, previous) &&
+           std::getline(in, node) && !group.empty() && !node.empty();
+}
+
+} // namespace
+
+SelectionLock::SelectionLock(const std::string& dir, const std::string& group)
+    : group_(group) {
+    if (dir.empty()) return;
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    std::string path = lock_file(dir, group);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        // Another user's file: locking works, recording does not
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+}
+
+SelectionLock::~SelectionLock() {
+    unlock();
+    if (fd_ >= 0) close(fd_);
+}
+
+bool SelectionLock::lock() {
+    if (fd_ < 0) return false;
+    if (!locked_) {
+        while (flock(fd_, LOCK_EX) != 0) {
+            if (errno != EINTR) return false;
+        }
+        locked_ = true;
+    }
+    return true;
+}
+
+bool SelectionLock::try_lock() {
+    if (fd_ < 0) return false;
+    if (!locked_) locked_ = flock(fd_, LOCK_EX | LOCK_NB) == 0;
+    return locked_;
+}
+
+void SelectionLock::unlock() {
+    if (locked_) flock(fd_, LOCK_UN);
+    locked_ = false;
+}
+
+bool SelectionLock::read_record(std::string& group, std::string& previous,
+                                std::string& node) const {
+    if (fd_ < 0) return false;
+    std::string data;
+    char buf[1024];
+    off_t off = 0;
+    ssize_t n;
+    while ((n = pread(fd_, buf, sizeof(buf), off)) > 0 && data.size() < 64 * 1024) {
+        data.append(buf, n);
+        off += n;
+    }
+    return parse_record(data, group, previous, node);
+}
+
+bool SelectionLock::read_pending(std::string& previous, std::string& node) const {
+    std::string group;
+    return read_record(group, previous, node) && group == group_;
+}
+
+void SelectionLock::write_pending(const std::string& previous, const std::string& node) {
+    if (fd_ < 0) return;
+    std::string data = group_ + "\n" + previous + "\n" + node + "\n";
+    if (ftruncate(fd_, 0) != 0) return;
+    if (pwrite(fd_, data.data(), data.size(), 0) != (ssize_t)data.size()) {
+        clear_pending();  // never leave half a record
+    }
+}
+
+void SelectionLock::clear_pending() {
+    if (fd_ < 0) return;
+    int rc = ftruncate(fd_, 0);  // fails only on a read-only file: nothing recorded
+    (void)rc;
+}
+
+std::vector<std::string> SelectionLock::pending_groups(const std::string& dir) {
+    std::vector<std::string> groups;
+    std::error_code ec;
+    if (dir.empty() || !fs::is_directory(dir, ec)) return groups;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("select-", 0) != 0) continue;
+        std::ifstream f(entry.path());
+        std::stringstream ss;
+        ss << f.rdbuf();
+        std::string group, previous, node;
+        if (parse_record(ss.str(), group, previous, node)) groups.push_back(group);
+    }
+    return groups;
+}
+
+std::string SelectionLock::default_dir() {
+    std::string dir = Config::config_dir();
+    if (dir.empty()) return "";
+    return dir + "/locks";
+}
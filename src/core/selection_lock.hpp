@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/// Cross-process advisory lock on one proxy group's selection.
+///
+/// Throughput tests switch a group's live selection for the duration of a
+/// download and the daemon's auto-selector switches groups on its own; both
+/// take this lock first so neither overwrites the other. The holder may
+/// record the selection it temporarily replaced, so the next holder can
+/// undo a test that was killed before restoring the group. The lock is an
+/// flock() on <dir>/select-<hash>.lock, released by the kernel if the
+/// holder dies.
+class SelectionLock {
+public:
+    /// Opens (creating if needed) the lock file of `group` under `dir`.
+    /// An empty `dir` or an unusable file leaves the lock invalid.
+    SelectionLock(const std::string& dir, const std::string& group);
+    ~SelectionLock();
+
+    SelectionLock(const SelectionLock&) = delete;
+    SelectionLock& operator=(const SelectionLock&) = delete;
+
+    bool valid() const { return fd_ >= 0; }
+
+    /// Block until held; false if the lock is invalid
+    bool lock();
+    /// Take it if nobody else holds it
+    bool try_lock();
+    void unlock();
+
+    /// A selection change made by a holder that did not undo it: `node`
+    /// was selected in place of `previous`. False if none is recorded.
+    bool read_pending(std::string& previous, std::string& node) const;
+    void write_pending(const std::string& previous, const std::string& node);
+    void clear_pending();
+
+    /// Groups with a recorded change under `dir` (read without locking)
+    static std::vector<std::string> pending_groups(const std::string& dir);
+
+    /// Default lock directory: <config_dir>/locks
+    static std::string default_dir();
+
+private:
+    int fd_ = -1;
+    bool locked_ = false;
+    std::string group_;
+
+    bool read_record(std::string& group, std::string& previous, std::string& node) const;
+};
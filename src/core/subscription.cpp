@@ -2,60 +2,318 @@
 #include "core/utils.hpp"
 
 #include <httplib.h>
+#include <openssl/evp.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <filesystem>
 
 namespace fs = std::filesystem;
 
-Subscription::DownloadResult Subscription::download(const std::string& url) {
+namespace {
+
+constexpr int kMaxRedirects = 10;
+
+std::string to_hex(const unsigned char* data, unsigned int len) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(len * 2);
+    for (unsigned int i = 0; i < len; ++i) {
+        out += hex[data[i] >> 4];
+        out += hex[data[i] & 0x0F];
+    }
+    return out;
+}
+
+bool is_redirect(int status) {
+    return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+}
+
+// Target of a redirect: an absolute URL, or one relative to the scheme,
+// host or directory of `base`
+std::string resolve_location(const std::string& base, const std::string& location) {
+    if (location.find("://") != std::string::npos) return location;
+    auto scheme_end = base.find("://");
+    if (scheme_end == std::string::npos) return location;
+    if (location.rfind("//", 0) == 0) return base.substr(0, scheme_end + 1) + location;
+
+    auto path_start = base.find('/', scheme_end + 3);
+    std::string origin = base.substr(0, path_start);
+    if (location.rfind('/', 0) == 0) return origin + location;
+
+    std::string path = path_start == std::string::npos ? "/" : base.substr(path_start);
+    path = path.substr(0, path.find_first_of("?#"));
+    return origin + path.substr(0, path.rfind('/') + 1) + location;
+}
+
+} // namespace
+
+// ── BodyWriter ──────────────────────────────────────────────
+
+struct Subscription::BodyWriter::Impl {
+    std::ofstream out;
+    EVP_MD_CTX* md = nullptr;
+    z_stream zs{};
+    bool inflating = false;     // zs initialized
+    bool stream_end = false;    // last gzip member complete
+
+    ~Impl() {
+        if (inflating) inflateEnd(&zs);
+        if (md) EVP_MD_CTX_free(md);
+    }
+};
+
+Subscription::BodyWriter::BodyWriter(const std::string& path, int64_t max_bytes)
+    : impl_(std::make_unique<Impl>()), path_(path), max_bytes_(max_bytes) {}
+
+Subscription::BodyWriter::~BodyWriter() = default;
+
+bool Subscription::BodyWriter::begin(const std::string& content_encoding) {
+    std::string enc = content_encoding;
+    std::transform(enc.begin(), enc.end(), enc.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    // Reset: redirects and retries may deliver several bodies
+    impl_ = std::make_unique<Impl>();
+    bytes_ = 0;
+    hash_.clear();
+
+    if (enc == "gzip" || enc == "x-gzip" || enc == "deflate") {
+        // 32: detect the gzip or zlib wrapper from the header
+        if (inflateInit2(&impl_->zs, 15 + 32) != Z_OK) {
+            error_ = "Cannot initialize decompression";
+            return false;
+        }
+        impl_->inflating = true;
+    } else if (!enc.empty() && enc != "identity") {
+        error_ = "Unsupported Content-Encoding: " + content_encoding;
+        return false;
+    }
+
+    impl_->md = EVP_MD_CTX_new();
+    if (!impl_->md || EVP_DigestInit_ex(impl_->md, EVP_sha256(), nullptr) != 1) {
+        error_ = "Cannot initialize SHA-256";
+        return false;
+    }
+
+    impl_->out.open(path_, std::ios::binary | std::ios::trunc);
+    if (!impl_->out.is_open()) {
+        error_ = "Cannot write " + path_;
+        return false;
+    }
+    return true;
+}
+
+bool Subscription::BodyWriter::emit(const char* data, size_t len) {
+    bytes_ += static_cast<int64_t>(len);
+    if (max_bytes_ > 0 && bytes_ > max_bytes_) {
+        error_ = "Profile exceeds " + std::to_string(max_bytes_ / (1024 * 1024)) + " MB limit";
+        return false;
+    }
+    if (EVP_DigestUpdate(impl_->md, data, len) != 1) {
+        error_ = "SHA-256 failed";
+        return false;
+    }
+    impl_->out.write(data, static_cast<std::streamsize>(len));
+    if (!impl_->out.good()) {
+        error_ = "Write failed: " + path_;
+        return false;
+    }
+    return true;
+}
+
+bool Subscription::BodyWriter::write(const char* data, size_t len) {
+    if (!impl_->md) {
+        error_ = "Body writer not started";
+        return false;
+    }
+    if (!impl_->inflating) return emit(data, len);
+
+    auto& zs = impl_->zs;
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    zs.avail_in = static_cast<uInt>(len);
+    char buf[16384];
+    do {
+        // Concatenated gzip members decode as one body
+        if (impl_->stream_end) {
+            if (zs.avail_in == 0) break;
+            if (inflateReset(&zs) != Z_OK) return false;
+            impl_->stream_end = false;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        int rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc != Z_OK && rc != Z_STREAM_END && rc != Z_BUF_ERROR) {
+            error_ = std::string("Corrupt compressed body: ") + (zs.msg ? zs.msg : "inflate failed");
+            return false;
+        }
+        size_t produced = sizeof(buf) - zs.avail_out;
+        if (produced > 0 && !emit(buf, produced)) return false;
+        if (rc == Z_STREAM_END) impl_->stream_end = true;
+        if (rc == Z_BUF_ERROR) break;  // needs more input
+        // A full buffer may leave output pending inside zlib
+    } while (zs.avail_in > 0 || zs.avail_out == 0);
+    return true;
+}
+
+bool Subscription::BodyWriter::finish() {
+    if (!impl_->md) {
+        error_ = "Body writer not started";
+        return false;
+    }
+    if (impl_->inflating && !impl_->stream_end) {
+        error_ = "Truncated compressed body";
+        return false;
+    }
+    impl_->out.close();
+    if (impl_->out.fail()) {
+        error_ = "Write failed: " + path_;
+        return false;
+    }
+
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+    if (EVP_DigestFinal_ex(impl_->md, hash, &hash_len) != 1) {
+        error_ = "SHA-256 failed";
+        return false;
+    }
+    hash_ = to_hex(hash, hash_len);
+    return true;
+}
+
+// ── Download ────────────────────────────────────────────────
+
+Subscription::DownloadResult Subscription::download(const std::string& url, const std::string& dest,
+                                                    const Progress& progress,
+                                                    const Validators& since, int64_t max_bytes) {
     DownloadResult result;
 
-    auto parts = parse_url(url);
-    if (parts.scheme.empty()) {
+    if (parse_url(url).scheme.empty()) {
         result.error = "Invalid URL";
         return result;
     }
-    const auto& scheme = parts.scheme;
-    const auto& host = parts.host;
-    const auto& path = parts.path;
-    int port = parts.port;
 
-    try {
+    BodyWriter writer(dest, max_bytes);
+    bool aborted = false;
+    bool started = false;       // writer accepted a 200 body
+    int status = 0;
+    int64_t total = 0;
+    int64_t received = 0;       // bytes on the wire (compressed, if it is)
+    std::string location;       // target of a redirect reply
+
+    auto response_handler = [&](const httplib::Response& res) -> bool {
+        status = res.status;
+        if (status == 304) return true;
+        if (is_redirect(status)) location = res.get_header_value("Location");
+        if (status != 200) return false;
+
+        total = 0;
+        received = 0;
+        if (res.has_header("Content-Length")) {
+            try {
+                total = std::stoll(res.get_header_value("Content-Length"));
+            } catch (...) {}
+        }
+        std::string encoding = res.get_header_value("Content-Encoding");
+        // An uncompressed body over the cap is refused before it arrives
+        if (encoding.empty() && max_bytes > 0 && total > max_bytes) {
+            result.error = "Profile exceeds " + std::to_string(max_bytes / (1024 * 1024)) + " MB limit";
+            return false;
+        }
+        started = writer.begin(encoding);
+        if (!started) result.error = writer.error();
+        return started;
+    };
+
+    auto content_receiver = [&](const char* data, size_t len) -> bool {
+        if (!started) return true;  // body of a 304
+        received += static_cast<int64_t>(len);
+        if (progress && !progress(received, total)) {
+            aborted = true;
+            return false;
+        }
+        if (!writer.write(data, len)) {
+            result.error = writer.error();
+            return false;
+        }
+        return true;
+    };
+
+    // Same handling for plain and TLS clients
+    auto fetch = [&](auto& cli, const std::string& path) {
+        cli.set_connection_timeout(10, 0);
+        cli.set_read_timeout(30, 0);
+        // Redirects are followed below: httplib's own following counts a
+        // 304 as a redirect without a Location and drops the reply
+        cli.set_follow_location(false);
+        cli.set_decompress(false);  // decoded here, while streaming to disk
+
         httplib::Headers headers = {
-            {"User-Agent", "clash.meta"}
+            {"User-Agent", "clash.meta"},
+            {"Accept-Encoding", "gzip, deflate"}
         };
+        if (!since.etag.empty()) headers.emplace("If-None-Match", since.etag);
+        if (!since.last_modified.empty()) headers.emplace("If-Modified-Since", since.last_modified);
 
-        if (scheme == "https") {
-            httplib::SSLClient cli(host, port);
-            cli.set_connection_timeout(10, 0);
-            cli.set_read_timeout(30, 0);
-            cli.set_follow_location(true);
+        auto res = cli.Get(path, headers, response_handler, content_receiver);
+        if (!res && !location.empty()) return;  // the caller follows it
+        if (res && (res->status == 200 || res->status == 304)) {
+            result.not_modified = (res->status == 304);
+            if (!result.not_modified && !writer.finish()) {
+                result.error = writer.error();
+                return;
+            }
+            result.success = true;
+            result.bytes = writer.bytes();
+            result.content_hash = writer.hash();
+            result.etag = res->get_header_value("ETag");
+            result.last_modified = res->get_header_value("Last-Modified");
+            // Servers may omit validators on 304; the old ones still hold
+            if (result.not_modified && result.etag.empty()) result.etag = since.etag;
+            if (result.not_modified && result.last_modified.empty()) {
+                result.last_modified = since.last_modified;
+            }
+        } else if (aborted) {
+            result.error = "Cancelled";
+        } else if (result.error.empty()) {
+            result.error = status > 0 ? "HTTP " + std::to_string(status) : "Connection failed";
+        }
+    };
 
-            auto res = cli.Get(path, headers);
-            if (res && res->status == 200) {
-                result.success = true;
-                result.content = res->body;
+    // Each hop repeats the conditional headers, so a 304 can come from the
+    // final location as well
+    std::string current = url;
+    try {
+        for (int hop = 0;; ++hop) {
+            auto parts = parse_url(current);
+            location.clear();
+            status = 0;
+            if (parts.scheme == "https") {
+                httplib::SSLClient cli(parts.host, parts.port);
+                fetch(cli, parts.path);
+            } else if (parts.scheme == "http") {
+                httplib::Client cli(parts.host, parts.port);
+                fetch(cli, parts.path);
             } else {
-                result.error = res ? "HTTP " + std::to_string(res->status) : "Connection failed";
+                result.error = "Unsupported URL: " + current;
+                break;
             }
-        } else {
-            httplib::Client cli(host, port);
-            cli.set_connection_timeout(10, 0);
-            cli.set_read_timeout(30, 0);
-            cli.set_follow_location(true);
-
-            auto res = cli.Get(path, headers);
-            if (res && res->status == 200) {
-                result.success = true;
-                result.content = res->body;
-            } else {
-                result.error = res ? "HTTP " + std::to_string(res->status) : "Connection failed";
+            if (location.empty()) break;
+            if (hop == kMaxRedirects) {
+                result.error = "Too many redirects";
+                break;
             }
+            current = resolve_location(current, location);
         }
     } catch (const std::exception& e) {
         result.error = e.what();
+        result.success = false;
     }
 
+    if (!result.success || result.not_modified) {
+        try { fs::remove(dest); } catch (...) {}
+    }
     return result;
 }
 
@@ -65,11 +323,28 @@ bool Subscription::save_to_file(const std::string& content, const std::string& p
         if (!parent.empty()) {
             fs::create_directories(parent);
         }
-        std::ofstream out(path);
+        // Atomic write: readers (and mihomo deploys) never see a partial file
+        std::string tmp = path + ".tmp";
+        std::ofstream out(tmp);
         if (!out.is_open()) return false;
         out << content;
+        out.close();
+        if (out.fail()) {
+            fs::remove(tmp);
+            return false;
+        }
+        fs::rename(tmp, path);
         return true;
     } catch (...) {
         return false;
     }
 }
+
+std::string Subscription::content_hash(const std::string& content) {
+    unsigned char hash[EVP_MAX_MD_SIZE];
+    unsigned int hash_len = 0;
+    if (EVP_Digest(content.data(), content.size(), hash, &hash_len, EVP_sha256(), nullptr) != 1) {
+        return "";
+    }
+    return to_hex(hash, hash_len);
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <functional>
 
@@ -7,13 +9,65 @@ class Subscription {
 public:
     struct DownloadResult {
         bool success = false;
+        bool not_modified = false;  // 304: the copy we already have is current
         std::string error;
-        std::string content;
+        std::string etag;           // validators for the next conditional request
+        std::string last_modified;
+        int64_t bytes = 0;          // decoded body size written to the file
+        std::string content_hash;   // SHA-256 of the decoded body
     };
 
-    // Download subscription content from URL
-    static DownloadResult download(const std::string& url);
+    /// Validators from the previous download; empty ones are not sent
+    struct Validators {
+        std::string etag;           // → If-None-Match
+        std::string last_modified;  // → If-Modified-Since
+    };
+
+    // Called as the body arrives (total = 0 if unknown); return false to abort
+    using Progress = std::function<bool(int64_t received, int64_t total)>;
+
+    /// Writes a response body to a file as it arrives: undoes gzip/deflate
+    /// Content-Encoding, hashes the decoded bytes and enforces a size cap,
+    /// so memory use does not grow with the body.
+    class BodyWriter {
+    public:
+        /// `max_bytes` caps the decoded size (0 = unlimited)
+        BodyWriter(const std::string& path, int64_t max_bytes);
+        ~BodyWriter();
+
+        /// Open (truncate) the file for a body with this Content-Encoding;
+        /// false for an unsupported encoding or an unwritable file
+        bool begin(const std::string& content_encoding);
+        bool write(const char* data, size_t len);
+        /// Flush and close; false if the body was truncated or unwritable
+        bool finish();
+
+        const std::string& error() const { return error_; }
+        int64_t bytes() const { return bytes_; }
+        std::string hash() const { return hash_; }  // valid after finish()
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> impl_;
+        std::string path_;
+        int64_t max_bytes_;
+        int64_t bytes_ = 0;
+        std::string error_;
+        std::string hash_;
+
+        bool emit(const char* data, size_t len);  // decoded bytes → file + hash
+    };
+
+    /// Download subscription content from URL straight into `dest`
+    /// (truncated first), following up to 10 redirects. With validators, a
+    /// 304 reply counts as success with `not_modified` set. `dest` is removed unless a body was written.
+    static DownloadResult download(const std::string& url, const std::string& dest,
+                                   const Progress& progress = nullptr,
+                                   const Validators& since = {}, int64_t max_bytes = 0);
 
     // Save subscription content to mihomo config path
     static bool save_to_file(const std::string& content, const std::string& path);
+
+    // SHA-256 of the content as lowercase hex; empty on failure
+    static std::string content_hash(const std::string& content);
 };
@@ -0,0 +1,201 @@
+#include "core/throughput_tester.hpp"
+#include "core/selection_lock.hpp"
+#include "core/utils.hpp"
+
+#include <httplib.h>
+#include <chrono>
+
+ThroughputTester::ThroughputTester(Options opts, SelectFn select, CurrentFn current)
+    : opts_(std::move(opts)), select_fn_(std::move(select)), current_fn_(std::move(current)) {
+    if (opts_.concurrency < 1) opts_.concurrency = 1;
+    if (opts_.max_seconds < 1) opts_.max_seconds = 1;
+}
+
+std::mutex& ThroughputTester::group_lock(const std::string& group) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& m = group_locks_[group];
+    if (!m) m = std::make_unique<std::mutex>();
+    return *m;
+}
+
+std::string ThroughputTester::check_route(const std::string& group,
+                                          const std::string& group_type,
+                                          const std::string& mode) {
+    if (mode == "direct") return "mihomo is in direct mode: no traffic goes through a proxy";
+    if (group == "GLOBAL") {
+        if (mode != "global") {
+            return "GLOBAL only routes traffic in global mode (mode is " + mode +
+                   "); pick a Selector group your rules use";
+        }
+        return "";
+    }
+    if (group_type != "Selector") {
+        return group + " is a " + group_type + " group; only Selector groups can be switched";
+    }
+    return "";
+}
+
+ThroughputResult ThroughputTester::test(const std::string& group, const std::string& node) {
+    if (!select_fn_) {
+        ThroughputResult r;
+        r.name = node;
+        r.error = "node selection unavailable";
+        return r;
+    }
+
+    std::lock_guard<std::mutex> route(group_lock(group));
+    SelectionLock shared(opts_.lock_dir, group);
+    shared.lock();  // other processes; unguarded if the file is unusable
+    std::string previous = current_fn_ ? current_fn_(group) : "";
+
+    // A test killed before restoring left the group on its node
+    std::string stale_previous, stale_node;
+    if (shared.read_pending(stale_previous, stale_node)) {
+        if (previous == stale_node && select_fn_(group, stale_previous)) previous = stale_previous;
+        shared.clear_pending();
+    }
+
+    if (previous != node) {
+        if (!previous.empty()) shared.write_pending(previous, node);
+        if (!select_fn_(group, node)) {
+            shared.clear_pending();
+            ThroughputResult r;
+            r.name = node;
+            r.error = "failed to select node";
+            return r;
+        }
+    }
+
+    auto result = measure(node);
+
+    // Only undo our own switch: a node picked meanwhile stays selected
+    bool settled = true;
+    if (!previous.empty() && previous != node) {
+        std::string now = current_fn_(group);
+        if (now == node) {
+            settled = select_fn_(group, previous);
+        } else {
+            settled = !now.empty();  // unknown: leave the record for recover()
+        }
+    }
+    if (settled) shared.clear_pending();
+    return result;
+}
+
+void ThroughputTester::recover() {
+    if (!select_fn_ || !current_fn_) return;
+    for (const auto& group : SelectionLock::pending_groups(opts_.lock_dir)) {
+        std::lock_guard<std::mutex> route(group_lock(group));
+        SelectionLock shared(opts_.lock_dir, group);
+        if (!shared.try_lock()) continue;  // a test is running: it is not stale
+        std::string previous, node;
+        if (!shared.read_pending(previous, node)) continue;
+        std::string now = current_fn_(group);
+        if (now.empty()) continue;  // mihomo unreachable: try again later
+        if (now != node || select_fn_(group, previous)) shared.clear_pending();
+    }
+}
+
+ThroughputResult ThroughputTester::measure(const std::string& label) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return active_ < opts_.concurrency; });
+        ++active_;
+    }
+
+    auto result = download(label);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --active_;
+    }
+    cv_.notify_one();
+    return result;
+}
+
+ThroughputResult ThroughputTester::download(const std::string& label) {
+    using clock = std::chrono::steady_clock;
+    auto ms_since = [](clock::time_point t) {
+        return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            clock::now() - t).count());
+    };
+
+    ThroughputResult result;
+    result.name = label;
+
+    UrlParts parts = parse_url(opts_.url);
+    if (parts.host.empty()) {
+        result.error = "invalid test URL";
+        return result;
+    }
+
+    auto start = clock::now();
+    clock::time_point first_byte;
+    bool got_first_byte = false;
+    bool capped = false;
+    int status = 0;
+
+    httplib::Headers headers = {
+        {"User-Agent", "clashtui-cpp"},
+    };
+
+    auto response_handler = [&](const httplib::Response& response) -> bool {
+        status = response.status;
+        result.ttfb_ms = ms_since(start);
+        return response.status == 200;
+    };
+
+    auto content_receiver = [&](const char*, size_t len) -> bool {
+        if (!got_first_byte) {
+            first_byte = clock::now();
+            got_first_byte = true;
+        }
+        result.bytes += static_cast<int64_t>(len);
+        if (result.bytes >= opts_.max_bytes || ms_since(start) >= opts_.max_seconds * 1000) {
+            capped = true;
+            return false;  // enough data: abort the transfer
+        }
+        return true;
+    };
+
+    auto run = [&](httplib::Client& cli) {
+        cli.set_connection_timeout(opts_.max_seconds, 0);
+        cli.set_read_timeout(opts_.max_seconds, 0);
+        cli.set_follow_location(true);
+        if (opts_.proxy_port > 0) cli.set_proxy(opts_.proxy_host, opts_.proxy_port);
+        return cli.Get(parts.path, headers, response_handler, content_receiver);
+    };
+
+    bool ok = false;
+    try {
+        if (parts.scheme == "https") {
+            httplib::SSLClient cli(parts.host, parts.port);
+            auto res = run(cli);
+            ok = (res && res->status == 200) || capped;
+        } else {
+            httplib::Client cli(parts.host, parts.port);
+            auto res = run(cli);
+            ok = (res && res->status == 200) || capped;
+        }
+    } catch (...) {
+        ok = false;
+    }
+
+    result.total_ms = ms_since(start);
+
+    if (!ok || result.bytes == 0) {
+        if (status != 0 && status != 200) {
+            result.error = "HTTP " + std::to_string(status);
+        } else {
+            result.error = result.bytes == 0 ? "no data received" : "download failed";
+        }
+        return result;
+    }
+
+    // Rate over the body transfer only; connect/handshake time is in ttfb
+    double transfer_sec = std::chrono::duration<double>(clock::now() - first_byte).count();
+    if (transfer_sec < 0.001) transfer_sec = 0.001;
+    result.mb_per_sec = static_cast<double>(result.bytes) / 1e6 / transfer_sec;
+    result.success = true;
+    return result;
+}
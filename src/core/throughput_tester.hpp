@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// Outcome of one bounded download
+struct ThroughputResult {
+    std::string name;
+    bool success = false;
+    std::string error;
+    int64_t bytes = 0;
+    int ttfb_ms = -1;          // request start → response headers
+    int total_ms = 0;          // request start → last byte
+    double mb_per_sec = 0;     // body bytes (10^6) per second of transfer
+};
+
+/// Bandwidth test through mihomo's mixed port.
+///
+/// mihomo has no per-request node choice, so a test routes through a node
+/// by selecting it in a group, downloads a bounded amount from the target
+/// URL and then restores the group's previous selection, so all traffic
+/// routed through that group follows the tested node meanwhile. Tests
+/// sharing a group are serialized (the concurrency limit only overlaps
+/// tests in different groups). The target URL must be routed through that
+/// group by mihomo's rules (e.g. GLOBAL in global mode); check_route()
+/// rejects the setups where it cannot be.
+///
+/// With a lock_dir, each test holds the group's SelectionLock, so the
+/// daemon's auto-selector leaves the group alone meanwhile, and records
+/// the switch there until it is undone. The previous node is only restored
+/// if the group is still on the tested one: a selection made during the
+/// test is kept.
+class ThroughputTester {
+public:
+    struct Options {
+        std::string url = "https://speed.cloudflare.com/__down?bytes=25000000";
+        int64_t max_bytes = 10 * 1024 * 1024;  // stop after this many bytes
+        int max_seconds = 10;                   // ... or after this long
+        int concurrency = 2;                    // downloads in flight
+        std::string proxy_host = "127.0.0.1";
+        int proxy_port = 0;                     // mixed port; 0 = no proxy
+        std::string lock_dir;                   // SelectionLock dir; "" = this process only
+    };
+
+    using SelectFn = std::function<bool(const std::string& group, const std::string& proxy)>;
+    using CurrentFn = std::function<std::string(const std::string& group)>;
+
+    explicit ThroughputTester(Options opts, SelectFn select = nullptr,
+                              CurrentFn current = nullptr);
+
+    /// Why a test through `group` (of `group_type`) would not measure its
+    /// nodes under mihomo `mode`, or "" if it can: GLOBAL only routes in
+    /// global mode, nothing is proxied in direct mode, and only Selector
+    /// groups can be switched
+    static std::string check_route(const std::string& group, const std::string& group_type,
+                                   const std::string& mode);
+
+    /// Route through `node` by selecting it in `group`, measure, restore
+    ThroughputResult test(const std::string& group, const std::string& node);
+
+    /// Undo switches left by tests that were killed mid-run (recorded in
+    /// lock_dir), where the group is still on the tested node
+    void recover();
+
+    /// Measure with the current routing (no selection changes)
+    ThroughputResult measure(const std::string& label);
+
+    const Options& options() const { return opts_; }
+
+private:
+    Options opts_;
+    SelectFn select_fn_;
+    CurrentFn current_fn_;
+
+    // Global concurrency limit
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int active_ = 0;
+
+    // One lock per group: a group can route through one node at a time
+    std::map<std::string, std::unique_ptr<std::mutex>> group_locks_;
+    std::mutex& group_lock(const std::string& group);
+
+    ThroughputResult download(const std::string& label);
+};
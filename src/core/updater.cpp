@@ -2,6 +2,8 @@
 #include "core/installer.hpp"
 #include "core/config.hpp"
 #include "core/utils.hpp"
+#include "api/mihomo_client.hpp"
+#include "daemon/ipc_client.hpp"
 
 #ifndef APP_VERSION
 #define APP_VERSION "0.0.0"
@@ -11,11 +13,14 @@
 #include <nlohmann/json.hpp>
 #include <sys/utsname.h>
 
+#include <chrono>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <regex>
 #include <filesystem>
 #include <fstream>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #ifdef __APPLE__
@@ -378,9 +383,50 @@ UpdateResult Updater::apply_self_update() const {
     return result;
 }
 
+// ════════════════════════════════════════════════════════════════
+// validate_mihomo_binary — `mihomo -t` against a config
+// ════════════════════════════════════════════════════════════════
+
+bool Updater::validate_mihomo_binary(const std::string& binary, const std::string& home_dir,
+                                     const std::string& config_path, std::string& output) {
+    output.clear();
+    std::string cmd = shell_quote(binary) + " -t -d " + shell_quote(home_dir) +
+                      " -f " + shell_quote(config_path) + " 2>&1";
+    FILE* pipe = popen(cmd.c_str(), "r");
+    if (!pipe) {
+        output = "Cannot run " + binary;
+        return false;
+    }
+    char buffer[256];
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        output += buffer;
+    }
+    int status = pclose(pipe);
+    while (!output.empty() && (output.back() == '\n' || output.back() == '\r')) {
+        output.pop_back();
+    }
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/// Milliseconds from `since` until mihomo's API answers; -1 on timeout
+static int64_t wait_mihomo_ready(const AppConfig& data, std::chrono::steady_clock::time_point since,
+                                 int timeout_sec = 15) {
+    MihomoClient client(data.api_host, data.api_port, data.api_secret);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (client.test_connection()) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - since).count();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
+    }
+    return -1;
+}
+
 // ════════════════════════════════════════════════════════════════
 // update_mihomo — download and replace the mihomo binary
-// Daemon-aware: stops daemon before replace, restarts after.
+// The running mihomo keeps serving until the new binary is downloaded,
+// verified and has accepted the active config; only then is it restarted.
 // ════════════════════════════════════════════════════════════════
 
 UpdateResult Updater::update_mihomo() const {
@@ -392,7 +438,7 @@ UpdateResult Updater::update_mihomo() const {
         cfg.load();
         const auto& data = cfg.data();
 
-        std::string binary_path = data.mihomo_binary_path;
+        std::string binary_path = Config::expand_home(data.mihomo_binary_path);
         std::string service_name = data.mihomo_service_name;
 
         // Step 2: Get current installed version
@@ -421,73 +467,112 @@ UpdateResult Updater::update_mihomo() const {
             return result;
         }
 
-        // Step 6: Detect daemon service and mihomo service
-        auto daemon_info = detect_daemon_service();
-        bool daemon_was_active = daemon_info.service_active;
-
-        ServiceScope mihomo_scope = ServiceScope::System;
-        if (binary_path.find("/usr/") != 0 && binary_path.find("/opt/") != 0) {
-            mihomo_scope = ServiceScope::User;
-        }
-        bool mihomo_was_running = Installer::has_systemd() &&
-                                  Installer::is_service_active(service_name, mihomo_scope);
-
-        // Step 7: Stop everything
-        // If daemon is running, stop daemon (which kills mihomo child process)
-        // Otherwise, stop mihomo service directly
-        if (daemon_was_active) {
-            stop_daemon_if_running(daemon_info);
-        } else if (mihomo_was_running) {
-            Installer::stop_service(service_name, mihomo_scope);
-        }
-
-        // Step 8: Download to temp location
+        // Step 6: Download to temp location (mihomo keeps running)
         std::string tmp_gz = "/tmp/mihomo-update.gz";
-        try { fs::remove(tmp_gz); } catch (...) {}
+        std::string tmp_bin = "/tmp/mihomo-update.bin";
+        auto cleanup = [&]() {
+            try { fs::remove(tmp_gz); } catch (...) {}
+            try { fs::remove(tmp_bin); } catch (...) {}
+        };
+        cleanup();
 
         if (!Installer::download_with_fallback(asset.download_url, tmp_gz, nullptr, nullptr)) {
-            // Restore services on failure
-            if (daemon_was_active) start_daemon(daemon_info);
-            else if (mihomo_was_running) Installer::start_service(service_name, mihomo_scope);
+            cleanup();
             result.message = "Failed to download mihomo from " + asset.download_url;
             return result;
         }
 
-        // Step 9: Verify SHA256 if checksums are available
+        // Step 7: Verify SHA256 if checksums are available
         if (!release.checksums_url.empty()) {
             std::string expected_hash = Installer::fetch_checksum_for_file(
                 release.checksums_url, asset.name);
-            if (!expected_hash.empty()) {
-                if (!Installer::verify_sha256(tmp_gz, expected_hash)) {
-                    try { fs::remove(tmp_gz); } catch (...) {}
-                    if (daemon_was_active) start_daemon(daemon_info);
-                    else if (mihomo_was_running) Installer::start_service(service_name, mihomo_scope);
-                    result.message = "SHA256 checksum verification failed for mihomo";
-                    return result;
-                }
+            if (!expected_hash.empty() && !Installer::verify_sha256(tmp_gz, expected_hash)) {
+                cleanup();
+                result.message = "SHA256 checksum verification failed for mihomo";
+                return result;
             }
         }
 
-        // Step 10: Install binary (extract + copy + chmod, handles sudo)
-        bool needs_sudo = (binary_path.find("/usr/") == 0 || binary_path.find("/opt/") == 0);
-        if (!Installer::install_binary(tmp_gz, binary_path, needs_sudo)) {
-            try { fs::remove(tmp_gz); } catch (...) {}
-            if (daemon_was_active) start_daemon(daemon_info);
-            else if (mihomo_was_running) Installer::start_service(service_name, mihomo_scope);
-            result.message = "Failed to install mihomo binary to " + binary_path;
+        // Step 8: Extract and check that the new binary accepts the active config
+        if (!Installer::extract_gz(tmp_gz, tmp_bin)) {
+            cleanup();
+            result.message = "Failed to extract mihomo";
             return result;
         }
+        // Validate what mihomo really runs: the daemon knows (blue/green
+        // slots have their own copy), otherwise the deployed config
+        DaemonClient dc;
+        std::string mihomo_dir = Config::mihomo_dir();
+        std::string active_config = Config::expand_home(data.mihomo_config_path);
+        if (dc.is_daemon_running()) {
+            auto st = dc.get_status();
+            if (!st.mihomo_config.empty()) {
+                active_config = st.mihomo_config;
+                mihomo_dir = st.mihomo_home;
+            }
+        }
+        if (!mihomo_dir.empty() && !active_config.empty() && fs::exists(active_config)) {
+            std::string output;
+            if (!validate_mihomo_binary(tmp_bin, mihomo_dir, active_config, output)) {
+                cleanup();
+                result.message = "New mihomo " + release.version + " rejected the active config";
+                if (!output.empty()) result.message += ": " + output;
+                return result;
+            }
+        }
 
-        // Step 11: Clean up
-        try { fs::remove(tmp_gz); } catch (...) {}
-
-        // Step 12: Restart services
-        // If daemon was running → start daemon (daemon auto-starts mihomo)
-        // Otherwise if mihomo service was running → start mihomo service
-        if (daemon_was_active) {
-            start_daemon(daemon_info);
-        } else if (mihomo_was_running) {
-            Installer::start_service(service_name, mihomo_scope);
+        // Step 9: Swap the binary in. rename() leaves the running process
+        // on the old inode, so nothing stops until the restart below.
+        if (fs::exists(binary_path)) {
+            std::string replace_err = atomic_replace_binary(tmp_bin, binary_path);
+            if (!replace_err.empty()) {
+                cleanup();
+                result.message = replace_err;
+                return result;
+            }
+        } else {
+            bool needs_sudo = (binary_path.find("/usr/") == 0 || binary_path.find("/opt/") == 0);
+            if (!Installer::install_binary(tmp_gz, binary_path, needs_sudo)) {
+                cleanup();
+                result.message = "Failed to install mihomo binary to " + binary_path;
+                return result;
+            }
+        }
+        cleanup();
+
+        // Step 10: Restart whatever runs mihomo and time the gap
+        // Daemon reachable → in-process restart with readiness detection
+        // Daemon service without IPC → restart the service
+        // Otherwise a standalone mihomo service → restart it
+        std::string restarted;
+        if (dc.is_daemon_running()) {
+            std::string err;
+            if (!dc.mihomo_restart(err)) {
+                result.message = "Mihomo " + release.version + " installed, but restart failed: " + err;
+                return result;
+            }
+            result.downtime_ms = dc.get_status().restart_downtime_ms;
+            restarted = "mihomo restarted";
+        } else {
+            auto daemon_info = detect_daemon_service();
+            ServiceScope mihomo_scope = ServiceScope::System;
+            if (binary_path.find("/usr/") != 0 && binary_path.find("/opt/") != 0) {
+                mihomo_scope = ServiceScope::User;
+            }
+            if (daemon_info.service_active) {
+                auto stopped_at = std::chrono::steady_clock::now();
+                stop_daemon_if_running(daemon_info);
+                start_daemon(daemon_info);
+                result.downtime_ms = wait_mihomo_ready(data, stopped_at);
+                restarted = "daemon restarted";
+            } else if (Installer::has_systemd() &&
+                       Installer::is_service_active(service_name, mihomo_scope)) {
+                auto stopped_at = std::chrono::steady_clock::now();
+                Installer::stop_service(service_name, mihomo_scope);
+                Installer::start_service(service_name, mihomo_scope);
+                result.downtime_ms = wait_mihomo_ready(data, stopped_at);
+                restarted = "service restarted";
+            }
         }
 
         result.success = true;
@@ -496,8 +581,12 @@ UpdateResult Updater::update_mihomo() const {
         } else {
             result.message = "Mihomo updated to " + release.version;
         }
-        if (daemon_was_active) {
-            result.message += ". Daemon restarted.";
+        if (!restarted.empty()) {
+            result.message += ". " + restarted;
+            if (result.downtime_ms >= 0) {
+                result.message += " (" + std::to_string(result.downtime_ms) + " ms downtime)";
+            }
+            result.message += ".";
         }
     } catch (const std::exception& e) {
         result.message = std::string("Mihomo update failed: ") + e.what();
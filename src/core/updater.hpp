@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 // Forward-declare to avoid including installer.hpp here
@@ -16,6 +17,7 @@ struct UpdateInfo {
 struct UpdateResult {
     bool success = false;
     std::string message;
+    int64_t downtime_ms = -1;     // mihomo update: restart until the API answered (-1 = unknown)
 };
 
 /// Info about the clashtui-cpp daemon's systemd service
@@ -42,9 +44,15 @@ public:
     UpdateResult apply_self_update() const;
 
     /// Download and apply mihomo update (using config for paths).
-    /// Daemon-aware: stops daemon before replace, restarts after.
+    /// The new binary is downloaded, verified and checked with `-t`
+    /// against the active config while mihomo keeps running; then it is
+    /// swapped in and mihomo restarted (through the daemon when reachable).
     UpdateResult update_mihomo() const;
 
+    /// Run `binary -t` on a config; `output` gets what it printed
+    static bool validate_mihomo_binary(const std::string& binary, const std::string& home_dir,
+                                       const std::string& config_path, std::string& output);
+
     /// Atomically replace a binary file using rename().
     static std::string atomic_replace_binary(const std::string& new_binary,
                                              const std::string& target_path);
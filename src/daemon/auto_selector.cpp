@@ -0,0 +1,215 @@
+#include "daemon/auto_selector.hpp"
+#include "core/config.hpp"
+#include "core/selection_lock.hpp"
+
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+AutoSelector::AutoSelector(Options opts, GroupsFn groups, StatsFn stats, SelectFn select,
+                           std::string log_path)
+    : opts_(std::move(opts)),
+      groups_fn_(std::move(groups)),
+      stats_fn_(std::move(stats)),
+      select_fn_(std::move(select)),
+      log_path_(std::move(log_path)) {
+    if (opts_.interval_sec < 1) opts_.interval_sec = 1;
+    if (opts_.min_samples < 1) opts_.min_samples = 1;
+}
+
+AutoSelector::~AutoSelector() {
+    stop();
+}
+
+std::string AutoSelector::default_log_path() {
+    std::string dir = Config::config_dir();
+    if (dir.empty()) return "";
+    return dir + "/auto_select.log";
+}
+
+void AutoSelector::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&AutoSelector::loop, this);
+}
+
+void AutoSelector::stop() {
+    if (!running_.exchange(false)) return;
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void AutoSelector::loop() {
+    while (running_.load()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait_for(lock, std::chrono::seconds(opts_.interval_sec),
+                         [this] { return !running_.load(); });
+        }
+        if (!running_.load()) break;
+        evaluate(now_ms());
+    }
+}
+
+double AutoSelector::score(const NodeLatency& nl) const {
+    if (nl.samples < opts_.min_samples || nl.p95 <= 0) return -1;
+    double failure_rate = static_cast<double>(nl.failures) / nl.samples;
+    if (failure_rate * 100 > opts_.max_failure_pct) return -1;
+    // Each failure in the window costs as much as doubling the tail latency
+    return nl.p95 * (1.0 + 2.0 * failure_rate);
+}
+
+std::vector<SelectDecision> AutoSelector::evaluate(int64_t now) {
+    std::vector<SelectDecision> made;
+    if (!groups_fn_ || !stats_fn_ || !select_fn_) return made;
+
+    // Held through the pass, and taken before reading the groups, so a
+    // throughput test cannot switch a group between the read and the select
+    std::map<std::string, std::unique_ptr<SelectionLock>> held;
+    for (const auto& name : opts_.groups) {
+        auto guard = std::make_unique<SelectionLock>(opts_.lock_dir, name);
+        if (guard->valid() && !guard->try_lock()) continue;  // a test owns it
+        held.emplace(name, std::move(guard));
+    }
+    if (held.empty()) return made;
+
+    auto groups = groups_fn_();
+    if (groups.empty()) return made;
+    auto stats = stats_fn_();
+
+    for (const auto& name : opts_.groups) {
+        if (!held.count(name)) continue;
+        auto git = groups.find(name);
+        if (git == groups.end() || git->second.type != "Selector") continue;
+        const auto& group = git->second;
+
+        std::string best;
+        double best_score = -1;
+        for (const auto& member : group.all) {
+            auto sit = stats.find(member);
+            if (sit == stats.end()) continue;
+            double s = score(sit->second);
+            if (s >= 0 && (best_score < 0 || s < best_score)) {
+                best = member;
+                best_score = s;
+            }
+        }
+
+        const std::string& current = group.now;
+        double current_score = -1;
+        bool current_unhealthy = false;
+        auto cit = stats.find(current);
+        if (cit != stats.end()) {
+            current_score = score(cit->second);
+            // Enough data to judge, and it fails the health bar
+            current_unhealthy = current_score < 0 &&
+                                cit->second.samples >= opts_.min_samples;
+        }
+
+        int64_t since;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& gs = group_state_[name];
+            if (gs.current != current) {
+                // First sight, or switched by someone else: restart the dwell
+                gs.current = current;
+                gs.since_ms = now;
+            }
+            since = gs.since_ms;
+        }
+
+        if (best.empty() || best == current) continue;
+
+        std::string reason;
+        if (current_unhealthy) {
+            reason = "unhealthy";
+        } else if (current_score < 0) {
+            continue;  // current node not measured yet
+        } else if (now - since < (int64_t)opts_.min_dwell_sec * 1000) {
+            continue;
+        } else if (best_score < current_score * (1.0 - opts_.hysteresis_pct / 100.0)) {
+            reason = "better";
+        } else {
+            continue;
+        }
+
+        SelectDecision d;
+        d.time_ms = now;
+        d.group = name;
+        d.from = current;
+        d.to = best;
+        d.from_score = current_score;
+        d.to_score = best_score;
+        d.reason = reason;
+
+        auto t0 = std::chrono::steady_clock::now();
+        d.applied = select_fn_(name, best);
+        d.apply_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - t0).count());
+
+        if (d.applied) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            group_state_[name] = GroupState{best, now};
+        }
+        log_decision(d);
+        made.push_back(std::move(d));
+    }
+    return made;
+}
+
+void AutoSelector::log_decision(const SelectDecision& d) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decisions_.push_back(d);
+        while (decisions_.size() > opts_.log_keep) decisions_.pop_front();
+    }
+
+    if (log_path_.empty()) return;
+    json line = {
+        {"t", d.time_ms},
+        {"group", d.group},
+        {"from", d.from},
+        {"to", d.to},
+        {"from_score", d.from_score},
+        {"to_score", d.to_score},
+        {"reason", d.reason},
+        {"applied", d.applied},
+        {"apply_ms", d.apply_ms}
+    };
+    rotate_log();
+    std::ofstream out(log_path_, std::ios::app);
+    if (out) out << line.dump() << "\n";
+}
+
+void AutoSelector::rotate_log() {
+    std::error_code ec;
+    auto size = fs::file_size(log_path_, ec);
+    if (ec || opts_.log_max_bytes <= 0 || static_cast<int64_t>(size) < opts_.log_max_bytes) return;
+    // log.N-1 → log.N … log → log.1; the oldest falls off
+    for (int i = opts_.log_files_keep; i >= 1; --i) {
+        std::string from = i == 1 ? log_path_ : log_path_ + "." + std::to_string(i - 1);
+        std::string to = log_path_ + "." + std::to_string(i);
+        if (fs::exists(from, ec)) fs::rename(from, to, ec);
+    }
+    if (opts_.log_files_keep <= 0) fs::remove(log_path_, ec);
+}
+
+std::vector<SelectDecision> AutoSelector::recent_decisions(size_t limit) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = std::min(limit, decisions_.size());
+    return std::vector<SelectDecision>(decisions_.end() - n, decisions_.end());
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "api/mihomo_client.hpp"
+#include "daemon/latency_prober.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// One switch made (or attempted) by the auto-selector
+struct SelectDecision {
+    int64_t time_ms = 0;     // unix epoch ms when the decision was made
+    std::string group;
+    std::string from;
+    std::string to;
+    double from_score = -1;  // -1 = no usable data for the old node
+    double to_score = -1;
+    std::string reason;      // "better", "unhealthy"
+    bool applied = false;    // select_proxy succeeded
+    int apply_ms = 0;        // select_proxy round trip
+};
+
+/// Picks the best node for chosen Selector groups from the prober's
+/// rolling window.
+///
+/// A node's score is its rolling p95 inflated by its failure rate; nodes
+/// with too few samples or too many failures are not eligible. The current
+/// node is only replaced when the best candidate beats it by the hysteresis
+/// margin and the group has kept its node for the minimum dwell time, so
+/// noise in single samples cannot make a group flap. An unhealthy current
+/// node is replaced right away. Groups whose SelectionLock is held (a
+/// throughput test has switched them) are skipped for that pass.
+class AutoSelector {
+public:
+    struct Options {
+        std::vector<std::string> groups;  // Selector groups to manage
+        int interval_sec = 30;            // evaluation period
+        int hysteresis_pct = 20;          // required improvement to switch
+        int min_dwell_sec = 300;          // minimum time between switches
+        int min_samples = 3;              // samples needed to be eligible
+        int max_failure_pct = 20;         // above this a node is unhealthy
+        size_t log_keep = 200;            // decisions kept in memory
+        int64_t log_max_bytes = 1024 * 1024;  // rotate the log file past this size
+        int log_files_keep = 2;           // rotated copies (log.1 … log.N)
+        std::string lock_dir;             // SelectionLock dir; "" = no guard
+    };
+
+    using GroupsFn = std::function<std::map<std::string, ProxyGroup>()>;
+    using StatsFn = std::function<std::map<std::string, NodeLatency>()>;
+    using SelectFn = std::function<bool(const std::string& group, const std::string& proxy)>;
+
+    /// `log_path` receives one JSON line per decision (empty = memory only),
+    /// rotated by size like LogRing's file
+    AutoSelector(Options opts, GroupsFn groups, StatsFn stats, SelectFn select,
+                 std::string log_path = "");
+    ~AutoSelector();
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    /// Run one evaluation pass at `now_ms` and return the decisions made
+    std::vector<SelectDecision> evaluate(int64_t now_ms);
+
+    /// Newest decisions, oldest first
+    std::vector<SelectDecision> recent_decisions(size_t limit = 50) const;
+
+    /// Lower is better; < 0 = not eligible
+    double score(const NodeLatency& nl) const;
+
+    /// Default log location: <config_dir>/auto_select.log
+    static std::string default_log_path();
+
+private:
+    Options opts_;
+    GroupsFn groups_fn_;
+    StatsFn stats_fn_;
+    SelectFn select_fn_;
+    std::string log_path_;
+
+    // Per group: node we believe is selected and when it became so
+    struct GroupState {
+        std::string current;
+        int64_t since_ms = 0;
+    };
+    std::map<std::string, GroupState> group_state_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<SelectDecision> decisions_;
+
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void loop();
+    void log_decision(const SelectDecision& d);
+    void rotate_log();
+};
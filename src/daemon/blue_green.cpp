@@ -0,0 +1,152 @@
+#include "daemon/blue_green.hpp"
+
+#include <yaml-cpp/yaml.h>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace blue_green {
+
+namespace {
+
+// Top-level inbound ports of a mihomo config
+const char* const kPortKeys[] = {"port", "socks-port", "mixed-port", "redir-port", "tproxy-port"};
+
+void set_controller(YAML::Node& root, const Ports& ports, int port) {
+    root["external-controller"] = ports.api_host + ":" + std::to_string(port);
+    root["secret"] = ports.secret;
+    // Extra controller endpoints would collide with the running instance
+    root.remove("external-controller-tls");
+    root.remove("external-controller-unix");
+}
+
+bool write_yaml(const YAML::Node& root, const std::string& out_path, std::string& err) {
+    try {
+        auto parent = fs::path(out_path).parent_path();
+        if (!parent.empty()) fs::create_directories(parent);
+        std::string tmp = out_path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            if (!out.is_open()) {
+                err = "Cannot write " + tmp;
+                return false;
+            }
+            YAML::Emitter emitter;
+            emitter << root;
+            out << emitter.c_str() << "\n";
+            out.close();
+            if (out.fail()) {
+                err = "Cannot write " + tmp;
+                return false;
+            }
+        }
+        fs::rename(tmp, out_path);
+        return true;
+    } catch (const std::exception& e) {
+        err = e.what();
+        return false;
+    }
+}
+
+bool load_profile(const std::string& profile_path, YAML::Node& root, std::string& err) {
+    try {
+        root = YAML::LoadFile(profile_path);
+    } catch (const std::exception& e) {
+        err = std::string("Cannot load profile: ") + e.what();
+        return false;
+    }
+    if (!root.IsMap()) {
+        err = "Invalid profile: not a YAML mapping";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::map<std::string, int> inbound_ports(const std::string& profile_path) {
+    std::map<std::string, int> ports;
+    YAML::Node root;
+    std::string err;
+    if (!load_profile(profile_path, root, err)) return ports;
+    for (const char* key : kPortKeys) {
+        try {
+            if (root[key] && root[key].as<int>(0) > 0) ports[key] = root[key].as<int>();
+        } catch (...) {}
+    }
+    return ports;
+}
+
+std::map<std::string, int> closed_inbound_ports() {
+    std::map<std::string, int> ports;
+    for (const char* key : kPortKeys) ports[key] = 0;
+    return ports;
+}
+
+std::string shift_listen(const std::string& addr, int offset) {
+    size_t colon = addr.rfind(':');
+    if (colon == std::string::npos || colon + 1 >= addr.size()) return addr;
+    try {
+        size_t used = 0;
+        int port = std::stoi(addr.substr(colon + 1), &used);
+        if (used != addr.size() - colon - 1 || port <= 0) return addr;
+        return addr.substr(0, colon + 1) + std::to_string(port + offset);
+    } catch (...) {
+        return addr;
+    }
+}
+
+bool write_standby_config(const std::string& profile_path, const Ports& ports,
+                          const std::string& out_path, std::string& err) {
+    YAML::Node root;
+    if (!load_profile(profile_path, root, err)) return false;
+
+    try {
+        for (const char* key : kPortKeys) {
+            if (root[key] && root[key].as<int>(0) > 0) {
+                root[key] = root[key].as<int>() + ports.offset;
+            }
+        }
+        if (auto listeners = root["listeners"]; listeners && listeners.IsSequence()) {
+            for (auto l : listeners) {
+                if (l["port"] && l["port"].as<int>(0) > 0) l["port"] = l["port"].as<int>() + ports.offset;
+            }
+        }
+        if (auto dns = root["dns"]; dns && dns.IsMap() && dns["listen"]) {
+            dns["listen"] = shift_listen(dns["listen"].as<std::string>(""), ports.offset);
+        }
+        // Only one TUN device can own the routes
+        if (auto tun = root["tun"]; tun && tun.IsMap()) tun["enable"] = false;
+        set_controller(root, ports, ports.api_port + ports.offset);
+    } catch (const std::exception& e) {
+        err = std::string("Cannot rewrite profile: ") + e.what();
+        return false;
+    }
+    return write_yaml(root, out_path, err);
+}
+
+bool write_final_config(const std::string& profile_path, const Ports& ports,
+                        const std::string& out_path, std::string& err) {
+    YAML::Node root;
+    if (!load_profile(profile_path, root, err)) return false;
+    set_controller(root, ports, ports.api_port);
+    return write_yaml(root, out_path, err);
+}
+
+void share_geodata(const std::string& from_dir, const std::string& to_dir) {
+    static const char* const files[] = {
+        "geoip.metadb", "geosite.dat", "GeoIP.dat", "GeoSite.dat", "Country.mmdb", "GeoLite2-ASN.mmdb",
+    };
+    std::error_code ec;
+    fs::create_directories(to_dir, ec);
+    for (const char* name : files) {
+        fs::path src = fs::path(from_dir) / name;
+        fs::path dst = fs::path(to_dir) / name;
+        if (!fs::exists(src, ec) || fs::exists(dst, ec)) continue;
+        fs::create_hard_link(src, dst, ec);
+        if (ec) fs::copy_file(src, dst, ec);
+    }
+}
+
+} // namespace blue_green
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+/// Config staging for blue/green profile switches.
+///
+/// A standby mihomo loads the new profile in its own home directory while
+/// the running one keeps serving: every listener is moved by `offset`, the
+/// controller sits on api_port + offset and TUN stays off, so nothing
+/// collides. Provider and rule-set downloads land in the standby's home.
+/// At handover the top-level inbound ports move from the old instance to
+/// the standby through the API, then the standby is given the same profile
+/// with its real controller and other listeners, which reloads from those
+/// warm caches while the moved ports keep serving.
+namespace blue_green {
+
+struct Ports {
+    std::string api_host = "127.0.0.1";
+    int api_port = 9090;
+    std::string secret;
+    int offset = 10000;
+};
+
+/// Write the warm-up variant of `profile_path` to `out_path`
+bool write_standby_config(const std::string& profile_path, const Ports& ports,
+                          const std::string& out_path, std::string& err);
+
+/// Write the serving variant (own listeners, controller on api_port)
+bool write_final_config(const std::string& profile_path, const Ports& ports,
+                        const std::string& out_path, std::string& err);
+
+/// Top-level inbound ports the profile sets ("port", "socks-port",
+/// "mixed-port", "redir-port", "tproxy-port"), keyed by config name
+std::map<std::string, int> inbound_ports(const std::string& profile_path);
+
+/// Every top-level inbound port set to 0 (closed)
+std::map<std::string, int> closed_inbound_ports();
+
+/// "host:port" / ":port" with the port moved by `offset`; unchanged
+/// when there is no numeric port
+std::string shift_listen(const std::string& addr, int offset);
+
+/// Hard-link (or copy) geodata files from one mihomo home to another so a
+/// standby does not download them again
+void share_geodata(const std::string& from_dir, const std::string& to_dir);
+
+} // namespace blue_green
@@ -0,0 +1,183 @@
+#include "daemon/controller_cache.hpp"
+
+#include <chrono>
+
+using json = nlohmann::json;
+
+namespace {
+
+const char* const kPaths[] = {"/version", "/configs", "/proxies", "/connections"};
+
+/// Name of the keyed collection inside a path's response ("" = none)
+const char* collection_of(const std::string& path) {
+    if (path == "/proxies") return "proxies";
+    if (path == "/connections") return "connections";
+    return "";
+}
+
+} // namespace
+
+ControllerCache::ControllerCache(Options opts, FetchFn fetch)
+    : opts_(opts), fetch_(std::move(fetch)),
+      epoch_(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch()).count())) {
+    if (opts_.interval_ms < 100) opts_.interval_ms = 100;
+}
+
+ControllerCache::~ControllerCache() {
+    stop();
+}
+
+void ControllerCache::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&ControllerCache::poll_loop, this);
+}
+
+void ControllerCache::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        running_.store(false);
+    }
+    stop_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool ControllerCache::is_cached_path(const std::string& path) {
+    for (const char* p : kPaths) {
+        if (path == p) return true;
+    }
+    return false;
+}
+
+void ControllerCache::poll_loop() {
+    while (running_.load()) {
+        poll_once();
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        stop_cv_.wait_for(lock, std::chrono::milliseconds(opts_.interval_ms),
+                          [this] { return !running_.load(); });
+    }
+}
+
+void ControllerCache::poll_once() {
+    for (const char* p : kPaths) refresh(p);
+}
+
+bool ControllerCache::refresh(const std::string& path) {
+    if (!is_cached_path(path)) return false;
+
+    std::lock_guard<std::mutex> fetch_lock(fetch_mutex_);
+    std::string body;
+    bool ok = false;
+    json parsed;
+    try {
+        ++fetch_count_;
+        ok = fetch_ && fetch_(path, body);
+        if (ok) {
+            parsed = json::parse(body);
+            ok = parsed.is_object();
+        }
+    } catch (...) {
+        ok = false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Resource& r = resources_[path];
+    r.ok = ok;
+    if (ok) apply(r, parsed, path);
+    return ok;
+}
+
+void ControllerCache::apply(Resource& r, const json& body, const std::string& path) {
+    uint64_t next = r.version + 1;
+    bool changed = false;
+
+    std::string coll = collection_of(path);
+    json fields = body;
+    json items = json::object();
+    if (!coll.empty()) {
+        auto it = fields.find(coll);
+        if (it != fields.end()) {
+            if (it->is_object()) {
+                items = std::move(*it);
+            } else if (it->is_array()) {
+                for (auto& entry : *it) {
+                    if (!entry.is_object()) continue;
+                    const auto id = entry.find("id");
+                    if (id == entry.end()) continue;
+                    std::string key = id->is_string() ? id->get<std::string>() : id->dump();
+                    items[key] = std::move(entry);
+                }
+            }
+            fields.erase(it);  // mihomo sends null for an empty connection list
+        }
+    }
+
+    if (fields != r.fields) {
+        r.fields = std::move(fields);
+        r.fields_version = next;
+        changed = true;
+    }
+
+    for (auto& [key, value] : items.items()) {
+        auto it = r.items.find(key);
+        if (it == r.items.end()) {
+            r.items.emplace(key, Item{std::move(value), next});
+            changed = true;
+        } else if (it->second.value != value) {
+            it->second.value = std::move(value);
+            it->second.version = next;
+            changed = true;
+        }
+    }
+
+    for (auto it = r.items.begin(); it != r.items.end();) {
+        if (items.contains(it->first)) {
+            ++it;
+            continue;
+        }
+        r.removed.emplace_back(next, it->first);
+        it = r.items.erase(it);
+        changed = true;
+    }
+    while (r.removed.size() > opts_.max_removed) {
+        r.floor = r.removed.front().first;
+        r.removed.pop_front();
+    }
+
+    if (changed) r.version = next;
+}
+
+bool ControllerCache::delta(const std::string& path, uint64_t epoch, uint64_t since,
+                            json& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto rit = resources_.find(path);
+    if (rit == resources_.end() || !rit->second.ok) return false;
+    const Resource& r = rit->second;
+
+    // Unknown epoch (daemon restarted), a future version or forgotten
+    // removals: the client has to start over
+    bool full = since == 0 || epoch != epoch_ || since > r.version || since < r.floor;
+    if (full) since = 0;
+
+    out = json::object();
+    out["epoch"] = epoch_;
+    out["version"] = r.version;
+    out["full"] = full;
+    if (r.fields_version > since) out["fields"] = r.fields;
+
+    json items = json::object();
+    for (const auto& [key, item] : r.items) {
+        if (item.version > since) items[key] = item.value;
+    }
+    out["items"] = std::move(items);
+
+    json removed = json::array();
+    if (!full) {
+        for (const auto& [version, key] : r.removed) {
+            // A key may have come back after its removal
+            if (version > since && !r.items.count(key)) removed.push_back(key);
+        }
+    }
+    out["removed"] = std::move(removed);
+    return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/// Shared snapshots of mihomo's read-only controller endpoints.
+///
+/// The daemon polls /version, /configs, /proxies and /connections once per
+/// interval, however many clients are attached, and keeps each response
+/// split into top-level fields plus a keyed collection (proxies by name,
+/// connections by id). Every poll that changes something bumps the path's
+/// version and stamps the changed entries with it, so a client that
+/// remembers the version it last saw only receives what changed since.
+/// Removed entries are remembered for a while; a client further behind
+/// than that (or from before a daemon restart) gets a full snapshot.
+class ControllerCache {
+public:
+    struct Options {
+        int interval_ms = 1000;      // poll period
+        size_t max_removed = 1024;   // removal records kept per path
+    };
+
+    /// GET `path` from mihomo; false if unreachable or not 200
+    using FetchFn = std::function<bool(const std::string& path, std::string& body)>;
+
+    ControllerCache(Options opts, FetchFn fetch);
+    ~ControllerCache();
+
+    ControllerCache(const ControllerCache&) = delete;
+    ControllerCache& operator=(const ControllerCache&) = delete;
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    static bool is_cached_path(const std::string& path);
+
+    /// Fetch every path once (what the poll thread does each interval)
+    void poll_once();
+
+    /// Fetch one path now, e.g. after a client changed it
+    bool refresh(const std::string& path);
+
+    /// Changes to `path` after `since` in the given epoch (0 = full snapshot):
+    /// {epoch, version, full, fields?, items, removed}. `fields` is present
+    /// when the top-level values changed. False if the last fetch failed.
+    bool delta(const std::string& path, uint64_t epoch, uint64_t since,
+               nlohmann::json& out) const;
+
+    /// Identifies this cache instance; versions restart with it
+    uint64_t epoch() const { return epoch_; }
+
+    /// Requests sent to mihomo so far
+    uint64_t fetch_count() const { return fetch_count_.load(); }
+
+private:
+    struct Item {
+        nlohmann::json value;
+        uint64_t version = 0;
+    };
+
+    struct Resource {
+        bool ok = false;             // last fetch succeeded
+        uint64_t version = 0;
+        nlohmann::json fields = nlohmann::json::object();
+        uint64_t fields_version = 0;
+        std::map<std::string, Item> items;
+        std::deque<std::pair<uint64_t, std::string>> removed;  // oldest first
+        uint64_t floor = 0;          // removals before this were forgotten
+    };
+
+    Options opts_;
+    FetchFn fetch_;
+    uint64_t epoch_;
+    std::atomic<uint64_t> fetch_count_{0};
+
+    mutable std::mutex mutex_;
+    std::map<std::string, Resource> resources_;
+
+    std::mutex fetch_mutex_;     // one fetch per path at a time
+    std::atomic<bool> running_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    std::thread thread_;
+
+    void poll_loop();
+    void apply(Resource& r, const nlohmann::json& body, const std::string& path);
+};
@@ -1,27 +1,159 @@
 #include "daemon/daemon.hpp"
 #include "core/installer.hpp"
+#include "core/selection_lock.hpp"
+#include "daemon/blue_green.hpp"
+#include "daemon/readiness.hpp"
 
 #ifndef APP_VERSION
 #define APP_VERSION "0.0.0"
 #endif
 
 #include <nlohmann/json.hpp>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <sys/stat.h>
 #include <unistd.h>
-#include <poll.h>
+#include <algorithm>
 #include <filesystem>
 #include <chrono>
 
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+namespace {
+
+// How long a request without "async" holds an IPC worker for its job;
+// below the 30 s clients wait for a reply, so the job id still reaches them
+constexpr int kSyncJobWaitMs = 25000;
+
+// Restart accounting of a mihomo process for `status`
+json health_json(const ProcessManager::Stats& st) {
+    json recent = json::array();
+    for (const auto& e : st.recent) {
+        recent.push_back({{"time", e.time_ms}, {"exit_code", e.exit_code},
+                          {"signal", e.signal}, {"uptime_ms", e.uptime_ms}});
+    }
+    return {{"started", st.started_ms}, {"restarts", st.restarts}, {"crashes", st.crashes},
+            {"consecutive_crashes", st.consecutive_crashes}, {"crash_loop", st.crash_loop},
+            {"recent_exits", recent}};
+}
+
+json launch_json(const ProcessManager::LaunchReport& r) {
+    return {{"pid", r.pid}, {"cpus", r.cpus}, {"nice", r.nice},
+            {"ionice_class", r.ionice_class}, {"ionice_level", r.ionice_level},
+            {"nofile_soft", r.nofile_soft}, {"nofile_hard", r.nofile_hard},
+            {"memory_bytes", r.memory_bytes}, {"env", r.env}, {"failed", r.failed}};
+}
+
+json sample_json(const ResourceMonitor::Sample& s) {
+    return {{"t", s.time_ms}, {"pid", s.pid}, {"cpu_pct", s.cpu_pct}, {"rss_kb", s.rss_kb},
+            {"fds", s.fds}, {"threads", s.threads}};
+}
+
+} // namespace
+
 Daemon::Daemon(Config& config)
-    : config_(config), profile_mgr_(config) {}
+    : config_(config), profile_mgr_(config),
+      latency_store_(LatencyStore::default_path(), config.data().latency_db_max_records) {
+    // Created up front: IPC workers share it and must not race on creation
+    client_ = std::make_unique<MihomoClient>(
+        config_.data().api_host,
+        config_.data().api_port,
+        config_.data().api_secret
+    );
+    refresh_active_profile();
+
+    profile_mgr_.on_change = [this](const std::string& event, const std::string& name) {
+        if (event == "profile_changed") refresh_active_profile();
+        update_scheduler_.set_profiles(profile_mgr_.list_profiles());
+        publish_event(event, {{"profile", name}});
+    };
+    LogRing::Options log_opts;
+    log_opts.max_lines = static_cast<size_t>(std::max(1, config_.data().mihomo_log_lines));
+    if (config_.data().mihomo_log_file_enabled) {
+        log_opts.file = Config::config_dir() + "/logs/mihomo.log";
+        log_opts.file_max_bytes = static_cast<int64_t>(config_.data().mihomo_log_file_max_kb) * 1024;
+        log_opts.file_keep = config_.data().mihomo_log_file_keep;
+    }
+    mihomo_log_ = std::make_unique<LogRing>(log_opts);
+
+    const auto& cfg = config_.data();
+    ProcessManager::LaunchOptions launch;
+    launch.cpus = cfg.mihomo_cpus;
+    launch.nice = cfg.mihomo_nice;
+    launch.ionice_class = cfg.mihomo_ionice_class;
+    launch.ionice_level = std::clamp(cfg.mihomo_ionice_level, 0, 7);
+    launch.nofile = static_cast<uint64_t>(std::max(0, cfg.mihomo_nofile));
+    launch.memory_bytes = static_cast<uint64_t>(std::max(0, cfg.mihomo_memory_limit_mb)) << 20;
+    if (cfg.mihomo_gomaxprocs > 0) launch.env.emplace_back("GOMAXPROCS", std::to_string(cfg.mihomo_gomaxprocs));
+    if (cfg.mihomo_gomemlimit_mb > 0) {
+        launch.env.emplace_back("GOMEMLIMIT", std::to_string(cfg.mihomo_gomemlimit_mb) + "MiB");
+    }
+
+    for (int slot = 0; slot < 2; ++slot) {
+        // A warming standby stays quiet until it takes over
+        mihomo_[slot] = std::make_unique<ProcessManager>();
+        mihomo_[slot]->set_launch_options(launch);
+        mihomo_[slot]->on_start = [this, slot](pid_t pid) {
+            if (slot == active_slot_.load()) publish_event("mihomo_started", {{"pid", pid}});
+        };
+        mihomo_[slot]->on_crash = [this, slot](int exit_code) {
+            if (slot != active_slot_.load()) return;
+            publish_event("mihomo_exited", {{"exit_code", exit_code}, {"crashed", true}});
+        };
+        mihomo_[slot]->on_crash_loop = [this, slot](const ProcessManager::Stats& st) {
+            if (slot != active_slot_.load()) return;
+            int exit_code = st.recent.empty() ? -1 : st.recent.back().exit_code;
+            publish_event("mihomo_crash_loop", {{"exit_code", exit_code},
+                                                {"crashes", st.consecutive_crashes}});
+        };
+        // Both slots write into one ring while a standby warms up; the slot
+        // keeps their half lines apart
+        mihomo_[slot]->set_output_sink([this, slot](int stream, const char* data, size_t len) {
+            const char* name = stream == STDERR_FILENO ? "stderr" : "stdout";
+            if (len == 0) mihomo_log_->flush(name, slot);
+            else mihomo_log_->append(name, data, len, slot);
+        });
+    }
+
+    ControllerCache::Options cache_opts;
+    cache_opts.interval_ms = config_.data().controller_cache_interval_ms;
+    cache_client_ = std::make_unique<MihomoClient>(
+        config_.data().api_host,
+        config_.data().api_port,
+        config_.data().api_secret
+    );
+    MihomoClient* cache_client = cache_client_.get();
+    controller_cache_ = std::make_unique<ControllerCache>(
+        cache_opts, [cache_client](const std::string& path, std::string& body) {
+            return cache_client->get_raw(path, body);
+        });
+
+    // One worker beyond the auto-update limit keeps user commands moving
+    int workers = std::max(2, config_.data().auto_update_concurrency + 1);
+    jobs_ = std::make_unique<JobQueue>(workers, [this](const JobInfo& info) {
+        publish_event("job", job_to_json(info));
+    });
+
+    const auto& d = config_.data();
+    ResourceMonitor::Options mon_opts;
+    mon_opts.interval_ms = std::max(1, d.mihomo_monitor_interval_sec) * 1000;
+    mon_opts.history = static_cast<size_t>(std::max(1, d.mihomo_monitor_history));
+    mon_opts.limits.rss_warn_kb = static_cast<uint64_t>(std::max(0, d.mihomo_monitor_rss_warn_mb)) * 1024;
+    mon_opts.limits.rss_restart_kb = static_cast<uint64_t>(std::max(0, d.mihomo_monitor_rss_restart_mb)) * 1024;
+    mon_opts.limits.fds_warn = d.mihomo_monitor_fds_warn;
+    mon_opts.limits.fds_restart = d.mihomo_monitor_fds_restart;
+    mon_opts.limits.cpu_warn_pct = d.mihomo_monitor_cpu_warn_pct;
+    mon_opts.limits.sustain = d.mihomo_monitor_sustain;
+    resource_monitor_ = std::make_unique<ResourceMonitor>(
+        mon_opts,
+        [this] { return mihomo_proc().child_pid(); },
+        [this](const ResourceMonitor::Sample& s, const std::vector<ResourceMonitor::Alert>& alerts) {
+            on_resource_sample(s, alerts);
+        });
+}
 
 Daemon::~Daemon() {
     request_stop();
+    resource_monitor_->stop();
+    jobs_->stop();
     cleanup_socket();
 }
 
@@ -32,9 +164,12 @@ std::string Daemon::socket_path() const {
 }
 
 void Daemon::cleanup_socket() {
-    if (socket_fd_ >= 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+    {
+        std::lock_guard<std::mutex> lock(events_mutex_);
+        if (ipc_server_) {
+            ipc_server_->close();
+            ipc_server_.reset();
+        }
     }
     std::string path = socket_path();
     if (!path.empty()) {
@@ -43,101 +178,139 @@ void Daemon::cleanup_socket() {
 }
 
 bool Daemon::start_ipc_server() {
-    std::string path = socket_path();
-    if (path.empty()) return false;
-
-    // Clean up any existing socket
-    unlink(path.c_str());
+    std::lock_guard<std::mutex> lock(events_mutex_);
+    ipc_server_ = std::make_unique<IpcServer>(
+        IpcServer::Options{},
+        [this](const json& req) { return handle_request(req); },
+        &Daemon::is_slow_command,
+        &Daemon::is_subscribe_command);
 
-    // Ensure directory exists
-    try {
-        fs::create_directories(fs::path(path).parent_path());
-    } catch (...) {
+    if (!ipc_server_->listen(socket_path())) {
+        ipc_server_.reset();
         return false;
     }
+    return true;
+}
 
-    socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (socket_fd_ < 0) return false;
-
-    struct sockaddr_un addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+void Daemon::ipc_loop() {
+    if (ipc_server_) ipc_server_->run(stop_flag_);
+}
 
-    if (bind(socket_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
+bool Daemon::is_slow_command(const json& req) {
+    // Anything that downloads, touches profile files, talks to mihomo or
+    // scans the latency database goes to the worker pool
+    try {
+        std::string cmd = req.value("cmd", "");
+        return cmd.rfind("profile_", 0) == 0 ||
+               (cmd.rfind("mihomo_", 0) == 0 && cmd != "mihomo_logs" && cmd != "mihomo_resources") ||
+               cmd == "latency_stats" ||
+               cmd == "latency_record" ||  // waits on the store lock a scan holds
+               (cmd == "controller" && req.value("refresh", false));
+    } catch (...) {
         return false;
     }
+}
 
-    // Allow non-root users to connect to daemon socket
-    chmod(path.c_str(), 0660);
-
-    if (listen(socket_fd_, 5) < 0) {
-        close(socket_fd_);
-        socket_fd_ = -1;
-        unlink(path.c_str());
+bool Daemon::is_subscribe_command(const json& req) {
+    try {
+        return req.value("cmd", "") == "subscribe";
+    } catch (...) {
         return false;
     }
+}
 
-    return true;
+void Daemon::publish_event(const std::string& type, const json& data) {
+    json ev = {
+        {"event", type},
+        {"t", std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::system_clock::now().time_since_epoch()).count()},
+        {"data", data}
+    };
+    std::lock_guard<std::mutex> lock(events_mutex_);
+    if (ipc_server_) ipc_server_->broadcast(ev);
 }
 
-void Daemon::ipc_loop() {
-    struct pollfd pfd;
-    pfd.fd = socket_fd_;
-    pfd.events = POLLIN;
+void Daemon::refresh_active_profile() {
+    std::string name = profile_mgr_.active_profile_name();
+    std::lock_guard<std::mutex> lock(active_mutex_);
+    active_profile_ = std::move(name);
+}
 
-    while (!stop_flag_.load()) {
-        int ret = poll(&pfd, 1, 500); // 500ms timeout
-        if (ret <= 0) continue;
-
-        if (pfd.revents & POLLIN) {
-            int client_fd = accept(socket_fd_, nullptr, nullptr);
-            if (client_fd < 0) continue;
-
-            // Read a single JSON line
-            std::string buffer;
-            char c;
-            while (read(client_fd, &c, 1) == 1) {
-                if (c == '\n') break;
-                buffer += c;
-                if (buffer.size() > 65536) break; // prevent abuse
-            }
-
-            if (!buffer.empty()) {
-                std::string response = handle_command(buffer);
-                response += "\n";
-                // Write response (ignore partial writes for simplicity)
-                ssize_t total = 0;
-                while (total < (ssize_t)response.size()) {
-                    ssize_t n = write(client_fd, response.data() + total,
-                                      response.size() - total);
-                    if (n <= 0) break;
-                    total += n;
-                }
-            }
+std::string Daemon::active_profile() {
+    std::lock_guard<std::mutex> lock(active_mutex_);
+    return active_profile_;
+}
 
-            close(client_fd);
-        }
-    }
+json Daemon::handle_request(const json& req) {
+    json resp = dispatch_command(req);
+
+    // Echo the request id so clients with several requests in flight can
+    // match replies
+    if (req.is_object() && req.contains("id")) resp["id"] = req["id"];
+    return resp;
 }
 
-std::string Daemon::handle_command(const std::string& json_line) {
+json Daemon::dispatch_command(const json& req) {
     try {
-        auto req = json::parse(json_line);
         std::string cmd = req.value("cmd", "");
 
         if (cmd == "status") {
             json data;
             data["version"] = APP_VERSION;
-            data["mihomo_running"] = process_mgr_.is_running();
-            data["mihomo_pid"] = process_mgr_.child_pid();
-            data["active_profile"] = profile_mgr_.active_profile_name();
-            return json({{"ok", true}, {"data", data}}).dump();
+            data["mihomo_running"] = mihomo_proc().is_running();
+            data["mihomo_pid"] = mihomo_proc().child_pid();
+            data["mihomo_health"] = health_json(mihomo_proc().stats());
+            {
+                std::lock_guard<std::mutex> lock(active_mutex_);
+                data["active_profile"] = active_profile_;
+            }
+            // What mihomo actually loaded (a blue/green slot serves its own copy)
+            int slot = active_slot_.load();
+            data["mihomo_home"] = slot_home(slot);
+            data["mihomo_config"] = served_config(slot);
+            data["reloads_skipped"] = reloads_skipped_.load();
+            data["restart_downtime_ms"] = restart_downtime_ms_.load();
+            data["startup_ready_ms"] = startup_ready_ms_.load();
+            json resources = {{"enabled", resource_monitor_->is_running()},
+                              {"planned_restarts", resource_restarts_.load()}};
+            ResourceMonitor::Sample sample;
+            if (resource_monitor_->latest(sample) && sample.pid == data["mihomo_pid"].get<int>()) {
+                resources["current"] = sample_json(sample);
+            }
+            data["mihomo_resources"] = resources;
+            data["mihomo_launch"] = launch_json(mihomo_proc().launch_report());
+            return json({{"ok", true}, {"data", data}});
+        }
+
+        if (cmd == "subscribe") {
+            // The IPC server marks this connection; events follow as lines
+            json events = {"profile_added", "profile_updated", "profile_deleted",
+                           "profile_changed", "mihomo_started", "mihomo_exited",
+                           "config_reloaded", "job", "mihomo_resources",
+                           "mihomo_resource_alert", "mihomo_crash_loop"};
+            return json({{"ok", true}, {"data", {{"events", events}}}});
+        }
+
+        if (cmd == "controller") {
+            // Shared snapshot of a mihomo endpoint, as changes since `since`
+            std::string path = req.value("path", "");
+            if (!controller_cache_->is_running()) {
+                return json({{"ok", false}, {"error", "Controller cache disabled"}});
+            }
+            if (!ControllerCache::is_cached_path(path)) {
+                return json({{"ok", false}, {"error", "Path not cached: " + path}});
+            }
+            if (req.value("refresh", false)) controller_cache_->refresh(path);
+            json data;
+            if (!controller_cache_->delta(path, req.value("epoch", uint64_t{0}),
+                                          req.value("since", uint64_t{0}), data)) {
+                return json({{"ok", false}, {"error", "Mihomo API not reachable"}});
+            }
+            return json({{"ok", true}, {"data", data}});
         }
 
         if (cmd == "profile_list") {
+            std::lock_guard<std::mutex> lock(profile_mutex_);
             auto profiles = profile_mgr_.list_profiles();
             json arr = json::array();
             for (const auto& p : profiles) {
@@ -151,93 +324,516 @@ std::string Daemon::handle_command(const std::string& json_line) {
                     {"is_active", p.is_active}
                 });
             }
-            return json({{"ok", true}, {"data", arr}}).dump();
+            return json({{"ok", true}, {"data", arr}});
         }
 
-        if (cmd == "profile_add") {
-            std::lock_guard<std::mutex> lock(profile_mutex_);
-            std::string name = req.value("name", "");
-            std::string url = req.value("url", "");
-            auto result = profile_mgr_.add_profile(name, url);
-            if (result.success) {
-                return json({{"ok", true}}).dump();
+        if (cmd == "latency_stats") {
+            int64_t since = req.value("since", (int64_t)0);
+            uint16_t flags = req.value("flags", (uint16_t)0);
+            // Node names are only unique within a profile
+            std::string profile = req.value("profile", "");
+            if (profile.empty()) profile = active_profile();
+            std::map<std::string, LatencyStats> stats;
+            if (req.contains("names") && req["names"].is_array()) {
+                stats = latency_store_.stats(req["names"].get<std::vector<std::string>>(), since,
+                                             flags, profile);
+            } else {
+                stats = latency_store_.stats_all(since, flags, profile);
+            }
+            json arr = json::array();
+            for (const auto& [name, st] : stats) {
+                arr.push_back({
+                    {"name", st.name},
+                    {"samples", st.samples},
+                    {"failures", st.failures},
+                    {"min", st.min},
+                    {"avg", st.avg},
+                    {"p50", st.p50},
+                    {"p95", st.p95},
+                    {"p99", st.p99},
+                    {"first_seen", st.first_seen},
+                    {"last_seen", st.last_seen}
+                });
             }
-            return json({{"ok", false}, {"error", result.error}}).dump();
+            return json({{"ok", true}, {"data", arr}});
         }
 
-        if (cmd == "profile_update") {
-            std::lock_guard<std::mutex> lock(profile_mutex_);
-            std::string name = req.value("name", "");
-            auto result = profile_mgr_.update_profile(name);
-            if (result.success) {
-                if (result.was_active) {
-                    reload_mihomo();
+        if (cmd == "latency") {
+            int64_t since = req.value("since", (int64_t)0);
+            size_t history = req.value("history", (size_t)0);
+            json data;
+            data["now"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            json nodes = json::object();
+            if (prober_) {
+                for (const auto& [name, nl] : prober_->snapshot(since, history)) {
+                    json item = {
+                        {"state", nl.state},
+                        {"delay", nl.delay},
+                        {"t", nl.last_probe_ms},
+                        {"min", nl.min},
+                        {"avg", nl.avg},
+                        {"p95", nl.p95},
+                        {"failures", nl.failures},
+                        {"samples", nl.samples}
+                    };
+                    if (!nl.history.empty()) {
+                        json hist = json::array();
+                        for (const auto& h : nl.history) hist.push_back({h.timestamp_ms, h.delay});
+                        item["history"] = std::move(hist);
+                    }
+                    nodes[name] = std::move(item);
                 }
-                return json({{"ok", true}}).dump();
             }
-            return json({{"ok", false}, {"error", result.error}}).dump();
+            data["nodes"] = std::move(nodes);
+            data["prober_running"] = prober_ && prober_->is_running();
+            return json({{"ok", true}, {"data", data}});
+        }
+
+        if (cmd == "auto_select_log") {
+            size_t limit = req.value("limit", (size_t)50);
+            json arr = json::array();
+            if (auto_selector_) {
+                for (const auto& d : auto_selector_->recent_decisions(limit)) {
+                    arr.push_back({
+                        {"t", d.time_ms},
+                        {"group", d.group},
+                        {"from", d.from},
+                        {"to", d.to},
+                        {"from_score", d.from_score},
+                        {"to_score", d.to_score},
+                        {"reason", d.reason},
+                        {"applied", d.applied},
+                        {"apply_ms", d.apply_ms}
+                    });
+                }
+            }
+            return json({{"ok", true}, {"data", arr}});
+        }
+
+        if (cmd == "latency_record") {
+            std::string name = req.value("name", "");
+            if (name.empty()) {
+                return json({{"ok", false}, {"error", "Missing node name"}});
+            }
+            std::string profile = req.value("profile", "");
+            if (profile.empty()) profile = active_profile();
+            if (latency_store_.append(name, req.value("delay", 0), 0, 0, profile)) {
+                return json({{"ok", true}});
+            }
+            return json({{"ok", false}, {"error", "Latency database unavailable"}});
+        }
+
+        if (cmd == "profile_add" || cmd == "profile_update" || cmd == "mihomo_restart") {
+            uint64_t id;
+            if (cmd == "profile_add") {
+                id = submit_profile_add(req.value("name", ""), req.value("url", ""));
+            } else if (cmd == "profile_update") {
+                id = submit_profile_update(req.value("name", ""));
+            } else {
+                id = submit_mihomo_restart();
+            }
+
+            // Async callers follow progress via job_status or events
+            if (req.value("async", false)) {
+                return json({{"ok", true}, {"data", {{"job", id}}}});
+            }
+            JobInfo info;
+            if (!jobs_->wait(id, info, kSyncJobWaitMs)) {
+                // Free the worker; the job keeps running and can be polled
+                return json({{"ok", false},
+                             {"error", "Still running as job " + std::to_string(id) +
+                                       " (see `job`)"},
+                             {"data", {{"job", id}, {"state", info.state}}}});
+            }
+            if (info.state == "done") {
+                return json({{"ok", true}, {"data", {{"job", id}}}});
+            }
+            return json({{"ok", false}, {"error", info.error}, {"data", {{"job", id}}}});
+        }
+
+        if (cmd == "job_status") {
+            // The job is named by "job": "id" is the request id
+            uint64_t id = req.value("job", (uint64_t)0);
+            if (id == 0) {
+                json arr = json::array();
+                for (const auto& info : jobs_->list()) arr.push_back(job_to_json(info));
+                return json({{"ok", true}, {"data", arr}});
+            }
+            JobInfo info;
+            if (!jobs_->get(id, info)) {
+                return json({{"ok", false}, {"error", "Unknown job: " + std::to_string(id)}});
+            }
+            return json({{"ok", true}, {"data", job_to_json(info)}});
+        }
+
+        if (cmd == "job_cancel") {
+            uint64_t id = req.value("job", (uint64_t)0);
+            if (jobs_->cancel(id)) {
+                return json({{"ok", true}});
+            }
+            return json({{"ok", false}, {"error", "No such running job"}});
         }
 
         if (cmd == "profile_delete") {
             std::lock_guard<std::mutex> lock(profile_mutex_);
             std::string name = req.value("name", "");
             if (profile_mgr_.delete_profile(name)) {
-                return json({{"ok", true}}).dump();
+                return json({{"ok", true}});
             }
-            return json({{"ok", false}, {"error", "Failed to delete profile"}}).dump();
+            return json({{"ok", false}, {"error", "Failed to delete profile"}});
         }
 
-        if (cmd == "profile_switch") {
+        if (cmd == "profile_set_interval") {
             std::lock_guard<std::mutex> lock(profile_mutex_);
             std::string name = req.value("name", "");
-            if (profile_mgr_.switch_active(name)) {
-                reload_mihomo();
-                return json({{"ok", true}}).dump();
+            if (profile_mgr_.set_update_interval(name, req.value("hours", 0))) {
+                return json({{"ok", true}});
+            }
+            return json({{"ok", false}, {"error", "Profile not found: " + name}});
+        }
+
+        if (cmd == "profile_switch") {
+            std::string name = req.value("name", "");
+            bool switched;
+            {
+                std::lock_guard<std::mutex> lock(profile_mutex_);
+                switched = profile_mgr_.switch_active(name);
+            }
+            if (switched) {
+                reload_mihomo(true);
+                return json({{"ok", true}});
+            }
+            return json({{"ok", false}, {"error", "Failed to switch profile"}});
+        }
+
+        if (cmd == "mihomo_logs") {
+            // Lines after `since`; followers pass back `next`
+            uint64_t since = req.value("since", uint64_t{0});
+            size_t limit = std::min<size_t>(req.value("limit", size_t{200}), 5000);
+            uint64_t next = 0;
+            json lines = json::array();
+            for (const auto& l : mihomo_log_->read(since, limit, &next)) {
+                lines.push_back({{"seq", l.seq}, {"t", l.time_ms}, {"stream", l.stream}, {"text", l.text}});
             }
-            return json({{"ok", false}, {"error", "Failed to switch profile"}}).dump();
+            return json({{"ok", true}, {"data", {{"lines", lines}, {"next", next}}}});
+        }
+
+        if (cmd == "mihomo_resources") {
+            // Sample history, oldest first (answered inline like mihomo_logs)
+            json samples = json::array();
+            for (const auto& s : resource_monitor_->history()) samples.push_back(sample_json(s));
+            return json({{"ok", true}, {"data", {{"samples", samples}}}});
         }
 
         if (cmd == "mihomo_start") {
+            std::lock_guard<std::mutex> lock(mihomo_mutex_);
             std::string binary = Config::expand_home(config_.data().mihomo_binary_path);
             std::string mihomo_dir = Config::mihomo_dir();
             if (mihomo_dir.empty()) {
-                return json({{"ok", false}, {"error", "Cannot determine mihomo directory"}}).dump();
+                return json({{"ok", false}, {"error", "Cannot determine mihomo directory"}});
             }
             Installer::ensure_geodata(mihomo_dir);
-            if (process_mgr_.start(binary, {"-d", mihomo_dir})) {
+            if (start_primary_mihomo(binary, mihomo_dir)) {
                 wait_for_mihomo();
-                return json({{"ok", true}}).dump();
+                if (prober_) prober_->refresh_targets();
+                return json({{"ok", true}});
             }
-            return json({{"ok", false}, {"error", "Failed to start mihomo"}}).dump();
+            return json({{"ok", false}, {"error", "Failed to start mihomo"}});
         }
 
         if (cmd == "mihomo_stop") {
-            if (process_mgr_.stop()) {
-                return json({{"ok", true}}).dump();
+            std::lock_guard<std::mutex> lock(mihomo_mutex_);
+            bool was_running = mihomo_proc().is_running();
+            if (mihomo_proc().stop()) {
+                if (was_running) publish_event("mihomo_exited", {{"exit_code", 0}, {"crashed", false}});
+                return json({{"ok", true}});
             }
-            return json({{"ok", false}, {"error", "Failed to stop mihomo"}}).dump();
+            return json({{"ok", false}, {"error", "Failed to stop mihomo"}});
         }
 
-        if (cmd == "mihomo_restart") {
-            if (process_mgr_.restart()) {
-                wait_for_mihomo();
-                reload_mihomo();
-                return json({{"ok", true}}).dump();
+        return json({{"ok", false}, {"error", "Unknown command: " + cmd}});
+
+    } catch (const std::exception& e) {
+        return json({{"ok", false}, {"error", std::string("Parse error: ") + e.what()}});
+    }
+}
+
+bool Daemon::reload_mihomo(bool blue_green) {
+    // The profile lock covers only the deploy: a standby warm-up can take a
+    // minute, and profile commands and updates go on meanwhile
+    std::string deployed, profile;
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(profile_mutex_);
+        deployed = profile_mgr_.deploy_active_to_mihomo();
+        profile = profile_mgr_.active_profile_path();
+        generation = ++reload_generation_;
+    }
+    if (deployed.empty() || !client_) return false;
+    // A reload requested later loads a newer profile, so this one stands down
+    auto superseded = [this, generation] { return reload_generation_.load() != generation; };
+
+    bool ok = false;
+    std::string mode = "reload";
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(mihomo_mutex_);
+        if (superseded()) return true;
+        bool switched = false;
+        if (blue_green && config_.data().blue_green_enabled && mihomo_proc().is_running()) {
+            switched = blue_green_switch(profile, superseded, ok, error);
+            if (switched) mode = "blue_green";
+        }
+        if (!switched && superseded()) return true;  // abandoned before the handover
+        if (!switched) {
+            // mihomo only loads configs from inside its home directory
+            if (active_slot_.load() != 0) {
+                const auto& cfg = config_.data();
+                blue_green::Ports ports;
+                ports.api_host = cfg.api_host;
+                ports.api_port = cfg.api_port;
+                ports.secret = cfg.api_secret;
+                std::string slot_cfg = slot_home(active_slot_.load()) + "/config.yaml";
+                std::string err;
+                if (blue_green::write_final_config(profile, ports, slot_cfg, err)) deployed = slot_cfg;
+            }
+            if (mihomo_proc().crash_looped()) {
+                // Restarts were suspended until the config changed
+                ok = mihomo_proc().restart() && wait_for_mihomo();
+                mode = "restart";
+            } else {
+                ok = client_->reload_config(deployed);
             }
-            return json({{"ok", false}, {"error", "Failed to restart mihomo"}}).dump();
         }
+    }
+    std::string active = active_profile();
+    if (controller_cache_->is_running()) {
+        controller_cache_->refresh("/configs");
+        controller_cache_->refresh("/proxies");
+    }
+    json event = {{"profile", active}, {"ok", ok}, {"mode", mode}};
+    if (!error.empty()) event["blue_green_error"] = error;
+    publish_event("config_reloaded", event);
+    if (prober_) prober_->refresh_targets();
+    return ok;
+}
 
-        return json({{"ok", false}, {"error", "Unknown command: " + cmd}}).dump();
+std::string Daemon::slot_home(int slot) {
+    std::string dir = Config::mihomo_dir();
+    if (dir.empty() || slot == 0) return dir;
+    return dir + "/blue-green";
+}
 
-    } catch (const std::exception& e) {
-        return json({{"ok", false}, {"error", std::string("Parse error: ") + e.what()}}).dump();
+std::string Daemon::served_config(int slot) const {
+    std::string home = slot_home(slot);
+    if (home.empty()) return "";
+    if (slot != 0) return home + "/config.yaml";
+    // reload_mihomo() loads the deployed profile; without one, mihomo
+    // runs its home directory's default config
+    std::string deployed = Config::expand_home(config_.data().mihomo_config_path);
+    if (!deployed.empty() && fs::exists(deployed)) return deployed;
+    return home + "/config.yaml";
+}
+
+bool Daemon::start_primary_mihomo(const std::string& binary, const std::string& mihomo_dir) {
+    mihomo_[1]->stop();
+    active_slot_.store(0);
+    mihomo_[0]->set_auto_restart(true);
+    return mihomo_[0]->start(binary, {"-d", mihomo_dir});
+}
+
+bool Daemon::blue_green_switch(const std::string& profile,
+                               const std::function<bool()>& superseded, bool& ok,
+                               std::string& err) {
+    const auto& cfg = config_.data();
+    int from = active_slot_.load();
+    int to = 1 - from;
+    std::string home = slot_home(to);
+    std::string binary = Config::expand_home(cfg.mihomo_binary_path);
+    if (profile.empty() || home.empty() || binary.empty()) {
+        err = "No profile or mihomo directory";
+        return false;
+    }
+
+    blue_green::Ports ports;
+    ports.api_host = cfg.api_host;
+    ports.api_port = cfg.api_port;
+    ports.secret = cfg.api_secret;
+    ports.offset = cfg.blue_green_port_offset;
+
+    // The standby reads and later serves the same file, so crash restarts
+    // after the handover come back with the real listeners
+    std::string slot_cfg = home + "/config.yaml";
+    blue_green::share_geodata(slot_home(from), home);
+    if (!blue_green::write_standby_config(profile, ports, slot_cfg, err)) return false;
+
+    // 1. Warm up beside the running instance
+    ProcessManager& standby = *mihomo_[to];
+    standby.set_auto_restart(false);
+    if (!standby.start(binary, {"-d", home, "-f", slot_cfg})) {
+        err = "Failed to start standby mihomo";
+        return false;
+    }
+    MihomoClient probe(cfg.api_host, cfg.api_port + ports.offset, cfg.api_secret);
+    bool healthy = false;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(std::max(1, cfg.blue_green_ready_timeout_sec));
+    while (!healthy && standby.is_running() && !stop_flag_.load() &&
+           std::chrono::steady_clock::now() < deadline) {
+        // Ready once the API answers with the profile's proxies loaded
+        healthy = probe.test_connection() && !probe.get_proxy_nodes().empty();
+        if (!healthy) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    if (!healthy) {
+        err = standby.is_running() ? "Standby mihomo did not become healthy"
+                                   : "Standby mihomo failed to load the profile";
+        standby.stop();
+        return false;
+    }
+    if (!blue_green::write_final_config(profile, ports, slot_cfg, err)) {
+        standby.stop();
+        return false;
+    }
+    if (superseded()) {
+        // The profile changed again while warming up
+        err = "Superseded by a newer reload";
+        standby.stop();
+        return false;
+    }
+
+    // 2. Handover of the proxy ports through the API, which rebinds only
+    //    those listeners: the old instance closes its top-level inbounds
+    //    and the standby binds them right after, so new connections are
+    //    refused for two API round trips; open ones stay on the old
+    //    instance until it stops.
+    MihomoClient serving(cfg.api_host, cfg.api_port, cfg.api_secret);
+    std::map<std::string, int> old_ports;
+    std::string body;
+    if (serving.get_raw("/configs", body)) {
+        try {
+            auto conf = nlohmann::json::parse(body);
+            for (const auto& [key, port] : blue_green::closed_inbound_ports()) {
+                old_ports[key] = conf.value(key, port);
+            }
+        } catch (...) {}
+    }
+    auto new_ports = blue_green::inbound_ports(profile);
+    if (old_ports.empty() || !serving.set_inbound_ports(blue_green::closed_inbound_ports())) {
+        err = "Cannot move the running mihomo's ports";
+        standby.stop();
+        return false;
+    }
+    bool bound = probe.set_inbound_ports(new_ports);
+    for (const auto& [key, port] : new_ports) {
+        bound = bound && readiness::port_accepts("127.0.0.1", port, 2000);
+    }
+    if (!bound) {
+        // Give the ports back: the old instance keeps serving
+        serving.set_inbound_ports(old_ports);
+        err = "Standby mihomo could not bind the proxy ports";
+        standby.stop();
+        return false;
+    }
+
+    // 3. Retire the old instance, then move the controller (and any
+    //    listeners:, DNS and TUN inbounds) with the final config. The
+    //    reload rebuilds the providers from warm caches; the top-level
+    //    ports do not change, so they keep serving through it.
+    mihomo_[from]->stop();
+    active_slot_.store(to);
+    ok = probe.reload_config(slot_cfg) && wait_for_mihomo(5);
+    if (!ok) {
+        // Controller not moved by the reload: restart on the final config,
+        // which is still quick with the caches already filled
+        ok = standby.start(binary, {"-d", home, "-f", slot_cfg}) && wait_for_mihomo();
+    }
+    if (ok) {
+        standby.set_auto_restart(true);
+        publish_event("mihomo_started", {{"pid", standby.child_pid()}});
+        return true;
     }
+
+    // Nothing serves: fall back to the previous instance
+    standby.stop();
+    active_slot_.store(from);
+    bool restored = mihomo_[from]->restart() && wait_for_mihomo();
+    err = restored ? "Standby mihomo failed after the handover; previous mihomo restarted"
+                   : "Standby mihomo failed after the handover; previous mihomo did not restart";
+    if (restored) publish_event("mihomo_started", {{"pid", mihomo_[from]->child_pid()}});
+    return true;
 }
 
-bool Daemon::reload_mihomo() {
-    std::string deployed = profile_mgr_.deploy_active_to_mihomo();
-    if (deployed.empty() || !client_) return false;
-    return client_->reload_config(deployed);
+void Daemon::start_prober() {
+    const auto& cfg = config_.data();
+    if (!cfg.prober_enabled || prober_) return;
+
+    prober_client_ = std::make_unique<MihomoClient>(cfg.api_host, cfg.api_port, cfg.api_secret);
+
+    LatencyProber::Options opts;
+    opts.rate_per_sec = cfg.prober_rate_per_sec;
+    opts.concurrency = cfg.prober_concurrency;
+    opts.selected_interval_sec = cfg.prober_selected_interval_sec;
+    opts.flaky_interval_sec = cfg.prober_flaky_interval_sec;
+    opts.stable_interval_sec = cfg.prober_stable_interval_sec;
+    opts.dead_interval_sec = cfg.prober_dead_interval_sec;
+
+    MihomoClient* client = prober_client_.get();
+    auto targets = [client](LatencyProber::Targets& out) {
+        auto nodes = client->get_proxy_nodes();
+        if (nodes.empty()) return client->test_connection();
+        for (const auto& [name, node] : nodes) {
+            // Built-in outbounds have nothing worth measuring
+            if (node.type == "Direct" || node.type == "Reject" ||
+                node.type == "RejectDrop" || node.type == "Pass" ||
+                node.type == "Compatible") {
+                continue;
+            }
+            out.nodes.push_back(name);
+        }
+        for (const auto& [name, group] : client->get_proxy_groups()) {
+            if (!group.now.empty()) out.selected.insert(group.now);
+        }
+        return true;
+    };
+    auto probe = [client, opts](const std::string& name) {
+        return client->test_delay(name, opts.test_url, opts.timeout_ms);
+    };
+    auto on_result = [this](const std::string& name, int delay) {
+        latency_store_.append(name, delay, 0, 0, active_profile());
+    };
+
+    prober_ = std::make_unique<LatencyProber>(opts, targets, probe, on_result);
+    prober_->start();
+
+    if (!cfg.auto_select_groups.empty()) {
+        AutoSelector::Options sel;
+        sel.groups = cfg.auto_select_groups;
+        sel.interval_sec = cfg.auto_select_interval_sec;
+        sel.hysteresis_pct = cfg.auto_select_hysteresis_pct;
+        sel.min_dwell_sec = cfg.auto_select_min_dwell_sec;
+        sel.max_failure_pct = cfg.auto_select_max_failure_pct;
+        sel.lock_dir = SelectionLock::default_dir();
+
+        LatencyProber* prober = prober_.get();
+        auto_selector_ = std::make_unique<AutoSelector>(
+            sel,
+            [client]() { return client->get_proxy_groups(); },
+            [prober]() { return prober->snapshot(); },
+            [client, prober](const std::string& group, const std::string& proxy) {
+                bool ok = client->select_proxy(group, proxy);
+                // Let the newly selected node move to the fast schedule
+                if (ok) prober->refresh_targets();
+                return ok;
+            },
+            AutoSelector::default_log_path());
+        auto_selector_->start();
+    }
+}
+
+void Daemon::stop_prober() {
+    if (auto_selector_) auto_selector_->stop();
+    if (prober_) prober_->stop();
 }
 
 bool Daemon::wait_for_mihomo(int timeout_sec) {
@@ -249,29 +845,213 @@ bool Daemon::wait_for_mihomo(int timeout_sec) {
         );
     }
 
-    for (int i = 0; i < timeout_sec * 10; ++i) {
-        if (client_->test_connection()) return true;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Watch the port with bare connects, then confirm the config is in
+    const auto& cfg = config_.data();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_sec);
+    bool listening = false;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (!listening) {
+            listening = readiness::port_accepts(cfg.api_host, cfg.api_port, 50);
+            if (!listening) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+        }
+        std::string body;
+        if (client_->get_raw("/proxies", body)) {
+            if (readiness::proxies_loaded(body)) return true;
+        } else {
+            listening = false;  // went away again (crash, restart)
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(25));
     }
     return false;
 }
 
 void Daemon::auto_update_loop() {
+    // Sleeps until the earliest deadline; profile changes and stop() wake it
     while (!stop_flag_.load()) {
-        // Check every 60 seconds
-        for (int i = 0; i < 600 && !stop_flag_.load(); ++i) {
+        auto due = update_scheduler_.wait_due();
+        if (due.empty() || stop_flag_.load()) break;
+        run_due_updates(std::move(due));
+    }
+}
+
+void Daemon::run_due_updates(std::vector<std::string> due) {
+    const auto& cfg = config_.data();
+    size_t limit = static_cast<size_t>(std::max(1, cfg.auto_update_concurrency));
+    int jitter_ms = std::max(0, cfg.auto_update_jitter_sec) * 1000;
+
+    // Each update starts at a random point in the jitter window, so many
+    // machines on the same schedule don't hit a provider in the same second
+    std::uniform_int_distribution<int> offset(0, jitter_ms);
+    std::vector<std::pair<int, std::string>> plan;
+    for (auto& name : due) plan.emplace_back(offset(rng_), std::move(name));
+    std::sort(plan.begin(), plan.end());
+
+    // Run as jobs so they show up in job_status and can be cancelled
+    std::map<uint64_t, std::string> running;
+    auto reap = [&]() {
+        for (auto it = running.begin(); it != running.end();) {
+            JobInfo info;
+            bool known = jobs_->get(it->first, info);
+            if (known && !info.finished()) {
+                ++it;
+                continue;
+            }
+            update_scheduler_.report(it->second, known && info.state == "done");
+            it = running.erase(it);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& [delay_ms, name] : plan) {
+        while (!stop_flag_.load()) {
+            reap();
+            bool started = std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(delay_ms);
+            if (started && running.size() < limit) break;
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
-        if (stop_flag_.load()) break;
+        if (stop_flag_.load()) return;
+        running.emplace(submit_profile_update(name), name);
+    }
+
+    while (!running.empty() && !stop_flag_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        reap();
+    }
+}
 
-        auto due = profile_mgr_.profiles_due_for_update();
-        for (const auto& name : due) {
-            if (stop_flag_.load()) break;
+// ── Jobs ────────────────────────────────────────────────────
+
+namespace {
+
+// Forward ProfileManager progress to a job; false (cancel) once it is cancelled
+ProfileManager::Progress job_progress(JobQueue::Context& ctx) {
+    return [&ctx](const std::string& phase, int64_t done, int64_t total) {
+        if (ctx.cancelled()) return false;
+        ctx.set_phase(phase);
+        if (phase == "download") ctx.set_bytes(done, total);
+        return true;
+    };
+}
+
+} // namespace
+
+json Daemon::job_to_json(const JobInfo& info) {
+    return {
+        {"job", info.id},
+        {"kind", info.kind},
+        {"target", info.target},
+        {"state", info.state},
+        {"phase", info.phase},
+        {"bytes", info.bytes},
+        {"total_bytes", info.total_bytes},
+        {"error", info.error},
+        {"created", info.created_ms},
+        {"finished", info.finished_ms}
+    };
+}
+
+uint64_t Daemon::submit_profile_add(const std::string& name, const std::string& url) {
+    return jobs_->submit("profile_add", name,
+        [this, name, url](JobQueue::Context& ctx, std::string& error) {
             std::lock_guard<std::mutex> lock(profile_mutex_);
-            auto result = profile_mgr_.update_profile(name);
-            if (result.success && result.was_active) {
-                reload_mihomo();
+            auto result = profile_mgr_.add_profile(name, url, job_progress(ctx));
+            error = result.error;
+            return result.success;
+        });
+}
+
+uint64_t Daemon::submit_profile_update(const std::string& name) {
+    return jobs_->submit("profile_update", name,
+        [this, name](JobQueue::Context& ctx, std::string& error) {
+            // The profile lock covers only the lookup and the final swap, so
+            // other profile commands and parallel updates run meanwhile
+            std::string url, staged;
+            int64_t max_bytes = 0;
+            ProfileManager::FetchCache cache;
+            {
+                std::lock_guard<std::mutex> lock(profile_mutex_);
+                url = profile_mgr_.source_url(name, &cache);
+                staged = profile_mgr_.staging_path(name);
+                max_bytes = profile_mgr_.max_download_bytes();
+            }
+            if (url.empty()) {
+                error = "Profile not found: " + name;
+                return false;
+            }
+
+            // Streamed to disk: memory use does not grow with the profile
+            error = ProfileManager::fetch_profile(url, staged, job_progress(ctx), cache, max_bytes);
+            if (!error.empty()) return false;
+
+            ProfileManager::UpdateResult result;
+            {
+                std::lock_guard<std::mutex> lock(profile_mutex_);
+                result = profile_mgr_.commit_update(name, staged, cache);
             }
+            if (!result.success) {
+                error = result.error;
+                return false;
+            }
+            if (result.was_active) {
+                // A reload drops connections; not worth it for the same config
+                if (result.unchanged) {
+                    reloads_skipped_.fetch_add(1);
+                } else {
+                    ctx.set_phase("deploy");
+                    reload_mihomo(true);
+                }
+            }
+            return true;
+        });
+}
+
+uint64_t Daemon::submit_mihomo_restart() {
+    return jobs_->submit("mihomo_restart", "",
+        [this](JobQueue::Context& ctx, std::string& error) {
+            {
+                std::lock_guard<std::mutex> lock(mihomo_mutex_);
+                ctx.set_phase("restart");
+                // Downtime runs from the stop until the API answers again
+                auto stopped_at = std::chrono::steady_clock::now();
+                if (!mihomo_proc().restart()) {
+                    error = "Failed to restart mihomo";
+                    return false;
+                }
+                ctx.set_phase("wait");
+                if (wait_for_mihomo()) {
+                    restart_downtime_ms_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - stopped_at).count());
+                } else {
+                    restart_downtime_ms_.store(-1);
+                }
+            }
+            if (ctx.cancelled()) {
+                error = "Cancelled after restart";
+                return false;
+            }
+            ctx.set_phase("deploy");
+            reload_mihomo();
+            return true;
+        });
+}
+
+void Daemon::on_resource_sample(const ResourceMonitor::Sample& s,
+                                const std::vector<ResourceMonitor::Alert>& alerts) {
+    publish_event("mihomo_resources", sample_json(s));
+    for (const auto& a : alerts) {
+        publish_event("mihomo_resource_alert", {{"metric", a.metric}, {"value", a.value},
+                                                {"limit", a.limit},
+                                                {"action", a.restart ? "restart" : "warn"},
+                                                {"pid", s.pid}});
+        if (a.restart) {
+            // The monitor asks at most once per pid, so a restart queued
+            // behind other jobs is not requested again meanwhile
+            ++resource_restarts_;
+            submit_mihomo_restart();
+            break;
         }
     }
 }
@@ -290,38 +1070,53 @@ int Daemon::run() {
     std::string binary = Config::expand_home(config_.data().mihomo_binary_path);
     std::string mihomo_dir = Config::mihomo_dir();
 
-    process_mgr_.set_auto_restart(true);
+    auto spawned_at = std::chrono::steady_clock::now();
     if (!binary.empty() && fs::exists(binary) && !mihomo_dir.empty()) {
         // Ensure geodata files exist before starting mihomo
         Installer::ensure_geodata(mihomo_dir);
-        process_mgr_.start(binary, {"-d", mihomo_dir});
+        spawned_at = std::chrono::steady_clock::now();
+        start_primary_mihomo(binary, mihomo_dir);
     }
 
     // 3. Wait for mihomo API
-    if (process_mgr_.is_running()) {
-        wait_for_mihomo();
+    if (mihomo_proc().is_running()) {
+        bool ready = wait_for_mihomo();
 
         // 4. Deploy and load active profile if set
         std::string deployed = profile_mgr_.deploy_active_to_mihomo();
         if (!deployed.empty() && client_) {
-            client_->reload_config(deployed);
+            ready = client_->reload_config(deployed) && wait_for_mihomo();
+        }
+        if (ready) {
+            startup_ready_ms_.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - spawned_at).count());
         }
     }
 
-    // 5. Start auto-update thread
+    // 5. Start auto-update thread, latency prober and controller cache
+    update_scheduler_.set_profiles(profile_mgr_.list_profiles());
     auto_update_thread_ = std::thread(&Daemon::auto_update_loop, this);
+    start_prober();
+    if (config_.data().controller_cache_enabled) controller_cache_->start();
+    if (config_.data().mihomo_monitor_enabled) resource_monitor_->start();
 
     // 6. IPC main loop
     ipc_loop();
 
     // 7. Cleanup
     stop_flag_.store(true);
+    update_scheduler_.stop();
+    stop_prober();
+    controller_cache_->stop();
+    resource_monitor_->stop();
+    jobs_->stop();
 
     if (auto_update_thread_.joinable()) {
         auto_update_thread_.join();
     }
 
-    process_mgr_.stop();
+    mihomo_[0]->stop();
+    mihomo_[1]->stop();
     cleanup_socket();
 
     return 0;
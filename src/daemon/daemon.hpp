@@ -2,14 +2,27 @@
 
 #include "core/config.hpp"
 #include "core/profile_manager.hpp"
+#include "core/latency_store.hpp"
 #include "daemon/process_manager.hpp"
+#include "daemon/latency_prober.hpp"
+#include "daemon/auto_selector.hpp"
+#include "daemon/ipc_server.hpp"
+#include "daemon/job_queue.hpp"
+#include "daemon/controller_cache.hpp"
+#include "daemon/update_scheduler.hpp"
+#include "daemon/log_ring.hpp"
+#include "daemon/resource_monitor.hpp"
 #include "api/mihomo_client.hpp"
 
+#include <nlohmann/json_fwd.hpp>
 #include <memory>
 #include <atomic>
+#include <functional>
 #include <thread>
 #include <mutex>
+#include <random>
 #include <string>
+#include <vector>
 
 class Daemon {
 public:
@@ -25,24 +38,103 @@ public:
 private:
     Config& config_;
     ProfileManager profile_mgr_;
-    ProcessManager process_mgr_;
+    // Captured stdout/stderr of mihomo (both slots); outlives the processes
+    std::unique_ptr<LogRing> mihomo_log_;
+    // mihomo runs in slot active_slot_. A blue/green switch starts the
+    // other slot as a standby and flips the index at handover.
+    std::unique_ptr<ProcessManager> mihomo_[2];
+    std::atomic<int> active_slot_{0};
+    ProcessManager& mihomo_proc() { return *mihomo_[active_slot_.load()]; }
+    /// Home directory (-d) of a slot: slot 0 is Config::mihomo_dir()
+    static std::string slot_home(int slot);
+    /// Config file mihomo in `slot` was loaded from
+    std::string served_config(int slot) const;
     std::unique_ptr<MihomoClient> client_;
+    LatencyStore latency_store_;
     std::atomic<bool> stop_flag_{false};
-    int socket_fd_ = -1;
 
     // IPC
+    std::unique_ptr<IpcServer> ipc_server_;
     std::string socket_path() const;
     bool start_ipc_server();
     void ipc_loop();
-    std::string handle_command(const std::string& json_line);
+    nlohmann::json handle_request(const nlohmann::json& req);
+    nlohmann::json dispatch_command(const nlohmann::json& req);
+    static bool is_slow_command(const nlohmann::json& req);
+    static bool is_subscribe_command(const nlohmann::json& req);
     void cleanup_socket();
 
+    // Push events to `subscribe`d clients (callable from any thread)
+    std::mutex events_mutex_;   // guards ipc_server_ against teardown
+    void publish_event(const std::string& type, const nlohmann::json& data);
+
+    // Active profile name as last seen by a profile command, so `status`
+    // can answer on the IPC loop while a profile operation is running
+    std::mutex active_mutex_;
+    std::string active_profile_;
+    void refresh_active_profile();
+    std::string active_profile();
+
     // Auto-update
     std::thread auto_update_thread_;
     std::mutex profile_mutex_;  // serialize profile operations
+    std::mutex mihomo_mutex_;   // serialize mihomo lifecycle and API reloads
+    UpdateScheduler update_scheduler_;         // next-due times, reloaded on profile changes
+    std::atomic<uint64_t> reloads_skipped_{0};  // active profile updated with unchanged content
+    std::atomic<int64_t> restart_downtime_ms_{-1};  // last mihomo_restart: stop → API ready
+    std::atomic<int64_t> startup_ready_ms_{-1};     // daemon start: spawn → profile loaded
+    std::mt19937 rng_{std::random_device{}()};  // auto-update jitter
     void auto_update_loop();
+    /// Run updates with jittered starts, at most auto_update_concurrency at
+    /// once, and report each outcome to the scheduler
+    void run_due_updates(std::vector<std::string> due);
+
+    // Background latency prober (own client: runs on the prober's threads)
+    std::unique_ptr<MihomoClient> prober_client_;
+    std::unique_ptr<LatencyProber> prober_;
+    void start_prober();
+    void stop_prober();
+
+    // Best-node policy for configured Selector groups (driven by the prober)
+    std::unique_ptr<AutoSelector> auto_selector_;
+
+    // One poller for mihomo's read-only endpoints, shared by every client
+    std::unique_ptr<MihomoClient> cache_client_;
+    std::unique_ptr<ControllerCache> controller_cache_;
+    void start_controller_cache();
+
+    // Long-running commands (downloads, restarts) with progress and cancel.
+    // Declared after everything the jobs touch, so it is destroyed first.
+    std::unique_ptr<JobQueue> jobs_;
+    uint64_t submit_profile_add(const std::string& name, const std::string& url);
+    uint64_t submit_profile_update(const std::string& name);
+    uint64_t submit_mihomo_restart();
+    static nlohmann::json job_to_json(const JobInfo& info);
+
+    // /proc samples of the active mihomo; may queue restarts, so it is
+    // declared after jobs_ and stopped before it
+    std::unique_ptr<ResourceMonitor> resource_monitor_;
+    std::atomic<uint64_t> resource_restarts_{0};   // restarts requested by its limits
+    void on_resource_sample(const ResourceMonitor::Sample& s,
+                            const std::vector<ResourceMonitor::Alert>& alerts);
 
     // Helper
-    bool reload_mihomo();
+    /// Deploy the active profile and load it. `blue_green`: the profile
+    /// changed, so load it through a standby when that is enabled (a
+    /// restart only reloads in place). Takes profile_mutex_ for the deploy
+    /// only, then mihomo_mutex_, which serializes the loads; a load that a
+    /// later call has superseded is skipped. profile_mutex_ must not be held.
+    bool reload_mihomo(bool blue_green = false);
+    std::atomic<uint64_t> reload_generation_{0};  // bumped by each reload_mihomo()
     bool wait_for_mihomo(int timeout_sec = 10);
+    /// Start mihomo in slot 0 (the one the daemon boots), stopping any other
+    bool start_primary_mihomo(const std::string& binary, const std::string& mihomo_dir);
+    /// Load `profile` in a standby instance and hand over to it. Returns
+    /// false if the running instance was left alone (the caller reloads
+    /// in place instead); otherwise `ok` tells whether the standby took
+    /// over. If it did not, the previous instance is restarted.
+    /// Gives up before the handover once `superseded` is true.
+    /// mihomo_mutex_ held.
+    bool blue_green_switch(const std::string& profile, const std::function<bool()>& superseded,
+                           bool& ok, std::string& err);
 };
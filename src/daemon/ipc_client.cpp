@@ -2,13 +2,101 @@
 #include "core/config.hpp"
 
 #include <nlohmann/json.hpp>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <cerrno>
+#include <chrono>
 #include <cstring>
+#include <future>
 
 using json = nlohmann::json;
 
+namespace {
+constexpr size_t kMaxResponseBytes = 64 * 1024 * 1024;
+constexpr int kHelloTimeoutMs = 2000;
+constexpr int kReplyTimeoutSec = 30;
+
+// Connect to the daemon socket; -1 on failure
+int connect_socket(const std::string& path) {
+    if (path.empty()) return -1;
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    // Don't let a wedged daemon block writers forever
+    struct timeval tv;
+    tv.tv_sec = kReplyTimeoutSec;
+    tv.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return fd;
+}
+
+bool write_all(int fd, const std::string& data) {
+    size_t total = 0;
+    while (total < data.size()) {
+        ssize_t n = send(fd, data.data() + total, data.size() - total, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        total += n;
+    }
+    return true;
+}
+
+// Ask for a binary wire format on a fresh connection. Daemons that don't
+// know `hello` answer with an error and the connection stays JSON lines.
+IpcEncoding negotiate(int fd, IpcEncoding want) {
+    if (want == IpcEncoding::Json) return IpcEncoding::Json;
+    if (!write_all(fd, ipc_codec::encode({{"cmd", "hello"}, {"encoding", ipc_codec::name(want)}},
+                                         IpcEncoding::Json))) {
+        return IpcEncoding::Json;
+    }
+
+    // Byte by byte: nothing after the reply line may be consumed here
+    std::string line;
+    char c;
+    while (line.size() < 4096) {
+        struct pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, kHelloTimeoutMs) <= 0) return IpcEncoding::Json;
+        ssize_t n = read(fd, &c, 1);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return IpcEncoding::Json;
+        if (c == '\n') break;
+        line += c;
+    }
+    try {
+        auto resp = json::parse(line);
+        if (resp.value("ok", false) &&
+            resp["data"].value("encoding", "") == ipc_codec::name(want)) {
+            return want;
+        }
+    } catch (...) {}
+    return IpcEncoding::Json;
+}
+
+} // namespace
+
+struct DaemonClient::Pending {
+    std::promise<json> promise;
+};
+
+DaemonClient::~DaemonClient() {
+    unsubscribe();
+    std::lock_guard<std::mutex> wlock(write_mutex_);
+    disconnect();
+}
+
 std::string DaemonClient::socket_path() const {
     // Try user-specific path first
     std::string dir = Config::config_dir();
@@ -30,59 +118,147 @@ std::string DaemonClient::socket_path() const {
     return "";
 }
 
-json DaemonClient::send_command(const json& cmd) {
-    std::string path = socket_path();
-    if (path.empty()) return json();
+bool DaemonClient::ensure_connected() {
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (connected_) return true;
+    }
+    disconnect();  // reap a connection the daemon has closed
 
-    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (fd < 0) return json();
+    int fd = connect_socket(socket_path());
+    if (fd < 0) return false;
+    IpcEncoding wire = negotiate(fd, encoding_.load());
 
-    struct sockaddr_un addr;
-    std::memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    fd_ = fd;
+    wire_ = wire;
+    connected_ = true;
+    reader_ = std::thread(&DaemonClient::reader_loop, this, fd, wire);
+    return true;
+}
 
-    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        close(fd);
-        return json();
+void DaemonClient::disconnect() {
+    int fd;
+    std::thread reader;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        fd = fd_;
+        fd_ = -1;
+        connected_ = false;
+        reader = std::move(reader_);
     }
+    if (fd >= 0) shutdown(fd, SHUT_RDWR);  // wakes the reader
+    if (reader.joinable()) reader.join();
+    if (fd >= 0) close(fd);
+}
 
-    // Set read timeout
-    struct timeval tv;
-    tv.tv_sec = 30;
-    tv.tv_usec = 0;
-    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-
-    // Send command
-    std::string msg = cmd.dump() + "\n";
-    ssize_t total = 0;
-    while (total < (ssize_t)msg.size()) {
-        ssize_t n = write(fd, msg.data() + total, msg.size() - total);
-        if (n <= 0) {
-            close(fd);
-            return json();
+void DaemonClient::reader_loop(int fd, IpcEncoding wire) {
+    std::string buffer;
+    std::vector<char> chunk(65536);
+
+    auto deliver = [this](json resp) {
+        if (!resp.is_object()) return;
+        std::shared_ptr<Pending> p;
+        {
+            std::lock_guard<std::mutex> lock(conn_mutex_);
+            if (pending_.empty()) return;
+            // Replies without an id come from a daemon that predates
+            // request ids and answers in order
+            auto it = resp.contains("id") ? pending_.find(resp.value("id", (uint64_t)0))
+                                          : pending_.begin();
+            if (it == pending_.end()) return;  // caller timed out
+            p = std::move(it->second);
+            pending_.erase(it);
         }
-        total += n;
+        resp.erase("id");
+        p->promise.set_value(std::move(resp));
+    };
+
+    bool overflow = false;
+    while (!overflow) {
+        ssize_t n = read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buffer.append(chunk.data(), n);
+
+        size_t pos = 0;
+        while (true) {
+            json resp;
+            std::string error;
+            auto st = ipc_codec::decode_next(buffer, pos, wire, kMaxResponseBytes, resp, error);
+            if (st == ipc_codec::Status::NeedMore) break;
+            if (st == ipc_codec::Status::TooLarge) {
+                overflow = true;
+                break;
+            }
+            if (st == ipc_codec::Status::Ok) deliver(std::move(resp));
+        }
+        buffer.erase(0, pos);
     }
 
-    // Read response
-    std::string buffer;
-    char c;
-    while (read(fd, &c, 1) == 1) {
-        if (c == '\n') break;
-        buffer += c;
-        if (buffer.size() > 65536) break;
+    // Connection gone: fail whatever is still waiting
+    std::map<uint64_t, std::shared_ptr<Pending>> orphans;
+    {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        connected_ = false;
+        orphans.swap(pending_);
     }
+    for (auto& [id, p] : orphans) p->promise.set_value(json());
+}
 
-    close(fd);
+json DaemonClient::send_command(const json& cmd) {
+    auto pending = std::make_shared<Pending>();
+    auto reply = pending->promise.get_future();
+    uint64_t id = 0;
 
-    if (buffer.empty()) return json();
+    {
+        std::lock_guard<std::mutex> wlock(write_mutex_);
+        // A failed write means the daemon went away since the last call;
+        // retry once on a fresh connection
+        bool sent = false;
+        for (int attempt = 0; attempt < 2 && !sent; ++attempt) {
+            if (!ensure_connected()) return json();
 
-    try {
-        return json::parse(buffer);
-    } catch (...) {
+            int fd = -1;
+            IpcEncoding wire = IpcEncoding::Json;
+            {
+                std::lock_guard<std::mutex> lock(conn_mutex_);
+                // The reader may have just seen EOF and failed the queue
+                if (connected_) {
+                    id = next_id_++;
+                    pending_[id] = pending;
+                    fd = fd_;
+                    wire = wire_;
+                }
+            }
+            if (fd < 0) continue;
+
+            json req = cmd;
+            req["id"] = id;
+            sent = write_all(fd, ipc_codec::encode(req, wire));
+
+            if (!sent) {
+                {
+                    std::lock_guard<std::mutex> lock(conn_mutex_);
+                    pending_.erase(id);
+                }
+                disconnect();
+            }
+        }
+        if (!sent) return json();
+    }
+
+    if (reply.wait_for(std::chrono::seconds(kReplyTimeoutSec)) != std::future_status::ready) {
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        pending_.erase(id);
         return json();
     }
+    return reply.get();
+}
+
+IpcEncoding DaemonClient::wire_encoding() {
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    return wire_;
 }
 
 bool DaemonClient::is_daemon_running() {
@@ -112,19 +288,18 @@ std::vector<ProfileInfo> DaemonClient::list_profiles() {
     return profiles;
 }
 
-bool DaemonClient::add_profile(const std::string& name, const std::string& url, std::string& err) {
-    auto resp = send_command({{"cmd", "profile_add"}, {"name", name}, {"url", url}});
-    if (resp.empty()) {
-        err = "Cannot connect to daemon";
-        return false;
-    }
-    if (resp.value("ok", false)) return true;
-    err = resp.value("error", "Unknown error");
-    return false;
+bool DaemonClient::add_profile(const std::string& name, const std::string& url, std::string& err,
+                               const JobProgress& on_progress) {
+    return run_job({{"cmd", "profile_add"}, {"name", name}, {"url", url}}, err, on_progress);
+}
+
+bool DaemonClient::update_profile(const std::string& name, std::string& err,
+                                  const JobProgress& on_progress) {
+    return run_job({{"cmd", "profile_update"}, {"name", name}}, err, on_progress);
 }
 
-bool DaemonClient::update_profile(const std::string& name, std::string& err) {
-    auto resp = send_command({{"cmd", "profile_update"}, {"name", name}});
+bool DaemonClient::delete_profile(const std::string& name, std::string& err) {
+    auto resp = send_command({{"cmd", "profile_delete"}, {"name", name}});
     if (resp.empty()) {
         err = "Cannot connect to daemon";
         return false;
@@ -134,8 +309,8 @@ bool DaemonClient::update_profile(const std::string& name, std::string& err) {
     return false;
 }
 
-bool DaemonClient::delete_profile(const std::string& name, std::string& err) {
-    auto resp = send_command({{"cmd", "profile_delete"}, {"name", name}});
+bool DaemonClient::switch_profile(const std::string& name, std::string& err) {
+    auto resp = send_command({{"cmd", "profile_switch"}, {"name", name}});
     if (resp.empty()) {
         err = "Cannot connect to daemon";
         return false;
@@ -145,8 +320,8 @@ bool DaemonClient::delete_profile(const std::string& name, std::string& err) {
     return false;
 }
 
-bool DaemonClient::switch_profile(const std::string& name, std::string& err) {
-    auto resp = send_command({{"cmd", "profile_switch"}, {"name", name}});
+bool DaemonClient::set_update_interval(const std::string& name, int hours, std::string& err) {
+    auto resp = send_command({{"cmd", "profile_set_interval"}, {"name", name}, {"hours", hours}});
     if (resp.empty()) {
         err = "Cannot connect to daemon";
         return false;
@@ -172,11 +347,180 @@ DaemonClient::DaemonStatus DaemonClient::get_status() {
         status.mihomo_running = data.value("mihomo_running", false);
         status.mihomo_pid = data.value("mihomo_pid", -1);
         status.active_profile = data.value("active_profile", "");
+        status.mihomo_config = data.value("mihomo_config", "");
+        status.mihomo_home = data.value("mihomo_home", "");
+        status.reloads_skipped = data.value("reloads_skipped", uint64_t{0});
+        status.restart_downtime_ms = data.value("restart_downtime_ms", int64_t{-1});
+        status.startup_ready_ms = data.value("startup_ready_ms", int64_t{-1});
+        if (data.contains("mihomo_health") && data["mihomo_health"].is_object()) {
+            const auto& h = data["mihomo_health"];
+            status.mihomo_restarts = h.value("restarts", uint64_t{0});
+            status.mihomo_crashes = h.value("crashes", uint64_t{0});
+            status.mihomo_crash_loop = h.value("crash_loop", false);
+            if (h.contains("recent_exits") && h["recent_exits"].is_array() &&
+                !h["recent_exits"].empty()) {
+                const auto& last = h["recent_exits"].back();
+                status.last_exit_code = last.value("exit_code", -1);
+                status.last_exit_signal = last.value("signal", 0);
+                status.last_exit_ms = last.value("time", int64_t{0});
+                status.last_uptime_ms = last.value("uptime_ms", int64_t{0});
+            }
+        }
+        if (data.contains("mihomo_resources") && data["mihomo_resources"].is_object()) {
+            const auto& r = data["mihomo_resources"];
+            status.resource_restarts = r.value("planned_restarts", uint64_t{0});
+            if (r.contains("current") && r["current"].is_object()) {
+                const auto& cur = r["current"];
+                status.mihomo_cpu_pct = cur.value("cpu_pct", -1.0);
+                status.mihomo_rss_kb = cur.value("rss_kb", uint64_t{0});
+                status.mihomo_fds = cur.value("fds", -1);
+                status.mihomo_threads = cur.value("threads", -1);
+            }
+        }
+        if (data.contains("mihomo_launch") && data["mihomo_launch"].is_object()) {
+            const auto& l = data["mihomo_launch"];
+            status.launch_pid = l.value("pid", -1);
+            status.launch_cpus = l.value("cpus", "");
+            status.launch_nice = l.value("nice", 0);
+            status.launch_ionice_class = l.value("ionice_class", 0);
+            status.launch_ionice_level = l.value("ionice_level", 0);
+            status.launch_nofile = l.value("nofile_soft", uint64_t{0});
+            status.launch_memory_bytes = l.value("memory_bytes", uint64_t{0});
+            status.launch_env = l.value("env", std::vector<std::string>{});
+            status.launch_failed = l.value("failed", std::vector<std::string>{});
+        }
     } catch (...) {}
 
     return status;
 }
 
+std::map<std::string, LatencyStats> DaemonClient::latency_stats(
+        const std::vector<std::string>& names, int64_t since, uint16_t flags,
+        const std::string& profile) {
+    std::map<std::string, LatencyStats> stats;
+    json cmd = {{"cmd", "latency_stats"}, {"since", since}, {"flags", flags}};
+    if (!names.empty()) cmd["names"] = names;
+    if (!profile.empty()) cmd["profile"] = profile;
+    auto resp = send_command(cmd);
+    if (resp.empty() || !resp.value("ok", false)) return stats;
+
+    try {
+        for (const auto& item : resp["data"]) {
+            LatencyStats st;
+            st.name = item.value("name", "");
+            st.samples = item.value("samples", (size_t)0);
+            st.failures = item.value("failures", (size_t)0);
+            st.min = item.value("min", -1);
+            st.avg = item.value("avg", -1);
+            st.p50 = item.value("p50", -1);
+            st.p95 = item.value("p95", -1);
+            st.p99 = item.value("p99", -1);
+            st.first_seen = item.value("first_seen", (int64_t)0);
+            st.last_seen = item.value("last_seen", (int64_t)0);
+            stats[st.name] = std::move(st);
+        }
+    } catch (...) {}
+
+    return stats;
+}
+
+bool DaemonClient::record_latency(const std::string& name, int delay, const std::string& profile) {
+    json cmd = {{"cmd", "latency_record"}, {"name", name}, {"delay", delay}};
+    if (!profile.empty()) cmd["profile"] = profile;
+    auto resp = send_command(cmd);
+    return !resp.empty() && resp.value("ok", false);
+}
+
+std::map<std::string, NodeLatency> DaemonClient::get_latencies(int64_t since_ms, size_t history,
+                                                                int64_t* server_now_ms) {
+    std::map<std::string, NodeLatency> out;
+    auto resp = send_command({{"cmd", "latency"}, {"since", since_ms}, {"history", history}});
+    if (resp.empty() || !resp.value("ok", false)) return out;
+
+    try {
+        auto& data = resp["data"];
+        if (server_now_ms) *server_now_ms = data.value("now", (int64_t)0);
+        for (auto& [name, item] : data["nodes"].items()) {
+            NodeLatency nl;
+            nl.name = name;
+            nl.state = item.value("state", "");
+            nl.delay = item.value("delay", -1);
+            nl.last_probe_ms = item.value("t", (int64_t)0);
+            nl.min = item.value("min", -1);
+            nl.avg = item.value("avg", -1);
+            nl.p95 = item.value("p95", -1);
+            nl.failures = item.value("failures", 0);
+            nl.samples = item.value("samples", 0);
+            if (item.contains("history")) {
+                for (const auto& h : item["history"]) {
+                    // [timestamp_ms, delay]
+                    nl.history.push_back(DelaySample{h.at(0).get<int64_t>(), h.at(1).get<int>()});
+                }
+            }
+            out[name] = std::move(nl);
+        }
+    } catch (...) {}
+
+    return out;
+}
+
+// ── Controller cache ────────────────────────────────────────
+
+struct DaemonClient::Mirror {
+    std::mutex mutex;            // one refresh of a path at a time
+    uint64_t epoch = 0;
+    uint64_t version = 0;
+    json fields = json::object();
+    std::map<std::string, json> items;
+};
+
+bool DaemonClient::controller_get(const std::string& path, bool fresh, std::string& body) {
+    std::shared_ptr<Mirror> m;
+    {
+        std::lock_guard<std::mutex> lock(mirrors_mutex_);
+        auto& slot = mirrors_[path];
+        if (!slot) slot = std::make_shared<Mirror>();
+        m = slot;
+    }
+    std::lock_guard<std::mutex> lock(m->mutex);
+
+    json cmd = {{"cmd", "controller"}, {"path", path},
+                {"epoch", m->epoch}, {"since", m->version}};
+    if (fresh) cmd["refresh"] = true;
+    auto resp = send_command(cmd);
+    if (resp.empty() || !resp.value("ok", false)) return false;
+
+    try {
+        const auto& data = resp.at("data");
+        if (data.value("full", true)) {
+            m->fields = json::object();
+            m->items.clear();
+        }
+        if (data.contains("fields")) m->fields = data["fields"];
+        for (const auto& [key, value] : data.at("items").items()) m->items[key] = value;
+        for (const auto& key : data.at("removed")) m->items.erase(key.get<std::string>());
+        m->epoch = data.value("epoch", uint64_t{0});
+        m->version = data.value("version", uint64_t{0});
+
+        json out = m->fields;
+        if (path == "/proxies") {
+            json proxies = json::object();
+            for (const auto& [key, value] : m->items) proxies[key] = value;
+            out["proxies"] = std::move(proxies);
+        } else if (path == "/connections") {
+            json conns = json::array();
+            for (const auto& [key, value] : m->items) conns.push_back(value);
+            out["connections"] = std::move(conns);
+        }
+        body = out.dump();
+        return true;
+    } catch (...) {
+        // Out of step with the daemon: start over next time
+        m->epoch = m->version = 0;
+        return false;
+    }
+}
+
 bool DaemonClient::mihomo_start(std::string& err) {
     auto resp = send_command({{"cmd", "mihomo_start"}});
     if (resp.empty()) {
@@ -199,8 +543,117 @@ bool DaemonClient::mihomo_stop(std::string& err) {
     return false;
 }
 
-bool DaemonClient::mihomo_restart(std::string& err) {
-    auto resp = send_command({{"cmd", "mihomo_restart"}});
+bool DaemonClient::mihomo_restart(std::string& err, const JobProgress& on_progress) {
+    return run_job({{"cmd", "mihomo_restart"}}, err, on_progress);
+}
+
+bool DaemonClient::mihomo_logs(uint64_t since, size_t limit, std::vector<MihomoLogLine>& lines,
+                               uint64_t& next) {
+    lines.clear();
+    auto resp = send_command({{"cmd", "mihomo_logs"}, {"since", since}, {"limit", limit}});
+    if (resp.empty() || !resp.value("ok", false)) return false;
+    try {
+        const auto& data = resp["data"];
+        next = data.value("next", since);
+        for (const auto& l : data["lines"]) {
+            MihomoLogLine line;
+            line.seq = l.value("seq", uint64_t{0});
+            line.time_ms = l.value("t", int64_t{0});
+            line.stream = l.value("stream", "");
+            line.text = l.value("text", "");
+            lines.push_back(std::move(line));
+        }
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
+
+// ── Jobs ────────────────────────────────────────────────────
+
+namespace {
+
+JobInfo job_from_json(const json& j) {
+    JobInfo info;
+    info.id = j.value("job", (uint64_t)0);
+    info.kind = j.value("kind", "");
+    info.target = j.value("target", "");
+    info.state = j.value("state", "");
+    info.phase = j.value("phase", "");
+    info.bytes = j.value("bytes", (int64_t)0);
+    info.total_bytes = j.value("total_bytes", (int64_t)0);
+    info.error = j.value("error", "");
+    info.created_ms = j.value("created", (int64_t)0);
+    info.finished_ms = j.value("finished", (int64_t)0);
+    return info;
+}
+
+} // namespace
+
+bool DaemonClient::run_job(const json& cmd, std::string& err, const JobProgress& on_progress) {
+    json req = cmd;
+    req["async"] = true;
+    auto resp = send_command(req);
+    if (resp.empty()) {
+        err = "Cannot connect to daemon";
+        return false;
+    }
+    if (!resp.value("ok", false)) {
+        err = resp.value("error", "Unknown error");
+        return false;
+    }
+
+    uint64_t id = 0;
+    try {
+        id = resp["data"].value("job", (uint64_t)0);
+    } catch (...) {}
+    if (id == 0) return true;  // daemon without jobs already finished it
+
+    // Poll instead of holding a request open for the whole download
+    JobInfo last;
+    while (true) {
+        JobInfo info;
+        if (!get_job(id, info)) {
+            err = "Lost connection to daemon";
+            return false;
+        }
+        if (on_progress && (info.state != last.state || info.phase != last.phase ||
+                            info.bytes != last.bytes)) {
+            on_progress(info);
+        }
+        if (info.finished()) {
+            if (info.state == "done") return true;
+            err = info.error.empty() ? "Unknown error" : info.error;
+            return false;
+        }
+        last = std::move(info);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+}
+
+bool DaemonClient::get_job(uint64_t id, JobInfo& out) {
+    auto resp = send_command({{"cmd", "job_status"}, {"job", id}});
+    if (resp.empty() || !resp.value("ok", false)) return false;
+    try {
+        out = job_from_json(resp["data"]);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+std::vector<JobInfo> DaemonClient::list_jobs() {
+    std::vector<JobInfo> jobs;
+    auto resp = send_command({{"cmd", "job_status"}});
+    if (resp.empty() || !resp.value("ok", false)) return jobs;
+    try {
+        for (const auto& j : resp["data"]) jobs.push_back(job_from_json(j));
+    } catch (...) {}
+    return jobs;
+}
+
+bool DaemonClient::cancel_job(uint64_t id, std::string& err) {
+    auto resp = send_command({{"cmd", "job_cancel"}, {"job", id}});
     if (resp.empty()) {
         err = "Cannot connect to daemon";
         return false;
@@ -209,3 +662,113 @@ bool DaemonClient::mihomo_restart(std::string& err) {
     err = resp.value("error", "Unknown error");
     return false;
 }
+
+// ── Event subscription ──────────────────────────────────────
+
+void DaemonClient::subscribe(std::function<void(const DaemonEvent&)> on_event) {
+    unsubscribe();
+    sub_stop_.store(false);
+    sub_thread_ = std::thread(&DaemonClient::subscribe_loop, this, std::move(on_event));
+}
+
+void DaemonClient::unsubscribe() {
+    sub_stop_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(sub_mutex_);
+        if (sub_fd_ >= 0) shutdown(sub_fd_, SHUT_RDWR);  // unblock the read
+    }
+    if (sub_thread_.joinable()) sub_thread_.join();
+}
+
+void DaemonClient::subscribe_loop(std::function<void(const DaemonEvent&)> on_event) {
+    auto link_event = [&on_event](const char* type) {
+        DaemonEvent ev;
+        ev.type = type;
+        on_event(ev);
+    };
+
+    while (!sub_stop_.load()) {
+        int fd = connect_socket(socket_path());
+        if (fd >= 0) {
+            {
+                std::lock_guard<std::mutex> lock(sub_mutex_);
+                sub_fd_ = fd;
+            }
+
+            std::string buffer;
+            bool acked = false;
+            bool rejected = false;
+            if (!sub_stop_.load() && write_all(fd, json({{"cmd", "subscribe"}}).dump() + "\n")) {
+                char chunk[4096];
+                while (!sub_stop_.load() && !rejected) {
+                    ssize_t n = read(fd, chunk, sizeof(chunk));
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) break;
+                    buffer.append(chunk, n);
+
+                    size_t start = 0;
+                    size_t nl;
+                    while ((nl = buffer.find('\n', start)) != std::string::npos) {
+                        std::string line = buffer.substr(start, nl - start);
+                        start = nl + 1;
+                        try {
+                            auto msg = json::parse(line);
+                            if (!acked) {
+                                // First line answers the subscribe request
+                                if (!msg.value("ok", false)) {
+                                    rejected = true;  // daemon predates events
+                                    break;
+                                }
+                                acked = true;
+                                link_event("daemon_connected");
+                                continue;
+                            }
+                            DaemonEvent ev;
+                            ev.type = msg.value("event", "");
+                            ev.time_ms = msg.value("t", (int64_t)0);
+                            if (msg.contains("data") && msg["data"].is_object()) {
+                                const auto& d = msg["data"];
+                                ev.profile = d.value("profile", "");
+                                ev.pid = d.value("pid", -1);
+                                ev.exit_code = d.value("exit_code", 0);
+                                ev.crashed = d.value("crashed", false);
+                                ev.ok = d.value("ok", true);
+                                ev.cpu_pct = d.value("cpu_pct", -1.0);
+                                ev.rss_kb = d.value("rss_kb", uint64_t{0});
+                                ev.metric = d.value("metric", "");
+                                ev.action = d.value("action", "");
+                            }
+                            if (!ev.type.empty()) on_event(ev);
+                        } catch (...) {}
+                    }
+                    buffer.erase(0, start);
+                    if (buffer.size() > kMaxResponseBytes) break;
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(sub_mutex_);
+                sub_fd_ = -1;
+            }
+            close(fd);
+            if (acked && !sub_stop_.load()) link_event("daemon_disconnected");
+
+            if (rejected && !sub_stop_.load()) {
+                // No events from this daemon: poll whether it is still up,
+                // then try subscribing again (it may have been upgraded)
+                link_event("daemon_connected");
+                while (!sub_stop_.load() && is_daemon_running()) {
+                    for (int i = 0; i < 10 && !sub_stop_.load(); ++i) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    }
+                }
+                if (!sub_stop_.load()) link_event("daemon_disconnected");
+            }
+        }
+
+        // Retry every second until unsubscribed
+        for (int i = 0; i < 10 && !sub_stop_.load(); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+}
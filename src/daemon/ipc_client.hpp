@@ -1,24 +1,87 @@
 #pragma once
 
 #include "core/profile_manager.hpp"
+#include "core/latency_store.hpp"
+#include "daemon/latency_prober.hpp"
+#include "daemon/job_queue.hpp"
+#include "daemon/ipc_codec.hpp"
 
 #include <nlohmann/json_fwd.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+/// Event pushed by the daemon to subscribers
+struct DaemonEvent {
+    /// profile_added / profile_updated / profile_deleted / profile_changed,
+    /// mihomo_started / mihomo_exited / mihomo_crash_loop, config_reloaded,
+    /// mihomo_resources / mihomo_resource_alert, plus the client-side
+    /// daemon_connected / daemon_disconnected
+    std::string type;
+    std::string profile;       // profile_* and config_reloaded
+    int pid = -1;              // mihomo_started
+    int exit_code = 0;         // mihomo_exited, mihomo_crash_loop
+    bool crashed = false;      // mihomo_exited: not requested by a client
+    bool ok = true;            // config_reloaded
+    double cpu_pct = -1;       // mihomo_resources (-1 = no CPU figure yet)
+    uint64_t rss_kb = 0;       // mihomo_resources
+    std::string metric;        // mihomo_resource_alert: rss_kb / fds / cpu_pct
+    std::string action;        // mihomo_resource_alert: warn / restart
+    int64_t time_ms = 0;       // daemon clock (0 for client-side events)
+};
+
+/// A line of mihomo's captured stdout/stderr
+struct MihomoLogLine {
+    uint64_t seq = 0;
+    int64_t time_ms = 0;       // unix ms
+    std::string stream;        // "stdout" / "stderr"
+    std::string text;
+};
+
+/// Client for the daemon's IPC socket.
+///
+/// Keeps one connection open and tags every request with an id, so calls
+/// from several threads share it with any number of requests in flight;
+/// a reader thread hands each reply to its caller in whatever order the
+/// daemon answers. A dropped connection (daemon restart) is re-established
+/// on the next call. Each connection asks for CBOR framing first and stays
+/// on JSON lines if the daemon does not support it.
 class DaemonClient {
 public:
+    DaemonClient() = default;
+    ~DaemonClient();
+
+    DaemonClient(const DaemonClient&) = delete;
+    DaemonClient& operator=(const DaemonClient&) = delete;
+
+    /// Wire format to ask for on the next connection (Json = no negotiation)
+    void set_encoding(IpcEncoding enc) { encoding_.store(enc); }
+
+    /// Wire format of the current connection
+    IpcEncoding wire_encoding();
+
     /// Check if the daemon is running (socket exists and responds)
     bool is_daemon_running();
 
     /// List profiles managed by the daemon
     std::vector<ProfileInfo> list_profiles();
 
-    /// Add a new profile
-    bool add_profile(const std::string& name, const std::string& url, std::string& err);
+    /// Progress of a daemon job (called when its state, phase or byte count changes)
+    using JobProgress = std::function<void(const JobInfo&)>;
+
+    /// Add a new profile (runs as a daemon job; blocks until it finishes)
+    bool add_profile(const std::string& name, const std::string& url, std::string& err,
+                     const JobProgress& on_progress = nullptr);
 
-    /// Update (re-download) a profile
-    bool update_profile(const std::string& name, std::string& err);
+    /// Update (re-download) a profile (daemon job)
+    bool update_profile(const std::string& name, std::string& err,
+                        const JobProgress& on_progress = nullptr);
 
     /// Delete a profile
     bool delete_profile(const std::string& name, std::string& err);
@@ -26,6 +89,9 @@ public:
     /// Switch the active profile
     bool switch_profile(const std::string& name, std::string& err);
 
+    /// Set a profile's auto-update interval (0 turns auto-update off)
+    bool set_update_interval(const std::string& name, int hours, std::string& err);
+
     /// Get the name of the active profile
     std::string get_active_profile();
 
@@ -34,19 +100,133 @@ public:
         bool mihomo_running = false;
         int mihomo_pid = -1;
         std::string active_profile;
+        std::string mihomo_config;      // file the running mihomo serves
+        std::string mihomo_home;        // its -d directory
+        uint64_t reloads_skipped = 0;   // mihomo reloads avoided: profile unchanged
+        int64_t restart_downtime_ms = -1;  // last mihomo restart until its API answered
+        int64_t startup_ready_ms = -1;     // daemon start: mihomo spawn until the profile was loaded
+        // mihomo crash accounting
+        uint64_t mihomo_restarts = 0;      // automatic restarts after crashes
+        uint64_t mihomo_crashes = 0;
+        bool mihomo_crash_loop = false;    // restarts suspended until the profile changes
+        int last_exit_code = -1;           // of the most recent crash (-1: signal)
+        int last_exit_signal = 0;
+        int64_t last_exit_ms = 0;          // unix ms, 0 = no crash yet
+        int64_t last_uptime_ms = 0;        // how long the crashed process ran
+        // Latest /proc sample of the running mihomo (fds/threads -1: none yet)
+        double mihomo_cpu_pct = -1;
+        uint64_t mihomo_rss_kb = 0;
+        int mihomo_fds = -1;
+        int mihomo_threads = -1;
+        uint64_t resource_restarts = 0;    // planned restarts after a resource limit
+        // Launch settings mihomo actually runs with (launch_pid -1: none reported)
+        int launch_pid = -1;
+        std::string launch_cpus;
+        int launch_nice = 0;
+        int launch_ionice_class = 0;
+        int launch_ionice_level = 0;
+        uint64_t launch_nofile = 0;        // soft limit
+        uint64_t launch_memory_bytes = 0;  // 0 = unlimited
+        std::vector<std::string> launch_env;
+        std::vector<std::string> launch_failed;  // options that could not be applied
     };
 
     /// Get daemon status
     DaemonStatus get_status();
 
+    /// Long-term latency statistics from the daemon's latency database.
+    /// Empty `names` = every known node. `since` = unix seconds (0 = all).
+    /// `flags` selects the probe kind (0 = delay tests, kLatencyFlagL4).
+    /// Empty `profile` = the daemon's active profile.
+    std::map<std::string, LatencyStats> latency_stats(const std::vector<std::string>& names = {},
+                                                      int64_t since = 0, uint16_t flags = 0,
+                                                      const std::string& profile = "");
+
+    /// Record a latency sample (delay 0 = failure) in the daemon's database,
+    /// under `profile` (empty = the daemon's active profile)
+    bool record_latency(const std::string& name, int delay, const std::string& profile = "");
+
+    /// Latest results of the daemon's background prober for nodes probed
+    /// at or after `since_ms` (0 = all), with up to `history` recent samples each.
+    /// `server_now_ms` receives the daemon's clock, to pass back as `since`.
+    std::map<std::string, NodeLatency> get_latencies(int64_t since_ms = 0, size_t history = 0,
+                                                     int64_t* server_now_ms = nullptr);
+
     /// Request mihomo start/stop/restart
     bool mihomo_start(std::string& err);
     bool mihomo_stop(std::string& err);
-    bool mihomo_restart(std::string& err);
+    bool mihomo_restart(std::string& err, const JobProgress& on_progress = nullptr);
+
+    /// mihomo output captured by the daemon after line `since` (at most the
+    /// newest `limit`). `next` receives the cursor to pass as `since` to
+    /// follow the log. False if the daemon is unreachable.
+    bool mihomo_logs(uint64_t since, size_t limit, std::vector<MihomoLogLine>& lines, uint64_t& next);
+
+    /// Status of one daemon job; false if unknown or unreachable
+    bool get_job(uint64_t id, JobInfo& out);
+
+    /// Recent and running daemon jobs
+    std::vector<JobInfo> list_jobs();
+
+    /// Cancel a queued or running job
+    bool cancel_job(uint64_t id, std::string& err);
+
+    /// GET a read-only mihomo endpoint (/version, /configs, /proxies,
+    /// /connections) from the daemon's shared cache. A local copy of each
+    /// path is kept so only what changed since the previous call crosses
+    /// the socket; `body` is rebuilt in mihomo's own response format.
+    /// `fresh` asks the daemon to re-poll mihomo first. False if the daemon
+    /// or mihomo is unreachable, or the cache is disabled.
+    bool controller_get(const std::string& path, bool fresh, std::string& body);
+
+    /// Stream daemon events to `on_event` from a background thread until
+    /// unsubscribe(). Uses its own connection and reconnects every second
+    /// while the daemon is down, reporting daemon_connected /
+    /// daemon_disconnected as the link changes. A daemon that rejects the
+    /// subscribe (one without events) is polled for availability instead.
+    void subscribe(std::function<void(const DaemonEvent&)> on_event);
+    void unsubscribe();
 
 private:
+    struct Pending;
+    struct Mirror;
+
+    // Local copies of the daemon's controller cache, by path
+    std::mutex mirrors_mutex_;
+    std::map<std::string, std::shared_ptr<Mirror>> mirrors_;
+
+    // Lock order: write_mutex_ before conn_mutex_. The reader thread only
+    // takes conn_mutex_, so a blocked write never stalls reply delivery.
+    std::mutex write_mutex_;
+    std::mutex conn_mutex_;
+    int fd_ = -1;
+    bool connected_ = false;     // false once the reader saw EOF or an error
+    std::atomic<IpcEncoding> encoding_{IpcEncoding::Cbor};
+    IpcEncoding wire_ = IpcEncoding::Json;  // negotiated for fd_
+    std::thread reader_;
+    uint64_t next_id_ = 1;
+    std::map<uint64_t, std::shared_ptr<Pending>> pending_;
+
+    // Event subscription
+    std::thread sub_thread_;
+    std::atomic<bool> sub_stop_{false};
+    std::mutex sub_mutex_;       // guards sub_fd_
+    int sub_fd_ = -1;
+    void subscribe_loop(std::function<void(const DaemonEvent&)> on_event);
+
     std::string socket_path() const;
 
+    /// Connect if there is no live connection (write_mutex_ held)
+    bool ensure_connected();
+
+    /// Close the connection and join the reader (write_mutex_ held)
+    void disconnect();
+
+    void reader_loop(int fd, IpcEncoding wire);
+
+    /// Start a job-backed command with "async" and poll it to completion
+    bool run_job(const nlohmann::json& cmd, std::string& err, const JobProgress& on_progress);
+
     /// Send a JSON command and receive response
     /// Returns empty json on connection failure
     nlohmann::json send_command(const nlohmann::json& cmd);
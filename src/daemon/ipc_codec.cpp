@@ -0,0 +1,94 @@
+#include "daemon/ipc_codec.hpp"
+
+#include <cstdint>
+
+using json = nlohmann::json;
+
+namespace ipc_codec {
+
+const char* name(IpcEncoding enc) {
+    switch (enc) {
+        case IpcEncoding::Cbor: return "cbor";
+        case IpcEncoding::MsgPack: return "msgpack";
+        default: return "json";
+    }
+}
+
+bool from_name(const std::string& name, IpcEncoding& out) {
+    if (name == "json") {
+        out = IpcEncoding::Json;
+    } else if (name == "cbor") {
+        out = IpcEncoding::Cbor;
+    } else if (name == "msgpack") {
+        out = IpcEncoding::MsgPack;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string encode(const json& msg, IpcEncoding enc) {
+    if (enc == IpcEncoding::Json) {
+        std::string out = msg.dump();
+        out += '\n';
+        return out;
+    }
+
+    // Serialize behind a placeholder header, then fill in the length
+    std::string out(kHeaderBytes, '\0');
+    if (enc == IpcEncoding::Cbor) {
+        json::to_cbor(msg, out);
+    } else {
+        json::to_msgpack(msg, out);
+    }
+    uint32_t len = static_cast<uint32_t>(out.size() - kHeaderBytes);
+    out[0] = static_cast<char>((len >> 24) & 0xFF);
+    out[1] = static_cast<char>((len >> 16) & 0xFF);
+    out[2] = static_cast<char>((len >> 8) & 0xFF);
+    out[3] = static_cast<char>(len & 0xFF);
+    return out;
+}
+
+Status decode_next(const std::string& buf, size_t& pos, IpcEncoding enc, size_t max_size,
+                   json& out, std::string& error) {
+    if (enc == IpcEncoding::Json) {
+        while (true) {
+            size_t nl = buf.find('\n', pos);
+            if (nl == std::string::npos) {
+                return buf.size() - pos > max_size ? Status::TooLarge : Status::NeedMore;
+            }
+            if (nl - pos > max_size) return Status::TooLarge;
+            size_t start = pos;
+            pos = nl + 1;
+            if (nl == start) continue;
+            try {
+                out = json::parse(buf.begin() + start, buf.begin() + nl);
+                return Status::Ok;
+            } catch (const std::exception& e) {
+                error = std::string("Parse error: ") + e.what();
+                return Status::Invalid;
+            }
+        }
+    }
+
+    if (buf.size() - pos < kHeaderBytes) return Status::NeedMore;
+    const auto* h = reinterpret_cast<const unsigned char*>(buf.data() + pos);
+    size_t len = (static_cast<size_t>(h[0]) << 24) | (static_cast<size_t>(h[1]) << 16) |
+                 (static_cast<size_t>(h[2]) << 8) | static_cast<size_t>(h[3]);
+    if (len > max_size) return Status::TooLarge;
+    if (buf.size() - pos - kHeaderBytes < len) return Status::NeedMore;
+
+    auto first = buf.begin() + pos + kHeaderBytes;
+    auto last = first + len;
+    pos += kHeaderBytes + len;
+    try {
+        out = enc == IpcEncoding::Cbor ? json::from_cbor(first, last)
+                                       : json::from_msgpack(first, last);
+        return Status::Ok;
+    } catch (const std::exception& e) {
+        error = std::string("Parse error: ") + e.what();
+        return Status::Invalid;
+    }
+}
+
+} // namespace ipc_codec
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include <cstddef>
+#include <string>
+
+/// Wire format of one daemon IPC connection.
+///
+/// Every connection starts with newline-delimited JSON. A client may send
+/// {"cmd":"hello","encoding":"cbor"|"msgpack"} as its first request; once
+/// the (JSON) reply is out, both directions switch to frames of a 4-byte
+/// big-endian length followed by the message in that binary encoding.
+/// Frames carry multi-megabyte messages that a text line cannot.
+enum class IpcEncoding { Json, Cbor, MsgPack };
+
+namespace ipc_codec {
+
+constexpr size_t kHeaderBytes = 4;
+
+const char* name(IpcEncoding enc);
+
+/// "json", "cbor" or "msgpack"; false for anything else
+bool from_name(const std::string& name, IpcEncoding& out);
+
+/// One message on the wire: a JSON line or a length-prefixed frame
+std::string encode(const nlohmann::json& msg, IpcEncoding enc);
+
+enum class Status {
+    Ok,         // `out` holds the next message
+    NeedMore,   // no complete message buffered yet
+    TooLarge,   // the next message exceeds `max_size`: drop the peer
+    Invalid     // a complete message that does not decode; skipped
+};
+
+/// Decode the next message in `buf` starting at `pos`, advancing `pos`
+/// past everything consumed (empty JSON lines are skipped). On Invalid,
+/// `error` describes the problem and `pos` is past the bad message.
+Status decode_next(const std::string& buf, size_t& pos, IpcEncoding enc, size_t max_size,
+                   nlohmann::json& out, std::string& error);
+
+} // namespace ipc_codec
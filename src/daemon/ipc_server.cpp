@@ -0,0 +1,407 @@
+#include "daemon/ipc_server.hpp"
+
+#include <nlohmann/json.hpp>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr uint64_t kListenId = 0;
+constexpr uint64_t kWakeId = UINT64_MAX;
+
+} // namespace
+
+IpcServer::IpcServer(Options opts, Handler handler, SlowPredicate is_slow,
+                     SubscribePredicate is_subscribe)
+    : opts_(opts), handler_(std::move(handler)), is_slow_(std::move(is_slow)),
+      is_subscribe_(std::move(is_subscribe)) {
+    if (opts_.workers < 1) opts_.workers = 1;
+}
+
+IpcServer::~IpcServer() {
+    close();
+}
+
+bool IpcServer::listen(const std::string& path) {
+    if (path.empty()) return false;
+
+    // Clean up any existing socket
+    unlink(path.c_str());
+
+    // Ensure directory exists
+    try {
+        fs::create_directories(fs::path(path).parent_path());
+    } catch (...) {
+        return false;
+    }
+
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) return false;
+
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    // Allow non-root users to connect to daemon socket
+    chmod(path.c_str(), 0660);
+
+    if (::listen(listen_fd_, SOMAXCONN) < 0) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        unlink(path.c_str());
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        close();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = kListenId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = kWakeId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    return true;
+}
+
+void IpcServer::close() {
+    stop_workers();
+    for (auto& [id, c] : clients_) {
+        if (c.fd >= 0) ::close(c.fd);
+    }
+    clients_.clear();
+    client_count_.store(0);
+    if (listen_fd_ >= 0) ::close(listen_fd_);
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    listen_fd_ = epoll_fd_ = wake_fd_ = -1;
+}
+
+// ── Worker pool ─────────────────────────────────────────────
+
+void IpcServer::start_workers() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        workers_stop_ = false;
+    }
+    for (int i = 0; i < opts_.workers; ++i) {
+        workers_.emplace_back(&IpcServer::worker_loop, this);
+    }
+}
+
+void IpcServer::stop_workers() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        workers_stop_ = true;
+        jobs_.clear();
+    }
+    jobs_cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+    workers_.clear();
+}
+
+void IpcServer::worker_loop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_cv_.wait(lock, [this] { return workers_stop_ || !jobs_.empty(); });
+            if (workers_stop_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+
+        // Encoding here keeps big responses off the loop thread
+        post_done(Done{job.client_id, ipc_codec::encode(handler_(job.req), job.enc), nullptr});
+    }
+}
+
+void IpcServer::post_done(Done done) {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if (workers_stop_) return;  // loop not running
+        done_.push_back(std::move(done));
+    }
+    uint64_t one = 1;
+    ssize_t n = write(wake_fd_, &one, sizeof(one));
+    (void)n;
+}
+
+void IpcServer::broadcast(const json& msg) {
+    post_done(Done{0, std::string(), msg});
+}
+
+// ── Event loop ──────────────────────────────────────────────
+
+void IpcServer::run(const std::atomic<bool>& stop) {
+    if (epoll_fd_ < 0) return;
+    start_workers();
+
+    epoll_event events[64];
+    while (!stop.load()) {
+        int n = epoll_wait(epoll_fd_, events, 64, 500);
+        for (int i = 0; i < n; ++i) {
+            uint64_t id = events[i].data.u64;
+            if (id == kListenId) {
+                accept_clients();
+            } else if (id == kWakeId) {
+                uint64_t count;
+                while (read(wake_fd_, &count, sizeof(count)) > 0) {}
+                drain_done();
+            } else {
+                uint32_t ev = events[i].events;
+                if (ev & (EPOLLIN | EPOLLHUP | EPOLLERR)) on_readable(id);
+                if (ev & EPOLLOUT) on_writable(id);
+            }
+        }
+    }
+
+    stop_workers();
+}
+
+void IpcServer::accept_clients() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;  // EAGAIN: backlog drained
+
+        if (clients_.size() >= opts_.max_clients) {
+            ::close(fd);
+            continue;
+        }
+
+        uint64_t id = next_client_id_++;
+        Client c;
+        c.fd = fd;
+        clients_.emplace(id, std::move(c));
+        client_count_.store(clients_.size());
+
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.u64 = id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+}
+
+void IpcServer::on_readable(uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    Client& c = it->second;
+
+    char buf[65536];
+    while (true) {
+        ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n > 0) {
+            c.in.append(buf, n);
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        c.read_closed = true;  // EOF or error
+        break;
+    }
+
+    // Dispatch every complete request; a hello may switch the encoding
+    // for the rest of the buffer
+    size_t pos = 0;
+    while (true) {
+        json req;
+        std::string error;
+        size_t limit = c.enc == IpcEncoding::Json ? opts_.max_line : opts_.max_frame;
+        auto st = ipc_codec::decode_next(c.in, pos, c.enc, limit, req, error);
+        if (st == ipc_codec::Status::NeedMore) break;
+        if (st == ipc_codec::Status::TooLarge) {
+            // prevent abuse: reject and drop the client
+            c.out += ipc_codec::encode({{"ok", false}, {"error", "Request too long"}}, c.enc);
+            pos = c.in.size();
+            c.read_closed = true;
+            break;
+        }
+        if (st == ipc_codec::Status::Invalid) {
+            c.out += ipc_codec::encode({{"ok", false}, {"error", error}}, c.enc);
+            continue;
+        }
+        on_request(id, std::move(req));
+    }
+    c.in.erase(0, pos);
+
+    flush(id);
+}
+
+void IpcServer::on_request(uint64_t id, json req) {
+    Client& c = clients_.at(id);
+
+    if (req.is_object() && req.contains("cmd") && req["cmd"] == "hello") {
+        on_hello(c, req);
+        return;
+    }
+
+    if (is_subscribe_ && is_subscribe_(req)) c.subscribed = true;
+
+    if (is_slow_ && is_slow_(req)) {
+        ++c.pending;
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            jobs_.push_back(Job{id, std::move(req), c.enc});
+        }
+        jobs_cv_.notify_one();
+    } else {
+        c.out += ipc_codec::encode(handler_(req), c.enc);
+    }
+}
+
+void IpcServer::on_hello(Client& c, const json& req) {
+    std::string name = "json";
+    if (req.contains("encoding") && req["encoding"].is_string()) {
+        name = req["encoding"].get<std::string>();
+    }
+
+    IpcEncoding enc;
+    json resp;
+    bool ok = ipc_codec::from_name(name, enc);
+    if (ok) {
+        size_t limit = enc == IpcEncoding::Json ? opts_.max_line : opts_.max_frame;
+        resp = {{"ok", true}, {"data", {{"encoding", name}, {"max_frame", limit}}}};
+    } else {
+        resp = {{"ok", false}, {"error", "Unsupported encoding: " + name}};
+    }
+    if (req.contains("id")) resp["id"] = req["id"];
+
+    // The reply still uses the old encoding; everything after it the new one
+    c.out += ipc_codec::encode(resp, c.enc);
+    if (ok) c.enc = enc;
+}
+
+void IpcServer::on_writable(uint64_t id) {
+    flush(id);
+}
+
+void IpcServer::drain_done() {
+    std::deque<Done> done;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        done.swap(done_);
+    }
+    for (auto& d : done) {
+        if (d.client_id == 0) {
+            // Encode once per wire format in use
+            std::map<IpcEncoding, std::string> encoded;
+            std::vector<uint64_t> ids;
+            for (const auto& [id, c] : clients_) {
+                if (!c.subscribed) continue;
+                ids.push_back(id);
+                if (!encoded.count(c.enc)) encoded[c.enc] = ipc_codec::encode(d.event, c.enc);
+            }
+            for (uint64_t id : ids) queue_response(id, encoded[clients_.at(id).enc]);
+            continue;
+        }
+        auto it = clients_.find(d.client_id);
+        if (it == clients_.end()) continue;  // client went away meanwhile
+        --it->second.pending;
+        queue_response(d.client_id, d.response);
+    }
+}
+
+void IpcServer::queue_response(uint64_t id, const std::string& response) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    it->second.out += response;
+    flush(id);
+}
+
+void IpcServer::flush(uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    Client& c = it->second;
+
+    while (!c.out.empty()) {
+        ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            c.out.erase(0, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close_client(id);  // peer gone
+        return;
+    }
+
+    if (c.out.size() > opts_.max_output) {
+        close_client(id);  // not reading: don't buffer forever
+        return;
+    }
+
+    update_interest(id);
+    maybe_close(id);
+}
+
+void IpcServer::update_interest(uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    Client& c = it->second;
+
+    bool want_write = !c.out.empty();
+    if (c.read_closed && !want_write) {
+        // Only a worker's reply can follow. EPOLLHUP cannot be masked, so a
+        // peer that hung up would wake the loop nonstop until then; the fd
+        // is added back when there is something to write.
+        if (c.in_epoll) {
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c.fd, nullptr);
+            c.in_epoll = false;
+        }
+        c.want_write = false;
+        return;
+    }
+    if (c.in_epoll && want_write == c.want_write && !c.read_closed) return;
+    c.want_write = want_write;
+
+    epoll_event ev{};
+    ev.events = 0;
+    if (!c.read_closed) ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (want_write) ev.events |= EPOLLOUT;
+    ev.data.u64 = id;
+    epoll_ctl(epoll_fd_, c.in_epoll ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, c.fd, &ev);
+    c.in_epoll = true;
+}
+
+void IpcServer::maybe_close(uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    const Client& c = it->second;
+    // Peer finished sending: close once every answer is out
+    if (c.read_closed && c.pending == 0 && c.out.empty()) {
+        close_client(id);
+    }
+}
+
+void IpcServer::close_client(uint64_t id) {
+    auto it = clients_.find(id);
+    if (it == clients_.end()) return;
+    if (it->second.in_epoll) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    clients_.erase(it);
+    client_count_.store(clients_.size());
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "daemon/ipc_codec.hpp"
+
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Unix socket server for the daemon's JSON request/response protocol.
+///
+/// A single epoll loop owns every socket: it accepts clients, reads
+/// requests into per-client buffers, decodes them (JSON lines, or binary
+/// frames after a `hello`, see IpcEncoding) and writes responses back
+/// without blocking. Fast commands are answered inline on the loop;
+/// commands classified as slow (downloads, process restarts) run on a
+/// worker pool, which also encodes their responses, so they never stall
+/// other clients. A connection may carry any number of requests; responses
+/// to slow commands are sent when they complete. Connections that
+/// subscribe also receive every message passed to broadcast().
+class IpcServer {
+public:
+    struct Options {
+        int workers = 4;                 // threads for slow commands
+        size_t max_line = 64 * 1024;     // longer JSON-line requests are rejected
+        size_t max_frame = 64 * 1024 * 1024;  // limit for binary frames
+        size_t max_clients = 1024;
+        size_t max_output = 128 * 1024 * 1024;  // unsent bytes before a client is dropped
+    };
+
+    /// Request → response. Must be thread-safe: called from the loop and
+    /// from workers.
+    using Handler = std::function<nlohmann::json(const nlohmann::json& req)>;
+
+    /// True if the request should run on the worker pool
+    using SlowPredicate = std::function<bool(const nlohmann::json& req)>;
+
+    /// True if the request subscribes its connection to broadcasts
+    using SubscribePredicate = std::function<bool(const nlohmann::json& req)>;
+
+    IpcServer(Options opts, Handler handler, SlowPredicate is_slow = nullptr,
+              SubscribePredicate is_subscribe = nullptr);
+    ~IpcServer();
+
+    IpcServer(const IpcServer&) = delete;
+    IpcServer& operator=(const IpcServer&) = delete;
+
+    /// Bind and listen on a Unix socket path (replacing a stale socket)
+    bool listen(const std::string& path);
+
+    /// Run the event loop until `stop` becomes true (checked every 500 ms)
+    void run(const std::atomic<bool>& stop);
+
+    /// Close the listening socket and every client
+    void close();
+
+    /// Send a message to every subscribed connection. Thread-safe.
+    void broadcast(const nlohmann::json& msg);
+
+    size_t client_count() const { return client_count_.load(); }
+
+private:
+    struct Client {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        int pending = 0;         // slow requests still running
+        bool read_closed = false;
+        bool want_write = false;
+        bool in_epoll = true;    // removed while only waiting on a worker
+        bool subscribed = false;
+        IpcEncoding enc = IpcEncoding::Json;
+    };
+
+    struct Job {
+        uint64_t client_id;
+        nlohmann::json req;
+        IpcEncoding enc;
+    };
+
+    struct Done {
+        uint64_t client_id;      // 0 = every subscriber
+        std::string response;    // encoded for the client
+        nlohmann::json event;    // broadcasts: encoded per subscriber
+    };
+
+    Options opts_;
+    Handler handler_;
+    SlowPredicate is_slow_;
+    SubscribePredicate is_subscribe_;
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;       // eventfd: workers signal completed jobs
+
+    std::map<uint64_t, Client> clients_;   // loop thread only
+    uint64_t next_client_id_ = 1;
+    std::atomic<size_t> client_count_{0};
+
+    // Worker pool
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::deque<Job> jobs_;
+    std::deque<Done> done_;      // finished jobs and broadcasts
+    bool workers_stop_ = true;   // true whenever run() is not active
+    std::vector<std::thread> workers_;
+
+    void start_workers();
+    void stop_workers();
+    void worker_loop();
+    void post_done(Done done);
+
+    void accept_clients();
+    void on_readable(uint64_t id);
+    void on_writable(uint64_t id);
+    void on_request(uint64_t id, nlohmann::json req);
+    void on_hello(Client& c, const nlohmann::json& req);
+    void drain_done();
+    void queue_response(uint64_t id, const std::string& response);
+    void flush(uint64_t id);
+    void update_interest(uint64_t id);
+    void close_client(uint64_t id);
+    void maybe_close(uint64_t id);
+};
@@ -0,0 +1,234 @@
+#include "daemon/job_queue.hpp"
+
+#include <chrono>
+
+namespace {
+
+constexpr int64_t kProgressIntervalMs = 250;
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+struct JobQueue::Context::Entry {
+    JobInfo info;
+    Work work;
+    std::atomic<bool> cancel{false};
+    int64_t last_report_ms = 0;
+};
+
+// ── Context ─────────────────────────────────────────────────
+
+bool JobQueue::Context::cancelled() const {
+    return entry_->cancel.load();
+}
+
+void JobQueue::Context::set_phase(const std::string& phase) {
+    {
+        std::lock_guard<std::mutex> lock(queue_.mutex_);
+        if (entry_->info.phase == phase) return;
+        entry_->info.phase = phase;
+    }
+    queue_.notify(entry_);
+}
+
+void JobQueue::Context::set_bytes(int64_t done, int64_t total) {
+    int64_t now = now_ms();
+    {
+        std::lock_guard<std::mutex> lock(queue_.mutex_);
+        entry_->info.bytes = done;
+        entry_->info.total_bytes = total;
+        bool complete = total > 0 && done >= total;
+        if (!complete && now - entry_->last_report_ms < kProgressIntervalMs) return;
+        entry_->last_report_ms = now;
+    }
+    queue_.notify(entry_);
+}
+
+// ── JobQueue ────────────────────────────────────────────────
+
+JobQueue::JobQueue(int workers, UpdateFn on_update, size_t keep_finished)
+    : on_update_(std::move(on_update)), keep_finished_(keep_finished) {
+    if (workers < 1) workers = 1;
+    for (int i = 0; i < workers; ++i) {
+        workers_.emplace_back(&JobQueue::worker_loop, this);
+    }
+}
+
+JobQueue::~JobQueue() {
+    stop();
+}
+
+void JobQueue::stop() {
+    std::vector<std::shared_ptr<Entry>> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_ && workers_.empty()) return;
+        stopping_ = true;
+        for (auto& [id, e] : jobs_) e->cancel.store(true);
+        dropped.assign(queue_.begin(), queue_.end());
+        queue_.clear();
+    }
+    cv_.notify_all();
+    for (auto& e : dropped) finish(e, "cancelled", "Cancelled");
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+    workers_.clear();
+}
+
+uint64_t JobQueue::submit(const std::string& kind, const std::string& target, Work work) {
+    auto e = std::make_shared<Entry>();
+    e->work = std::move(work);
+    e->info.kind = kind;
+    e->info.target = target;
+    e->info.state = "queued";
+    e->info.phase = "queued";
+    e->info.created_ms = now_ms();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        e->info.id = next_id_++;
+        jobs_[e->info.id] = e;
+        if (stopping_) {
+            e->info.state = "cancelled";
+            e->info.error = "Daemon is shutting down";
+            e->info.finished_ms = e->info.created_ms;
+        } else {
+            queue_.push_back(e);
+        }
+        prune();
+    }
+    cv_.notify_one();
+    notify(e);
+    return e->info.id;
+}
+
+bool JobQueue::cancel(uint64_t id) {
+    std::shared_ptr<Entry> e;
+    bool was_queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || it->second->info.finished()) return false;
+        e = it->second;
+        e->cancel.store(true);
+        for (auto q = queue_.begin(); q != queue_.end(); ++q) {
+            if (*q == e) {
+                queue_.erase(q);
+                was_queued = true;
+                break;
+            }
+        }
+    }
+    // A running job notices the flag at its next progress check
+    if (was_queued) finish(e, "cancelled", "Cancelled");
+    return true;
+}
+
+bool JobQueue::get(uint64_t id, JobInfo& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    out = it->second->info;
+    return true;
+}
+
+bool JobQueue::wait(uint64_t id, JobInfo& out, int timeout_ms) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    auto e = it->second;
+    auto done = [&e] { return e->info.finished(); };
+    if (timeout_ms < 0) {
+        done_cv_.wait(lock, done);
+    } else {
+        done_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), done);
+    }
+    out = e->info;
+    return out.finished();
+}
+
+std::vector<JobInfo> JobQueue::list() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<JobInfo> out;
+    out.reserve(jobs_.size());
+    for (const auto& [id, e] : jobs_) out.push_back(e->info);
+    return out;
+}
+
+void JobQueue::worker_loop() {
+    while (true) {
+        std::shared_ptr<Entry> e;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) return;
+            e = queue_.front();
+            queue_.pop_front();
+            e->info.state = "running";
+        }
+        notify(e);
+
+        Context ctx(*this, e);
+        std::string error;
+        bool ok = false;
+        try {
+            ok = e->work(ctx, error);
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        } catch (...) {
+            error = "Unknown error";
+        }
+
+        if (ok) {
+            finish(e, "done", "");
+        } else if (e->cancel.load()) {
+            finish(e, "cancelled", error.empty() ? "Cancelled" : error);
+        } else {
+            finish(e, "failed", error.empty() ? "Unknown error" : error);
+        }
+    }
+}
+
+void JobQueue::finish(const std::shared_ptr<Entry>& e, const std::string& state,
+                      const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        e->info.state = state;
+        e->info.error = error;
+        if (state == "done") e->info.phase = "done";
+        e->info.finished_ms = now_ms();
+        e->work = nullptr;  // release captures
+    }
+    done_cv_.notify_all();
+    notify(e);
+}
+
+void JobQueue::notify(const std::shared_ptr<Entry>& e) {
+    if (!on_update_) return;
+    JobInfo copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copy = e->info;
+    }
+    on_update_(copy);
+}
+
+void JobQueue::prune() {
+    size_t finished = 0;
+    for (const auto& [id, e] : jobs_) {
+        if (e->info.finished()) ++finished;
+    }
+    for (auto it = jobs_.begin(); it != jobs_.end() && finished > keep_finished_;) {
+        if (it->second->info.finished()) {
+            it = jobs_.erase(it);
+            --finished;
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Snapshot of a long-running daemon job
+struct JobInfo {
+    uint64_t id = 0;
+    std::string kind;            // "profile_add", "profile_update", "mihomo_restart"
+    std::string target;          // profile name, empty for mihomo
+    std::string state;           // queued / running / done / failed / cancelled
+    std::string phase;           // e.g. download / parse / save / deploy / reload
+    int64_t bytes = 0;           // download progress
+    int64_t total_bytes = 0;     // 0 = unknown
+    std::string error;
+    int64_t created_ms = 0;
+    int64_t finished_ms = 0;     // 0 while queued or running
+
+    bool finished() const { return state == "done" || state == "failed" || state == "cancelled"; }
+};
+
+/// Worker pool for daemon commands that can take a while (subscription
+/// downloads, mihomo restarts).
+///
+/// submit() returns an id at once; the job's work function reports its
+/// phase and byte progress through a Context and polls it for cancellation.
+/// Every change is passed to `on_update` (byte progress at most every
+/// 250 ms per job). The most recent finished jobs are kept for status queries.
+class JobQueue {
+public:
+    class Context {
+    public:
+        /// True once cancel() was called: the work should return soon
+        bool cancelled() const;
+        void set_phase(const std::string& phase);
+        void set_bytes(int64_t done, int64_t total);
+
+    private:
+        friend class JobQueue;
+        struct Entry;
+        Context(JobQueue& queue, std::shared_ptr<Entry> entry)
+            : queue_(queue), entry_(std::move(entry)) {}
+        JobQueue& queue_;
+        std::shared_ptr<Entry> entry_;
+    };
+
+    /// Does the job; returns false and fills `error` on failure
+    using Work = std::function<bool(Context& ctx, std::string& error)>;
+    using UpdateFn = std::function<void(const JobInfo&)>;
+
+    explicit JobQueue(int workers = 2, UpdateFn on_update = nullptr, size_t keep_finished = 100);
+    ~JobQueue();
+
+    JobQueue(const JobQueue&) = delete;
+    JobQueue& operator=(const JobQueue&) = delete;
+
+    uint64_t submit(const std::string& kind, const std::string& target, Work work);
+
+    /// Cancel a queued or running job. False if unknown or already finished.
+    bool cancel(uint64_t id);
+
+    bool get(uint64_t id, JobInfo& out) const;
+
+    /// Block until the job finishes (or `timeout_ms` passes, <0 = forever)
+    bool wait(uint64_t id, JobInfo& out, int timeout_ms = -1) const;
+
+    /// All known jobs, oldest first
+    std::vector<JobInfo> list() const;
+
+    /// Cancel everything and join the workers
+    void stop();
+
+private:
+    using Entry = Context::Entry;
+
+    UpdateFn on_update_;
+    size_t keep_finished_;
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;       // workers: new job / stop
+    mutable std::condition_variable done_cv_;  // waiters: a job finished
+    std::map<uint64_t, std::shared_ptr<Entry>> jobs_;
+    std::deque<std::shared_ptr<Entry>> queue_;
+    uint64_t next_id_ = 1;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+
+    void worker_loop();
+    void finish(const std::shared_ptr<Entry>& e, const std::string& state, const std::string& error);
+    void notify(const std::shared_ptr<Entry>& e);
+    void prune();  // mutex_ held
+};
@@ -0,0 +1,255 @@
+#include "daemon/latency_prober.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+namespace {
+constexpr int64_t kUnreachableRetryMs = 5000;
+}
+
+LatencyProber::LatencyProber(Options opts, TargetsFn targets, ProbeFn probe, ResultFn on_result)
+    : opts_(std::move(opts)),
+      targets_fn_(std::move(targets)),
+      probe_fn_(std::move(probe)),
+      on_result_(std::move(on_result)) {
+    if (opts_.rate_per_sec <= 0) opts_.rate_per_sec = 1.0;
+    if (opts_.burst < 1) opts_.burst = 1;
+    if (opts_.concurrency < 1) opts_.concurrency = 1;
+}
+
+LatencyProber::~LatencyProber() {
+    stop();
+}
+
+int64_t LatencyProber::now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void LatencyProber::start() {
+    if (running_.exchange(true)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next_refresh_ms_ = 0;
+        tokens_ = opts_.burst;
+        last_refill_ms_ = now_ms();
+    }
+    for (int i = 0; i < opts_.concurrency; ++i) {
+        workers_.emplace_back(&LatencyProber::worker_loop, this);
+    }
+}
+
+void LatencyProber::stop() {
+    if (!running_.exchange(false)) return;
+    cv_.notify_all();
+    for (auto& t : workers_) {
+        if (t.joinable()) t.join();
+    }
+    workers_.clear();
+}
+
+void LatencyProber::refresh_targets() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        next_refresh_ms_ = 0;
+    }
+    cv_.notify_all();
+}
+
+void LatencyProber::do_refresh() {
+    Targets targets;
+    bool reachable = targets_fn_ && targets_fn_(targets);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = now_ms();
+    mihomo_reachable_ = reachable;
+    if (!reachable) {
+        // Poll for mihomo coming back more often than the normal refresh
+        next_refresh_ms_ = std::min(next_refresh_ms_, now + kUnreachableRetryMs);
+        return;
+    }
+
+    std::set<std::string> present(targets.nodes.begin(), targets.nodes.end());
+
+    // Drop nodes that left the profile
+    for (auto it = nodes_.begin(); it != nodes_.end();) {
+        if (!present.count(it->first)) {
+            it = nodes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto& name : targets.nodes) {
+        auto& st = nodes_[name];
+        bool selected = targets.selected.count(name) > 0;
+        if (selected && !st.selected) {
+            // Newly selected: probe soon instead of waiting out a long interval
+            st.next_due_ms = std::min(st.next_due_ms, now);
+        }
+        st.selected = selected;
+    }
+}
+
+std::string LatencyProber::pick_due(int64_t now, int64_t& wait_until) {
+    std::string best;
+    int64_t best_due = 0;
+    for (auto& [name, st] : nodes_) {
+        if (st.in_flight) continue;
+        // Selected nodes win ties so they are never starved by the backlog
+        bool earlier = best.empty() || st.next_due_ms < best_due ||
+                       (st.next_due_ms == best_due && st.selected);
+        if (earlier) {
+            best = name;
+            best_due = st.next_due_ms;
+        }
+    }
+    if (best.empty()) return "";
+    if (best_due > now) {
+        wait_until = std::min(wait_until, best_due);
+        return "";
+    }
+    return best;
+}
+
+int64_t LatencyProber::take_token(int64_t now) {
+    double elapsed = static_cast<double>(now - last_refill_ms_) / 1000.0;
+    last_refill_ms_ = now;
+    tokens_ = std::min<double>(opts_.burst, tokens_ + elapsed * opts_.rate_per_sec);
+    if (tokens_ >= 1.0) {
+        tokens_ -= 1.0;
+        return 0;
+    }
+    return static_cast<int64_t>((1.0 - tokens_) * 1000.0 / opts_.rate_per_sec) + 1;
+}
+
+int64_t LatencyProber::interval_for(const NodeState& st) const {
+    int64_t sec;
+    if (st.state == "dead") {
+        int shift = std::min(st.consecutive_failures - 3, 10);
+        sec = std::min<int64_t>((int64_t)opts_.dead_interval_sec << std::max(shift, 0),
+                                opts_.dead_max_interval_sec);
+    } else if (st.state == "selected") {
+        sec = opts_.selected_interval_sec;
+    } else if (st.state == "flaky") {
+        sec = opts_.flaky_interval_sec;
+    } else {
+        sec = opts_.stable_interval_sec;
+    }
+
+    // ±10% jitter so nodes added together drift apart
+    thread_local std::minstd_rand rng(std::random_device{}());
+    std::uniform_real_distribution<double> jitter(0.9, 1.1);
+    return static_cast<int64_t>(sec * 1000 * jitter(rng));
+}
+
+void LatencyProber::record(const std::string& name, const DelayResult& result) {
+    int64_t now = now_ms();
+    int delay = result.success ? result.delay : 0;
+    bool counted = true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nodes_.find(name);
+        if (it == nodes_.end()) return;  // removed while probing
+        auto& st = it->second;
+        st.in_flight = false;
+
+        if (!result.success && result.api_unreachable) {
+            // mihomo itself is unreachable: not the node's fault
+            mihomo_reachable_ = false;
+            next_refresh_ms_ = std::min(next_refresh_ms_, now + kUnreachableRetryMs);
+            st.next_due_ms = now + kUnreachableRetryMs;
+            counted = false;
+        } else {
+            st.history.push(delay, now);
+            st.last_delay = delay;
+            st.last_probe_ms = now;
+            st.consecutive_failures = delay > 0 ? 0 : st.consecutive_failures + 1;
+
+            const auto& h = st.history;
+            if (st.consecutive_failures >= 3) {
+                st.state = "dead";
+            } else if (st.selected) {
+                st.state = "selected";
+            } else if (h.failures() > 0 || (h.size() >= 3 && h.p95() > 2 * h.min() + 50)) {
+                st.state = "flaky";
+            } else {
+                st.state = "stable";
+            }
+            st.next_due_ms = now + interval_for(st);
+        }
+    }
+
+    if (counted) {
+        probe_count_.fetch_add(1);
+        if (on_result_) on_result_(name, delay);
+    }
+    cv_.notify_all();
+}
+
+void LatencyProber::worker_loop() {
+    while (running_.load()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        int64_t now = now_ms();
+
+        if (now >= next_refresh_ms_) {
+            // This worker refreshes; others keep probing the current set
+            next_refresh_ms_ = now + (int64_t)opts_.refresh_interval_sec * 1000;
+            lock.unlock();
+            do_refresh();
+            continue;
+        }
+
+        if (!mihomo_reachable_) {
+            cv_.wait_for(lock, std::chrono::milliseconds(next_refresh_ms_ - now));
+            continue;
+        }
+
+        int64_t wait_until = next_refresh_ms_;
+        std::string name = pick_due(now, wait_until);
+        if (name.empty()) {
+            cv_.wait_for(lock, std::chrono::milliseconds(std::max<int64_t>(wait_until - now, 1)));
+            continue;
+        }
+
+        int64_t token_wait = take_token(now);
+        if (token_wait > 0) {
+            cv_.wait_for(lock, std::chrono::milliseconds(token_wait));
+            continue;
+        }
+
+        nodes_[name].in_flight = true;
+        lock.unlock();
+
+        DelayResult result = probe_fn_ ? probe_fn_(name) : DelayResult{};
+        record(name, result);
+    }
+}
+
+std::map<std::string, NodeLatency> LatencyProber::snapshot(int64_t since_ms, size_t history) const {
+    std::map<std::string, NodeLatency> out;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, st] : nodes_) {
+        if (since_ms > 0 && st.last_probe_ms < since_ms) continue;
+        NodeLatency nl;
+        nl.name = name;
+        nl.state = st.state;
+        nl.delay = st.last_delay;
+        nl.last_probe_ms = st.last_probe_ms;
+        nl.min = st.history.min();
+        nl.avg = st.history.avg();
+        nl.p95 = st.history.p95();
+        nl.failures = st.history.failures();
+        nl.samples = static_cast<int>(st.history.size());
+        if (history > 0) {
+            size_t n = std::min(history, st.history.size());
+            for (size_t i = st.history.size() - n; i < st.history.size(); ++i) {
+                nl.history.push_back(st.history[i]);
+            }
+        }
+        out[name] = std::move(nl);
+    }
+    return out;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "api/mihomo_client.hpp"
+#include "core/delay_history.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Latest probe state of one node, as served over IPC
+struct NodeLatency {
+    std::string name;
+    std::string state;           // "new", "selected", "stable", "flaky", "dead"
+    int delay = -1;              // last result: -1 untested, 0 failed
+    int64_t last_probe_ms = 0;   // unix epoch ms of the last result
+    int min = -1;
+    int avg = -1;
+    int p95 = -1;
+    int failures = 0;
+    int samples = 0;
+    std::vector<DelaySample> history;  // newest samples, oldest first
+};
+
+/// Background latency prober for the daemon.
+///
+/// Nodes are probed through mihomo's delay API on an adaptive schedule:
+/// selected and flaky nodes are revisited often, stable ones rarely and dead
+/// ones with exponential backoff. A global token bucket caps the probe rate
+/// so mihomo is never flooded regardless of node count.
+class LatencyProber {
+public:
+    struct Options {
+        double rate_per_sec = 1.0;      // global probe rate limit
+        int burst = 3;                  // token bucket size
+        int concurrency = 2;            // probes in flight
+        std::string test_url = "http://www.gstatic.com/generate_204";
+        int timeout_ms = 5000;
+        int selected_interval_sec = 30;
+        int flaky_interval_sec = 60;
+        int stable_interval_sec = 300;
+        int dead_interval_sec = 600;    // base, doubled per consecutive failure
+        int dead_max_interval_sec = 3600;
+        int refresh_interval_sec = 60;  // how often the node list is re-read
+    };
+
+    /// Current node set: all proxy nodes and the ones selected in a group
+    struct Targets {
+        std::vector<std::string> nodes;
+        std::set<std::string> selected;
+    };
+
+    using TargetsFn = std::function<bool(Targets& out)>;  // false = mihomo unreachable
+    using ProbeFn = std::function<DelayResult(const std::string& name)>;
+    using ResultFn = std::function<void(const std::string& name, int delay)>;
+
+    LatencyProber(Options opts, TargetsFn targets, ProbeFn probe, ResultFn on_result = nullptr);
+    ~LatencyProber();
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    /// Re-read the node list now (e.g. after a profile switch)
+    void refresh_targets();
+
+    /// Snapshot of nodes probed at or after `since_ms` (0 = all nodes).
+    /// `history` = number of newest samples to include per node.
+    std::map<std::string, NodeLatency> snapshot(int64_t since_ms = 0, size_t history = 0) const;
+
+    /// Total probes issued since start
+    uint64_t probe_count() const { return probe_count_.load(); }
+
+private:
+    struct NodeState {
+        DelayHistory history{20};
+        int64_t next_due_ms = 0;
+        int64_t last_probe_ms = 0;
+        int last_delay = -1;
+        int consecutive_failures = 0;
+        bool selected = false;
+        bool in_flight = false;
+        std::string state = "new";
+    };
+
+    Options opts_;
+    TargetsFn targets_fn_;
+    ProbeFn probe_fn_;
+    ResultFn on_result_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::string, NodeState> nodes_;
+    int64_t next_refresh_ms_ = 0;
+    bool mihomo_reachable_ = false;
+
+    // Token bucket
+    double tokens_ = 0;
+    int64_t last_refill_ms_ = 0;
+
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> probe_count_{0};
+    std::vector<std::thread> workers_;
+
+    void worker_loop();
+    void do_refresh();
+    /// Pick the earliest due node (caller holds mutex_). Empty if none.
+    std::string pick_due(int64_t now, int64_t& wait_until);
+    /// Milliseconds until a token is available (0 = token taken). Holds mutex_.
+    int64_t take_token(int64_t now);
+    void record(const std::string& name, const DelayResult& result);
+    int64_t interval_for(const NodeState& st) const;
+
+    static int64_t now_ms();
+};
@@ -0,0 +1,119 @@
+#include "daemon/log_ring.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+LogRing::LogRing() : LogRing(Options{}) {}
+
+LogRing::LogRing(Options opts) : opts_(std::move(opts)) {
+    if (opts_.max_lines == 0) opts_.max_lines = 1;
+    if (opts_.file.empty()) return;
+    std::error_code ec;
+    fs::create_directories(fs::path(opts_.file).parent_path(), ec);
+    file_.open(opts_.file, std::ios::app);
+    file_bytes_ = static_cast<int64_t>(fs::file_size(opts_.file, ec));
+    if (ec) file_bytes_ = 0;
+}
+
+void LogRing::append(const std::string& stream, const char* data, size_t len, int source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string& partial = partials_[{source, stream}];
+    size_t start = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (data[i] != '\n') continue;
+        partial.append(data + start, i - start);
+        push_line(stream, std::move(partial));
+        partial.clear();
+        start = i + 1;
+    }
+    partial.append(data + start, len - start);
+    // A runaway line without newlines must not grow without bound
+    if (partial.size() >= opts_.max_line_bytes) {
+        push_line(stream, std::move(partial));
+        partial.clear();
+    }
+    if (file_.is_open()) file_.flush();
+}
+
+void LogRing::flush(const std::string& stream, int source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = partials_.find({source, stream});
+    if (it == partials_.end()) return;
+    std::string partial = std::move(it->second);
+    partials_.erase(it);
+    if (partial.empty()) return;
+    push_line(stream, std::move(partial));
+    if (file_.is_open()) file_.flush();
+}
+
+void LogRing::push_line(const std::string& stream, std::string text) {
+    if (!text.empty() && text.back() == '\r') text.pop_back();
+    if (text.size() > opts_.max_line_bytes) text.resize(opts_.max_line_bytes);
+
+    Line line;
+    line.seq = next_seq_++;
+    line.time_ms = unix_ms();
+    line.stream = stream;
+    line.text = std::move(text);
+    if (file_.is_open()) write_file(line);
+
+    lines_.push_back(std::move(line));
+    while (lines_.size() > opts_.max_lines) lines_.pop_front();
+}
+
+void LogRing::write_file(const Line& line) {
+    std::time_t secs = static_cast<std::time_t>(line.time_ms / 1000);
+    std::tm tm{};
+    localtime_r(&secs, &tm);
+    char ts[32];
+    std::strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    std::string out = std::string(ts) + " " + line.stream + " " + line.text + "\n";
+    file_ << out;
+    file_bytes_ += static_cast<int64_t>(out.size());
+    if (opts_.file_max_bytes > 0 && file_bytes_ >= opts_.file_max_bytes) rotate();
+}
+
+void LogRing::rotate() {
+    file_.close();
+    std::error_code ec;
+    // file.N-1 → file.N … file → file.1; the oldest falls off
+    for (int i = opts_.file_keep; i >= 1; --i) {
+        std::string from = i == 1 ? opts_.file : opts_.file + "." + std::to_string(i - 1);
+        std::string to = opts_.file + "." + std::to_string(i);
+        if (fs::exists(from, ec)) fs::rename(from, to, ec);
+    }
+    if (opts_.file_keep <= 0) fs::remove(opts_.file, ec);
+    file_.open(opts_.file, std::ios::trunc);
+    file_bytes_ = 0;
+}
+
+std::vector<LogRing::Line> LogRing::read(uint64_t since, size_t limit, uint64_t* next) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (next) *next = next_seq_ - 1;
+
+    if (lines_.empty() || since >= lines_.back().seq) return {};
+
+    // Sequence numbers are contiguous, so the first wanted line is found by offset
+    size_t first = 0;
+    if (since >= lines_.front().seq) first = static_cast<size_t>(since - lines_.front().seq + 1);
+    if (limit > 0 && lines_.size() - first > limit) first = lines_.size() - limit;
+    return std::vector<Line>(lines_.begin() + first, lines_.end());
+}
+
+uint64_t LogRing::last_seq() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_seq_ - 1;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Bounded in-memory log of a child process's output.
+///
+/// Raw chunks from stdout/stderr are split into lines (a partial line
+/// waits for the rest of its stream from the same source), numbered, and the oldest lines are
+/// dropped past `max_lines`. Readers page through it by sequence number,
+/// so a follower only ever fetches what is new. Lines can also be written
+/// to a file that is rotated by size.
+class LogRing {
+public:
+    struct Options {
+        size_t max_lines = 2000;
+        size_t max_line_bytes = 4096;   // longer lines are cut
+        std::string file;               // empty = memory only
+        int64_t file_max_bytes = 1024 * 1024;
+        int file_keep = 3;              // rotated copies (file.1 … file.N)
+    };
+
+    struct Line {
+        uint64_t seq = 0;               // 1, 2, … in arrival order
+        int64_t time_ms = 0;            // unix ms when the line completed
+        std::string stream;             // "stdout" / "stderr"
+        std::string text;               // without the newline
+    };
+
+    LogRing();
+    explicit LogRing(Options opts);
+
+    /// Add a raw chunk of a stream's output. `source` tells apart writers
+    /// sharing the ring (e.g. two processes), so their partial lines are
+    /// never spliced together. Thread-safe.
+    void append(const std::string& stream, const char* data, size_t len, int source = 0);
+
+    /// Emit a stream's unterminated last line (the writer closed it)
+    void flush(const std::string& stream, int source = 0);
+
+    /// Lines after `since`, at most the newest `limit` of them (0 = all).
+    /// `next` receives the sequence number to pass as `since` next time.
+    std::vector<Line> read(uint64_t since, size_t limit, uint64_t* next = nullptr) const;
+
+    uint64_t last_seq() const;
+
+private:
+    Options opts_;
+    mutable std::mutex mutex_;
+    std::deque<Line> lines_;
+    uint64_t next_seq_ = 1;
+    std::map<std::pair<int, std::string>, std::string> partials_;  // (source, stream) → unfinished line
+
+    std::ofstream file_;
+    int64_t file_bytes_ = 0;
+
+    void push_line(const std::string& stream, std::string text);  // mutex_ held
+    void write_file(const Line& line);                            // mutex_ held
+    void rotate();                                                // mutex_ held
+};
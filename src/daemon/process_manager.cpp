@@ -2,89 +2,356 @@
 
 #include <unistd.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
 #include <cstring>
 
-ProcessManager::ProcessManager() = default;
+#ifdef __linux__
+#include <sched.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#endif
+
+extern char** environ;
+
+namespace {
+
+// fd that becomes readable when `pid` exits; -1 if the kernel has no pidfd
+int open_pidfd(pid_t pid) {
+#ifdef __linux__
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+// SIGCHLD as a readable fd for the calling thread (blocks the signal there)
+int open_sigchld_fd() {
+#ifdef __linux__
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    return signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+#else
+    return -1;
+#endif
+}
+
+int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// ioprio_set/ioprio_get have no libc wrappers
+constexpr int kIoprioWhoProcess = 1;
+constexpr int kIoprioClassShift = 13;
+
+// Bytes the child writes to the report pipe for options it could not apply
+constexpr char kFailAffinity = 'a';
+constexpr char kFailNice = 'n';
+constexpr char kFailIonice = 'i';
+constexpr char kFailNofile = 'f';
+constexpr char kFailMemory = 'm';
+
+const char* fail_name(char code) {
+    switch (code) {
+        case kFailAffinity: return "cpus";
+        case kFailNice:     return "nice";
+        case kFailIonice:   return "ionice";
+        case kFailNofile:   return "nofile";
+        case kFailMemory:   return "memory";
+        default:            return "unknown";
+    }
+}
+
+// The daemon's environment with `overrides` replacing or adding entries;
+// built before fork since the child may not allocate
+std::vector<std::string> merged_environment(
+        const std::vector<std::pair<std::string, std::string>>& overrides) {
+    std::vector<std::string> env;
+    for (char** e = environ; e && *e; ++e) {
+        std::string entry(*e);
+        std::string key = entry.substr(0, entry.find('='));
+        bool replaced = std::any_of(overrides.begin(), overrides.end(),
+                                    [&](const auto& kv) { return kv.first == key; });
+        if (!replaced) env.push_back(std::move(entry));
+    }
+    for (const auto& kv : overrides) env.push_back(kv.first + "=" + kv.second);
+    return env;
+}
+
+// Read back what `pid` runs with (after its exec)
+void read_launch_state(pid_t pid, ProcessManager::LaunchReport& r) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(pid, sizeof(set), &set) == 0) {
+        std::vector<int> cpus;
+        for (int i = 0; i < CPU_SETSIZE; ++i) {
+            if (CPU_ISSET(i, &set)) cpus.push_back(i);
+        }
+        r.cpus = ProcessManager::format_cpu_list(cpus);
+    }
+    long io = syscall(SYS_ioprio_get, kIoprioWhoProcess, pid);
+    if (io >= 0) {
+        r.ionice_class = static_cast<int>(io >> kIoprioClassShift);
+        r.ionice_level = static_cast<int>(io & ((1 << kIoprioClassShift) - 1));
+    }
+    rlimit rl{};
+    if (prlimit(pid, RLIMIT_NOFILE, nullptr, &rl) == 0) {
+        r.nofile_soft = rl.rlim_cur;
+        r.nofile_hard = rl.rlim_max;
+    }
+    if (prlimit(pid, RLIMIT_AS, nullptr, &rl) == 0) {
+        r.memory_bytes = rl.rlim_cur == RLIM_INFINITY ? 0 : rl.rlim_cur;
+    }
+#endif
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, pid);
+    if (errno == 0) r.nice = nice;
+}
+
+} // namespace
+
+ProcessManager::ProcessManager() {
+    if (pipe2(wake_fds_, O_NONBLOCK | O_CLOEXEC) != 0) {
+        wake_fds_[0] = wake_fds_[1] = -1;
+    }
+}
 
 ProcessManager::~ProcessManager() {
     stop();
+    for (int fd : wake_fds_) {
+        if (fd >= 0) close(fd);
+    }
+    // The sink's owner may already be gone
+    close_output(0, false);
+    close_output(1, false);
+}
+
+void ProcessManager::set_output_sink(OutputSink sink) {
+    output_sink_ = std::move(sink);
+}
+
+void ProcessManager::close_output(int index, bool notify) {
+    if (output_fds_[index] < 0) return;
+    close(output_fds_[index]);
+    output_fds_[index] = -1;
+    if (notify && output_sink_) output_sink_(index == 0 ? STDOUT_FILENO : STDERR_FILENO, nullptr, 0);
+}
+
+bool ProcessManager::read_output(int index) {
+    int fd = output_fds_[index];
+    if (fd < 0) return false;
+    char buf[4096];
+    // Bounded, so a chatty child cannot keep the monitor from its exit
+    for (int i = 0; i < 16; ++i) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            if (output_sink_) output_sink_(index == 0 ? STDOUT_FILENO : STDERR_FILENO, buf, n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+        close_output(index, true);  // EOF or error
+        return false;
+    }
+    return true;
 }
 
-bool ProcessManager::do_start() {
+pid_t ProcessManager::do_start() {
+    // Build argv before forking: the child may only call async-signal-safe functions
+    std::vector<const char*> argv;
+    argv.push_back(binary_path_.c_str());
+    for (const auto& arg : args_) {
+        argv.push_back(arg.c_str());
+    }
+    argv.push_back(nullptr);
+
+    // Launch options, prepared here for the same reason
+    const LaunchOptions& opts = launch_;
+    std::vector<std::string> env_storage;
+    std::vector<char*> envp;
+    if (!opts.env.empty()) {
+        env_storage = merged_environment(opts.env);
+        for (auto& e : env_storage) envp.push_back(&e[0]);
+        envp.push_back(nullptr);
+    }
+    std::vector<int> cpu_list;
+    bool set_affinity = !opts.cpus.empty() && parse_cpu_list(opts.cpus, cpu_list);
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpu_list) CPU_SET(cpu, &cpu_set);
+#endif
+
+    // Closed by the child's exec; carries one byte per option it failed to apply.
+    // Pipes are created close-on-exec atomically: a child forked by another
+    // slot in between must not inherit a write end, or the read below hangs.
+    int report_pipe[2] = {-1, -1};
+    if (pipe2(report_pipe, O_CLOEXEC) != 0) {
+        report_pipe[0] = report_pipe[1] = -1;
+    }
+
+    // Output pipes for this child; the previous child's are done with
+    close_output(0, true);
+    close_output(1, true);
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    if (output_sink_ && (pipe2(out_pipe, O_CLOEXEC) != 0 || pipe2(err_pipe, O_CLOEXEC) != 0)) {
+        for (int fd : {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1]}) {
+            if (fd >= 0) close(fd);
+        }
+        out_pipe[0] = out_pipe[1] = err_pipe[0] = err_pipe[1] = -1;
+    }
+    bool capture = out_pipe[0] >= 0;
+
     pid_t pid = fork();
     if (pid < 0) {
-        return false; // fork failed
+        for (int fd : {out_pipe[0], out_pipe[1], err_pipe[0], err_pipe[1], report_pipe[0], report_pipe[1]}) {
+            if (fd >= 0) close(fd);
+        }
+        return -1; // fork failed
     }
 
     if (pid == 0) {
-        // Child process
-        // Build argv array for execvp
-        std::vector<const char*> argv;
-        argv.push_back(binary_path_.c_str());
-        for (const auto& arg : args_) {
-            argv.push_back(arg.c_str());
+        // Child process: don't pass on the monitor thread's blocked SIGCHLD
+        sigset_t none;
+        sigemptyset(&none);
+        sigprocmask(SIG_SETMASK, &none, nullptr);
+
+        // dup2 clears close-on-exec, so only fds 1 and 2 survive exec
+        if (capture) {
+            dup2(out_pipe[1], STDOUT_FILENO);
+            dup2(err_pipe[1], STDERR_FILENO);
         }
-        argv.push_back(nullptr);
+
+        // Launch options: syscalls only, failures reported and not fatal
+        auto fail = [&](char code) {
+            ssize_t n = write(report_pipe[1], &code, 1);
+            (void)n;
+        };
+#ifdef __linux__
+        if (set_affinity && sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) fail(kFailAffinity);
+        if (opts.ionice_class > 0 &&
+            syscall(SYS_ioprio_set, kIoprioWhoProcess, 0,
+                    (opts.ionice_class << kIoprioClassShift) | opts.ionice_level) != 0) {
+            fail(kFailIonice);
+        }
+#else
+        if (set_affinity) fail(kFailAffinity);
+        if (opts.ionice_class > 0) fail(kFailIonice);
+#endif
+        if (!opts.cpus.empty() && !set_affinity) fail(kFailAffinity);
+        if (opts.nice != 0 && setpriority(PRIO_PROCESS, 0, opts.nice) != 0) fail(kFailNice);
+        if (opts.nofile > 0) {
+            // Raise the hard limit too where permitted, else go as high as it allows
+            rlimit cur{};
+            getrlimit(RLIMIT_NOFILE, &cur);
+            rlimit want{static_cast<rlim_t>(opts.nofile),
+                        std::max(cur.rlim_max, static_cast<rlim_t>(opts.nofile))};
+            if (setrlimit(RLIMIT_NOFILE, &want) != 0) {
+                want.rlim_max = cur.rlim_max;
+                want.rlim_cur = std::min(want.rlim_cur, cur.rlim_max);
+                setrlimit(RLIMIT_NOFILE, &want);
+                fail(kFailNofile);
+            }
+        }
+        if (opts.memory_bytes > 0) {
+            rlimit mem{static_cast<rlim_t>(opts.memory_bytes), static_cast<rlim_t>(opts.memory_bytes)};
+            if (setrlimit(RLIMIT_AS, &mem) != 0) fail(kFailMemory);
+        }
+        if (!envp.empty()) environ = envp.data();
 
         // Replace child process with target binary
-        execvp(binary_path_.c_str(), const_cast<char* const*>(argv.data()));
+        execvp(argv[0], const_cast<char* const*>(argv.data()));
 
         // If execvp returns, it failed
         _exit(127);
     }
 
-    // Parent process
+    // Parent process: wait for the exec (or exit), then read back what it got
+    LaunchReport report;
+    report.pid = pid;
+    if (report_pipe[0] >= 0) {
+        close(report_pipe[1]);
+        char codes[16];
+        for (;;) {
+            ssize_t n = read(report_pipe[0], codes, sizeof(codes));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            for (ssize_t i = 0; i < n; ++i) report.failed.push_back(fail_name(codes[i]));
+        }
+        close(report_pipe[0]);
+    }
+    read_launch_state(pid, report);
+    for (const auto& kv : opts.env) report.env.push_back(kv.first + "=" + kv.second);
+    launch_report_ = std::move(report);
+
+    if (capture) {
+        close(out_pipe[1]);
+        close(err_pipe[1]);
+        output_fds_[0] = out_pipe[0];
+        output_fds_[1] = err_pipe[0];
+        for (int fd : output_fds_) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
     child_pid_ = pid;
-    return true;
+    stats_.started_ms = unix_ms();
+    return pid;
 }
 
 bool ProcessManager::start(const std::string& binary_path, const std::vector<std::string>& args) {
-    // Stop existing process if running
-    if (is_running()) {
-        stop();
-    }
+    // Stop existing process (and a monitor that outlived its child)
+    stop();
 
     binary_path_ = binary_path;
     args_ = args;
-    stop_requested_.store(false);
 
-    if (!do_start()) {
+    pid_t pid;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_requested_.store(false);
+        // An explicit start is a fresh attempt, also out of a crash loop
+        stats_.consecutive_crashes = 0;
+        stats_.crash_loop = false;
+        pid = do_start();
+    }
+    if (pid <= 0) {
         return false;
     }
+    if (on_start) on_start(pid);
 
-    // Start monitor thread
-    monitor_running_.store(true);
-    monitor_thread_ = std::thread(&ProcessManager::monitor_loop, this);
-
+    start_monitor();
     return true;
 }
 
 bool ProcessManager::stop() {
-    stop_requested_.store(true);
-
-    if (child_pid_ > 0) {
-        // Send SIGTERM first
-        if (kill(child_pid_, SIGTERM) == 0) {
-            // Wait up to 5 seconds for graceful exit
-            for (int i = 0; i < 50; ++i) {
-                int status;
-                pid_t result = waitpid(child_pid_, &status, WNOHANG);
-                if (result > 0) {
-                    child_pid_ = -1;
-                    stop_monitor();
-                    return true;
-                }
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            }
+    pid_t pid;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_requested_.store(true);
+        pid = child_pid_.load();
+    }
 
-            // Force kill if still running
-            kill(child_pid_, SIGKILL);
-            int status;
-            waitpid(child_pid_, &status, 0);
+    // The monitor reaps the child and reports it through exited_cv_
+    if (pid > 0 && kill(pid, SIGTERM) == 0) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto gone = [&] { return child_pid_.load() != pid; };
+        // Wait up to 5 seconds for graceful exit, then force kill
+        if (!exited_cv_.wait_for(lock, std::chrono::seconds(5), gone)) {
+            kill(pid, SIGKILL);
+            exited_cv_.wait(lock, gone);
         }
-        child_pid_ = -1;
     }
 
     stop_monitor();
@@ -92,25 +359,17 @@ bool ProcessManager::stop() {
 }
 
 bool ProcessManager::restart() {
-    stop();
-    stop_requested_.store(false);
-
-    if (!do_start()) {
-        return false;
-    }
-
-    // Restart monitor
-    monitor_running_.store(true);
-    monitor_thread_ = std::thread(&ProcessManager::monitor_loop, this);
-
-    return true;
+    std::string binary = binary_path_;
+    std::vector<std::string> args = args_;
+    return start(binary, args);
 }
 
 bool ProcessManager::is_running() const {
-    if (child_pid_ <= 0) return false;
+    pid_t pid = child_pid_.load();
+    if (pid <= 0) return false;
 
     // Check if process exists without sending a signal
-    if (kill(child_pid_, 0) == 0) {
+    if (kill(pid, 0) == 0) {
         return true;
     }
     return false;
@@ -124,46 +383,231 @@ void ProcessManager::set_auto_restart(bool enable) {
     auto_restart_.store(enable);
 }
 
+void ProcessManager::set_restart_policy(const RestartPolicy& policy) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    policy_ = policy;
+}
+
+int64_t ProcessManager::backoff_delay_ms(const RestartPolicy& policy, int crashes) {
+    int64_t delay = std::max(policy.initial_delay_ms, 0);
+    for (int i = 1; i < crashes && delay < policy.max_delay_ms; ++i) {
+        delay *= 2;
+    }
+    return std::min<int64_t>(delay, policy.max_delay_ms);
+}
+
+void ProcessManager::set_launch_options(const LaunchOptions& opts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    launch_ = opts;
+}
+
+ProcessManager::LaunchReport ProcessManager::launch_report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return launch_report_;
+}
+
+bool ProcessManager::parse_cpu_list(const std::string& list, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string part = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        size_t dash = part.find('-');
+        std::string lo_s = part.substr(0, dash);
+        std::string hi_s = dash == std::string::npos ? lo_s : part.substr(dash + 1);
+        auto is_num = [](const std::string& s) {
+            return !s.empty() && s.size() <= 5 &&
+                   std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+        };
+        if (!is_num(lo_s) || !is_num(hi_s)) return false;
+        int lo = std::stoi(lo_s);
+        int hi = std::stoi(hi_s);
+        if (lo > hi || hi >= kMaxCpus) return false;
+        for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string ProcessManager::format_cpu_list(const std::vector<int>& cpus) {
+    std::string out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
+
+ProcessManager::Stats ProcessManager::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s = stats_;
+    if (child_pid_.load() <= 0) s.started_ms = 0;
+    return s;
+}
+
+bool ProcessManager::crash_looped() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.crash_loop;
+}
+
+void ProcessManager::start_monitor() {
+    stop_monitor();
+    monitor_running_.store(true);
+    monitor_thread_ = std::thread(&ProcessManager::monitor_loop, this);
+}
+
 void ProcessManager::stop_monitor() {
     monitor_running_.store(false);
+    if (wake_fds_[1] >= 0) {
+        char c = 1;
+        ssize_t n = write(wake_fds_[1], &c, 1);
+        (void)n;
+    }
     if (monitor_thread_.joinable()) {
         monitor_thread_.join();
     }
+    drain_wake();
 }
 
-void ProcessManager::monitor_loop() {
+void ProcessManager::drain_wake() {
+    if (wake_fds_[0] < 0) return;
+    char buf[64];
+    while (read(wake_fds_[0], buf, sizeof(buf)) > 0) {}
+}
+
+bool ProcessManager::sleep_unless_woken(int64_t ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
     while (monitor_running_.load() && !stop_requested_.load()) {
-        if (child_pid_ > 0) {
-            int status;
-            pid_t result = waitpid(child_pid_, &status, WNOHANG);
-
-            if (result > 0) {
-                // Child exited
-                int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
-                child_pid_ = -1;
-
-                if (!stop_requested_.load()) {
-                    // Unexpected exit
-                    if (on_crash) {
-                        on_crash(exit_code);
-                    }
-
-                    if (auto_restart_.load()) {
-                        // Wait before restarting
-                        for (int i = 0; i < 30 && !stop_requested_.load(); ++i) {
-                            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                        }
-                        if (!stop_requested_.load()) {
-                            do_start();
-                        }
-                    }
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) return true;
+        pollfd pfd{wake_fds_[0], POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(left)) > 0) drain_wake();
+    }
+    return false;
+}
+
+bool ProcessManager::wait_exit(pid_t pid, int& status, int& sigfd) {
+    int pidfd = open_pidfd(pid);
+    if (pidfd < 0 && sigfd < 0) sigfd = open_sigchld_fd();
+    int watch = pidfd >= 0 ? pidfd : sigfd;
+    // SIGCHLD may be taken by another thread, so the fallback re-checks
+    int timeout = pidfd >= 0 ? -1 : (sigfd >= 0 ? 250 : 50);
+
+    bool reaped = false;
+    while (monitor_running_.load()) {
+        pid_t r = waitpid(pid, &status, WNOHANG);
+        if (r == pid || (r < 0 && errno == ECHILD)) {
+            if (r < 0) status = -1;  // reaped elsewhere
+            reaped = true;
+            break;
+        }
+
+        // An fd of -1 is ignored by poll()
+        pollfd fds[4] = {{wake_fds_[0], POLLIN, 0}, {watch, POLLIN, 0},
+                         {output_fds_[0], POLLIN, 0}, {output_fds_[1], POLLIN, 0}};
+        if (poll(fds, 4, timeout) <= 0) continue;
+        if (fds[0].revents & POLLIN) drain_wake();
+#ifdef __linux__
+        if (watch >= 0 && watch == sigfd && (fds[1].revents & POLLIN)) {
+            signalfd_siginfo info;
+            while (read(sigfd, &info, sizeof(info)) > 0) {}
+        }
+#endif
+        for (int i = 0; i < 2; ++i) {
+            if (fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR)) read_output(i);
+        }
+    }
+
+    // Last words of the exited child (crash messages), then the pipes go
+    if (reaped) {
+        for (int i = 0; i < 2; ++i) {
+            while (output_fds_[i] >= 0 && read_output(i)) {
+                pollfd pfd{output_fds_[i], POLLIN, 0};
+                if (poll(&pfd, 1, 0) <= 0) break;  // a grandchild may keep it open
+            }
+            close_output(i, true);
+        }
+    }
+
+    if (pidfd >= 0) close(pidfd);
+    return reaped;
+}
+
+void ProcessManager::monitor_loop() {
+    int sigfd = -1;
+
+    while (monitor_running_.load()) {
+        pid_t pid = child_pid_.load();
+        if (pid <= 0) break;
+
+        int status = 0;
+        if (!wait_exit(pid, status, sigfd)) break;  // told to stop
+
+        // Child exited
+        bool exited = status != -1 && WIFEXITED(status);
+        int exit_code = exited ? WEXITSTATUS(status) : -1;
+        RestartPolicy policy;
+        Stats loop_stats;
+        int64_t delay = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            child_pid_ = -1;
+            if (!stop_requested_.load()) {
+                ExitRecord rec;
+                rec.time_ms = unix_ms();
+                rec.exit_code = exit_code;
+                rec.signal = (status != -1 && WIFSIGNALED(status)) ? WTERMSIG(status) : 0;
+                rec.uptime_ms = rec.time_ms - stats_.started_ms;
+                stats_.recent.push_back(rec);
+                if (stats_.recent.size() > kRecentExits) stats_.recent.erase(stats_.recent.begin());
+                ++stats_.crashes;
+
+                // Back off while it keeps crashing; a long enough run starts over
+                policy = policy_;
+                if (rec.uptime_ms >= policy.stable_after_ms) stats_.consecutive_crashes = 0;
+                ++stats_.consecutive_crashes;
+                delay = backoff_delay_ms(policy, stats_.consecutive_crashes);
+                if (auto_restart_.load() && policy.crash_loop_threshold > 0 &&
+                    stats_.consecutive_crashes >= policy.crash_loop_threshold) {
+                    stats_.crash_loop = true;
+                    loop_stats = stats_;
                 }
             }
         }
+        exited_cv_.notify_all();
+        if (stop_requested_.load()) break;
+
+        // Unexpected exit
+        if (on_crash) {
+            on_crash(exit_code);
+        }
+        if (!auto_restart_.load()) break;
+        if (loop_stats.crash_loop) {
+            // Restarting would fail the same way; wait for an explicit start
+            if (on_crash_loop) on_crash_loop(loop_stats);
+            break;
+        }
 
-        // Check every 500ms
-        for (int i = 0; i < 5 && monitor_running_.load() && !stop_requested_.load(); ++i) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (!sleep_unless_woken(delay)) break;
+
+        pid_t next;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stop_requested_.load()) break;
+            next = do_start();
+            if (next > 0) ++stats_.restarts;
         }
+        if (next <= 0) break;
+        if (on_start) on_start(next);
     }
+
+    if (sigfd >= 0) close(sigfd);
 }
@@ -3,15 +3,86 @@
 #include <string>
 #include <functional>
 #include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <thread>
+#include <utility>
 #include <vector>
 #include <sys/types.h>
 
+/// Runs one child process and restarts it when it crashes.
+///
+/// The monitor thread sleeps until the child exits: on a pidfd where the
+/// kernel has pidfd_open (Linux 5.3+), otherwise on SIGCHLD through a
+/// signalfd with a periodic waitpid as a safety net. Crash restarts back
+/// off exponentially instead of waiting a fixed time, and stop altogether
+/// after too many quick crashes in a row (crash loop) until the next
+/// explicit start(). With an output sink, the child's stdout/stderr are
+/// pipes that the monitor reads without blocking in the same poll().
+/// Launch options (affinity, priorities, rlimits, environment) are applied
+/// in the child between fork and exec, so they hold from mihomo's first
+/// instruction and every restart gets them again.
 class ProcessManager {
 public:
+    /// Delay before restarting a crashed child
+    struct RestartPolicy {
+        int initial_delay_ms = 100;     // first restart after a crash
+        int max_delay_ms = 30000;       // doubled per consecutive crash up to this
+        int stable_after_ms = 30000;    // a child up this long resets the backoff
+        int crash_loop_threshold = 5;   // consecutive quick crashes before giving up (0 = never)
+    };
+
+    /// An exit that was not asked for
+    struct ExitRecord {
+        int64_t time_ms = 0;            // unix ms
+        int exit_code = -1;             // -1 when killed by a signal
+        int signal = 0;                 // terminating signal, 0 if it exited
+        int64_t uptime_ms = 0;          // how long that child ran
+    };
+
+    struct Stats {
+        int64_t started_ms = 0;         // unix ms the current child started (0 = none)
+        uint64_t restarts = 0;          // automatic restarts after crashes
+        uint64_t crashes = 0;
+        int consecutive_crashes = 0;    // quick crashes since the last stable run
+        bool crash_loop = false;        // restarts suspended
+        std::vector<ExitRecord> recent; // oldest first, at most kRecentExits
+    };
+
+    static constexpr size_t kRecentExits = 16;
+
+    /// Applied to every child before exec; defaults inherit the daemon's
+    struct LaunchOptions {
+        std::string cpus;               // CPU affinity list, e.g. "0-3,6" (empty = inherit)
+        int nice = 0;                   // 0 = inherit
+        int ionice_class = 0;           // 1 realtime, 2 best-effort, 3 idle (0 = inherit)
+        int ionice_level = 4;           // 0 (highest) - 7, realtime and best-effort
+        uint64_t nofile = 0;            // RLIMIT_NOFILE (0 = inherit)
+        uint64_t memory_bytes = 0;      // RLIMIT_AS (0 = inherit)
+        std::vector<std::pair<std::string, std::string>> env;  // added/overridden variables
+    };
+
+    /// What the current child actually runs with, read back after exec
+    struct LaunchReport {
+        pid_t pid = -1;                 // -1 = no child started yet
+        std::string cpus;               // affinity as a CPU list
+        int nice = 0;
+        int ionice_class = 0;
+        int ionice_level = 0;
+        uint64_t nofile_soft = 0;
+        uint64_t nofile_hard = 0;
+        uint64_t memory_bytes = 0;      // RLIMIT_AS soft limit (0 = unlimited)
+        std::vector<std::string> env;   // "KEY=value" set from LaunchOptions::env
+        std::vector<std::string> failed;  // options the child could not apply
+    };
+
     ProcessManager();
     ~ProcessManager();
 
+    ProcessManager(const ProcessManager&) = delete;
+    ProcessManager& operator=(const ProcessManager&) = delete;
+
     /// Start a child process with the given binary and arguments
     bool start(const std::string& binary_path, const std::vector<std::string>& args = {});
 
@@ -30,9 +101,49 @@ public:
     /// Enable or disable automatic restart on crash
     void set_auto_restart(bool enable);
 
+    void set_restart_policy(const RestartPolicy& policy);
+
+    /// Options for children started from now on (restarts included)
+    void set_launch_options(const LaunchOptions& opts);
+
+    /// Effective launch settings of the last child
+    LaunchReport launch_report() const;
+
+    /// Highest CPU index a list may name, plus one (glibc's CPU_SETSIZE)
+    static constexpr int kMaxCpus = 1024;
+
+    /// "0-3,6" → CPU indices; false on a malformed list
+    static bool parse_cpu_list(const std::string& list, std::vector<int>& cpus);
+
+    /// CPU indices (sorted) → "0-3,6"
+    static std::string format_cpu_list(const std::vector<int>& cpus);
+
+    /// Delay before the restart that follows `crashes` consecutive crashes (≥ 1)
+    static int64_t backoff_delay_ms(const RestartPolicy& policy, int crashes);
+
+    /// Restart and crash accounting since construction
+    Stats stats() const;
+
+    /// True while restarts are suspended after a crash loop
+    bool crash_looped() const;
+
     /// Callback invoked when the child process exits unexpectedly
     std::function<void(int exit_code)> on_crash;
 
+    /// Callback invoked when restarts are suspended (after on_crash)
+    std::function<void(const Stats& stats)> on_crash_loop;
+
+    /// Callback invoked after a child process is spawned (including auto-restarts)
+    std::function<void(pid_t pid)> on_start;
+
+    /// Receives the child's output: `stream` is STDOUT_FILENO or
+    /// STDERR_FILENO, and a call with `len` 0 means that stream closed.
+    /// Runs on the monitor thread.
+    using OutputSink = std::function<void(int stream, const char* data, size_t len)>;
+
+    /// Capture stdout/stderr of children started from now on (null = inherit)
+    void set_output_sink(OutputSink sink);
+
 private:
     std::string binary_path_;
     std::vector<std::string> args_;
@@ -42,7 +153,34 @@ private:
     std::atomic<bool> monitor_running_{false};
     std::thread monitor_thread_;
 
+    // Guards spawning against stop(), the policy and stats_, and carries
+    // exit notifications
+    mutable std::mutex mutex_;
+    std::condition_variable exited_cv_;
+    RestartPolicy policy_;
+    Stats stats_;
+    LaunchOptions launch_;
+    LaunchReport launch_report_;
+
+    // Written to wake the monitor out of poll() (stop, shutdown)
+    int wake_fds_[2] = {-1, -1};
+
+    // Read ends of the child's stdout/stderr pipes; used by whichever
+    // thread spawns (start() with the monitor stopped, or the monitor)
+    OutputSink output_sink_;
+    int output_fds_[2] = {-1, -1};
+
     void monitor_loop();
     void stop_monitor();
-    bool do_start();
+    void start_monitor();
+    /// Fork and exec; returns the pid or -1 (does not call on_start)
+    pid_t do_start();
+    /// Block until `pid` is reaped (true) or the monitor is told to stop
+    bool wait_exit(pid_t pid, int& status, int& sigfd);
+    /// Sleep up to `ms`; false if woken early to stop
+    bool sleep_unless_woken(int64_t ms);
+    void drain_wake();
+    /// Read what is buffered on an output pipe; false once it is closed
+    bool read_output(int index);
+    void close_output(int index, bool notify);
 };
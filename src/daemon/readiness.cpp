@@ -0,0 +1,50 @@
+#include "daemon/readiness.hpp"
+
+#include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+
+namespace readiness {
+
+bool port_accepts(const std::string& host, int port, int timeout_ms) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0) return false;
+
+    bool ok = false;
+    for (addrinfo* ai = res; ai && !ok; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            ok = true;
+        } else if (errno == EINPROGRESS) {
+            pollfd pfd{fd, POLLOUT, 0};
+            if (poll(&pfd, 1, timeout_ms) > 0) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ok = getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0;
+            }
+        }
+        close(fd);
+    }
+    freeaddrinfo(res);
+    return ok;
+}
+
+bool proxies_loaded(const std::string& body) {
+    try {
+        auto j = nlohmann::json::parse(body);
+        return j.contains("proxies") && j["proxies"].is_object() && !j["proxies"].empty();
+    } catch (...) {
+        return false;
+    }
+}
+
+} // namespace readiness
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+/// Readiness checks for a freshly started mihomo.
+///
+/// The controller port is watched with non-blocking connects first, which
+/// cost a syscall each and fail at once while nothing listens, so no HTTP
+/// client is built until mihomo accepts connections. The API comes up
+/// before the config is fully applied, so /proxies then has to list the
+/// loaded proxies before mihomo counts as ready.
+namespace readiness {
+
+/// True once host:port accepts a TCP connection within `timeout_ms`
+bool port_accepts(const std::string& host, int port, int timeout_ms);
+
+/// True if a /proxies response body lists at least one proxy
+bool proxies_loaded(const std::string& body);
+
+} // namespace readiness
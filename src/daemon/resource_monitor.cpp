@@ -0,0 +1,228 @@
+#include "daemon/resource_monitor.hpp"
+
+#include <dirent.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+int64_t unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    out = ss.str();
+    return true;
+}
+
+// Entries of /proc/<pid>/fd; -1 if it cannot be listed
+int count_fds(pid_t pid) {
+    std::string path = "/proc/" + std::to_string(pid) + "/fd";
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return -1;
+    int n = 0;
+    while (dirent* ent = readdir(dir)) {
+        if (ent->d_name[0] != '.') ++n;
+    }
+    closedir(dir);
+    return n;
+}
+
+} // namespace
+
+ResourceMonitor::ResourceMonitor(Options opts, PidFn pid_fn, SampleFn on_sample)
+    : opts_(std::move(opts)), pid_fn_(std::move(pid_fn)), on_sample_(std::move(on_sample)) {
+    if (opts_.interval_ms < 100) opts_.interval_ms = 100;
+    if (opts_.history == 0) opts_.history = 1;
+}
+
+ResourceMonitor::~ResourceMonitor() {
+    stop();
+}
+
+void ResourceMonitor::start() {
+    if (running_.exchange(true)) return;
+    thread_ = std::thread(&ResourceMonitor::run_loop, this);
+}
+
+void ResourceMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        running_.store(false);
+    }
+    stop_cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+}
+
+void ResourceMonitor::run_loop() {
+    while (running_.load()) {
+        sample_once();
+        std::unique_lock<std::mutex> lock(stop_mutex_);
+        stop_cv_.wait_for(lock, std::chrono::milliseconds(opts_.interval_ms),
+                          [this] { return !running_.load(); });
+    }
+}
+
+bool ResourceMonitor::sample_once() {
+    pid_t pid = pid_fn_ ? pid_fn_() : -1;
+    if (pid <= 0) {
+        last_pid_ = -1;
+        return false;
+    }
+
+    Sample s;
+    uint64_t ticks = 0;
+    if (!read_proc(pid, s, ticks)) return false;
+
+    // CPU share over the interval since the previous sample of this process
+    int64_t now = steady_ms();
+    if (pid == last_pid_ && now > last_steady_ms_ && ticks >= last_ticks_) {
+        static const long hz = sysconf(_SC_CLK_TCK) > 0 ? sysconf(_SC_CLK_TCK) : 100;
+        double cpu_sec = static_cast<double>(ticks - last_ticks_) / static_cast<double>(hz);
+        s.cpu_pct = cpu_sec * 100000.0 / static_cast<double>(now - last_steady_ms_);
+    }
+    last_pid_ = pid;
+    last_ticks_ = ticks;
+    last_steady_ms_ = now;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        history_.push_back(s);
+        while (history_.size() > opts_.history) history_.pop_front();
+    }
+
+    std::vector<Alert> alerts = check(s);
+    if (on_sample_) on_sample_(s, alerts);
+    return true;
+}
+
+std::vector<ResourceMonitor::Sample> ResourceMonitor::history() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<Sample>(history_.begin(), history_.end());
+}
+
+bool ResourceMonitor::latest(Sample& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (history_.empty()) return false;
+    out = history_.back();
+    return true;
+}
+
+bool ResourceMonitor::over(Streak& s, bool exceeded, bool once) {
+    if (!exceeded) {
+        s = Streak{};
+        return false;
+    }
+    ++s.count;
+    if (s.count < std::max(1, opts_.limits.sustain)) return false;
+    if (once) {
+        // A warning is repeated only after the value came back under
+        if (s.fired) return false;
+        s.fired = true;
+        return true;
+    }
+    s.count = 0;
+    return true;
+}
+
+std::vector<ResourceMonitor::Alert> ResourceMonitor::check(const Sample& sample) {
+    if (sample.pid != check_pid_) {
+        check_pid_ = sample.pid;
+        rss_warn_ = rss_restart_ = fds_warn_ = fds_restart_ = cpu_warn_ = Streak{};
+        restart_requested_ = false;
+    }
+
+    const Limits& l = opts_.limits;
+    std::vector<Alert> alerts;
+    auto raise = [&](const char* metric, double value, double limit, bool restart) {
+        alerts.push_back({metric, value, limit, restart});
+    };
+    double rss = static_cast<double>(sample.rss_kb);
+
+    if (l.rss_warn_kb > 0 && over(rss_warn_, sample.rss_kb >= l.rss_warn_kb, true)) {
+        raise("rss_kb", rss, static_cast<double>(l.rss_warn_kb), false);
+    }
+    if (l.fds_warn > 0 && over(fds_warn_, sample.fds >= l.fds_warn, true)) {
+        raise("fds", sample.fds, l.fds_warn, false);
+    }
+    if (l.cpu_warn_pct > 0 && over(cpu_warn_, sample.cpu_pct >= l.cpu_warn_pct, true)) {
+        raise("cpu_pct", sample.cpu_pct, l.cpu_warn_pct, false);
+    }
+    // One restart per process: while it is pending (e.g. queued behind
+    // other jobs) the same pid must not queue more
+    if (restart_requested_) return alerts;
+    if (l.rss_restart_kb > 0 && over(rss_restart_, sample.rss_kb >= l.rss_restart_kb, false)) {
+        raise("rss_kb", rss, static_cast<double>(l.rss_restart_kb), true);
+        restart_requested_ = true;
+    } else if (l.fds_restart > 0 && over(fds_restart_, sample.fds >= l.fds_restart, false)) {
+        raise("fds", sample.fds, l.fds_restart, true);
+        restart_requested_ = true;
+    }
+    return alerts;
+}
+
+bool ResourceMonitor::read_proc(pid_t pid, Sample& out, uint64_t& cpu_ticks) {
+    std::string base = "/proc/" + std::to_string(pid);
+    std::string stat, status;
+    if (!read_file(base + "/stat", stat) || !read_file(base + "/status", status)) return false;
+
+    out = Sample{};
+    out.pid = pid;
+    out.time_ms = unix_ms();
+    if (!parse_stat(stat, cpu_ticks, out.threads)) return false;
+    if (!parse_status_rss(status, out.rss_kb)) return false;
+    out.fds = count_fds(pid);
+    return out.fds >= 0;
+}
+
+bool ResourceMonitor::parse_stat(const std::string& line, uint64_t& cpu_ticks, int& threads) {
+    // "pid (comm) state ppid ..." — comm ends at the last ')'
+    size_t close = line.rfind(')');
+    if (close == std::string::npos) return false;
+    std::istringstream in(line.substr(close + 1));
+
+    // Fields after comm start at 3 (state); utime/stime are 14/15, num_threads 20
+    std::string field;
+    uint64_t utime = 0, stime = 0;
+    long num_threads = 0;
+    for (int i = 3; i <= 20; ++i) {
+        if (!(in >> field)) return false;
+        if (i == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+        else if (i == 15) stime = std::strtoull(field.c_str(), nullptr, 10);
+        else if (i == 20) num_threads = std::strtol(field.c_str(), nullptr, 10);
+    }
+    cpu_ticks = utime + stime;
+    threads = static_cast<int>(num_threads);
+    return true;
+}
+
+bool ResourceMonitor::parse_status_rss(const std::string& content, uint64_t& rss_kb) {
+    std::istringstream in(content);
+    std::string line;
+    bool seen_name = false;
+    while (std::getline(in, line)) {
+        if (line.rfind("Name:", 0) == 0) seen_name = true;
+        if (line.rfind("VmRSS:", 0) == 0) {
+            rss_kb = std::strtoull(line.c_str() + 6, nullptr, 10);
+            return true;
+        }
+    }
+    // Kernel threads and zombies have no Vm* lines
+    rss_kb = 0;
+    return seen_name;
+}
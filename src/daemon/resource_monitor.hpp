@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+/// Periodic resource samples of the managed mihomo from /proc.
+///
+/// Each interval reads /proc/<pid>/stat (CPU ticks, threads), the VmRSS
+/// line of /proc/<pid>/status and the entries of /proc/<pid>/fd: three
+/// small reads, no child processes. A short history is kept for `status`.
+/// Limits act only after `sustain` consecutive samples over them; a
+/// warning fires once per excursion, a restart is requested at most once
+/// per pid (it is pending until a new pid shows up), and a new pid starts
+/// the accounting over.
+class ResourceMonitor {
+public:
+    struct Sample {
+        int64_t time_ms = 0;     // unix ms
+        pid_t pid = -1;
+        double cpu_pct = -1;     // of one core since the previous sample (-1 = first)
+        uint64_t rss_kb = 0;
+        int fds = 0;
+        int threads = 0;
+    };
+
+    /// 0 disables a limit
+    struct Limits {
+        uint64_t rss_warn_kb = 0;
+        uint64_t rss_restart_kb = 0;
+        int fds_warn = 0;
+        int fds_restart = 0;
+        int cpu_warn_pct = 0;
+        int sustain = 3;         // consecutive samples over a limit before acting
+    };
+
+    struct Options {
+        int interval_ms = 10000;
+        size_t history = 60;     // samples kept
+        Limits limits;
+    };
+
+    /// A limit that was held for `sustain` samples
+    struct Alert {
+        std::string metric;      // "rss_kb", "fds" or "cpu_pct"
+        double value = 0;
+        double limit = 0;
+        bool restart = false;    // a restart limit, not a warning
+    };
+
+    /// pid to sample now (-1 = nothing running)
+    using PidFn = std::function<pid_t()>;
+    /// Runs on the sampling thread after each sample, with any alerts it raised
+    using SampleFn = std::function<void(const Sample& sample, const std::vector<Alert>& alerts)>;
+
+    ResourceMonitor(Options opts, PidFn pid_fn, SampleFn on_sample);
+    ~ResourceMonitor();
+
+    ResourceMonitor(const ResourceMonitor&) = delete;
+    ResourceMonitor& operator=(const ResourceMonitor&) = delete;
+
+    void start();
+    void stop();
+    bool is_running() const { return running_.load(); }
+
+    /// Take one sample (what the thread does each interval); false if no
+    /// process is running or /proc could not be read
+    bool sample_once();
+
+    /// Oldest first
+    std::vector<Sample> history() const;
+
+    /// Most recent sample; false if there is none
+    bool latest(Sample& out) const;
+
+    /// Feed a sample through the limits (sample_once() does this)
+    std::vector<Alert> check(const Sample& sample);
+
+    /// Read `pid` from /proc. `cpu_ticks` is utime + stime in clock ticks;
+    /// cpu_pct is left to the caller.
+    static bool read_proc(pid_t pid, Sample& out, uint64_t& cpu_ticks);
+
+    /// Fields of a /proc/<pid>/stat line; the comm field may hold spaces
+    /// and parentheses
+    static bool parse_stat(const std::string& line, uint64_t& cpu_ticks, int& threads);
+
+    /// VmRSS of /proc/<pid>/status in kB (0 for kernel threads)
+    static bool parse_status_rss(const std::string& content, uint64_t& rss_kb);
+
+private:
+    // Consecutive samples over each limit, and whether its warning is out
+    struct Streak {
+        int count = 0;
+        bool fired = false;
+    };
+
+    Options opts_;
+    PidFn pid_fn_;
+    SampleFn on_sample_;
+
+    mutable std::mutex mutex_;
+    std::deque<Sample> history_;
+
+    // Sampling thread state
+    pid_t last_pid_ = -1;
+    uint64_t last_ticks_ = 0;
+    int64_t last_steady_ms_ = 0;
+    // Limit accounting (check()), per pid
+    pid_t check_pid_ = -1;
+    Streak rss_warn_, rss_restart_, fds_warn_, fds_restart_, cpu_warn_;
+    bool restart_requested_ = false;  // for check_pid_
+
+    std::atomic<bool> running_{false};
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    std::thread thread_;
+
+    void run_loop();
+    /// Count a sample against one limit; true when it should act now
+    bool over(Streak& s, bool exceeded, bool once);
+};
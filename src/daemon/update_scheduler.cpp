@@ -0,0 +1,159 @@
+#include "daemon/update_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+
+UpdateScheduler::UpdateScheduler() : UpdateScheduler(Options{}) {}
+
+UpdateScheduler::UpdateScheduler(Options opts) : opts_(opts) {}
+
+int64_t UpdateScheduler::now_sec() {
+    return static_cast<int64_t>(std::time(nullptr));
+}
+
+int64_t UpdateScheduler::parse_timestamp(const std::string& ts) {
+    std::tm tm{};
+    if (std::sscanf(ts.c_str(), "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return -1;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    return static_cast<int64_t>(std::mktime(&tm));
+}
+
+void UpdateScheduler::set_profiles(const std::vector<ProfileInfo>& profiles, int64_t now) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::map<std::string, State> next;
+        for (const auto& p : profiles) {
+            if (!p.auto_update || p.source_url.empty() || p.update_interval_hours <= 0) continue;
+
+            State st;
+            bool known = false;
+            auto old = states_.find(p.name);
+            if (old != states_.end()) {
+                st = old->second;
+                known = true;
+            }
+            st.interval = static_cast<int64_t>(p.update_interval_hours) * 3600;
+
+            // Unparseable timestamp: due right away
+            int64_t last = parse_timestamp(p.last_updated);
+            int64_t due = last < 0 ? now : last + st.interval;
+            if (st.failures > 0) due = std::max(due, st.due);  // keep the backoff
+
+            // Unchanged deadlines keep their heap entry
+            if (!st.in_flight && !(known && due == st.due)) schedule(p.name, st, due);
+            next[p.name] = st;
+        }
+        states_.swap(next);  // removed profiles' heap entries go stale
+
+        // Too many stale entries: rebuild from the live states
+        if (heap_.size() > 2 * states_.size() + 16) {
+            heap_ = {};
+            for (const auto& [name, st] : states_) {
+                if (!st.in_flight) heap_.emplace(st.due, st.gen, name);
+            }
+        }
+        drop_stale();
+    }
+    cv_.notify_all();
+}
+
+void UpdateScheduler::schedule(const std::string& name, State& st, int64_t due) {
+    st.due = due;
+    st.gen = next_gen_++;
+    heap_.emplace(due, st.gen, name);
+}
+
+void UpdateScheduler::drop_stale() {
+    while (!heap_.empty()) {
+        const auto& [due, gen, name] = heap_.top();
+        auto it = states_.find(name);
+        if (it != states_.end() && it->second.gen == gen && !it->second.in_flight) return;
+        heap_.pop();
+    }
+}
+
+std::vector<std::string> UpdateScheduler::take_due_locked(int64_t now) {
+    std::vector<std::string> due;
+    drop_stale();
+    while (!heap_.empty() && std::get<0>(heap_.top()) <= now) {
+        std::string name = std::get<2>(heap_.top());
+        heap_.pop();
+        states_[name].in_flight = true;
+        due.push_back(std::move(name));
+        drop_stale();
+    }
+    return due;
+}
+
+std::vector<std::string> UpdateScheduler::take_due(int64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return take_due_locked(now);
+}
+
+std::vector<std::string> UpdateScheduler::wait_due() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+        drop_stale();
+        if (heap_.empty()) {
+            cv_.wait(lock);
+            continue;
+        }
+        int64_t now = now_sec();
+        int64_t due = std::get<0>(heap_.top());
+        if (due <= now) return take_due_locked(now);
+        cv_.wait_for(lock, std::chrono::seconds(due - now));
+    }
+    return {};
+}
+
+void UpdateScheduler::report(const std::string& name, bool ok, int64_t now) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = states_.find(name);
+        if (it == states_.end()) return;  // removed meanwhile
+        State& st = it->second;
+        st.in_flight = false;
+        if (ok) {
+            st.failures = 0;
+            schedule(name, st, now + st.interval);
+        } else {
+            int shift = std::min(st.failures, 20);
+            int64_t backoff = std::min<int64_t>(static_cast<int64_t>(opts_.base_backoff_sec) << shift,
+                                                opts_.max_backoff_sec);
+            ++st.failures;
+            schedule(name, st, now + backoff);
+        }
+    }
+    cv_.notify_all();
+}
+
+void UpdateScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+}
+
+int64_t UpdateScheduler::next_due() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t best = -1;
+    for (const auto& [name, st] : states_) {
+        if (st.in_flight) continue;
+        if (best < 0 || st.due < best) best = st.due;
+    }
+    return best;
+}
+
+int UpdateScheduler::failures(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(name);
+    return it == states_.end() ? 0 : it->second.failures;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "core/profile_manager.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Deadlines for subscription auto-updates.
+///
+/// Keeps a min-heap of next-due times (last update + interval, parsed once
+/// when the metadata changes) so the daemon can sleep until the earliest
+/// one instead of rescanning profiles.yaml. A due profile is handed out
+/// once and stays out of the schedule until its outcome is reported;
+/// failures push the next attempt back exponentially.
+class UpdateScheduler {
+public:
+    struct Options {
+        int base_backoff_sec = 60;          // retry delay after the first failure
+        int max_backoff_sec = 6 * 3600;     // doubled per failure up to this
+    };
+
+    UpdateScheduler();
+    explicit UpdateScheduler(Options opts);
+
+    /// Rebuild deadlines from profile metadata and wake the waiter.
+    /// Pending backoff and in-flight updates are kept.
+    void set_profiles(const std::vector<ProfileInfo>& profiles, int64_t now = now_sec());
+
+    /// Block until at least one profile is due and return every due one.
+    /// Empty once stop() was called.
+    std::vector<std::string> wait_due();
+
+    /// Profiles due at `now`, without blocking
+    std::vector<std::string> take_due(int64_t now);
+
+    /// Outcome of an update handed out by wait_due()/take_due()
+    void report(const std::string& name, bool ok, int64_t now = now_sec());
+
+    /// Wake and end wait_due()
+    void stop();
+
+    /// Earliest deadline (unix seconds); -1 if nothing is scheduled
+    int64_t next_due() const;
+
+    /// Consecutive failures of a profile
+    int failures(const std::string& name) const;
+
+    /// "%Y-%m-%dT%H:%M:%S" in local time → unix seconds; -1 if invalid
+    static int64_t parse_timestamp(const std::string& ts);
+
+    static int64_t now_sec();
+
+private:
+    struct State {
+        int64_t due = 0;
+        int64_t interval = 0;    // seconds
+        int failures = 0;
+        bool in_flight = false;
+        uint64_t gen = 0;        // matches the live heap entry
+    };
+
+    // (due, gen, name); entries whose gen no longer matches are stale
+    using HeapEntry = std::tuple<int64_t, uint64_t, std::string>;
+
+    Options opts_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap_;
+    std::map<std::string, State> states_;
+    uint64_t next_gen_ = 1;
+    bool stopped_ = false;
+
+    void schedule(const std::string& name, State& st, int64_t due);  // mutex_ held
+    void drop_stale();                                                 // mutex_ held
+    std::vector<std::string> take_due_locked(int64_t now);
+};
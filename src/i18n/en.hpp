@@ -173,4 +173,8 @@ inline constexpr Strings EN_STRINGS_DEF = {
     "Language",
     "Ctrl+L to toggle",
     "Press Ctrl+S to save",
+
+    // Status bar: mihomo health
+    "crashes",
+    "mihomo crash loop",
 };
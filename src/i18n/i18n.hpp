@@ -175,6 +175,10 @@ struct Strings {
     const char* config_language;
     const char* config_lang_toggle;
     const char* config_save_hint;
+
+    // Status bar: mihomo health
+    const char* status_crashes;
+    const char* status_crash_loop;
 };
 
 #include "i18n/en.hpp"
@@ -173,4 +173,8 @@ inline constexpr Strings ZH_STRINGS_DEF = {
     "语言",
     "Ctrl+L 切换",
     "按 Ctrl+S 保存",
+
+    // Status bar: mihomo health
+    "次崩溃",
+    "mihomo 崩溃循环",
 };
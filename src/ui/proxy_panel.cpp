@@ -4,9 +4,12 @@
 #include <ftxui/dom/elements.hpp>
 #include <ftxui/component/event.hpp>
 #include <algorithm>
+#include <cstdio>
+#include <set>
 #include <sstream>
 #include <thread>
 #include <mutex>
+#include <chrono>
 
 using namespace ftxui;
 
@@ -27,16 +30,13 @@ static std::string delay_badge(int delay) {
 
 // ── Mini sparkline from delay history ───────────────────────
 
-static std::string sparkline(const std::vector<int>& history, int count = 5) {
+static std::string sparkline(const DelayHistory& history, int count = 5) {
     static const char* blocks[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
 
     if (history.empty()) return "";
 
     // Take last `count` entries
-    auto start = history.size() > (size_t)count
-                     ? history.end() - count
-                     : history.begin();
-    std::vector<int> recent(start, history.end());
+    std::vector<int> recent = history.recent_delays(count);
 
     int max_val = *std::max_element(recent.begin(), recent.end());
     if (max_val <= 0) max_val = 1;
@@ -53,6 +53,15 @@ static std::string sparkline(const std::vector<int>& history, int count = 5) {
     return result;
 }
 
+static std::string stat_ms(int v) {
+    return v < 0 ? "-" : std::to_string(v) + "ms";
+}
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
 // ── ProxyPanel::Impl ────────────────────────────────────────
 
 struct ProxyPanel::Impl {
@@ -62,6 +71,10 @@ struct ProxyPanel::Impl {
     std::vector<std::string> group_names;
     std::map<std::string, ProxyGroup> groups;
     std::map<std::string, ProxyNode> nodes;
+    std::map<std::string, LatencyStats> long_term;
+    std::map<std::string, ThroughputResult> throughput;  // last result per node
+    std::set<std::string> throughput_running;
+    std::string throughput_group;  // group switched by the running test
     std::mutex data_mutex;
 
     // Selection state
@@ -69,6 +82,51 @@ struct ProxyPanel::Impl {
     int selected_node = 0;
     int focus_column = 0; // 0=groups, 1=nodes, 2=details
 
+    // Replace groups/nodes with fresh data, keeping locally recorded
+    // delay tests that mihomo's short history does not know about.
+    // mihomo's samples are merged into the local history so its entry for
+    // a test wins over our record of it. Caller must hold data_mutex.
+    void apply_data(std::map<std::string, ProxyGroup> new_groups,
+                    std::map<std::string, ProxyNode> new_nodes) {
+        for (auto& [name, node] : new_nodes) {
+            auto old = nodes.find(name);
+            if (old == nodes.end() || old->second.delay_history.empty()) continue;
+            DelayHistory merged = std::move(old->second.delay_history);
+            merged.merge(node.delay_history);
+            node.delay_history = std::move(merged);
+            node.delay = node.delay_history.back().delay;
+        }
+        groups = std::move(new_groups);
+        nodes = std::move(new_nodes);
+
+        // Rebuild sorted group names
+        group_names.clear();
+        for (auto& [name, _] : groups) {
+            group_names.push_back(name);
+        }
+        std::sort(group_names.begin(), group_names.end());
+    }
+
+    // Query long-term stats for a set of nodes (no lock needed)
+    std::map<std::string, LatencyStats> fetch_long_term(
+            const std::map<std::string, ProxyNode>& node_map) {
+        if (!callbacks.get_latency_stats || node_map.empty()) return {};
+        std::vector<std::string> names;
+        names.reserve(node_map.size());
+        for (const auto& [name, _] : node_map) names.push_back(name);
+        return callbacks.get_latency_stats(names);
+    }
+
+    // Record a local delay test result so it shows at once; mihomo's own
+    // history entry for it replaces it on the next merge. Caller must hold
+    // data_mutex.
+    void record_delay(const std::string& name, const DelayResult& result) {
+        auto it = nodes.find(name);
+        if (it == nodes.end()) return;
+        it->second.delay = result.success ? result.delay : 0;
+        it->second.delay_history.push(it->second.delay, now_ms());
+    }
+
     // Get current group
     const ProxyGroup* current_group() {
         if (group_names.empty() || selected_group < 0 ||
@@ -222,11 +280,55 @@ struct ProxyPanel::Impl {
                         : text("no") | color(Color::Red),
         }));
 
-        // Delay history sparkline
-        if (!node->delay_history.empty()) {
+        // Delay history sparkline + rolling stats
+        const auto& history = node->delay_history;
+        if (!history.empty()) {
             items.push_back(separator());
             items.push_back(text(" Delay History:") | dim);
-            items.push_back(text(" " + sparkline(node->delay_history)));
+            items.push_back(text(" " + sparkline(history)));
+            items.push_back(hbox({
+                text(" Min/Avg/P95: ") | dim,
+                text(stat_ms(history.min()) + " / " + stat_ms(history.avg()) +
+                     " / " + stat_ms(history.p95())),
+            }));
+            items.push_back(hbox({
+                text(" Failures: ") | dim,
+                text(std::to_string(history.failures()) + "/" +
+                     std::to_string(history.size())),
+            }));
+        }
+
+        // Throughput test (B)
+        if (throughput_running.count(node->name)) {
+            items.push_back(separator());
+            // The test switches the group's live selection meanwhile
+            items.push_back(text(" Throughput: testing (" + throughput_group + " rerouted)...") | dim);
+        } else if (auto tp = throughput.find(node->name); tp != throughput.end()) {
+            const auto& r = tp->second;
+            items.push_back(separator());
+            if (r.success) {
+                char rate[32];
+                std::snprintf(rate, sizeof(rate), "%.2f MB/s", r.mb_per_sec);
+                items.push_back(hbox({text(" Throughput: ") | dim, text(rate) | bold}));
+                items.push_back(hbox({text(" TTFB: ") | dim, text(stat_ms(r.ttfb_ms))}));
+            } else {
+                items.push_back(hbox({
+                    text(" Throughput: ") | dim,
+                    text(r.error) | color(Color::Red),
+                }));
+            }
+        }
+
+        // Long-term percentiles from the latency database
+        auto lt = long_term.find(node->name);
+        if (lt != long_term.end() && lt->second.samples > 0) {
+            const auto& st = lt->second;
+            items.push_back(separator());
+            items.push_back(text(" Long-term (" + std::to_string(st.samples) + "):") | dim);
+            items.push_back(hbox({
+                text(" P50/P95/P99: ") | dim,
+                text(stat_ms(st.p50) + " / " + stat_ms(st.p95) + " / " + stat_ms(st.p99)),
+            }));
         }
 
         return vbox(std::move(items)) | border |
@@ -239,22 +341,33 @@ ProxyPanel::~ProxyPanel() = default;
 
 void ProxyPanel::set_callbacks(Callbacks cb) { impl_->callbacks = std::move(cb); }
 
+void ProxyPanel::apply_delay_samples(
+        const std::map<std::string, std::vector<DelaySample>>& samples) {
+    std::lock_guard<std::mutex> lock(impl_->data_mutex);
+    for (const auto& [name, incoming] : samples) {
+        auto it = impl_->nodes.find(name);
+        if (it == impl_->nodes.end() || incoming.empty()) continue;
+        it->second.delay_history.merge(incoming);
+        it->second.delay = it->second.delay_history.back().delay;
+    }
+}
+
+DelayHistory ProxyPanel::delay_history(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(impl_->data_mutex);
+    auto it = impl_->nodes.find(name);
+    return it == impl_->nodes.end() ? DelayHistory() : it->second.delay_history;
+}
+
 void ProxyPanel::refresh_data() {
     if (!impl_->callbacks.get_groups || !impl_->callbacks.get_nodes) return;
 
     auto groups = impl_->callbacks.get_groups();
     auto nodes = impl_->callbacks.get_nodes();
+    auto long_term = impl_->fetch_long_term(nodes);
 
     std::lock_guard<std::mutex> lock(impl_->data_mutex);
-    impl_->groups = std::move(groups);
-    impl_->nodes = std::move(nodes);
-
-    // Rebuild sorted group names
-    impl_->group_names.clear();
-    for (auto& [name, _] : impl_->groups) {
-        impl_->group_names.push_back(name);
-    }
-    std::sort(impl_->group_names.begin(), impl_->group_names.end());
+    impl_->apply_data(std::move(groups), std::move(nodes));
+    impl_->long_term = std::move(long_term);
 
     // Auto-select group on first load:
     // 1. Try GLOBAL's "now" if it points to a sub-group
@@ -392,14 +505,7 @@ Component ProxyPanel::component() {
                     std::thread([sp, name]() {
                         auto result = sp->callbacks.test_delay(name);
                         std::lock_guard<std::mutex> lock(sp->data_mutex);
-                        auto it = sp->nodes.find(name);
-                        if (it != sp->nodes.end()) {
-                            it->second.delay = result.success ? result.delay : 0;
-                            if (it->second.delay_history.size() >= 100) {
-                                it->second.delay_history.erase(it->second.delay_history.begin());
-                            }
-                            it->second.delay_history.push_back(it->second.delay);
-                        }
+                        sp->record_delay(name, result);
                     }).detach();
                 }
             }
@@ -415,34 +521,46 @@ Component ProxyPanel::component() {
                     std::thread([sp, name]() {
                         auto result = sp->callbacks.test_delay(name);
                         std::lock_guard<std::mutex> lock(sp->data_mutex);
-                        auto it = sp->nodes.find(name);
-                        if (it != sp->nodes.end()) {
-                            it->second.delay = result.success ? result.delay : 0;
-                            if (it->second.delay_history.size() >= 100) {
-                                it->second.delay_history.erase(it->second.delay_history.begin());
-                            }
-                            it->second.delay_history.push_back(it->second.delay);
-                        }
+                        sp->record_delay(name, result);
                     }).detach();
                 }
             }
             return true;
         }
 
+        // B: throughput test of the selected node through the current group
+        if (event.is_character() && (event.character() == "b" || event.character() == "B")) {
+            if (self->callbacks.test_throughput) {
+                std::lock_guard<std::mutex> lock(self->data_mutex);
+                auto* g = self->current_group();
+                auto names = self->current_node_names();
+                if (g && self->selected_node >= 0 && self->selected_node < (int)names.size()) {
+                    std::string group = g->name;
+                    std::string name = names[self->selected_node];
+                    if (self->throughput_running.insert(name).second) {
+                        self->throughput_group = group;
+                        std::thread([sp, group, name]() {
+                            auto result = sp->callbacks.test_throughput(group, name);
+                            std::lock_guard<std::mutex> lock(sp->data_mutex);
+                            sp->throughput_running.erase(name);
+                            sp->throughput[name] = std::move(result);
+                        }).detach();
+                    }
+                }
+            }
+            return true;
+        }
+
         // R: refresh data
         if (event.is_character() && (event.character() == "r" || event.character() == "R")) {
             if (self->callbacks.get_groups && self->callbacks.get_nodes) {
                 std::thread([sp]() {
                     auto groups = sp->callbacks.get_groups();
                     auto nodes = sp->callbacks.get_nodes();
+                    auto long_term = sp->fetch_long_term(nodes);
                     std::lock_guard<std::mutex> lock(sp->data_mutex);
-                    sp->groups = std::move(groups);
-                    sp->nodes = std::move(nodes);
-                    sp->group_names.clear();
-                    for (auto& [name, _] : sp->groups) {
-                        sp->group_names.push_back(name);
-                    }
-                    std::sort(sp->group_names.begin(), sp->group_names.end());
+                    sp->apply_data(std::move(groups), std::move(nodes));
+                    sp->long_term = std::move(long_term);
                 }).detach();
             }
             return true;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "api/mihomo_client.hpp"
+#include "core/latency_store.hpp"
+#include "core/throughput_tester.hpp"
 
 #include <ftxui/component/component.hpp>
 #include <memory>
@@ -13,6 +15,12 @@ public:
         std::function<std::map<std::string, ProxyNode>()> get_nodes;
         std::function<bool(const std::string& group, const std::string& proxy)> select_proxy;
         std::function<DelayResult(const std::string& name)> test_delay;
+        // Long-term stats from the latency database (optional)
+        std::function<std::map<std::string, LatencyStats>(
+            const std::vector<std::string>& names)> get_latency_stats;
+        // Bounded download routed through `node` via `group` (optional)
+        std::function<ThroughputResult(const std::string& group,
+                                       const std::string& node)> test_throughput;
     };
 
     ProxyPanel();
@@ -21,6 +29,13 @@ public:
     void set_callbacks(Callbacks cb);
     void refresh_data();
 
+    /// Merge delay samples measured elsewhere (e.g. the daemon's background
+    /// prober) into the displayed node history. Unknown nodes are ignored.
+    void apply_delay_samples(const std::map<std::string, std::vector<DelaySample>>& samples);
+
+    /// Displayed delay history of a node (empty if unknown)
+    DelayHistory delay_history(const std::string& name) const;
+
     ftxui::Component component();
 
 private:
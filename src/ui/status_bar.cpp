@@ -31,6 +31,19 @@ void StatusBar::set_update_available(const std::string& version) {
     update_version_ = version;
 }
 
+void StatusBar::set_mihomo_health(uint64_t crashes, bool crash_loop) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mihomo_crashes_ = crashes;
+    mihomo_crash_loop_ = crash_loop;
+}
+
+void StatusBar::set_mihomo_resources(double cpu_pct, uint64_t rss_kb, bool over_limit) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mihomo_cpu_pct_ = cpu_pct;
+    mihomo_rss_kb_ = rss_kb;
+    mihomo_over_limit_ = over_limit;
+}
+
 std::string StatusBar::format_speed(int64_t bytes_per_sec) {
     std::ostringstream oss;
     if (bytes_per_sec < 1024) {
@@ -51,6 +64,11 @@ Component StatusBar::component() {
         int conn_count;
         int64_t up_speed, down_speed;
         std::string update_ver;
+        uint64_t crashes;
+        bool crash_loop;
+        double cpu_pct;
+        uint64_t rss_kb;
+        bool over_limit;
         {
             std::lock_guard<std::mutex> lock(mutex_);
             mode = mode_;
@@ -58,6 +76,11 @@ Component StatusBar::component() {
             up_speed = upload_speed_;
             down_speed = download_speed_;
             update_ver = update_version_;
+            crashes = mihomo_crashes_;
+            crash_loop = mihomo_crash_loop_;
+            cpu_pct = mihomo_cpu_pct_;
+            rss_kb = mihomo_rss_kb_;
+            over_limit = mihomo_over_limit_;
         }
 
         bool is_connected = connected_.load();
@@ -71,8 +94,25 @@ Component StatusBar::component() {
                           + "↓ " + format_speed(down_speed);
         auto center_text = text(stats);
 
-        // Right: update indicator
+        // Right: mihomo usage and health + update indicator
         Elements right_elements;
+        if (rss_kb > 0) {
+            std::ostringstream usage;
+            usage << " " << std::fixed << std::setprecision(0) << (double)rss_kb / 1024.0 << " MiB";
+            if (cpu_pct >= 0) usage << " " << std::setprecision(0) << cpu_pct << "%";
+            usage << " ";
+            right_elements.push_back(over_limit ? text(usage.str()) | color(Color::Yellow)
+                                                : text(usage.str()));
+        }
+        if (crash_loop) {
+            right_elements.push_back(
+                text(" " + std::string(T().status_crash_loop) + " ") | bold | color(Color::Red)
+            );
+        } else if (crashes > 0) {
+            right_elements.push_back(
+                text(" " + std::to_string(crashes) + " " + T().status_crashes + " ") | color(Color::Yellow)
+            );
+        }
         if (!update_ver.empty()) {
             right_elements.push_back(
                 text(" ↑ " + update_ver + " ") | color(Color::Yellow)
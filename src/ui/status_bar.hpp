@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ftxui/component/component.hpp>
+#include <cstdint>
 #include <string>
 #include <mutex>
 #include <atomic>
@@ -17,6 +18,11 @@ public:
     void set_connections(int count, int64_t upload_speed, int64_t download_speed);
     void set_connected(bool connected);
     void set_update_available(const std::string& version);
+    /// Daemon-reported mihomo crashes; shown when non-zero or looping
+    void set_mihomo_health(uint64_t crashes, bool crash_loop);
+    /// Latest daemon sample of mihomo (rss 0 hides it); `over_limit` after
+    /// a resource warning, until mihomo restarts
+    void set_mihomo_resources(double cpu_pct, uint64_t rss_kb, bool over_limit);
 
 private:
     std::mutex mutex_;
@@ -26,6 +32,11 @@ private:
     int64_t download_speed_ = 0;
     std::atomic<bool> connected_{false};
     std::string update_version_;
+    uint64_t mihomo_crashes_ = 0;
+    bool mihomo_crash_loop_ = false;
+    double mihomo_cpu_pct_ = -1;
+    uint64_t mihomo_rss_kb_ = 0;
+    bool mihomo_over_limit_ = false;
 
     static std::string format_speed(int64_t bytes_per_sec);
 };
@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+#include "daemon/auto_selector.hpp"
+#include "core/selection_lock.hpp"
+
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+NodeLatency stats_for(const std::string& name, int p95, int samples = 10, int failures = 0) {
+    NodeLatency nl;
+    nl.name = name;
+    nl.state = "stable";
+    nl.p95 = p95;
+    nl.min = p95;
+    nl.avg = p95;
+    nl.samples = samples;
+    nl.failures = failures;
+    return nl;
+}
+
+} // namespace
+
+class AutoSelectorTest : public ::testing::Test {
+protected:
+    std::map<std::string, ProxyGroup> groups_;
+    std::map<std::string, NodeLatency> stats_;
+    std::vector<std::pair<std::string, std::string>> selects_;
+
+    void SetUp() override {
+        ProxyGroup g;
+        g.name = "Proxy";
+        g.type = "Selector";
+        g.now = "a";
+        g.all = {"a", "b", "c"};
+        groups_["Proxy"] = g;
+
+        stats_["a"] = stats_for("a", 200);
+        stats_["b"] = stats_for("b", 190);
+        stats_["c"] = stats_for("c", 300);
+    }
+
+    AutoSelector make(int hysteresis_pct = 20, int dwell_sec = 60, std::string log = "",
+                      std::string lock_dir = "") {
+        AutoSelector::Options opts;
+        opts.groups = {"Proxy"};
+        opts.lock_dir = lock_dir;
+        opts.hysteresis_pct = hysteresis_pct;
+        opts.min_dwell_sec = dwell_sec;
+        return AutoSelector(opts,
+            [this]() { return groups_; },
+            [this]() { return stats_; },
+            [this](const std::string& group, const std::string& proxy) {
+                selects_.emplace_back(group, proxy);
+                groups_[group].now = proxy;
+                return true;
+            },
+            log);
+    }
+};
+
+TEST_F(AutoSelectorTest, ScorePenalizesFailures) {
+    auto sel = make();
+    EXPECT_DOUBLE_EQ(sel.score(stats_for("x", 100)), 100.0);
+    EXPECT_DOUBLE_EQ(sel.score(stats_for("x", 100, 10, 1)), 120.0);
+    EXPECT_LT(sel.score(stats_for("x", 100, 10, 3)), 0);  // 30% > 20% limit
+    EXPECT_LT(sel.score(stats_for("x", 100, 2)), 0);      // too few samples
+}
+
+TEST_F(AutoSelectorTest, HysteresisBlocksSmallGains) {
+    auto sel = make(20, 0);
+    EXPECT_TRUE(sel.evaluate(1000).empty());  // 190 vs 200 is within 20%
+    EXPECT_TRUE(selects_.empty());
+
+    stats_["b"] = stats_for("b", 100);
+    auto made = sel.evaluate(2000);
+    ASSERT_EQ(made.size(), 1u);
+    EXPECT_EQ(made[0].from, "a");
+    EXPECT_EQ(made[0].to, "b");
+    EXPECT_EQ(made[0].reason, "better");
+    EXPECT_TRUE(made[0].applied);
+    EXPECT_EQ(groups_["Proxy"].now, "b");
+}
+
+TEST_F(AutoSelectorTest, MinDwellDelaysSwitch) {
+    auto sel = make(20, 60);
+    stats_["b"] = stats_for("b", 100);
+
+    EXPECT_TRUE(sel.evaluate(0).empty());       // dwell starts at first sight
+    EXPECT_TRUE(sel.evaluate(59000).empty());
+    EXPECT_EQ(sel.evaluate(60000).size(), 1u);
+
+    // Just switched: c getting much better must wait out the dwell again
+    stats_["c"] = stats_for("c", 10);
+    EXPECT_TRUE(sel.evaluate(61000).empty());
+    auto made = sel.evaluate(121000);
+    ASSERT_EQ(made.size(), 1u);
+    EXPECT_EQ(made[0].to, "c");
+}
+
+TEST_F(AutoSelectorTest, UnhealthyCurrentSwitchesImmediately) {
+    auto sel = make(20, 3600);
+    stats_["a"] = stats_for("a", 200, 10, 5);
+    auto made = sel.evaluate(0);
+    ASSERT_EQ(made.size(), 1u);
+    EXPECT_EQ(made[0].reason, "unhealthy");
+    EXPECT_EQ(made[0].to, "b");
+    EXPECT_LT(made[0].from_score, 0);
+}
+
+TEST_F(AutoSelectorTest, UnmeasuredCurrentIsLeftAlone) {
+    auto sel = make(20, 0);
+    stats_.erase("a");
+    stats_["b"] = stats_for("b", 10);
+    EXPECT_TRUE(sel.evaluate(0).empty());
+}
+
+TEST_F(AutoSelectorTest, SkipsGroupUnderThroughputTest) {
+    std::string dir = "/tmp/ct_autosel_lock_" + std::to_string(::getpid());
+    auto sel = make(20, 0, "", dir);
+    stats_["b"] = stats_for("b", 100);
+    {
+        SelectionLock test(dir, "Proxy");
+        ASSERT_TRUE(test.lock());
+        EXPECT_TRUE(sel.evaluate(1000).empty());
+        EXPECT_TRUE(selects_.empty());
+    }
+    EXPECT_EQ(sel.evaluate(2000).size(), 1u);
+    fs::remove_all(dir);
+}
+
+TEST_F(AutoSelectorTest, IgnoresNonSelectorGroups) {
+    groups_["Proxy"].type = "URLTest";
+    stats_["b"] = stats_for("b", 10);
+    auto sel = make(20, 0);
+    EXPECT_TRUE(sel.evaluate(0).empty());
+    EXPECT_TRUE(selects_.empty());
+}
+
+TEST_F(AutoSelectorTest, DecisionsAreLogged) {
+    std::string log = fs::temp_directory_path().string() + "/clashtui_autosel_" +
+                      std::to_string(::getpid()) + ".log";
+    fs::remove(log);
+    {
+        auto sel = make(20, 0, log);
+        stats_["b"] = stats_for("b", 100);
+        sel.evaluate(5000);
+        auto recent = sel.recent_decisions();
+        ASSERT_EQ(recent.size(), 1u);
+        EXPECT_EQ(recent[0].time_ms, 5000);
+    }
+
+    std::ifstream in(log);
+    std::string line;
+    ASSERT_TRUE(std::getline(in, line));
+    auto j = nlohmann::json::parse(line);
+    EXPECT_EQ(j.value("group", ""), "Proxy");
+    EXPECT_EQ(j.value("to", ""), "b");
+    EXPECT_TRUE(j.value("applied", false));
+    fs::remove(log);
+}
+
+TEST_F(AutoSelectorTest, DecisionLogIsRotated) {
+    std::string log = fs::temp_directory_path().string() + "/clashtui_autosel_rot_" +
+                      std::to_string(::getpid()) + ".log";
+    auto cleanup = [&] {
+        for (const char* suffix : {"", ".1", ".2", ".3"}) fs::remove(log + suffix);
+    };
+    cleanup();
+
+    AutoSelector::Options opts;
+    opts.groups = {"Proxy"};
+    opts.hysteresis_pct = 20;
+    opts.min_dwell_sec = 0;
+    opts.min_samples = 1;
+    opts.log_max_bytes = 200;
+    opts.log_files_keep = 2;
+    AutoSelector sel(opts,
+        [this] { return groups_; },
+        [this] { return stats_; },
+        [this](const std::string& g, const std::string& p) {
+            selects_.emplace_back(g, p);
+            groups_[g].now = p;
+            return true;
+        },
+        log);
+
+    // Flip between two nodes so every evaluation logs a switch
+    for (int i = 0; i < 40; ++i) {
+        bool to_b = groups_["Proxy"].now == "a";
+        stats_["a"] = stats_for("a", to_b ? 500 : 10);
+        stats_["b"] = stats_for("b", to_b ? 10 : 500);
+        sel.evaluate(1000 * (i + 1));
+    }
+
+    EXPECT_TRUE(fs::exists(log + ".1"));
+    EXPECT_TRUE(fs::exists(log + ".2"));
+    EXPECT_FALSE(fs::exists(log + ".3"));
+    // Rotated once the size is reached, so one line past the cap at most
+    EXPECT_LT(fs::file_size(log), 200u + 512u);
+    cleanup();
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "daemon/blue_green.hpp"
+
+#include <yaml-cpp/yaml.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+class BlueGreenTest : public ::testing::Test {
+protected:
+    std::string dir_;
+    std::string profile_;
+    blue_green::Ports ports_;
+
+    void SetUp() override {
+        dir_ = fs::temp_directory_path().string() + "/clashtui_bg_test_" + std::to_string(getpid());
+        fs::create_directories(dir_);
+        profile_ = dir_ + "/profile.yaml";
+        std::ofstream(profile_) << "mixed-port: 7890\n"
+                                   "socks-port: 7891\n"
+                                   "external-controller: 0.0.0.0:9999\n"
+                                   "external-controller-tls: 0.0.0.0:9443\n"
+                                   "tun:\n  enable: true\n"
+                                   "dns:\n  enable: true\n  listen: 0.0.0.0:1053\n"
+                                   "listeners:\n  - name: in\n    type: http\n    port: 8080\n"
+                                   "proxies:\n  - {name: a, type: direct}\n";
+        ports_.api_port = 9090;
+        ports_.secret = "s3cret";
+        ports_.offset = 10000;
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        fs::remove_all(dir_, ec);
+    }
+};
+
+TEST_F(BlueGreenTest, StandbyConfigMovesEveryListener) {
+    std::string out = dir_ + "/standby/config.yaml";
+    std::string err;
+    ASSERT_TRUE(blue_green::write_standby_config(profile_, ports_, out, err)) << err;
+
+    YAML::Node root = YAML::LoadFile(out);
+    EXPECT_EQ(root["mixed-port"].as<int>(), 17890);
+    EXPECT_EQ(root["socks-port"].as<int>(), 17891);
+    EXPECT_FALSE(root["port"]);
+    EXPECT_EQ(root["listeners"][0]["port"].as<int>(), 18080);
+    EXPECT_EQ(root["dns"]["listen"].as<std::string>(), "0.0.0.0:11053");
+    EXPECT_FALSE(root["tun"]["enable"].as<bool>());
+    EXPECT_EQ(root["external-controller"].as<std::string>(), "127.0.0.1:19090");
+    EXPECT_EQ(root["secret"].as<std::string>(), "s3cret");
+    EXPECT_FALSE(root["external-controller-tls"]);
+    EXPECT_EQ(root["proxies"].size(), 1u);
+}
+
+TEST_F(BlueGreenTest, FinalConfigKeepsListenersAndUsesApiPort) {
+    std::string out = dir_ + "/config.yaml";
+    std::string err;
+    ASSERT_TRUE(blue_green::write_final_config(profile_, ports_, out, err)) << err;
+
+    YAML::Node root = YAML::LoadFile(out);
+    EXPECT_EQ(root["mixed-port"].as<int>(), 7890);
+    EXPECT_TRUE(root["tun"]["enable"].as<bool>());
+    EXPECT_EQ(root["external-controller"].as<std::string>(), "127.0.0.1:9090");
+    EXPECT_FALSE(fs::exists(out + ".tmp"));
+}
+
+TEST_F(BlueGreenTest, RejectsUnreadableProfile) {
+    std::string err;
+    EXPECT_FALSE(blue_green::write_standby_config(dir_ + "/missing.yaml", ports_, dir_ + "/o.yaml", err));
+    EXPECT_FALSE(err.empty());
+
+    std::ofstream(profile_) << "- just\n- a list\n";
+    err.clear();
+    EXPECT_FALSE(blue_green::write_final_config(profile_, ports_, dir_ + "/o.yaml", err));
+    EXPECT_FALSE(err.empty());
+}
+
+TEST_F(BlueGreenTest, InboundPortsListsTopLevelPorts) {
+    auto ports = blue_green::inbound_ports(profile_);
+    std::map<std::string, int> expected = {{"mixed-port", 7890}, {"socks-port", 7891}};
+    EXPECT_EQ(ports, expected);
+    EXPECT_TRUE(blue_green::inbound_ports(dir_ + "/missing.yaml").empty());
+
+    auto closed = blue_green::closed_inbound_ports();
+    EXPECT_EQ(closed.size(), 5u);
+    for (const auto& [key, port] : closed) EXPECT_EQ(port, 0) << key;
+}
+
+TEST(BlueGreenShiftTest, ShiftListen) {
+    EXPECT_EQ(blue_green::shift_listen("0.0.0.0:53", 100), "0.0.0.0:153");
+    EXPECT_EQ(blue_green::shift_listen(":1053", 1), ":1054");
+    EXPECT_EQ(blue_green::shift_listen("[::]:53", 10), "[::]:63");
+    EXPECT_EQ(blue_green::shift_listen("localhost", 10), "localhost");
+    EXPECT_EQ(blue_green::shift_listen("host:dns", 10), "host:dns");
+}
+
+TEST_F(BlueGreenTest, ShareGeodataLinksExistingFiles) {
+    std::string from = dir_ + "/a";
+    std::string to = dir_ + "/b";
+    fs::create_directories(from);
+    std::ofstream(from + "/geoip.metadb") << "geo";
+
+    blue_green::share_geodata(from, to);
+    EXPECT_TRUE(fs::exists(to + "/geoip.metadb"));
+    EXPECT_FALSE(fs::exists(to + "/geosite.dat"));
+
+    std::ifstream in(to + "/geoip.metadb");
+    std::string content;
+    in >> content;
+    EXPECT_EQ(content, "geo");
+}
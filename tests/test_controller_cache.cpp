@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "daemon/controller_cache.hpp"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+using json = nlohmann::json;
+
+namespace {
+
+/// Stand-in for mihomo: serves whatever body the test sets per path
+struct FakeController {
+    std::mutex mutex;
+    std::map<std::string, std::string> bodies;
+
+    ControllerCache::FetchFn fetch() {
+        return [this](const std::string& path, std::string& body) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = bodies.find(path);
+            if (it == bodies.end()) return false;
+            body = it->second;
+            return true;
+        };
+    }
+
+    void set(const std::string& path, const json& body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        bodies[path] = body.dump();
+    }
+};
+
+json proxies(const std::string& now, int a_delay) {
+    return {{"proxies", {
+        {"Proxy", {{"type", "Selector"}, {"now", now}, {"all", {"A", "B"}}}},
+        {"A", {{"type", "Shadowsocks"}, {"history", {{{"delay", a_delay}}}}}},
+        {"B", {{"type", "Shadowsocks"}}},
+    }}};
+}
+
+} // namespace
+
+TEST(ControllerCacheTest, FullSnapshotThenOnlyChanges) {
+    FakeController mihomo;
+    mihomo.set("/proxies", proxies("A", 100));
+    ControllerCache cache({}, mihomo.fetch());
+    ASSERT_TRUE(cache.refresh("/proxies"));
+
+    json full;
+    ASSERT_TRUE(cache.delta("/proxies", 0, 0, full));
+    EXPECT_TRUE(full["full"].get<bool>());
+    EXPECT_EQ(full["items"].size(), 3u);
+    uint64_t v1 = full["version"];
+    uint64_t epoch = full["epoch"];
+
+    // Nothing changed: same version, empty delta
+    ASSERT_TRUE(cache.refresh("/proxies"));
+    json d;
+    ASSERT_TRUE(cache.delta("/proxies", epoch, v1, d));
+    EXPECT_EQ(d["version"], v1);
+    EXPECT_FALSE(d["full"].get<bool>());
+    EXPECT_TRUE(d["items"].empty());
+    EXPECT_TRUE(d["removed"].empty());
+
+    // One node's delay changed: only that node is sent
+    mihomo.set("/proxies", proxies("A", 80));
+    ASSERT_TRUE(cache.refresh("/proxies"));
+    ASSERT_TRUE(cache.delta("/proxies", epoch, v1, d));
+    EXPECT_GT(d["version"].get<uint64_t>(), v1);
+    ASSERT_EQ(d["items"].size(), 1u);
+    EXPECT_TRUE(d["items"].contains("A"));
+    EXPECT_FALSE(d.contains("fields"));
+}
+
+TEST(ControllerCacheTest, RemovedEntriesAreReported) {
+    FakeController mihomo;
+    mihomo.set("/connections", {{"uploadTotal", 1}, {"connections", {{{"id", "c1"}}, {{"id", "c2"}}}}});
+    ControllerCache cache({}, mihomo.fetch());
+    ASSERT_TRUE(cache.refresh("/connections"));
+    json d;
+    ASSERT_TRUE(cache.delta("/connections", 0, 0, d));
+    EXPECT_EQ(d["items"].size(), 2u);
+    EXPECT_EQ(d["fields"]["uploadTotal"], 1);
+    uint64_t epoch = d["epoch"];
+    uint64_t v1 = d["version"];
+
+    // mihomo reports an empty connection list as null
+    mihomo.set("/connections", {{"uploadTotal", 2}, {"connections", nullptr}});
+    ASSERT_TRUE(cache.refresh("/connections"));
+    ASSERT_TRUE(cache.delta("/connections", epoch, v1, d));
+    EXPECT_TRUE(d["items"].empty());
+    EXPECT_EQ(d["removed"], json({"c1", "c2"}));
+    EXPECT_EQ(d["fields"]["uploadTotal"], 2);
+}
+
+TEST(ControllerCacheTest, FallsBackToFullSnapshot) {
+    FakeController mihomo;
+    ControllerCache::Options opts;
+    opts.max_removed = 1;
+    mihomo.set("/proxies", proxies("A", 100));
+    ControllerCache cache(opts, mihomo.fetch());
+    ASSERT_TRUE(cache.refresh("/proxies"));
+    json d;
+    ASSERT_TRUE(cache.delta("/proxies", 0, 0, d));
+    uint64_t epoch = d["epoch"];
+    uint64_t v1 = d["version"];
+
+    // Another epoch (daemon restarted since the client's last read)
+    ASSERT_TRUE(cache.delta("/proxies", epoch + 1, v1, d));
+    EXPECT_TRUE(d["full"].get<bool>());
+    EXPECT_EQ(d["items"].size(), 3u);
+
+    // Two removals with room to remember one: a client at v1 missed one
+    mihomo.set("/proxies", {{"proxies", {{"B", {{"type", "Shadowsocks"}}}}}});
+    ASSERT_TRUE(cache.refresh("/proxies"));
+    ASSERT_TRUE(cache.delta("/proxies", epoch, v1, d));
+    EXPECT_TRUE(d["full"].get<bool>());
+    EXPECT_EQ(d["items"].size(), 1u);
+    EXPECT_TRUE(d["removed"].empty());
+}
+
+TEST(ControllerCacheTest, FailedFetchServesNothing) {
+    FakeController mihomo;
+    mihomo.set("/configs", {{"mode", "rule"}});
+    ControllerCache cache({}, mihomo.fetch());
+    json d;
+    EXPECT_FALSE(cache.delta("/configs", 0, 0, d));  // never fetched
+    ASSERT_TRUE(cache.refresh("/configs"));
+    ASSERT_TRUE(cache.delta("/configs", 0, 0, d));
+    EXPECT_EQ(d["fields"]["mode"], "rule");
+
+    mihomo.set("/configs", json());  // not an object: treated as a failed fetch
+    EXPECT_FALSE(cache.refresh("/configs"));
+    EXPECT_FALSE(cache.delta("/configs", 0, 0, d));
+
+    EXPECT_FALSE(cache.refresh("/rules"));
+    EXPECT_FALSE(ControllerCache::is_cached_path("/rules"));
+}
+
+TEST(ControllerCacheTest, ReadersDoNotCauseFetches) {
+    FakeController mihomo;
+    mihomo.set("/version", {{"version", "v1.18"}});
+    mihomo.set("/configs", {{"mode", "rule"}});
+    mihomo.set("/proxies", proxies("A", 100));
+    mihomo.set("/connections", {{"connections", json::array()}});
+    ControllerCache cache({}, mihomo.fetch());
+    cache.poll_once();
+    EXPECT_EQ(cache.fetch_count(), 4u);
+
+    for (int client = 0; client < 100; ++client) {
+        json d;
+        ASSERT_TRUE(cache.delta("/proxies", 0, 0, d));
+        ASSERT_TRUE(cache.delta("/connections", 0, 0, d));
+    }
+    EXPECT_EQ(cache.fetch_count(), 4u);
+}
@@ -6,9 +6,13 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
+#include <algorithm>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <vector>
 #include <filesystem>
+#include <cstdio>
 #include <cstdlib>
 
 namespace fs = std::filesystem;
@@ -114,12 +118,57 @@ TEST_F(DaemonIPCTest, StatusCommand) {
         EXPECT_TRUE(resp.value("ok", false));
         EXPECT_TRUE(resp.contains("data"));
         EXPECT_FALSE(resp["data"].value("mihomo_running", true));
+        // No profile deployed: slot 0 serves its home's default config
+        EXPECT_EQ(resp["data"].value("mihomo_home", ""), Config::mihomo_dir());
+        EXPECT_EQ(resp["data"].value("mihomo_config", ""), Config::mihomo_dir() + "/config.yaml");
     }
 
     daemon.request_stop();
     t.join();
 }
 
+TEST_F(DaemonIPCTest, ConcurrentStatusP99) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    // 200 clients at once, every tenth keeping a worker busy with the
+    // latency database meanwhile; `status` answers on the loop
+    constexpr int kClients = 200;
+    std::vector<double> latencies;
+    std::mutex latencies_mutex;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kClients; ++i) {
+        threads.emplace_back([&, i]() {
+            if (i % 10 == 0) {
+                send_ipc({{"cmd", "latency_record"}, {"name", "n" + std::to_string(i)}, {"delay", 50}});
+                send_ipc({{"cmd", "latency_stats"}});
+                return;
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            auto resp = send_ipc({{"cmd", "status"}});
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0).count();
+            std::lock_guard<std::mutex> lock(latencies_mutex);
+            latencies.push_back(resp.value("ok", false) ? ms : -1.0);
+        });
+    }
+    for (auto& th : threads) th.join();
+
+    daemon.request_stop();
+    t.join();
+
+    ASSERT_EQ(latencies.size(), size_t(kClients - kClients / 10));
+    for (double l : latencies) ASSERT_GE(l, 0.0);
+    std::sort(latencies.begin(), latencies.end());
+    double p99 = latencies[latencies.size() * 99 / 100];
+    // Recorded only: a wall-clock bound would flake on loaded runners
+    RecordProperty("p99_ms", std::to_string(p99));
+    std::printf("[ status p99] %.2f ms over %zu clients\n", p99, latencies.size());
+}
+
 TEST_F(DaemonIPCTest, ProfileListEmpty) {
     // If system profiles exist on this machine, fallback returns them
     if (fs::exists(Config::system_config_dir() + "/profiles")) {
@@ -181,3 +230,143 @@ TEST_F(DaemonIPCTest, ProfileAddEmptyName) {
     daemon.request_stop();
     t.join();
 }
+
+TEST_F(DaemonIPCTest, LatencyRecordAndStats) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto rec1 = send_ipc({{"cmd", "latency_record"}, {"name", "node-a"}, {"delay", 120}});
+    auto rec2 = send_ipc({{"cmd", "latency_record"}, {"name", "node-a"}, {"delay", 0}});
+    EXPECT_TRUE(rec1.value("ok", false));
+    EXPECT_TRUE(rec2.value("ok", false));
+
+    auto resp = send_ipc({{"cmd", "latency_stats"}, {"names", {"node-a"}}});
+    EXPECT_TRUE(resp.value("ok", false));
+    ASSERT_TRUE(resp["data"].is_array());
+    ASSERT_EQ(resp["data"].size(), 1u);
+    EXPECT_EQ(resp["data"][0].value("samples", 0), 2);
+    EXPECT_EQ(resp["data"][0].value("failures", 0), 1);
+    EXPECT_EQ(resp["data"][0].value("p50", -1), 120);
+
+    // Same name in another profile: a separate history
+    send_ipc({{"cmd", "latency_record"}, {"name", "node-a"}, {"delay", 300}, {"profile", "other"}});
+    resp = send_ipc({{"cmd", "latency_stats"}, {"names", {"node-a"}}, {"profile", "other"}});
+    ASSERT_EQ(resp["data"].size(), 1u);
+    EXPECT_EQ(resp["data"][0].value("samples", 0), 1);
+    EXPECT_EQ(resp["data"][0].value("p50", -1), 300);
+
+    daemon.request_stop();
+    t.join();
+}
+
+TEST_F(DaemonIPCTest, LatencySnapshotWithoutMihomo) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto resp = send_ipc({{"cmd", "latency"}, {"since", 0}, {"history", 5}});
+    EXPECT_TRUE(resp.value("ok", false));
+    ASSERT_TRUE(resp["data"].is_object());
+    EXPECT_GT(resp["data"].value("now", (int64_t)0), 0);
+    ASSERT_TRUE(resp["data"]["nodes"].is_object());
+    EXPECT_TRUE(resp["data"]["nodes"].empty());  // mihomo unreachable: nothing probed
+
+    daemon.request_stop();
+    t.join();
+}
+
+TEST_F(DaemonIPCTest, RequestIdEchoed) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto resp = send_ipc({{"cmd", "status"}, {"id", 42}});
+    EXPECT_TRUE(resp.value("ok", false));
+    EXPECT_EQ(resp.value("id", 0), 42);
+
+    resp = send_ipc({{"cmd", "bogus"}, {"id", "abc"}});
+    EXPECT_FALSE(resp.value("ok", true));
+    EXPECT_EQ(resp.value("id", ""), "abc");
+
+    daemon.request_stop();
+    t.join();
+}
+
+TEST_F(DaemonIPCTest, SubscribeAcknowledged) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto resp = send_ipc({{"cmd", "subscribe"}});
+    EXPECT_TRUE(resp.value("ok", false));
+    ASSERT_TRUE(resp["data"]["events"].is_array());
+    EXPECT_FALSE(resp["data"]["events"].empty());
+    const auto& events = resp["data"]["events"];
+    EXPECT_NE(std::find(events.begin(), events.end(), "mihomo_crash_loop"), events.end());
+
+    daemon.request_stop();
+    t.join();
+}
+
+TEST_F(DaemonIPCTest, AsyncJobReportsFailure) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto resp = send_ipc({{"cmd", "profile_add"}, {"name", ""}, {"url", "http://x"}, {"async", true}});
+    ASSERT_TRUE(resp.value("ok", false));
+    uint64_t job = resp["data"].value("job", (uint64_t)0);
+    ASSERT_GT(job, 0u);
+
+    json st;
+    for (int i = 0; i < 50; ++i) {
+        st = send_ipc({{"cmd", "job_status"}, {"job", job}});
+        if (st["data"].value("state", "") == "failed") break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    EXPECT_EQ(st["data"].value("state", ""), "failed");
+    EXPECT_EQ(st["data"].value("error", ""), "Profile name cannot be empty");
+
+    // Synchronous form still answers with the outcome
+    resp = send_ipc({{"cmd", "profile_add"}, {"name", ""}, {"url", "http://x"}});
+    EXPECT_FALSE(resp.value("ok", true));
+    EXPECT_EQ(resp.value("error", ""), "Profile name cannot be empty");
+
+    resp = send_ipc({{"cmd", "job_cancel"}, {"job", job}});
+    EXPECT_FALSE(resp.value("ok", true));  // already finished
+
+    daemon.request_stop();
+    t.join();
+}
+
+TEST_F(DaemonIPCTest, ControllerCacheWithoutMihomo) {
+    Config config;
+    config.data().mihomo_binary_path = "/nonexistent/mihomo";
+    Daemon daemon(config);
+    std::thread t([&]() { daemon.run(); });
+    ASSERT_TRUE(wait_for_socket());
+
+    auto resp = send_ipc({{"cmd", "controller"}, {"path", "/proxies"}});
+    EXPECT_FALSE(resp.value("ok", true));
+    EXPECT_EQ(resp.value("error", ""), "Mihomo API not reachable");
+
+    resp = send_ipc({{"cmd", "controller"}, {"path", "/rules"}});
+    EXPECT_FALSE(resp.value("ok", true));
+    EXPECT_EQ(resp.value("error", ""), "Path not cached: /rules");
+
+    daemon.request_stop();
+    t.join();
+}
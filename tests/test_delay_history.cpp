@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include "core/delay_history.hpp"
+#include "ui/proxy_panel.hpp"
+
+#include <chrono>
+
+TEST(DelayHistoryTest, Defaults) {
+    DelayHistory h;
+    EXPECT_TRUE(h.empty());
+    EXPECT_EQ(h.size(), 0u);
+    EXPECT_EQ(h.capacity(), DelayHistory::kDefaultCapacity);
+    EXPECT_EQ(h.min(), -1);
+    EXPECT_EQ(h.avg(), -1);
+    EXPECT_EQ(h.p95(), -1);
+    EXPECT_EQ(h.failures(), 0);
+}
+
+TEST(DelayHistoryTest, PushKeepsOrder) {
+    DelayHistory h(4);
+    h.push(10, 1000);
+    h.push(20, 2000);
+    h.push(30, 3000);
+    ASSERT_EQ(h.size(), 3u);
+    EXPECT_EQ(h[0].delay, 10);
+    EXPECT_EQ(h[2].delay, 30);
+    EXPECT_EQ(h.back().timestamp_ms, 3000);
+}
+
+TEST(DelayHistoryTest, OverwritesOldestWhenFull) {
+    DelayHistory h(3);
+    for (int i = 1; i <= 5; ++i) {
+        h.push(i * 10, i * 1000);
+    }
+    ASSERT_EQ(h.size(), 3u);
+    EXPECT_EQ(h[0].delay, 30);
+    EXPECT_EQ(h[1].delay, 40);
+    EXPECT_EQ(h[2].delay, 50);
+}
+
+TEST(DelayHistoryTest, RollingMinTracksEviction) {
+    DelayHistory h(3);
+    h.push(5, 1);
+    h.push(50, 2);
+    h.push(40, 3);
+    EXPECT_EQ(h.min(), 5);
+    h.push(60, 4); // evicts 5
+    EXPECT_EQ(h.min(), 40);
+    h.push(70, 5); // evicts 50
+    EXPECT_EQ(h.min(), 40);
+    h.push(80, 6); // evicts 40
+    EXPECT_EQ(h.min(), 60);
+}
+
+TEST(DelayHistoryTest, AvgAndFailures) {
+    DelayHistory h(10);
+    h.push(100, 1);
+    h.push(0, 2);
+    h.push(200, 3);
+    EXPECT_EQ(h.avg(), 150);
+    EXPECT_EQ(h.failures(), 1);
+    EXPECT_EQ(h.min(), 100);
+}
+
+TEST(DelayHistoryTest, P95) {
+    DelayHistory h(100);
+    for (int i = 0; i < 95; ++i) h.push(50, i);
+    for (int i = 0; i < 5; ++i) h.push(900, 100 + i);
+    // 95% of samples are 50ms → bucket [50,60)
+    EXPECT_EQ(h.p95(), 60);
+    h.push(900, 200); // evicts a 50ms sample, now 6% are 900ms
+    EXPECT_EQ(h.p95(), 910);
+}
+
+TEST(DelayHistoryTest, AllFailures) {
+    DelayHistory h(5);
+    h.push(0, 1);
+    h.push(0, 2);
+    EXPECT_EQ(h.min(), -1);
+    EXPECT_EQ(h.avg(), -1);
+    EXPECT_EQ(h.p95(), -1);
+    EXPECT_EQ(h.failures(), 2);
+}
+
+TEST(DelayHistoryTest, MergeByTimestamp) {
+    DelayHistory local(10);
+    local.push(11, 1500);
+    local.push(33, 3500);
+
+    std::vector<DelaySample> remote = {{1000, 10}, {2000, 20}, {3000, 30}};
+    local.merge(remote);
+
+    ASSERT_EQ(local.size(), 5u);
+    EXPECT_EQ(local[0].delay, 10);
+    EXPECT_EQ(local[1].delay, 11);
+    EXPECT_EQ(local[2].delay, 20);
+    EXPECT_EQ(local[3].delay, 30);
+    EXPECT_EQ(local[4].delay, 33);
+    EXPECT_EQ(local.min(), 10);
+}
+
+TEST(DelayHistoryTest, MergeDropsDuplicates) {
+    DelayHistory a(10);
+    a.push(10, 1000);
+    a.push(20, 2000);
+    DelayHistory b(10);
+    b.push(20, 2000);
+    b.push(30, 3000);
+    a.merge(b);
+    ASSERT_EQ(a.size(), 3u);
+    EXPECT_EQ(a.back().delay, 30);
+}
+
+TEST(DelayHistoryTest, MergeCountsSameTestOnce) {
+    // Local record of a manual test, then mihomo's history entry for it
+    DelayHistory h(10);
+    h.push(120, 10400);
+    h.push(0, 20400);
+    h.merge(std::vector<DelaySample>{{10000, 120}, {20000, 0}, {30000, 120}});
+    ASSERT_EQ(h.size(), 3u);
+    EXPECT_EQ(h[0].timestamp_ms, 10000);
+    EXPECT_EQ(h.failures(), 1);
+
+    // Merging the same history again changes nothing
+    h.merge(std::vector<DelaySample>{{10000, 120}, {20000, 0}, {30000, 120}});
+    EXPECT_EQ(h.size(), 3u);
+
+    // Far apart, or a different delay: separate tests
+    h.merge(std::vector<DelaySample>{{40000, 120}, {30500, 121}});
+    EXPECT_EQ(h.size(), 5u);
+}
+
+TEST(DelayHistoryTest, MergeKeepsRepeatedFailures) {
+    // Failures more than a second apart are separate tests
+    DelayHistory h(10);
+    h.push(0, 10000);
+    h.merge(std::vector<DelaySample>{{8500, 0}, {12000, 0}});
+    EXPECT_EQ(h.size(), 3u);
+    EXPECT_EQ(h.failures(), 3);
+
+    // A local failure recorded just before or after mihomo's is the same test
+    h.push(0, 20300);
+    h.merge(std::vector<DelaySample>{{20000, 0}});
+    EXPECT_EQ(h.size(), 4u);
+    EXPECT_EQ(h.back().timestamp_ms, 20000);
+    h.push(0, 29800);
+    h.merge(std::vector<DelaySample>{{30000, 0}});
+    EXPECT_EQ(h.size(), 5u);
+    EXPECT_EQ(h.back().timestamp_ms, 30000);
+}
+
+TEST(DelayHistoryTest, PanelRefreshTakesMihomoEntryForLocalTest) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::vector<DelaySample> mihomo_history;
+
+    ProxyPanel panel;
+    ProxyPanel::Callbacks cb;
+    cb.get_groups = [] { return std::map<std::string, ProxyGroup>{}; };
+    cb.get_nodes = [&] {
+        ProxyNode node;
+        node.name = "n1";
+        node.delay_history.merge(mihomo_history);
+        return std::map<std::string, ProxyNode>{{"n1", node}};
+    };
+    panel.set_callbacks(cb);
+    panel.refresh_data();
+
+    // A local failure, then mihomo's own entry for it (stamped earlier)
+    // and for a successful test recorded locally a little later
+    panel.apply_delay_samples({{"n1", {{now, 0}, {now + 5000, 80}}}});
+    mihomo_history = {{now - 400, 0}, {now + 3000, 80}};
+    panel.refresh_data();
+
+    auto h = panel.delay_history("n1");
+    ASSERT_EQ(h.size(), 2u);
+    EXPECT_EQ(h.failures(), 1);
+    EXPECT_EQ(h[0].timestamp_ms, now - 400);
+    EXPECT_EQ(h[1].timestamp_ms, now + 3000);
+}
+
+TEST(DelayHistoryTest, MergeKeepsNewest) {
+    DelayHistory h(2);
+    h.merge(std::vector<DelaySample>{{1, 10}, {2, 20}, {3, 30}});
+    ASSERT_EQ(h.size(), 2u);
+    EXPECT_EQ(h[0].delay, 20);
+    EXPECT_EQ(h[1].delay, 30);
+    EXPECT_EQ(h.min(), 20);
+}
+
+TEST(DelayHistoryTest, RecentDelays) {
+    DelayHistory h(10);
+    for (int i = 1; i <= 7; ++i) h.push(i, i);
+    auto recent = h.recent_delays(5);
+    ASSERT_EQ(recent.size(), 5u);
+    EXPECT_EQ(recent.front(), 3);
+    EXPECT_EQ(recent.back(), 7);
+    EXPECT_EQ(h.recent_delays(20).size(), 7u);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "daemon/ipc_codec.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using json = nlohmann::json;
+
+namespace {
+
+/// Roughly what a full /proxies snapshot looks like on a large subscription
+json proxy_snapshot(int nodes) {
+    json proxies = json::object();
+    json all = json::array();
+    for (int i = 0; i < nodes; ++i) {
+        std::string name = "HK-" + std::to_string(i) + " | Premium IPLC";
+        json history = json::array();
+        for (int h = 0; h < 10; ++h) {
+            history.push_back({{"time", "2024-05-01T10:00:0" + std::to_string(h) + ".123456789+08:00"},
+                               {"delay", 80 + (i * 7 + h) % 300}});
+        }
+        proxies[name] = {{"type", "Shadowsocks"}, {"server", "node" + std::to_string(i) + ".example.com"},
+                         {"port", 443 + i % 100}, {"udp", true}, {"alive", i % 13 != 0},
+                         {"history", std::move(history)}};
+        all.push_back(name);
+    }
+    proxies["Proxy"] = {{"type", "Selector"}, {"now", all[0]}, {"all", all}};
+    return {{"ok", true}, {"id", 42}, {"data", {{"proxies", std::move(proxies)}}}};
+}
+
+} // namespace
+
+TEST(IpcCodecTest, RoundTripEveryEncoding) {
+    json msg = {{"cmd", "controller"}, {"path", "/proxies"}, {"since", 12}, {"id", 7},
+                {"blob", std::string(1000, 'z')}, {"nested", {{"a", {1, 2.5, nullptr, false}}}}};
+    for (auto enc : {IpcEncoding::Json, IpcEncoding::Cbor, IpcEncoding::MsgPack}) {
+        std::string wire = ipc_codec::encode(msg, enc);
+        size_t pos = 0;
+        json out;
+        std::string err;
+        ASSERT_EQ(ipc_codec::decode_next(wire, pos, enc, 1 << 20, out, err), ipc_codec::Status::Ok)
+            << ipc_codec::name(enc) << ": " << err;
+        EXPECT_EQ(out, msg);
+        EXPECT_EQ(pos, wire.size());
+    }
+}
+
+TEST(IpcCodecTest, PartialAndOversizedFrames) {
+    std::string first = ipc_codec::encode({{"cmd", "status"}}, IpcEncoding::Cbor);
+    std::string wire = first + ipc_codec::encode({{"cmd", "profile_list"}}, IpcEncoding::Cbor);
+
+    json out;
+    std::string err;
+    // Every prefix short of a whole frame waits for more
+    for (size_t cut = 0; cut < first.size(); ++cut) {
+        size_t pos = 0;
+        EXPECT_EQ(ipc_codec::decode_next(wire.substr(0, cut), pos, IpcEncoding::Cbor, 1024, out, err),
+                  ipc_codec::Status::NeedMore);
+        EXPECT_EQ(pos, 0u);
+    }
+
+    size_t pos = 0;
+    ASSERT_EQ(ipc_codec::decode_next(wire, pos, IpcEncoding::Cbor, 1024, out, err), ipc_codec::Status::Ok);
+    EXPECT_EQ(out["cmd"], "status");
+    ASSERT_EQ(ipc_codec::decode_next(wire, pos, IpcEncoding::Cbor, 1024, out, err), ipc_codec::Status::Ok);
+    EXPECT_EQ(out["cmd"], "profile_list");
+    EXPECT_EQ(ipc_codec::decode_next(wire, pos, IpcEncoding::Cbor, 1024, out, err),
+              ipc_codec::Status::NeedMore);
+
+    // The length is checked before the payload arrives
+    std::string big = ipc_codec::encode({{"blob", std::string(4096, 'x')}}, IpcEncoding::MsgPack);
+    pos = 0;
+    EXPECT_EQ(ipc_codec::decode_next(big.substr(0, 8), pos, IpcEncoding::MsgPack, 1024, out, err),
+              ipc_codec::Status::TooLarge);
+}
+
+TEST(IpcCodecTest, BadMessagesAreSkipped) {
+    std::string wire = "\n{not json}\n{\"cmd\":\"ok\"}\n";
+    size_t pos = 0;
+    json out;
+    std::string err;
+    EXPECT_EQ(ipc_codec::decode_next(wire, pos, IpcEncoding::Json, 1024, out, err),
+              ipc_codec::Status::Invalid);
+    EXPECT_NE(err.find("Parse error"), std::string::npos);
+    ASSERT_EQ(ipc_codec::decode_next(wire, pos, IpcEncoding::Json, 1024, out, err), ipc_codec::Status::Ok);
+    EXPECT_EQ(out["cmd"], "ok");
+
+    std::string frame("\0\0\0\3\xff\xff\xff", 7);
+    frame += ipc_codec::encode({{"cmd", "ok"}}, IpcEncoding::Cbor);
+    pos = 0;
+    EXPECT_EQ(ipc_codec::decode_next(frame, pos, IpcEncoding::Cbor, 1024, out, err),
+              ipc_codec::Status::Invalid);
+    ASSERT_EQ(ipc_codec::decode_next(frame, pos, IpcEncoding::Cbor, 1024, out, err), ipc_codec::Status::Ok);
+    EXPECT_EQ(out["cmd"], "ok");
+
+    IpcEncoding enc;
+    EXPECT_TRUE(ipc_codec::from_name("msgpack", enc));
+    EXPECT_EQ(enc, IpcEncoding::MsgPack);
+    EXPECT_FALSE(ipc_codec::from_name("bson", enc));
+}
+
+// Encode/decode cost and size of a large snapshot in each wire format.
+// Numbers are reported (and recorded as test properties), not asserted,
+// except that the binary formats must be smaller than JSON text.
+TEST(IpcCodecTest, BenchmarkAgainstJsonLines) {
+    using Clock = std::chrono::steady_clock;
+    constexpr int kRounds = 5;
+    json snapshot = proxy_snapshot(3000);
+
+    size_t json_bytes = 0;
+    for (auto enc : {IpcEncoding::Json, IpcEncoding::Cbor, IpcEncoding::MsgPack}) {
+        std::string wire;
+        double encode_ms = 0, decode_ms = 0;
+        for (int r = 0; r < kRounds; ++r) {
+            auto t0 = Clock::now();
+            wire = ipc_codec::encode(snapshot, enc);
+            auto t1 = Clock::now();
+            size_t pos = 0;
+            json out;
+            std::string err;
+            ASSERT_EQ(ipc_codec::decode_next(wire, pos, enc, 256 << 20, out, err), ipc_codec::Status::Ok);
+            auto t2 = Clock::now();
+            encode_ms += std::chrono::duration<double, std::milli>(t1 - t0).count();
+            decode_ms += std::chrono::duration<double, std::milli>(t2 - t1).count();
+            if (r == 0) {
+                ASSERT_EQ(out, snapshot);
+            }
+        }
+        encode_ms /= kRounds;
+        decode_ms /= kRounds;
+
+        std::string name = ipc_codec::name(enc);
+        RecordProperty(name + "_bytes", std::to_string(wire.size()));
+        RecordProperty(name + "_encode_ms", std::to_string(encode_ms));
+        RecordProperty(name + "_decode_ms", std::to_string(decode_ms));
+        std::printf("[ ipc bench] %-8s %9zu bytes  encode %7.2f ms  decode %7.2f ms\n",
+                    name.c_str(), wire.size(), encode_ms, decode_ms);
+
+        if (enc == IpcEncoding::Json) {
+            json_bytes = wire.size();
+        } else {
+            EXPECT_LT(wire.size(), json_bytes);
+        }
+    }
+}
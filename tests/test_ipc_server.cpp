@@ -0,0 +1,428 @@
+#include <gtest/gtest.h>
+#include "daemon/ipc_server.hpp"
+#include "daemon/ipc_client.hpp"
+#include "core/config.hpp"
+
+#include <nlohmann/json.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+json handle(const json& req) {
+    std::string cmd = req.value("cmd", "");
+    if (cmd == "slow" || cmd == "profile_update") {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+    json resp = {{"ok", true}, {"data", cmd}};
+    if (cmd == "big") resp["data"] = std::string(req.value("size", 0), 'x');
+    if (req.contains("id")) resp["id"] = req["id"];
+    return resp;
+}
+
+// A daemon that predates events: subscribe is an unknown command
+json handle_legacy(const json& req) {
+    if (req.value("cmd", "") == "subscribe") return {{"ok", false}, {"error", "Unknown command"}};
+    return handle(req);
+}
+
+bool is_subscribe(const json& req) {
+    return req.value("cmd", "") == "subscribe";
+}
+
+bool is_slow(const json& req) {
+    std::string cmd = req.value("cmd", "");
+    return cmd == "slow" || cmd == "profile_update";
+}
+
+} // namespace
+
+class IpcServerTest : public ::testing::Test {
+protected:
+    std::string dir_;
+    std::string path_;
+    std::atomic<bool> stop_{false};
+    std::unique_ptr<IpcServer> server_;
+    std::thread loop_;
+
+    void SetUp() override {
+        dir_ = "/tmp/ct_ipc_" + std::to_string(::getpid());
+        path_ = dir_ + "/test.sock";
+    }
+
+    void start(IpcServer::Options opts = {}) {
+        server_ = std::make_unique<IpcServer>(opts, handle, is_slow, is_subscribe);
+        ASSERT_TRUE(server_->listen(path_));
+        loop_ = std::thread([this]() { server_->run(stop_); });
+    }
+
+    void TearDown() override {
+        stop_.store(true);
+        if (loop_.joinable()) loop_.join();
+        server_.reset();
+        try {
+            fs::remove_all(dir_);
+        } catch (...) {}
+    }
+
+    int connect_client() {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        struct sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path_.c_str(), sizeof(addr.sun_path) - 1);
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+            close(fd);
+            return -1;
+        }
+        struct timeval tv;
+        tv.tv_sec = 5;
+        tv.tv_usec = 0;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return fd;
+    }
+
+    static void send_all(int fd, const std::string& data) {
+        size_t total = 0;
+        while (total < data.size()) {
+            ssize_t n = write(fd, data.data() + total, data.size() - total);
+            if (n <= 0) return;
+            total += n;
+        }
+    }
+
+    static std::string read_line(int fd) {
+        std::string buf;
+        char c;
+        while (read(fd, &c, 1) == 1) {
+            if (c == '\n') break;
+            buf += c;
+        }
+        return buf;
+    }
+};
+
+TEST_F(IpcServerTest, PipelinedAndSplitRequests) {
+    start();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+
+    // One request split across writes, followed by two in a single write
+    send_all(fd, "{\"cmd\":\"a");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    send_all(fd, "\"}\n{\"cmd\":\"b\"}\n{\"cmd\":\"c\"}\n");
+
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "a");
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "b");
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "c");
+    close(fd);
+}
+
+TEST_F(IpcServerTest, SlowCommandDoesNotBlockOthers) {
+    start();
+    int slow_fd = connect_client();
+    ASSERT_GE(slow_fd, 0);
+    send_all(slow_fd, "{\"cmd\":\"slow\"}\n");
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto t0 = Clock::now();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    send_all(fd, "{\"cmd\":\"status\"}\n");
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "status");
+    auto fast_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - t0).count();
+    EXPECT_LT(fast_ms, 400);
+    close(fd);
+
+    // The slow answer still arrives on its own connection
+    EXPECT_EQ(json::parse(read_line(slow_fd))["data"], "slow");
+    close(slow_fd);
+}
+
+TEST_F(IpcServerTest, OversizedRequestRejected) {
+    IpcServer::Options opts;
+    opts.max_line = 1024;
+    start(opts);
+
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    send_all(fd, std::string(4096, 'x'));
+    auto resp = json::parse(read_line(fd));
+    EXPECT_FALSE(resp.value("ok", true));
+    EXPECT_EQ(resp.value("error", ""), "Request too long");
+
+    // Server drops the connection afterwards
+    char c;
+    EXPECT_EQ(read(fd, &c, 1), 0);
+    close(fd);
+}
+
+TEST_F(IpcServerTest, ResponseAfterClientHalfClose) {
+    start();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    send_all(fd, "{\"cmd\":\"slow\"}\n");
+    shutdown(fd, SHUT_WR);
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "slow");
+    close(fd);
+}
+
+TEST_F(IpcServerTest, ClosedClientWithPendingRequestDoesNotSpin) {
+    start();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    send_all(fd, "{\"cmd\":\"slow\"}\n");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    close(fd);  // gives up while the worker is busy
+
+    // The loop must sleep until the reply arrives, not spin on EPOLLHUP
+    timespec cpu0{}, cpu1{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu1);
+    double cpu_ms = (cpu1.tv_sec - cpu0.tv_sec) * 1e3 + (cpu1.tv_nsec - cpu0.tv_nsec) / 1e6;
+    EXPECT_LT(cpu_ms, 100.0);
+
+    // The late reply is dropped with the client
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(server_->client_count(), 0u);
+}
+
+TEST_F(IpcServerTest, BroadcastReachesSubscribersOnly) {
+    start();
+    int sub_fd = connect_client();
+    int other_fd = connect_client();
+    ASSERT_GE(sub_fd, 0);
+    ASSERT_GE(other_fd, 0);
+
+    send_all(sub_fd, "{\"cmd\":\"subscribe\"}\n");
+    EXPECT_EQ(json::parse(read_line(sub_fd))["data"], "subscribe");
+    send_all(other_fd, "{\"cmd\":\"status\"}\n");
+    EXPECT_EQ(json::parse(read_line(other_fd))["data"], "status");
+
+    server_->broadcast({{"event", "profile_changed"}});
+    EXPECT_EQ(json::parse(read_line(sub_fd))["event"], "profile_changed");
+
+    // The plain client only sees the answer to its next request
+    send_all(other_fd, "{\"cmd\":\"status\"}\n");
+    EXPECT_EQ(json::parse(read_line(other_fd))["data"], "status");
+    close(sub_fd);
+    close(other_fd);
+}
+
+TEST_F(IpcServerTest, HelloSwitchesToBinaryFrames) {
+    start();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+
+    send_all(fd, "{\"cmd\":\"hello\",\"encoding\":\"cbor\",\"id\":1}\n");
+    auto hello = json::parse(read_line(fd));  // the reply itself is still a line
+    ASSERT_TRUE(hello.value("ok", false));
+    EXPECT_EQ(hello["data"]["encoding"], "cbor");
+    EXPECT_EQ(hello["id"], 1);
+
+    // A multi-megabyte reply, far beyond the line limit, fits in one frame
+    constexpr size_t kSize = 5 * 1024 * 1024;
+    send_all(fd, ipc_codec::encode({{"cmd", "big"}, {"size", kSize}}, IpcEncoding::Cbor));
+    send_all(fd, ipc_codec::encode({{"cmd", "slow"}}, IpcEncoding::Cbor));
+
+    std::string buf;
+    std::vector<json> replies;
+    char chunk[65536];
+    while (replies.size() < 2) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        ASSERT_GT(n, 0);
+        buf.append(chunk, n);
+        size_t pos = 0;
+        json msg;
+        std::string err;
+        while (ipc_codec::decode_next(buf, pos, IpcEncoding::Cbor, 64 << 20, msg, err) ==
+               ipc_codec::Status::Ok) {
+            replies.push_back(msg);
+        }
+        buf.erase(0, pos);
+    }
+    EXPECT_EQ(replies[0]["data"].get<std::string>().size(), kSize);
+    EXPECT_EQ(replies[1]["data"], "slow");
+    close(fd);
+}
+
+TEST_F(IpcServerTest, UnknownEncodingKeepsJsonLines) {
+    start();
+    int fd = connect_client();
+    ASSERT_GE(fd, 0);
+    send_all(fd, "{\"cmd\":\"hello\",\"encoding\":\"xml\"}\n{\"cmd\":\"status\"}\n");
+    auto hello = json::parse(read_line(fd));
+    EXPECT_FALSE(hello.value("ok", true));
+    EXPECT_EQ(json::parse(read_line(fd))["data"], "status");
+    close(fd);
+}
+
+// ── DaemonClient over a persistent connection ───────────────
+
+class DaemonClientTest : public IpcServerTest {
+protected:
+    std::string original_home_;
+
+    void SetUp() override {
+        if (geteuid() == 0) GTEST_SKIP() << "Skipped: socket_path() differs when running as root";
+        IpcServerTest::SetUp();
+        const char* home = std::getenv("HOME");
+        if (home) original_home_ = home;
+        setenv("HOME", dir_.c_str(), 1);
+        path_ = Config::config_dir() + "/clashtui.sock";
+    }
+
+    void TearDown() override {
+        IpcServerTest::TearDown();
+        if (!original_home_.empty()) {
+            setenv("HOME", original_home_.c_str(), 1);
+        } else {
+            unsetenv("HOME");
+        }
+    }
+
+    void restart_server() {
+        stop_.store(true);
+        if (loop_.joinable()) loop_.join();
+        server_.reset();
+        stop_.store(false);
+        start();
+    }
+};
+
+TEST_F(DaemonClientTest, RepliesArriveOutOfOrder) {
+    start();
+    DaemonClient dc;
+    ASSERT_TRUE(dc.is_daemon_running());
+
+    std::atomic<bool> slow_done{false};
+    std::thread slow([&]() {
+        std::string err;
+        EXPECT_TRUE(dc.update_profile("p", err)) << err;
+        slow_done.store(true);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_TRUE(dc.is_daemon_running());
+    EXPECT_FALSE(slow_done.load());  // fast reply overtook the slow one
+    slow.join();
+
+    EXPECT_EQ(server_->client_count(), 1u);  // one shared connection
+}
+
+TEST_F(DaemonClientTest, NegotiatesBinaryFraming) {
+    start();
+    DaemonClient dc;
+    ASSERT_TRUE(dc.is_daemon_running());
+    EXPECT_EQ(dc.wire_encoding(), IpcEncoding::Cbor);
+
+    DaemonClient plain;
+    plain.set_encoding(IpcEncoding::Json);
+    ASSERT_TRUE(plain.is_daemon_running());
+    EXPECT_EQ(plain.wire_encoding(), IpcEncoding::Json);
+}
+
+TEST_F(DaemonClientTest, ReconnectsAfterDaemonRestart) {
+    start();
+    DaemonClient dc;
+    ASSERT_TRUE(dc.is_daemon_running());
+
+    restart_server();
+    EXPECT_TRUE(dc.is_daemon_running());
+
+    stop_.store(true);
+    loop_.join();
+    server_.reset();
+    EXPECT_FALSE(dc.is_daemon_running());
+}
+
+TEST_F(DaemonClientTest, SubscribeStreamsEvents) {
+    start();
+    DaemonClient dc;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<DaemonEvent> events;
+    dc.subscribe([&](const DaemonEvent& ev) {
+        std::lock_guard<std::mutex> lock(mu);
+        events.push_back(ev);
+        cv.notify_all();
+    });
+
+    auto wait_for = [&](size_t n) {
+        std::unique_lock<std::mutex> lock(mu);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return events.size() >= n; });
+    };
+
+    ASSERT_TRUE(wait_for(1));
+    EXPECT_EQ(events[0].type, "daemon_connected");
+
+    server_->broadcast({{"event", "mihomo_exited"}, {"t", 123},
+                        {"data", {{"exit_code", 2}, {"crashed", true}}}});
+    ASSERT_TRUE(wait_for(2));
+    EXPECT_EQ(events[1].type, "mihomo_exited");
+    EXPECT_EQ(events[1].exit_code, 2);
+    EXPECT_TRUE(events[1].crashed);
+    EXPECT_EQ(events[1].time_ms, 123);
+
+    stop_.store(true);
+    loop_.join();
+    server_.reset();
+    ASSERT_TRUE(wait_for(3));
+    EXPECT_EQ(events[2].type, "daemon_disconnected");
+
+    dc.unsubscribe();
+}
+
+TEST_F(DaemonClientTest, RejectedSubscribeFallsBackToPolling) {
+    server_ = std::make_unique<IpcServer>(IpcServer::Options{}, handle_legacy, is_slow,
+                                          [](const json&) { return false; });
+    ASSERT_TRUE(server_->listen(path_));
+    loop_ = std::thread([this]() { server_->run(stop_); });
+    DaemonClient dc;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::vector<DaemonEvent> events;
+    dc.subscribe([&](const DaemonEvent& ev) {
+        std::lock_guard<std::mutex> lock(mu);
+        events.push_back(ev);
+        cv.notify_all();
+    });
+
+    auto wait_for = [&](size_t n) {
+        std::unique_lock<std::mutex> lock(mu);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return events.size() >= n; });
+    };
+
+    // Available although it sends no events, until it stops answering
+    ASSERT_TRUE(wait_for(1));
+    EXPECT_EQ(events[0].type, "daemon_connected");
+
+    stop_.store(true);
+    loop_.join();
+    server_.reset();
+    ASSERT_TRUE(wait_for(2));
+    EXPECT_EQ(events[1].type, "daemon_disconnected");
+
+    dc.unsubscribe();
+    EXPECT_EQ(events.size(), 2u);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "daemon/job_queue.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEST(JobQueueTest, RunsAndReportsProgress) {
+    std::mutex mu;
+    std::vector<JobInfo> updates;
+    JobQueue q(1, [&](const JobInfo& info) {
+        std::lock_guard<std::mutex> lock(mu);
+        updates.push_back(info);
+    });
+
+    uint64_t id = q.submit("profile_update", "p", [](JobQueue::Context& ctx, std::string&) {
+        ctx.set_phase("download");
+        ctx.set_bytes(100, 100);
+        ctx.set_phase("parse");
+        return true;
+    });
+
+    JobInfo info;
+    ASSERT_TRUE(q.wait(id, info, 5000));
+    EXPECT_EQ(info.state, "done");
+    EXPECT_EQ(info.phase, "done");
+    EXPECT_EQ(info.bytes, 100);
+    EXPECT_EQ(info.kind, "profile_update");
+    EXPECT_EQ(info.target, "p");
+    EXPECT_GT(info.finished_ms, 0);
+
+    std::lock_guard<std::mutex> lock(mu);
+    std::vector<std::string> phases;
+    for (const auto& u : updates) phases.push_back(u.state + "/" + u.phase);
+    ASSERT_GE(phases.size(), 5u);
+    EXPECT_EQ(phases.front(), "queued/queued");
+    EXPECT_NE(std::find(phases.begin(), phases.end(), "running/download"), phases.end());
+    EXPECT_NE(std::find(phases.begin(), phases.end(), "running/parse"), phases.end());
+    EXPECT_EQ(phases.back(), "done/done");
+}
+
+TEST(JobQueueTest, FailureCarriesError) {
+    JobQueue q(1);
+    uint64_t id = q.submit("profile_add", "x", [](JobQueue::Context&, std::string& err) {
+        err = "HTTP 404";
+        return false;
+    });
+    JobInfo info;
+    ASSERT_TRUE(q.wait(id, info, 5000));
+    EXPECT_EQ(info.state, "failed");
+    EXPECT_EQ(info.error, "HTTP 404");
+}
+
+TEST(JobQueueTest, CancelQueuedAndRunning) {
+    JobQueue q(1);
+    std::atomic<bool> started{false};
+    uint64_t running = q.submit("profile_update", "a", [&](JobQueue::Context& ctx, std::string& err) {
+        started.store(true);
+        while (!ctx.cancelled()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        err = "Cancelled";
+        return false;
+    });
+    uint64_t queued = q.submit("profile_update", "b", [](JobQueue::Context&, std::string&) {
+        return true;
+    });
+
+    while (!started.load()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    JobInfo info;
+    ASSERT_TRUE(q.cancel(queued));
+    ASSERT_TRUE(q.get(queued, info));
+    EXPECT_EQ(info.state, "cancelled");  // never ran
+
+    ASSERT_TRUE(q.cancel(running));
+    ASSERT_TRUE(q.wait(running, info, 5000));
+    EXPECT_EQ(info.state, "cancelled");
+
+    EXPECT_FALSE(q.cancel(running));  // already finished
+    EXPECT_FALSE(q.cancel(9999));
+}
+
+TEST(JobQueueTest, KeepsRecentFinishedJobs) {
+    JobQueue q(1, nullptr, 3);
+    uint64_t first = 0;
+    for (int i = 0; i < 6; ++i) {
+        uint64_t id = q.submit("profile_update", std::to_string(i),
+                               [](JobQueue::Context&, std::string&) { return true; });
+        if (i == 0) first = id;
+        JobInfo info;
+        ASSERT_TRUE(q.wait(id, info, 5000));
+    }
+    JobInfo info;
+    EXPECT_FALSE(q.get(first, info));
+    EXPECT_LE(q.list().size(), 4u);
+}
+
+TEST(JobQueueTest, StopCancelsPendingWork) {
+    JobQueue q(1);
+    std::atomic<bool> started{false};
+    q.submit("mihomo_restart", "", [&](JobQueue::Context& ctx, std::string&) {
+        started.store(true);
+        while (!ctx.cancelled()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return false;
+    });
+    uint64_t pending = q.submit("profile_update", "p", [](JobQueue::Context&, std::string&) {
+        return true;
+    });
+    while (!started.load()) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    q.stop();
+    JobInfo info;
+    ASSERT_TRUE(q.get(pending, info));
+    EXPECT_EQ(info.state, "cancelled");
+
+    uint64_t late = q.submit("profile_update", "q", [](JobQueue::Context&, std::string&) {
+        return true;
+    });
+    ASSERT_TRUE(q.get(late, info));
+    EXPECT_EQ(info.state, "cancelled");
+}
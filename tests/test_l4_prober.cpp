@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include "core/l4_prober.hpp"
+
+#include <openssl/err.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Listening socket on 127.0.0.1 with an ephemeral port. The kernel
+// completes handshakes into the backlog, so nothing needs to accept().
+class Listener {
+public:
+    Listener() {
+        fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(fd_, 1024);
+        socklen_t len = sizeof(addr);
+        getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+        port_ = ntohs(addr.sin_port);
+    }
+    ~Listener() { close(); }
+    void close() {
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+    }
+    int port() const { return port_; }
+
+private:
+    int fd_ = -1;
+    int port_ = 0;
+};
+
+L4Target local(const std::string& name, int port, bool tls = false) {
+    L4Target t;
+    t.name = name;
+    t.host = "127.0.0.1";
+    t.port = port;
+    t.tls = tls;
+    return t;
+}
+
+} // namespace
+
+TEST(L4ProberTest, ConnectsToListener) {
+    Listener l;
+    L4Prober prober(L4Prober::Options{});
+    auto results = prober.run({local("up", l.port())});
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_TRUE(results[0].success) << results[0].error;
+    EXPECT_EQ(results[0].name, "up");
+    EXPECT_GE(results[0].connect_ms, 0);
+    EXPECT_EQ(results[0].tls_ms, -1);
+    EXPECT_GE(results[0].delay(), 1);
+}
+
+TEST(L4ProberTest, RefusedAndInvalidPorts) {
+    Listener l;
+    int closed_port = l.port();
+    l.close();
+
+    L4Prober prober(L4Prober::Options{});
+    auto results = prober.run({local("refused", closed_port), local("bad", 0)});
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_FALSE(results[0].success);
+    EXPECT_FALSE(results[0].error.empty());
+    EXPECT_EQ(results[0].delay(), 0);
+    EXPECT_FALSE(results[1].success);
+    EXPECT_EQ(results[1].error, "invalid port");
+}
+
+TEST(L4ProberTest, ManyTargetsWithLimitedConcurrency) {
+    Listener l;
+    std::vector<L4Target> targets;
+    for (int i = 0; i < 300; ++i) targets.push_back(local("n" + std::to_string(i), l.port()));
+
+    L4Prober::Options opts;
+    opts.concurrency = 32;
+    L4Prober prober(opts);
+    size_t callbacks = 0;
+    auto results = prober.run(targets, [&](const L4Result&) { ++callbacks; });
+
+    ASSERT_EQ(results.size(), 300u);
+    EXPECT_EQ(callbacks, 300u);
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].name, "n" + std::to_string(i));  // target order kept
+        EXPECT_TRUE(results[i].success) << results[i].error;
+    }
+}
+
+TEST(L4ProberTest, SilentTlsServerTimesOut) {
+    Listener l;  // accepts TCP but never answers the ClientHello
+    L4Prober::Options opts;
+    opts.tls = true;
+    opts.timeout_ms = 200;
+    L4Prober prober(opts);
+    auto results = prober.run({local("tls", l.port(), true), local("plain", l.port())});
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_FALSE(results[0].success);
+    EXPECT_EQ(results[0].error, "tls timeout");
+    EXPECT_GE(results[0].connect_ms, 0);
+    EXPECT_TRUE(results[1].success);  // not marked tls: TCP only
+}
+
+TEST(L4ProberTest, StaleSslErrorDoesNotFailHandshake) {
+    // Left on this thread's queue by some earlier OpenSSL user
+    ERR_raise(ERR_LIB_SSL, ERR_R_INTERNAL_ERROR);
+
+    Listener l;
+    L4Prober::Options opts;
+    opts.tls = true;
+    opts.timeout_ms = 200;
+    L4Prober prober(opts);
+    auto results = prober.run({local("tls", l.port(), true)});
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].error, "tls timeout");
+    ERR_clear_error();
+}
+
+TEST(L4ProberTest, TargetsFromProfile) {
+    std::string path = fs::temp_directory_path().string() + "/clashtui_l4_" +
+                       std::to_string(::getpid()) + ".yaml";
+    {
+        std::ofstream out(path);
+        out << "proxies:\n"
+               "  - {name: a, type: ss, server: 1.2.3.4, port: 8388}\n"
+               "  - {name: b, type: trojan, server: t.example.com, port: 443, sni: s.example.com}\n"
+               "  - {name: c, type: vmess, server: v.example.com, port: 443, tls: true}\n"
+               "  - {name: d, type: hysteria2, server: h.example.com, port: 443}\n";
+    }
+    auto targets = L4Prober::targets_from_profile(path);
+    fs::remove(path);
+
+    ASSERT_EQ(targets.size(), 3u);
+    EXPECT_EQ(targets[0].name, "a");
+    EXPECT_FALSE(targets[0].tls);
+    EXPECT_EQ(targets[0].port, 8388);
+    EXPECT_TRUE(targets[1].tls);
+    EXPECT_EQ(targets[1].sni, "s.example.com");
+    EXPECT_TRUE(targets[2].tls);
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include "daemon/latency_prober.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+LatencyProber::Options fast_options() {
+    LatencyProber::Options opts;
+    opts.rate_per_sec = 1000;
+    opts.burst = 10;
+    opts.concurrency = 2;
+    opts.selected_interval_sec = 0;
+    opts.flaky_interval_sec = 0;
+    opts.stable_interval_sec = 0;
+    opts.dead_interval_sec = 0;
+    opts.dead_max_interval_sec = 0;
+    return opts;
+}
+
+LatencyProber::TargetsFn fixed_targets(std::vector<std::string> nodes,
+                                       std::set<std::string> selected = {}) {
+    return [nodes, selected](LatencyProber::Targets& out) {
+        out.nodes = nodes;
+        out.selected = selected;
+        return true;
+    };
+}
+
+DelayResult ok_result(const std::string& name, int delay) {
+    DelayResult r;
+    r.name = name;
+    r.delay = delay;
+    r.success = true;
+    return r;
+}
+
+// Poll until `pred` holds or the timeout passes
+template <typename Pred>
+bool wait_for(Pred pred, int timeout_ms = 2000) {
+    for (int i = 0; i < timeout_ms / 10; ++i) {
+        if (pred()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return pred();
+}
+
+} // namespace
+
+TEST(LatencyProberTest, ProbesAllNodes) {
+    std::mutex mu;
+    std::map<std::string, int> recorded;
+    LatencyProber prober(fast_options(), fixed_targets({"a", "b", "c"}),
+        [](const std::string& name) { return ok_result(name, 50); },
+        [&](const std::string& name, int delay) {
+            std::lock_guard<std::mutex> lock(mu);
+            recorded[name] = delay;
+        });
+    prober.start();
+    ASSERT_TRUE(wait_for([&] { return prober.snapshot().size() == 3 &&
+                                      prober.probe_count() >= 6; }));
+    prober.stop();
+
+    auto snap = prober.snapshot();
+    for (const auto& name : {"a", "b", "c"}) {
+        ASSERT_TRUE(snap.count(name));
+        EXPECT_EQ(snap[name].delay, 50);
+        EXPECT_EQ(snap[name].state, "stable");
+        EXPECT_GT(snap[name].last_probe_ms, 0);
+    }
+    std::lock_guard<std::mutex> lock(mu);
+    EXPECT_EQ(recorded.size(), 3u);
+}
+
+TEST(LatencyProberTest, SelectedAndDeadStates) {
+    LatencyProber prober(fast_options(), fixed_targets({"good", "bad"}, {"good"}),
+        [](const std::string& name) {
+            if (name == "good") return ok_result(name, 80);
+            DelayResult r;
+            r.name = name;
+            r.error = "Timeout";
+            return r;
+        });
+    prober.start();
+    ASSERT_TRUE(wait_for([&] {
+        auto snap = prober.snapshot();
+        return snap["bad"].state == "dead" && snap["good"].state == "selected";
+    }));
+    prober.stop();
+
+    auto snap = prober.snapshot(0, 3);
+    EXPECT_EQ(snap["bad"].delay, 0);
+    EXPECT_GE(snap["bad"].failures, 3);
+    EXPECT_EQ(snap["good"].min, 80);
+    EXPECT_EQ(snap["good"].history.size(), 3u);
+}
+
+TEST(LatencyProberTest, FlakyWhenWindowHasFailures) {
+    std::atomic<int> calls{0};
+    LatencyProber prober(fast_options(), fixed_targets({"n"}),
+        [&](const std::string& name) {
+            // One failure, then successes: not dead, but not stable either
+            if (calls.fetch_add(1) == 0) return DelayResult{name, 0, false, "Timeout"};
+            return ok_result(name, 40);
+        });
+    prober.start();
+    ASSERT_TRUE(wait_for([&] { return prober.probe_count() >= 3; }));
+    prober.stop();
+    EXPECT_EQ(prober.snapshot()["n"].state, "flaky");
+}
+
+TEST(LatencyProberTest, GlobalRateLimit) {
+    auto opts = fast_options();
+    opts.rate_per_sec = 20;
+    opts.burst = 1;
+    opts.concurrency = 4;
+    std::vector<std::string> nodes;
+    for (int i = 0; i < 50; ++i) nodes.push_back("node" + std::to_string(i));
+
+    LatencyProber prober(opts, fixed_targets(nodes),
+        [](const std::string& name) { return ok_result(name, 10); });
+    prober.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    prober.stop();
+
+    // ~10 probes in 0.5s at 20/s; allow scheduling slack but far below 50
+    EXPECT_GE(prober.probe_count(), 3u);
+    EXPECT_LE(prober.probe_count(), 14u);
+}
+
+TEST(LatencyProberTest, MihomoDownIsNotANodeFailure) {
+    LatencyProber prober(fast_options(), fixed_targets({"a"}),
+        [](const std::string& name) { return DelayResult{name, 0, false, "connection failed", true}; });
+    prober.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    prober.stop();
+
+    EXPECT_EQ(prober.probe_count(), 0u);
+    auto snap = prober.snapshot();
+    ASSERT_TRUE(snap.count("a"));
+    EXPECT_EQ(snap["a"].state, "new");
+    EXPECT_EQ(snap["a"].samples, 0);
+}
+
+TEST(LatencyProberTest, UnreachableTargetsProbeNothing) {
+    std::atomic<int> probes{0};
+    LatencyProber prober(fast_options(),
+        [](LatencyProber::Targets&) { return false; },
+        [&](const std::string& name) { ++probes; return ok_result(name, 1); });
+    prober.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    prober.stop();
+    EXPECT_EQ(probes.load(), 0);
+    EXPECT_TRUE(prober.snapshot().empty());
+}
+
+TEST(LatencyProberTest, SnapshotSinceFilters) {
+    LatencyProber prober(fast_options(), fixed_targets({"a"}),
+        [](const std::string& name) { return ok_result(name, 5); });
+    prober.start();
+    ASSERT_TRUE(wait_for([&] { return prober.probe_count() >= 1; }));
+    prober.stop();
+
+    int64_t last = prober.snapshot()["a"].last_probe_ms;
+    EXPECT_EQ(prober.snapshot(last).size(), 1u);
+    EXPECT_TRUE(prober.snapshot(last + 1).empty());
+}
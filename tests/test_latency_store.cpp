@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include "core/latency_store.hpp"
+
+#include <filesystem>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+class LatencyStoreTest : public ::testing::Test {
+protected:
+    std::string dir_;
+    std::string path_;
+
+    void SetUp() override {
+        dir_ = fs::temp_directory_path().string() + "/clashtui_lat_" + std::to_string(::getpid());
+        fs::create_directories(dir_);
+        path_ = dir_ + "/latency.db";
+    }
+
+    void TearDown() override {
+        try {
+            fs::remove_all(dir_);
+        } catch (...) {}
+    }
+};
+
+TEST_F(LatencyStoreTest, NodeIdStable) {
+    EXPECT_EQ(LatencyStore::node_id("node-a"), LatencyStore::node_id("node-a"));
+    EXPECT_NE(LatencyStore::node_id("node-a"), LatencyStore::node_id("node-b"));
+    EXPECT_EQ(LatencyStore::node_id("node-a", ""), LatencyStore::node_id("node-a"));
+    EXPECT_NE(LatencyStore::node_id("node-a", "p1"), LatencyStore::node_id("node-a", "p2"));
+    EXPECT_NE(LatencyStore::node_id("b", "a"), LatencyStore::node_id("", "ab"));
+}
+
+TEST_F(LatencyStoreTest, SameNameInTwoProfilesKeptApart) {
+    {
+        LatencyStore store(path_, 64);
+        store.append("HK 01", 100, 1000, 0, "work");
+        store.append("HK 01", 300, 1000, 0, "home");
+        store.append("HK 01", 300, 1001, 0, "home");
+        store.append("old", 50, 900);  // recorded before profiles were tracked
+
+        auto work = store.stats({"HK 01"}, 0, 0, "work");
+        EXPECT_EQ(work["HK 01"].samples, 1u);
+        EXPECT_EQ(work["HK 01"].min, 100);
+        EXPECT_EQ(store.stats({"HK 01"}, 0, 0, "home")["HK 01"].samples, 2u);
+        EXPECT_TRUE(store.stats({"HK 01"}).empty());
+    }
+
+    // Listing keeps the split after a reload of the names file
+    LatencyStore reopened(path_, 64);
+    auto home = reopened.stats_all(0, 0, "home");
+    ASSERT_EQ(home.size(), 1u);
+    EXPECT_EQ(home["HK 01"].samples, 2u);
+    EXPECT_EQ(reopened.known_nodes("work"), std::vector<std::string>{"HK 01"});
+    EXPECT_EQ(reopened.known_nodes(), std::vector<std::string>{"old"});
+}
+
+TEST_F(LatencyStoreTest, CreatesFile) {
+    LatencyStore store(path_, 128);
+    EXPECT_TRUE(store.open());
+    EXPECT_TRUE(fs::exists(path_));
+    EXPECT_EQ(store.capacity(), 128u);
+    EXPECT_EQ(store.size(), 0u);
+}
+
+TEST_F(LatencyStoreTest, AppendAndStats) {
+    LatencyStore store(path_, 1024);
+    for (int i = 1; i <= 100; ++i) {
+        ASSERT_TRUE(store.append("a", i, 1000 + i));
+    }
+    store.append("a", 0, 2000);
+    store.append("b", 50, 2000);
+
+    auto stats = store.stats({"a"});
+    ASSERT_EQ(stats.count("a"), 1u);
+    const auto& st = stats["a"];
+    EXPECT_EQ(st.samples, 101u);
+    EXPECT_EQ(st.failures, 1u);
+    EXPECT_EQ(st.min, 1);
+    EXPECT_EQ(st.p50, 50);
+    EXPECT_EQ(st.p95, 95);
+    EXPECT_EQ(st.p99, 99);
+    EXPECT_EQ(st.first_seen, 1001);
+    EXPECT_EQ(st.last_seen, 2000);
+    EXPECT_EQ(stats.count("b"), 0u);
+}
+
+TEST_F(LatencyStoreTest, SinceFilter) {
+    LatencyStore store(path_, 64);
+    store.append("a", 10, 100);
+    store.append("a", 20, 200);
+    store.append("a", 30, 300);
+    auto stats = store.stats({"a"}, 200);
+    EXPECT_EQ(stats["a"].samples, 2u);
+    EXPECT_EQ(stats["a"].min, 20);
+}
+
+TEST_F(LatencyStoreTest, WrapsAroundWhenFull) {
+    LatencyStore store(path_, 10);
+    for (int i = 1; i <= 25; ++i) {
+        store.append("a", i, i);
+    }
+    EXPECT_EQ(store.size(), 10u);
+    auto stats = store.stats({"a"});
+    EXPECT_EQ(stats["a"].samples, 10u);
+    EXPECT_EQ(stats["a"].min, 16);
+    EXPECT_EQ(stats["a"].first_seen, 16);
+}
+
+TEST_F(LatencyStoreTest, PersistsAcrossInstances) {
+    {
+        LatencyStore store(path_, 64);
+        store.append("node with spaces", 42, 100);
+    }
+    // Reopen with a different requested capacity: file keeps its own
+    LatencyStore store(path_, 4096);
+    EXPECT_EQ(store.capacity(), 64u);
+    EXPECT_EQ(store.size(), 1u);
+
+    auto names = store.known_nodes();
+    ASSERT_EQ(names.size(), 1u);
+    EXPECT_EQ(names[0], "node with spaces");
+
+    auto all = store.stats_all();
+    ASSERT_EQ(all.count("node with spaces"), 1u);
+    EXPECT_EQ(all["node with spaces"].p50, 42);
+}
+
+TEST_F(LatencyStoreTest, SharedBetweenInstances) {
+    LatencyStore writer(path_, 64);
+    LatencyStore reader(path_, 64);
+    ASSERT_TRUE(reader.open());
+    writer.append("a", 10, 100);
+    writer.append("a", 20, 200);
+    EXPECT_EQ(reader.size(), 2u);
+    EXPECT_EQ(reader.stats({"a"})["a"].samples, 2u);
+}
+
+TEST_F(LatencyStoreTest, RejectsCorruptFile) {
+    {
+        FILE* f = fopen(path_.c_str(), "w");
+        ASSERT_NE(f, nullptr);
+        std::string junk(128, 'x');
+        fwrite(junk.data(), 1, junk.size(), f);
+        fclose(f);
+    }
+    LatencyStore store(path_, 64);
+    EXPECT_FALSE(store.open());
+    EXPECT_FALSE(store.append("a", 10));
+    EXPECT_TRUE(store.stats({"a"}).empty());
+}
+
+TEST_F(LatencyStoreTest, RecreatesTruncatedFile) {
+    {
+        LatencyStore store(path_, 1024);
+        ASSERT_TRUE(store.append("a", 10, 100));
+    }
+    // Header intact, records cut short (e.g. ENOSPC while sizing the file)
+    fs::resize_file(path_, 64 + 100 * 16);
+
+    LatencyStore store(path_, 64);
+    ASSERT_TRUE(store.open());
+    EXPECT_EQ(store.capacity(), 64u);
+    EXPECT_EQ(store.size(), 0u);
+    EXPECT_TRUE(store.append("a", 20, 200));
+    EXPECT_EQ(store.stats({"a"})["a"].samples, 1u);
+    EXPECT_GE(fs::file_size(path_), 64u + 64 * 16);
+}
+
+TEST_F(LatencyStoreTest, RecreatesShortFileWithoutShrinkingIt) {
+    {
+        LatencyStore store(path_, 1024);
+        ASSERT_TRUE(store.append("a", 10, 100));
+    }
+    fs::resize_file(path_, 64 + 100 * 16);
+
+    // Stands in for another process that still has the old file open
+    int old_fd = ::open(path_.c_str(), O_RDONLY);
+    ASSERT_GE(old_fd, 0);
+
+    LatencyStore store(path_, 64);
+    ASSERT_TRUE(store.append("a", 20, 200));
+
+    // A new file took the name; the old one was left as it was
+    struct stat old_st{}, new_st{};
+    ASSERT_EQ(fstat(old_fd, &old_st), 0);
+    ASSERT_EQ(stat(path_.c_str(), &new_st), 0);
+    EXPECT_NE(old_st.st_ino, new_st.st_ino);
+    EXPECT_EQ(old_st.st_size, 64 + 100 * 16);
+    ::close(old_fd);
+
+    size_t files = 0;
+    for (const auto& e : fs::directory_iterator(dir_)) {
+        if (e.path().filename().string().rfind("latency.db.tmp", 0) == 0) ++files;
+    }
+    EXPECT_EQ(files, 0u);
+}
+
+TEST_F(LatencyStoreTest, StatsFollowAppendsAndQueries) {
+    LatencyStore store(path_, 64);
+    store.append("a", 10, 100);
+    store.append("b", 30, 100);
+    EXPECT_EQ(store.stats({"a"})["a"].samples, 1u);
+    // Same count, other names: answered from the same pass
+    EXPECT_EQ(store.stats({"b"})["b"].p50, 30);
+    store.append("a", 20, 200);
+    EXPECT_EQ(store.stats({"a"})["a"].samples, 2u);
+    EXPECT_EQ(store.stats({"a"}, 150)["a"].samples, 1u);
+    EXPECT_TRUE(store.stats({"a"}, 0, kLatencyFlagL4).empty());
+}
+
+TEST_F(LatencyStoreTest, EmptyPathIsUnusable) {
+    LatencyStore store("", 64);
+    EXPECT_FALSE(store.open());
+    EXPECT_FALSE(store.append("a", 10));
+}
+
+TEST_F(LatencyStoreTest, ProbeKindsKeptApart) {
+    LatencyStore store(path_, 128);
+    store.append("node", 200);
+    store.append("node", 30, 0, kLatencyFlagL4);
+
+    auto delay = store.stats({"node"});
+    ASSERT_EQ(delay.count("node"), 1u);
+    EXPECT_EQ(delay["node"].samples, 1u);
+    EXPECT_EQ(delay["node"].p50, 200);
+
+    auto l4 = store.stats_all(0, kLatencyFlagL4);
+    ASSERT_EQ(l4.count("node"), 1u);
+    EXPECT_EQ(l4["node"].samples, 1u);
+    EXPECT_EQ(l4["node"].p50, 30);
+}
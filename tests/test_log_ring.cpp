@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "daemon/log_ring.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void add(LogRing& ring, const std::string& stream, const std::string& data) {
+    ring.append(stream, data.data(), data.size());
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(LogRingTest, SplitsChunksIntoLinesPerStream) {
+    LogRing ring;
+    add(ring, "stdout", "hel");
+    add(ring, "stderr", "fatal: bad");
+    add(ring, "stdout", "lo\nwor");
+    add(ring, "stderr", " config\r\n");
+    add(ring, "stdout", "ld\n");
+
+    auto lines = ring.read(0, 0);
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0].text, "hello");
+    EXPECT_EQ(lines[0].stream, "stdout");
+    EXPECT_EQ(lines[1].text, "fatal: bad config");
+    EXPECT_EQ(lines[1].stream, "stderr");
+    EXPECT_EQ(lines[2].text, "world");
+    EXPECT_EQ(lines[2].seq, 3u);
+    EXPECT_GT(lines[2].time_ms, 0);
+
+    // An unterminated line is kept until the stream closes
+    add(ring, "stdout", "tail");
+    EXPECT_EQ(ring.last_seq(), 3u);
+    ring.flush("stdout");
+    EXPECT_EQ(ring.read(3, 0).at(0).text, "tail");
+}
+
+TEST(LogRingTest, SourcesKeepTheirOwnPartialLines) {
+    // Two processes writing the same stream name at once
+    LogRing ring;
+    ring.append("stdout", "live ha", 7, 0);
+    ring.append("stdout", "standby ha", 10, 1);
+    ring.append("stdout", "lf\n", 3, 0);
+    ring.flush("stdout", 1);  // standby exits mid-line
+
+    auto lines = ring.read(0, 0);
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_EQ(lines[0].text, "live half");
+    EXPECT_EQ(lines[1].text, "standby ha");
+
+    // The live instance's next half line waits for its own rest
+    ring.append("stdout", "more", 4, 0);
+    ring.flush("stdout", 1);
+    EXPECT_EQ(ring.last_seq(), 2u);
+}
+
+TEST(LogRingTest, ReadFollowsBySequenceAndDropsOldest) {
+    LogRing::Options opts;
+    opts.max_lines = 5;
+    LogRing ring(opts);
+    for (int i = 1; i <= 8; ++i) add(ring, "stdout", "line " + std::to_string(i) + "\n");
+
+    uint64_t next = 0;
+    auto all = ring.read(0, 0, &next);
+    ASSERT_EQ(all.size(), 5u);
+    EXPECT_EQ(all.front().text, "line 4");
+    EXPECT_EQ(next, 8u);
+
+    // Newest `limit`
+    auto last2 = ring.read(0, 2);
+    ASSERT_EQ(last2.size(), 2u);
+    EXPECT_EQ(last2[0].text, "line 7");
+
+    // Follow from a cursor
+    EXPECT_TRUE(ring.read(next, 0, &next).empty());
+    add(ring, "stderr", "line 9\n");
+    auto fresh = ring.read(next, 0, &next);
+    ASSERT_EQ(fresh.size(), 1u);
+    EXPECT_EQ(fresh[0].text, "line 9");
+    EXPECT_EQ(next, 9u);
+    EXPECT_TRUE(ring.read(UINT64_MAX, 10).empty());
+}
+
+TEST(LogRingTest, CutsOverlongLines) {
+    LogRing::Options opts;
+    opts.max_line_bytes = 16;
+    LogRing ring(opts);
+    add(ring, "stdout", std::string(40, 'x'));
+    auto lines = ring.read(0, 0);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0].text.size(), 16u);
+}
+
+TEST(LogRingTest, RotatesFileBySize) {
+    std::string dir = fs::temp_directory_path().string() + "/clashtui_logring_" + std::to_string(getpid());
+    fs::remove_all(dir);
+    LogRing::Options opts;
+    opts.file = dir + "/mihomo.log";
+    opts.file_max_bytes = 200;
+    opts.file_keep = 2;
+    {
+        LogRing ring(opts);
+        for (int i = 0; i < 30; ++i) add(ring, "stdout", "message number " + std::to_string(i) + "\n");
+    }
+
+    EXPECT_TRUE(fs::exists(opts.file));
+    EXPECT_TRUE(fs::exists(opts.file + ".1"));
+    EXPECT_TRUE(fs::exists(opts.file + ".2"));
+    EXPECT_FALSE(fs::exists(opts.file + ".3"));
+    EXPECT_LT(fs::file_size(opts.file), 200u);
+    // The newest line is in the live file, or in .1 if it just rotated
+    std::string recent = read_file(opts.file + ".1") + read_file(opts.file);
+    EXPECT_NE(recent.find("stdout message number 29"), std::string::npos);
+    EXPECT_EQ(recent.find("message number 0\n"), std::string::npos);
+    fs::remove_all(dir);
+}
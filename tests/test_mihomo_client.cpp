@@ -19,6 +19,56 @@ TEST(MihomoClientTest, TestConnectionNoServer) {
     EXPECT_FALSE(client.test_connection());
 }
 
+TEST(MihomoClientTest, ReadSourceServesReads) {
+    MihomoClient client("127.0.0.1", 1, "");
+    std::vector<std::string> paths;
+    client.set_read_source([&](const std::string& path, bool, std::string& body) {
+        paths.push_back(path);
+        if (path == "/proxies") {
+            body = R"({"proxies":{"Proxy":{"type":"Selector","now":"A","all":["A","B"]},)"
+                   R"("A":{"type":"Shadowsocks","server":"a.example","port":443}}})";
+            return true;
+        }
+        if (path == "/connections") {
+            body = R"({"uploadTotal":5,"downloadTotal":7,"connections":[{"id":"1"},{"id":"2"}]})";
+            return true;
+        }
+        return false;  // anything else falls back to HTTP
+    });
+
+    auto groups = client.get_proxy_groups();
+    ASSERT_EQ(groups.count("Proxy"), 1u);
+    EXPECT_EQ(groups["Proxy"].now, "A");
+    auto nodes = client.get_proxy_nodes();
+    ASSERT_EQ(nodes.count("A"), 1u);
+    EXPECT_EQ(nodes["A"].port, 443);
+    auto stats = client.get_connections();
+    EXPECT_EQ(stats.active_connections, 2);
+    EXPECT_EQ(stats.download_total, 7);
+
+    EXPECT_FALSE(client.test_connection());  // /version declined, no server
+    EXPECT_EQ(paths.back(), "/version");
+}
+
+TEST(MihomoClientTest, ReadAfterWriteAsksForFreshData) {
+    MihomoClient client("127.0.0.1", 1, "");
+    std::vector<bool> fresh;
+    client.set_read_source([&](const std::string&, bool f, std::string& body) {
+        fresh.push_back(f);
+        body = "{}";
+        return true;
+    });
+
+    client.get_config();
+    client.select_proxy("Proxy", "A");  // fails without a server, still a write attempt
+    client.get_config();
+    client.get_config();
+    ASSERT_EQ(fresh.size(), 3u);
+    EXPECT_FALSE(fresh[0]);
+    EXPECT_TRUE(fresh[1]);
+    EXPECT_FALSE(fresh[2]);
+}
+
 // ── Data structure tests ────────────────────────────────────
 
 TEST(DataStructTest, VersionInfoDefaults) {
@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 #include "daemon/process_manager.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <signal.h>
+#include <unistd.h>
 
 TEST(ProcessManagerTest, Construction) {
     ProcessManager pm;
@@ -96,3 +101,240 @@ TEST(ProcessManagerTest, DoubleStop) {
     EXPECT_TRUE(pm.stop());
     EXPECT_TRUE(pm.stop()); // should not crash
 }
+
+TEST(ProcessManagerTest, ExitDetectedWithoutPolling) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+
+    std::atomic<bool> crashed{false};
+    pm.on_crash = [&](int) { crashed = true; };
+
+    auto t0 = std::chrono::steady_clock::now();
+    EXPECT_TRUE(pm.start("/bin/false"));
+    while (!crashed && std::chrono::steady_clock::now() - t0 < std::chrono::seconds(2)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_TRUE(crashed);
+    // Well under the old 500 ms polling period
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(400));
+    EXPECT_EQ(pm.child_pid(), -1);
+    pm.stop();
+}
+
+TEST(ProcessManagerTest, StopReturnsOnceChildExits) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+    EXPECT_TRUE(pm.start("/bin/sleep", {"60"}));
+
+    auto t0 = std::chrono::steady_clock::now();
+    EXPECT_TRUE(pm.stop());
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(400));
+    EXPECT_FALSE(pm.is_running());
+}
+
+TEST(ProcessManagerTest, BackoffDelayDoublesToMax) {
+    ProcessManager::RestartPolicy policy;
+    policy.initial_delay_ms = 100;
+    policy.max_delay_ms = 1000;
+    EXPECT_EQ(ProcessManager::backoff_delay_ms(policy, 1), 100);
+    EXPECT_EQ(ProcessManager::backoff_delay_ms(policy, 2), 200);
+    EXPECT_EQ(ProcessManager::backoff_delay_ms(policy, 4), 800);
+    EXPECT_EQ(ProcessManager::backoff_delay_ms(policy, 5), 1000);
+    EXPECT_EQ(ProcessManager::backoff_delay_ms(policy, 100), 1000);
+}
+
+TEST(ProcessManagerTest, CrashLoopBacksOff) {
+    ProcessManager pm;
+    ProcessManager::RestartPolicy policy;
+    policy.initial_delay_ms = 20;
+    policy.max_delay_ms = 400;
+    policy.crash_loop_threshold = 0;
+    pm.set_restart_policy(policy);
+
+    std::atomic<int> starts{0};
+    pm.on_start = [&](pid_t) { ++starts; };
+
+    // Restarts after 20, 40, 80, 160, 320 ms ... ≈ 5 within 800 ms
+    EXPECT_TRUE(pm.start("/bin/false"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(800));
+    pm.stop();
+    EXPECT_GE(starts.load(), 4);
+    EXPECT_LE(starts.load(), 8);
+
+    // No restarts once stopped
+    int after_stop = starts.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(starts.load(), after_stop);
+}
+
+TEST(ProcessManagerTest, StartAgainAfterChildExited) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+    EXPECT_TRUE(pm.start("/bin/true"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_FALSE(pm.is_running());
+
+    // The finished monitor is replaced, not leaked
+    EXPECT_TRUE(pm.start("/bin/sleep", {"60"}));
+    EXPECT_TRUE(pm.is_running());
+    pm.stop();
+}
+
+TEST(ProcessManagerTest, CrashLoopSuspendsRestartsUntilStart) {
+    ProcessManager pm;
+    ProcessManager::RestartPolicy policy;
+    policy.initial_delay_ms = 10;
+    policy.crash_loop_threshold = 3;
+    pm.set_restart_policy(policy);
+
+    std::atomic<int> starts{0};
+    std::atomic<bool> looped{false};
+    pm.on_start = [&](pid_t) { ++starts; };
+    pm.on_crash_loop = [&](const ProcessManager::Stats& st) {
+        EXPECT_EQ(st.consecutive_crashes, 3);
+        looped = true;
+    };
+
+    EXPECT_TRUE(pm.start("/bin/false"));
+    for (int i = 0; i < 200 && !looped; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(looped);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    EXPECT_EQ(starts.load(), 3);  // first start + 2 restarts, then nothing
+
+    auto st = pm.stats();
+    EXPECT_TRUE(st.crash_loop);
+    EXPECT_TRUE(pm.crash_looped());
+    EXPECT_EQ(st.crashes, 3u);
+    EXPECT_EQ(st.restarts, 2u);
+    ASSERT_EQ(st.recent.size(), 3u);
+    EXPECT_EQ(st.recent.back().exit_code, 1);
+    EXPECT_EQ(st.recent.back().signal, 0);
+    EXPECT_GT(st.recent.back().time_ms, 0);
+    EXPECT_GE(st.recent.back().uptime_ms, 0);
+
+    // An explicit start is a fresh attempt
+    EXPECT_TRUE(pm.start("/bin/sleep", {"60"}));
+    EXPECT_FALSE(pm.crash_looped());
+    EXPECT_EQ(pm.stats().consecutive_crashes, 0);
+    EXPECT_EQ(pm.stats().crashes, 3u);
+    pm.stop();
+}
+
+TEST(ProcessManagerTest, RecordsTerminatingSignal) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+    std::atomic<bool> crashed{false};
+    pm.on_crash = [&](int) { crashed = true; };
+
+    EXPECT_TRUE(pm.start("/bin/sleep", {"60"}));
+    kill(pm.child_pid(), SIGKILL);
+    for (int i = 0; i < 200 && !crashed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto st = pm.stats();
+    ASSERT_EQ(st.recent.size(), 1u);
+    EXPECT_EQ(st.recent[0].exit_code, -1);
+    EXPECT_EQ(st.recent[0].signal, SIGKILL);
+    EXPECT_EQ(st.started_ms, 0);
+    pm.stop();
+}
+
+TEST(ProcessManagerTest, CapturesOutput) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+
+    std::mutex mu;
+    std::string out, err;
+    int closed = 0;
+    pm.set_output_sink([&](int stream, const char* data, size_t len) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (len == 0) ++closed;
+        else (stream == STDERR_FILENO ? err : out).append(data, len);
+    });
+    std::atomic<bool> crashed{false};
+    pm.on_crash = [&](int) { crashed = true; };
+
+    EXPECT_TRUE(pm.start("/bin/sh", {"-c", "echo started; echo 'bad config' >&2; exit 3"}));
+    for (int i = 0; i < 200 && !crashed; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pm.stop();
+
+    std::lock_guard<std::mutex> lock(mu);
+    EXPECT_EQ(out, "started\n");
+    EXPECT_EQ(err, "bad config\n");
+    EXPECT_EQ(closed, 2);
+}
+
+TEST(ProcessManagerTest, CpuListParsing) {
+    std::vector<int> cpus;
+    ASSERT_TRUE(ProcessManager::parse_cpu_list("0-3,6,2", cpus));
+    EXPECT_EQ(cpus, (std::vector<int>{0, 1, 2, 3, 6}));
+    EXPECT_EQ(ProcessManager::format_cpu_list(cpus), "0-3,6");
+    EXPECT_EQ(ProcessManager::format_cpu_list({5}), "5");
+    EXPECT_EQ(ProcessManager::format_cpu_list({}), "");
+
+    EXPECT_FALSE(ProcessManager::parse_cpu_list("", cpus));
+    EXPECT_FALSE(ProcessManager::parse_cpu_list("3-1", cpus));
+    EXPECT_FALSE(ProcessManager::parse_cpu_list("0,,1", cpus));
+    EXPECT_FALSE(ProcessManager::parse_cpu_list("a-b", cpus));
+    EXPECT_FALSE(ProcessManager::parse_cpu_list("4096", cpus));
+}
+
+TEST(ProcessManagerTest, AppliesLaunchOptions) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+
+    std::mutex mu;
+    std::string out;
+    pm.set_output_sink([&](int stream, const char* data, size_t len) {
+        std::lock_guard<std::mutex> lock(mu);
+        if (stream == STDOUT_FILENO) out.append(data, len);
+    });
+
+    // Lowering limits and raising nice never need privileges
+    ProcessManager::LaunchOptions opts;
+    opts.cpus = "0";
+    opts.nice = 5;
+    opts.nofile = 256;
+    opts.memory_bytes = uint64_t{4} << 30;
+    opts.env = {{"GOMAXPROCS", "2"}, {"CLASHTUI_TEST_VAR", "x"}};
+    pm.set_launch_options(opts);
+
+    ASSERT_TRUE(pm.start("/bin/sh", {"-c", "ulimit -n; echo $GOMAXPROCS$CLASHTUI_TEST_VAR; exec sleep 5"}));
+    auto report = pm.launch_report();
+    EXPECT_EQ(report.pid, pm.child_pid());
+    EXPECT_TRUE(report.failed.empty());
+    EXPECT_EQ(report.cpus, "0");
+    EXPECT_EQ(report.nice, 5);
+    EXPECT_EQ(report.nofile_soft, 256u);
+    EXPECT_EQ(report.memory_bytes, uint64_t{4} << 30);
+    EXPECT_EQ(report.env, (std::vector<std::string>{"GOMAXPROCS=2", "CLASHTUI_TEST_VAR=x"}));
+
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (out.find("2x\n") != std::string::npos) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pm.stop();
+    std::lock_guard<std::mutex> lock(mu);
+    EXPECT_EQ(out, "256\n2x\n");
+}
+
+TEST(ProcessManagerTest, ReportsOptionsItCannotApply) {
+    ProcessManager pm;
+    pm.set_auto_restart(false);
+    ProcessManager::LaunchOptions opts;
+    opts.cpus = "1023";   // no such CPU
+    pm.set_launch_options(opts);
+
+    ASSERT_TRUE(pm.start("/bin/sleep", {"5"}));
+    auto report = pm.launch_report();
+    EXPECT_EQ(report.failed, (std::vector<std::string>{"cpus"}));
+    EXPECT_FALSE(report.cpus.empty());   // inherited affinity
+    pm.stop();
+}
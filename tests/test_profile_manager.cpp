@@ -1,10 +1,16 @@
 #include <gtest/gtest.h>
 #include "core/profile_manager.hpp"
+#include "core/subscription.hpp"
 #include "core/config.hpp"
 
+#include <httplib.h>
+#include <zlib.h>
+#include <algorithm>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <cstdlib>
+#include <thread>
 #include <unistd.h>
 
 namespace fs = std::filesystem;
@@ -119,6 +125,303 @@ TEST_F(ProfileManagerTest, UpdateNonexistentProfile) {
     EXPECT_FALSE(result.success);
 }
 
+TEST_F(ProfileManagerTest, ChangeEventsOnSwitchAndDelete) {
+    if (fs::exists(Config::system_config_dir() + "/profiles")) {
+        GTEST_SKIP() << "Skipped: system profiles exist, fallback returns them";
+    }
+    Config config;
+    ProfileManager pm(config);
+    std::vector<std::pair<std::string, std::string>> events;
+    pm.on_change = [&](const std::string& ev, const std::string& name) {
+        events.emplace_back(ev, name);
+    };
+
+    fs::create_directories(pm.profiles_dir());
+    std::ofstream(pm.profiles_dir() + "/a.yaml") << "proxies: []\n";
+    std::ofstream(pm.profiles_dir() + "/profiles.yaml")
+        << "- name: a\n  filename: a.yaml\n  source_url: http://example.invalid/a\n";
+
+    EXPECT_FALSE(pm.switch_active("missing"));
+    EXPECT_TRUE(events.empty());
+
+    ASSERT_TRUE(pm.switch_active("a"));
+    ASSERT_TRUE(pm.delete_profile("a"));
+
+    ASSERT_EQ(events.size(), 3u);
+    EXPECT_EQ(events[0], std::make_pair(std::string("profile_changed"), std::string("a")));
+    EXPECT_EQ(events[1], std::make_pair(std::string("profile_deleted"), std::string("a")));
+    EXPECT_EQ(events[2], std::make_pair(std::string("profile_changed"), std::string("")));
+}
+
+TEST_F(ProfileManagerTest, CommitUpdateSwapsContent) {
+    if (fs::exists(Config::system_config_dir() + "/profiles")) {
+        GTEST_SKIP() << "Skipped: system profiles exist, fallback returns them";
+    }
+    Config config;
+    ProfileManager pm(config);
+    std::vector<std::string> events;
+    pm.on_change = [&](const std::string& ev, const std::string&) { events.push_back(ev); };
+
+    fs::create_directories(pm.profiles_dir());
+    std::ofstream(pm.profiles_dir() + "/a.yaml") << "proxies: []\n";
+    std::ofstream(pm.profiles_dir() + "/profiles.yaml")
+        << "- name: a\n  filename: a.yaml\n  source_url: http://example.invalid/a\n"
+           "  last_updated: 2000-01-01T00:00:00\n";
+
+    EXPECT_EQ(pm.source_url("a"), "http://example.invalid/a");
+    EXPECT_EQ(pm.source_url("missing"), "");
+
+    // A staged download for a profile deleted meanwhile is discarded
+    ProfileManager::FetchCache cache;
+    std::string staged = pm.staging_path("missing");
+    std::ofstream(staged) << "x: 1\n";
+    EXPECT_FALSE(pm.commit_update("missing", staged, cache).success);
+    EXPECT_FALSE(fs::exists(staged));
+
+    staged = pm.staging_path("a");
+    EXPECT_NE(staged, pm.staging_path("a"));
+    std::ofstream(staged) << "proxies: [new]\n";
+    auto result = pm.commit_update("a", staged, cache);
+    ASSERT_TRUE(result.success) << result.error;
+    std::ifstream in(pm.profiles_dir() + "/a.yaml");
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "proxies: [new]\n");
+    EXPECT_FALSE(fs::exists(staged));
+    EXPECT_NE(pm.list_profiles()[0].last_updated, "2000-01-01T00:00:00");
+    EXPECT_EQ(events, std::vector<std::string>{"profile_updated"});
+}
+
+TEST_F(ProfileManagerTest, MetadataCacheFollowsFileChanges) {
+    if (fs::exists(Config::system_config_dir() + "/profiles")) {
+        GTEST_SKIP() << "Skipped: system profiles exist, fallback returns them";
+    }
+    Config config;
+    ProfileManager pm(config);
+    fs::create_directories(pm.profiles_dir());
+    std::string meta = pm.profiles_dir() + "/profiles.yaml";
+    std::ofstream(meta) << "- name: b\n  filename: b.yaml\n";
+    ASSERT_EQ(pm.list_profiles().size(), 1u);
+    EXPECT_EQ(pm.list_profiles()[0].name, "b");
+
+    // Same inode, size and mtime: served from the cache without a parse
+    auto mtime = fs::last_write_time(meta);
+    std::ofstream(meta) << "- name: c\n  filename: c.yaml\n";
+    fs::last_write_time(meta, mtime);
+    EXPECT_EQ(pm.list_profiles()[0].name, "b");
+
+    // Any real change to the file's identity reloads it
+    fs::last_write_time(meta, mtime + std::chrono::seconds(1));
+    EXPECT_EQ(pm.list_profiles()[0].name, "c");
+
+    std::ofstream(meta + ".new") << "- name: d\n  filename: d.yaml\n- name: e\n  filename: e.yaml\n";
+    fs::rename(meta + ".new", meta);
+    ASSERT_EQ(pm.list_profiles().size(), 2u);
+
+    // The active flag follows the config, not the cached file
+    config.data().active_profile = "e";
+    EXPECT_FALSE(pm.list_profiles()[0].is_active);
+    EXPECT_TRUE(pm.list_profiles()[1].is_active);
+
+    // Our own writes refresh the cache; a deleted file empties the list
+    ASSERT_TRUE(pm.set_update_interval("d", 6));
+    EXPECT_EQ(pm.list_profiles()[0].update_interval_hours, 6);
+    fs::remove(meta);
+    EXPECT_TRUE(pm.list_profiles().empty());
+}
+
+TEST_F(ProfileManagerTest, UnchangedUpdateKeepsFileAndValidators) {
+    if (fs::exists(Config::system_config_dir() + "/profiles")) {
+        GTEST_SKIP() << "Skipped: system profiles exist, fallback returns them";
+    }
+    Config config;
+    ProfileManager pm(config);
+    fs::create_directories(pm.profiles_dir());
+    std::ofstream(pm.profiles_dir() + "/a.yaml") << "proxies: []\n";
+    std::ofstream(pm.profiles_dir() + "/profiles.yaml")
+        << "- name: a\n  filename: a.yaml\n  source_url: http://example.invalid/a\n"
+           "  last_updated: 2000-01-01T00:00:00\n  etag: '\"v1\"'\n";
+
+    ProfileManager::FetchCache cache;
+    ASSERT_EQ(pm.source_url("a", &cache), "http://example.invalid/a");
+    EXPECT_EQ(cache.etag, "\"v1\"");
+
+    // A 304 (or identical body) leaves the file alone but records the time
+    auto mtime = fs::last_write_time(pm.profiles_dir() + "/a.yaml");
+    cache.unchanged = true;
+    cache.last_modified = "Wed, 01 May 2024 10:00:00 GMT";
+    auto result = pm.commit_update("a", "", cache);
+    ASSERT_TRUE(result.success) << result.error;
+    EXPECT_TRUE(result.unchanged);
+    EXPECT_EQ(fs::last_write_time(pm.profiles_dir() + "/a.yaml"), mtime);
+
+    auto info = pm.list_profiles()[0];
+    EXPECT_NE(info.last_updated, "2000-01-01T00:00:00");
+    EXPECT_EQ(info.etag, "\"v1\"");
+    EXPECT_EQ(info.last_modified, "Wed, 01 May 2024 10:00:00 GMT");
+
+    // New content: renamed in, and the hash is remembered for next time
+    ProfileManager::FetchCache fresh;
+    fresh.content_hash = Subscription::content_hash("proxies: [new]\n");
+    std::string staged = pm.staging_path("a");
+    std::ofstream(staged) << "proxies: [new]\n";
+    result = pm.commit_update("a", staged, fresh);
+    ASSERT_TRUE(result.success);
+    EXPECT_FALSE(result.unchanged);
+    info = pm.list_profiles()[0];
+    EXPECT_EQ(info.content_hash, fresh.content_hash);
+    EXPECT_TRUE(info.etag.empty());
+
+    // No validators are offered when the file is gone
+    fs::remove(pm.profiles_dir() + "/a.yaml");
+    ProfileManager::FetchCache missing;
+    pm.source_url("a", &missing);
+    EXPECT_TRUE(missing.content_hash.empty());
+}
+
+TEST(SubscriptionTest, ContentHashIsSha256) {
+    EXPECT_EQ(Subscription::content_hash(""),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(Subscription::content_hash("abc"),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+namespace {
+
+std::string gzip(const std::string& data) {
+    z_stream zs{};
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, data.size()) + 32, '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+TEST(SubscriptionTest, BodyWriterDecodesGzipInChunks) {
+    std::string path = fs::temp_directory_path().string() + "/clashtui_body_" + std::to_string(getpid());
+    std::string body;
+    for (int i = 0; i < 20000; ++i) body += "  - {name: node-" + std::to_string(i) + ", type: ss}\n";
+    std::string wire = gzip(body);
+    ASSERT_LT(wire.size(), body.size());
+
+    Subscription::BodyWriter writer(path, 0);
+    ASSERT_TRUE(writer.begin("gzip"));
+    for (size_t pos = 0; pos < wire.size(); pos += 1000) {
+        ASSERT_TRUE(writer.write(wire.data() + pos, std::min<size_t>(1000, wire.size() - pos)))
+            << writer.error();
+    }
+    ASSERT_TRUE(writer.finish()) << writer.error();
+    EXPECT_EQ(writer.bytes(), static_cast<int64_t>(body.size()));
+    EXPECT_EQ(writer.hash(), Subscription::content_hash(body));
+    EXPECT_EQ(read_file(path), body);
+
+    // Plain bodies pass through unchanged
+    ASSERT_TRUE(writer.begin(""));
+    ASSERT_TRUE(writer.write("a: 1\n", 5));
+    ASSERT_TRUE(writer.finish());
+    EXPECT_EQ(read_file(path), "a: 1\n");
+    fs::remove(path);
+}
+
+TEST(SubscriptionTest, BodyWriterRejectsBadBodies) {
+    std::string path = fs::temp_directory_path().string() + "/clashtui_body_" + std::to_string(getpid());
+    std::string big(4096, 'x');
+
+    // The cap applies to decoded bytes, so a small gzip bomb is caught too
+    Subscription::BodyWriter capped(path, 1024);
+    std::string wire = gzip(big);
+    ASSERT_TRUE(capped.begin("GZIP"));
+    EXPECT_FALSE(capped.write(wire.data(), wire.size()));
+    EXPECT_NE(capped.error().find("limit"), std::string::npos);
+
+    Subscription::BodyWriter writer(path, 0);
+    ASSERT_TRUE(writer.begin("gzip"));
+    ASSERT_TRUE(writer.write(wire.data(), wire.size() / 2));
+    EXPECT_FALSE(writer.finish());
+    EXPECT_EQ(writer.error(), "Truncated compressed body");
+
+    ASSERT_TRUE(writer.begin("gzip"));
+    EXPECT_FALSE(writer.write("not gzip at all", 15));
+
+    EXPECT_FALSE(writer.begin("br"));
+    fs::remove(path);
+}
+
+class SubscriptionServerTest : public ::testing::Test {
+protected:
+    httplib::Server server_;
+    std::thread server_thread_;
+    int port_ = -1;
+    std::string dest_;
+
+    void SetUp() override {
+        server_.Get("/profile", [](const httplib::Request& req, httplib::Response& res) {
+            res.set_header("ETag", "\"v1\"");
+            if (req.get_header_value("If-None-Match") == "\"v1\"") {
+                res.status = 304;
+                return;
+            }
+            res.set_content("proxies: []\n", "text/yaml");
+        });
+        server_.Get("/moved", [](const httplib::Request&, httplib::Response& res) {
+            res.status = 302;
+            res.set_header("Location", "/profile");
+        });
+
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        if (port_ <= 0) GTEST_SKIP() << "Skipped: cannot bind a local HTTP server";
+        server_thread_ = std::thread([this]() { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+        dest_ = fs::temp_directory_path().string() + "/clashtui_sub_" + std::to_string(getpid());
+    }
+
+    void TearDown() override {
+        server_.stop();
+        if (server_thread_.joinable()) server_thread_.join();
+        if (!dest_.empty()) fs::remove(dest_);
+    }
+
+    std::string url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(port_) + path;
+    }
+};
+
+TEST_F(SubscriptionServerTest, DownloadsBodyThroughRedirect) {
+    auto r = Subscription::download(url("/moved"), dest_);
+    ASSERT_TRUE(r.success) << r.error;
+    EXPECT_FALSE(r.not_modified);
+    EXPECT_EQ(r.etag, "\"v1\"");
+    EXPECT_EQ(r.bytes, 12);
+    EXPECT_TRUE(fs::exists(dest_));
+}
+
+TEST_F(SubscriptionServerTest, NotModifiedReplyIsSuccess) {
+    Subscription::Validators since;
+    since.etag = "\"v1\"";
+
+    auto r = Subscription::download(url("/profile"), dest_, nullptr, since);
+    ASSERT_TRUE(r.success) << r.error;
+    EXPECT_TRUE(r.not_modified);
+    EXPECT_EQ(r.etag, "\"v1\"");
+    EXPECT_FALSE(fs::exists(dest_));
+
+    // The conditional headers go along to the redirect target
+    r = Subscription::download(url("/moved"), dest_, nullptr, since);
+    ASSERT_TRUE(r.success) << r.error;
+    EXPECT_TRUE(r.not_modified);
+}
+
 // Test ProfileInfo defaults
 TEST(ProfileInfoTest, Defaults) {
     ProfileInfo info;
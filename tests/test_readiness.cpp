@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include "daemon/readiness.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+
+namespace {
+
+// Listening socket on an ephemeral loopback port
+int listen_any(int& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        close(fd);
+        return -1;
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+} // namespace
+
+TEST(ReadinessTest, PortAcceptsFollowsListener) {
+    int port = 0;
+    int fd = listen_any(port);
+    ASSERT_GE(fd, 0);
+    EXPECT_TRUE(readiness::port_accepts("127.0.0.1", port, 200));
+    EXPECT_TRUE(readiness::port_accepts("localhost", port, 200));
+
+    close(fd);
+    // Refused right away rather than after the timeout
+    auto t0 = std::chrono::steady_clock::now();
+    EXPECT_FALSE(readiness::port_accepts("127.0.0.1", port, 1000));
+    EXPECT_LT(std::chrono::steady_clock::now() - t0, std::chrono::milliseconds(500));
+}
+
+TEST(ReadinessTest, PortAcceptsRejectsBadHost) {
+    EXPECT_FALSE(readiness::port_accepts("no such host!", 80, 50));
+}
+
+TEST(ReadinessTest, ProxiesLoaded) {
+    EXPECT_TRUE(readiness::proxies_loaded(R"({"proxies":{"DIRECT":{"type":"Direct"}}})"));
+    EXPECT_FALSE(readiness::proxies_loaded(R"({"proxies":{}})"));
+    EXPECT_FALSE(readiness::proxies_loaded(R"({"message":"Unauthorized"})"));
+    EXPECT_FALSE(readiness::proxies_loaded("not json"));
+}
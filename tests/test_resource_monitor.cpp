@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "daemon/resource_monitor.hpp"
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+
+TEST(ResourceMonitorTest, ParseStatWithOddComm) {
+    // comm may contain spaces and ')'
+    std::string line = "4242 (mi ho) mo) S 1 4242 4242 0 -1 4194560 1000 0 0 0 "
+                       "150 50 0 0 20 0 17 0 12345 800000000 12000 18446744073709551615";
+    uint64_t ticks = 0;
+    int threads = 0;
+    ASSERT_TRUE(ResourceMonitor::parse_stat(line, ticks, threads));
+    EXPECT_EQ(ticks, 200u);
+    EXPECT_EQ(threads, 17);
+
+    EXPECT_FALSE(ResourceMonitor::parse_stat("4242 (short) S 1 2", ticks, threads));
+    EXPECT_FALSE(ResourceMonitor::parse_stat("garbage", ticks, threads));
+}
+
+TEST(ResourceMonitorTest, ParseStatusRss) {
+    uint64_t rss = 0;
+    ASSERT_TRUE(ResourceMonitor::parse_status_rss(
+        "Name:\tmihomo\nVmPeak:\t  900000 kB\nVmRSS:\t   54321 kB\nThreads:\t17\n", rss));
+    EXPECT_EQ(rss, 54321u);
+    ASSERT_TRUE(ResourceMonitor::parse_status_rss("Name:\tkthreadd\nThreads:\t1\n", rss));
+    EXPECT_EQ(rss, 0u);
+    EXPECT_FALSE(ResourceMonitor::parse_status_rss("", rss));
+}
+
+TEST(ResourceMonitorTest, SamplesOwnProcess) {
+    std::vector<ResourceMonitor::Sample> seen;
+    ResourceMonitor::Options opts;
+    opts.history = 2;
+    ResourceMonitor mon(opts, [] { return getpid(); },
+                        [&](const ResourceMonitor::Sample& s, const std::vector<ResourceMonitor::Alert>&) {
+                            seen.push_back(s);
+                        });
+
+    for (int i = 0; i < 3; ++i) {
+        // CPU share needs time to pass between samples
+        if (i > 0) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ASSERT_TRUE(mon.sample_once());
+    }
+    ASSERT_EQ(seen.size(), 3u);
+    EXPECT_EQ(seen[0].pid, getpid());
+    EXPECT_LT(seen[0].cpu_pct, 0);   // no previous sample
+    EXPECT_GE(seen[1].cpu_pct, 0);
+    EXPECT_GT(seen[2].rss_kb, 0u);
+    EXPECT_GE(seen[2].fds, 3);
+    EXPECT_GE(seen[2].threads, 1);
+
+    EXPECT_EQ(mon.history().size(), 2u);
+    ResourceMonitor::Sample last;
+    ASSERT_TRUE(mon.latest(last));
+    EXPECT_EQ(last.time_ms, seen[2].time_ms);
+}
+
+TEST(ResourceMonitorTest, NothingRunning) {
+    ResourceMonitor mon(ResourceMonitor::Options{}, [] { return pid_t{-1}; }, nullptr);
+    EXPECT_FALSE(mon.sample_once());
+    ResourceMonitor::Sample s;
+    EXPECT_FALSE(mon.latest(s));
+}
+
+TEST(ResourceMonitorTest, LimitsNeedSustainedExcess) {
+    ResourceMonitor::Options opts;
+    opts.limits.rss_warn_kb = 1000;
+    opts.limits.rss_restart_kb = 5000;
+    opts.limits.sustain = 2;
+    ResourceMonitor mon(opts, nullptr, nullptr);
+
+    ResourceMonitor::Sample s;
+    s.pid = 100;
+    s.rss_kb = 2000;
+    EXPECT_TRUE(mon.check(s).empty());        // first sample over
+    auto alerts = mon.check(s);
+    ASSERT_EQ(alerts.size(), 1u);
+    EXPECT_EQ(alerts[0].metric, "rss_kb");
+    EXPECT_FALSE(alerts[0].restart);
+    EXPECT_TRUE(mon.check(s).empty());        // warned once per excursion
+
+    s.rss_kb = 500;
+    EXPECT_TRUE(mon.check(s).empty());
+    s.rss_kb = 2000;
+    mon.check(s);
+    EXPECT_EQ(mon.check(s).size(), 1u);       // re-armed after coming back under
+
+    s.rss_kb = 6000;
+    EXPECT_TRUE(mon.check(s).empty());
+    alerts = mon.check(s);
+    ASSERT_EQ(alerts.size(), 1u);
+    EXPECT_TRUE(alerts[0].restart);
+
+    // Still over while the restart is pending: no second request
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(mon.check(s).empty());
+
+    // A new process starts the counts over
+    s.pid = 101;
+    EXPECT_TRUE(mon.check(s).empty());
+    alerts = mon.check(s);
+    ASSERT_EQ(alerts.size(), 2u);             // warning and restart again
+    EXPECT_TRUE(alerts[1].restart);
+}
+
+TEST(ResourceMonitorTest, CpuLimitSkipsFirstSample) {
+    ResourceMonitor::Options opts;
+    opts.limits.cpu_warn_pct = 50;
+    opts.limits.fds_warn = 10;
+    opts.limits.sustain = 1;
+    ResourceMonitor mon(opts, nullptr, nullptr);
+
+    ResourceMonitor::Sample s;
+    s.pid = 7;
+    s.cpu_pct = -1;
+    s.fds = 3;
+    EXPECT_TRUE(mon.check(s).empty());
+    s.cpu_pct = 90;
+    s.fds = 12;
+    auto alerts = mon.check(s);
+    ASSERT_EQ(alerts.size(), 2u);
+    EXPECT_EQ(alerts[0].metric, "fds");
+    EXPECT_EQ(alerts[1].metric, "cpu_pct");
+}
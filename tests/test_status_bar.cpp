@@ -51,3 +51,19 @@ TEST(StatusBarTest, ThreadSafety) {
     for (auto& t : threads) t.join();
     // No crash or data race
 }
+
+TEST(StatusBarTest, SetMihomoHealth) {
+    StatusBar bar;
+    bar.set_mihomo_health(3, false);
+    bar.set_mihomo_health(5, true);
+    bar.set_mihomo_health(0, false);
+    // No crash
+}
+
+TEST(StatusBarTest, SetMihomoResources) {
+    StatusBar bar;
+    bar.set_mihomo_resources(-1, 51200, false);
+    bar.set_mihomo_resources(12.5, 65536, true);
+    bar.set_mihomo_resources(-1, 0, false);
+    // No crash
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include "core/throughput_tester.hpp"
+#include "core/selection_lock.hpp"
+
+#include <httplib.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr size_t kFileSize = 2 * 1024 * 1024;
+
+} // namespace
+
+class ThroughputTesterTest : public ::testing::Test {
+protected:
+    httplib::Server server_;
+    std::thread server_thread_;
+    int port_ = -1;
+    std::atomic<int> in_flight_{0};
+    std::atomic<int> max_in_flight_{0};
+
+    void SetUp() override {
+        server_.Get("/file", [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(std::string(kFileSize, 'x'), "application/octet-stream");
+        });
+        server_.Get("/slow", [this](const httplib::Request&, httplib::Response& res) {
+            int now = ++in_flight_;
+            int prev = max_in_flight_.load();
+            while (now > prev && !max_in_flight_.compare_exchange_weak(prev, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(150));
+            --in_flight_;
+            res.set_content(std::string(1024, 'x'), "application/octet-stream");
+        });
+
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        if (port_ <= 0) GTEST_SKIP() << "Skipped: cannot bind a local HTTP server";
+        server_thread_ = std::thread([this]() { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+    }
+
+    void TearDown() override {
+        server_.stop();
+        if (server_thread_.joinable()) server_thread_.join();
+    }
+
+    ThroughputTester::Options options(const std::string& path) {
+        ThroughputTester::Options opts;
+        opts.url = "http://127.0.0.1:" + std::to_string(port_) + path;
+        opts.max_seconds = 5;
+        return opts;
+    }
+};
+
+TEST_F(ThroughputTesterTest, MeasuresDownload) {
+    ThroughputTester tester(options("/file"));
+    auto r = tester.measure("local");
+    ASSERT_TRUE(r.success) << r.error;
+    EXPECT_EQ(r.bytes, (int64_t)kFileSize);
+    EXPECT_GE(r.ttfb_ms, 0);
+    EXPECT_GE(r.total_ms, r.ttfb_ms);
+    EXPECT_GT(r.mb_per_sec, 0.0);
+}
+
+TEST_F(ThroughputTesterTest, ByteCapStopsEarly) {
+    auto opts = options("/file");
+    opts.max_bytes = 256 * 1024;
+    ThroughputTester tester(opts);
+    auto r = tester.measure("local");
+    ASSERT_TRUE(r.success) << r.error;
+    EXPECT_GE(r.bytes, opts.max_bytes);
+    EXPECT_LT(r.bytes, (int64_t)kFileSize);
+}
+
+TEST_F(ThroughputTesterTest, HttpErrorReported) {
+    ThroughputTester tester(options("/missing"));
+    auto r = tester.measure("local");
+    EXPECT_FALSE(r.success);
+    EXPECT_EQ(r.error, "HTTP 404");
+}
+
+TEST_F(ThroughputTesterTest, ConcurrencyLimit) {
+    auto opts = options("/slow");
+    opts.concurrency = 2;
+    ThroughputTester tester(opts);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; ++i) {
+        threads.emplace_back([&tester, i]() { tester.measure("n" + std::to_string(i)); });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_GE(max_in_flight_.load(), 1);
+    EXPECT_LE(max_in_flight_.load(), 2);
+}
+
+TEST(ThroughputTesterRouting, SelectsNodeAndRestores) {
+    std::string current = "old";
+    std::vector<std::string> selects;
+
+    ThroughputTester::Options opts;
+    opts.url = "http://127.0.0.1:1/unreachable";
+    opts.max_seconds = 1;
+    ThroughputTester tester(opts,
+        [&](const std::string& group, const std::string& proxy) {
+            EXPECT_EQ(group, "GLOBAL");
+            selects.push_back(proxy);
+            current = proxy;
+            return true;
+        },
+        [&](const std::string&) { return current; });
+
+    auto r = tester.test("GLOBAL", "fast");
+    EXPECT_FALSE(r.success);
+    EXPECT_EQ(r.name, "fast");
+    ASSERT_EQ(selects.size(), 2u);
+    EXPECT_EQ(selects[0], "fast");
+    EXPECT_EQ(selects[1], "old");
+    EXPECT_EQ(current, "old");
+}
+
+TEST(ThroughputTesterRouting, SelectFailureSkipsDownload) {
+    ThroughputTester tester(ThroughputTester::Options{},
+        [](const std::string&, const std::string&) { return false; },
+        [](const std::string&) { return std::string("old"); });
+    auto r = tester.test("GLOBAL", "fast");
+    EXPECT_FALSE(r.success);
+    EXPECT_EQ(r.error, "failed to select node");
+    EXPECT_EQ(r.bytes, 0);
+}
+
+TEST(ThroughputTesterRouting, SameGroupRunsSerialized) {
+    // Every test in one group switches its selection: never two at once
+    std::atomic<int> in_flight{0};
+    std::atomic<int> max_in_flight{0};
+    std::mutex mu;
+    std::string current = "old";
+    ThroughputTester::Options opts;
+    opts.url = "not a url";
+    opts.concurrency = 4;
+    ThroughputTester tester(opts,
+        [&](const std::string&, const std::string& proxy) {
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                current = proxy;
+            }
+            if (proxy == "old") {
+                --in_flight;
+                return true;
+            }
+            int now = ++in_flight;
+            int seen = max_in_flight.load();
+            while (now > seen && !max_in_flight.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            return true;
+        },
+        [&](const std::string&) {
+            std::lock_guard<std::mutex> lock(mu);
+            return current;
+        });
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&tester, i]() { tester.test("Proxy", "n" + std::to_string(i)); });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(max_in_flight.load(), 1);
+    EXPECT_EQ(in_flight.load(), 0);
+}
+
+TEST(ThroughputTesterRouting, KeepsSelectionMadeDuringTest) {
+    std::string current = "old";
+    std::vector<std::string> selects;
+    ThroughputTester::Options opts;
+    opts.url = "not a url";
+    ThroughputTester tester(opts,
+        [&](const std::string&, const std::string& proxy) {
+            selects.push_back(proxy);
+            current = proxy;
+            if (proxy == "fast") current = "manual";  // someone picks a node meanwhile
+            return true;
+        },
+        [&](const std::string&) { return current; });
+
+    tester.test("Proxy", "fast");
+    ASSERT_EQ(selects.size(), 1u);
+    EXPECT_EQ(current, "manual");
+}
+
+TEST(ThroughputTesterRouting, RecoversInterruptedTest) {
+    std::string dir = "/tmp/ct_tput_lock_" + std::to_string(::getpid());
+    {
+        // A test that died after switching the group
+        SelectionLock crashed(dir, "Proxy");
+        ASSERT_TRUE(crashed.lock());
+        crashed.write_pending("old", "fast");
+    }
+    EXPECT_EQ(SelectionLock::pending_groups(dir), std::vector<std::string>{"Proxy"});
+
+    std::string current = "fast";
+    ThroughputTester::Options opts;
+    opts.lock_dir = dir;
+    ThroughputTester tester(opts,
+        [&](const std::string&, const std::string& proxy) {
+            current = proxy;
+            return true;
+        },
+        [&](const std::string&) { return current; });
+
+    tester.recover();
+    EXPECT_EQ(current, "old");
+    EXPECT_TRUE(SelectionLock::pending_groups(dir).empty());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ThroughputTesterRouting, HoldsSelectionLockDuringTest) {
+    std::string dir = "/tmp/ct_tput_lock_" + std::to_string(::getpid());
+    bool busy_during_test = false;
+    std::string current = "old";
+    ThroughputTester::Options opts;
+    opts.url = "not a url";
+    opts.lock_dir = dir;
+    ThroughputTester tester(opts,
+        [&](const std::string&, const std::string& proxy) {
+            if (proxy == "fast") {
+                SelectionLock other(dir, "Proxy");
+                busy_during_test = !other.try_lock();
+            }
+            current = proxy;
+            return true;
+        },
+        [&](const std::string&) { return current; });
+
+    tester.test("Proxy", "fast");
+    EXPECT_TRUE(busy_during_test);
+    EXPECT_EQ(current, "old");
+    SelectionLock after(dir, "Proxy");
+    EXPECT_TRUE(after.try_lock());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ThroughputTesterRouting, CheckRoute) {
+    EXPECT_EQ(ThroughputTester::check_route("GLOBAL", "Selector", "global"), "");
+    EXPECT_NE(ThroughputTester::check_route("GLOBAL", "Selector", "rule"), "");
+    EXPECT_NE(ThroughputTester::check_route("Proxy", "Selector", "direct"), "");
+    EXPECT_EQ(ThroughputTester::check_route("Proxy", "Selector", "rule"), "");
+    EXPECT_NE(ThroughputTester::check_route("Auto", "URLTest", "rule"), "");
+}
+
+TEST(ThroughputTesterRouting, InvalidUrl) {
+    ThroughputTester::Options opts;
+    opts.url = "not a url";
+    ThroughputTester tester(opts);
+    auto r = tester.measure("x");
+    EXPECT_FALSE(r.success);
+    EXPECT_EQ(r.error, "invalid test URL");
+}
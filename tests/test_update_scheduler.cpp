@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "daemon/update_scheduler.hpp"
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+ProfileInfo auto_profile(const std::string& name, int hours, const std::string& last_updated) {
+    ProfileInfo p;
+    p.name = name;
+    p.source_url = "http://example.com/" + name;
+    p.auto_update = true;
+    p.update_interval_hours = hours;
+    p.last_updated = last_updated;
+    return p;
+}
+
+} // namespace
+
+TEST(UpdateSchedulerTest, HandsOutDueProfilesOnce) {
+    UpdateScheduler sched;
+    int64_t base = UpdateScheduler::parse_timestamp("2024-05-01T10:00:00");
+    ASSERT_GT(base, 0);
+
+    ProfileInfo manual = auto_profile("manual", 1, "2024-05-01T10:00:00");
+    manual.auto_update = false;
+    sched.set_profiles({auto_profile("a", 2, "2024-05-01T10:00:00"),
+                        auto_profile("b", 1, "2024-05-01T10:00:00"),
+                        auto_profile("never", 1, ""), manual},
+                       base);
+
+    // Never-updated profiles are due right away
+    EXPECT_EQ(sched.next_due(), base);
+    EXPECT_EQ(sched.take_due(base), std::vector<std::string>{"never"});
+    EXPECT_TRUE(sched.take_due(base + 3599).empty());
+    EXPECT_EQ(sched.take_due(base + 3600), std::vector<std::string>{"b"});
+    EXPECT_EQ(sched.next_due(), base + 7200);
+
+    // In-flight profiles are not handed out again until reported
+    EXPECT_EQ(sched.take_due(base + 7200), std::vector<std::string>{"a"});
+    EXPECT_TRUE(sched.take_due(base + 100000).empty());
+    EXPECT_EQ(sched.next_due(), -1);
+
+    sched.report("b", true, base + 3700);
+    EXPECT_EQ(sched.next_due(), base + 3700 + 3600);
+}
+
+TEST(UpdateSchedulerTest, FailuresBackOffExponentially) {
+    UpdateScheduler sched({/*base_backoff_sec=*/60, /*max_backoff_sec=*/300});
+    sched.set_profiles({auto_profile("a", 1, "")}, 1000);
+
+    int64_t now = 1000;
+    for (int64_t expect : {60, 120, 240, 300, 300}) {
+        ASSERT_EQ(sched.take_due(now), std::vector<std::string>{"a"});
+        sched.report("a", false, now);
+        EXPECT_EQ(sched.next_due(), now + expect);
+        now += expect;
+    }
+    EXPECT_EQ(sched.failures("a"), 5);
+
+    // A metadata reload keeps the backoff instead of retrying at once
+    sched.set_profiles({auto_profile("a", 1, "")}, now - 10);
+    EXPECT_EQ(sched.next_due(), now);
+
+    ASSERT_EQ(sched.take_due(now), std::vector<std::string>{"a"});
+    sched.report("a", true, now);
+    EXPECT_EQ(sched.failures("a"), 0);
+    EXPECT_EQ(sched.next_due(), now + 3600);
+}
+
+TEST(UpdateSchedulerTest, ReloadMovesAndDropsDeadlines) {
+    UpdateScheduler sched;
+    int64_t base = UpdateScheduler::parse_timestamp("2024-05-01T10:00:00");
+    sched.set_profiles({auto_profile("a", 1, "2024-05-01T10:00:00"),
+                        auto_profile("b", 4, "2024-05-01T10:00:00")},
+                       base);
+    EXPECT_EQ(sched.next_due(), base + 3600);
+
+    // Interval change reschedules; removed profiles disappear
+    sched.set_profiles({auto_profile("b", 2, "2024-05-01T10:00:00")}, base);
+    EXPECT_EQ(sched.next_due(), base + 7200);
+    EXPECT_EQ(sched.take_due(base + 100000), std::vector<std::string>{"b"});
+
+    // Reports for profiles deleted meanwhile are ignored
+    sched.set_profiles({}, base);
+    sched.report("b", true, base);
+    EXPECT_EQ(sched.next_due(), -1);
+}
+
+TEST(UpdateSchedulerTest, WaitWakesOnChangeAndStop) {
+    UpdateScheduler sched;
+    std::vector<std::string> got;
+    std::thread waiter([&] { got = sched.wait_due(); });
+
+    // Nothing scheduled: the waiter sleeps until a profile becomes due
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sched.set_profiles({auto_profile("a", 1, "")});
+    waiter.join();
+    EXPECT_EQ(got, std::vector<std::string>{"a"});
+
+    std::thread stopper([&] { got = sched.wait_due(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    sched.stop();
+    stopper.join();
+    EXPECT_TRUE(got.empty());
+}
+
+TEST(UpdateSchedulerTest, ParseTimestamp) {
+    int64_t t = UpdateScheduler::parse_timestamp("2024-05-01T10:00:00");
+    EXPECT_EQ(UpdateScheduler::parse_timestamp("2024-05-01T11:00:30"), t + 3630);
+    EXPECT_EQ(UpdateScheduler::parse_timestamp(""), -1);
+    EXPECT_EQ(UpdateScheduler::parse_timestamp("yesterday"), -1);
+}
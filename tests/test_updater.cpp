@@ -190,3 +190,47 @@ TEST_F(AtomicReplaceTest, ConsecutiveReplacementsWork) {
     EXPECT_TRUE(err.empty());
     EXPECT_EQ(read_content(old_bin.string()), "BINARY_V3");
 }
+
+// ════════════════════════════════════════════════════════════════
+// validate_mihomo_binary tests
+// ════════════════════════════════════════════════════════════════
+
+class ValidateMihomoBinaryTest : public ::testing::Test {
+protected:
+    fs::path tmp_dir;
+
+    void SetUp() override {
+        tmp_dir = fs::temp_directory_path() / "clashtui-validate-test";
+        fs::create_directories(tmp_dir);
+    }
+
+    void TearDown() override {
+        try { fs::remove_all(tmp_dir); } catch (...) {}
+    }
+};
+
+TEST_F(ValidateMihomoBinaryTest, RunsConfigTest) {
+    // Stand-in for mihomo: accepts only configs mentioning "good"
+    std::string fake = (tmp_dir / "fake-mihomo").string();
+    {
+        std::ofstream f(fake);
+        f << "#!/bin/sh\n"
+             "[ \"$1\" = \"-t\" ] || exit 2\n"
+             "if grep -q good \"$5\"; then echo \"test is successful\"; exit 0; fi\n"
+             "echo \"parse config error\"; exit 1\n";
+    }
+    fs::permissions(fake, fs::perms::owner_all);
+
+    std::string good = (tmp_dir / "good.yaml").string();
+    std::string bad = (tmp_dir / "bad.yaml").string();
+    std::ofstream(good) << "good: true\n";
+    std::ofstream(bad) << "nope: true\n";
+
+    std::string output;
+    EXPECT_TRUE(Updater::validate_mihomo_binary(fake, tmp_dir.string(), good, output));
+    EXPECT_EQ(output, "test is successful");
+    EXPECT_FALSE(Updater::validate_mihomo_binary(fake, tmp_dir.string(), bad, output));
+    EXPECT_EQ(output, "parse config error");
+    EXPECT_FALSE(Updater::validate_mihomo_binary((tmp_dir / "missing").string(),
+                                                 tmp_dir.string(), good, output));
+}